@@ -173,6 +173,7 @@
 #include "peripherals/dialogs/GUIDialogPeripheralSettings.h"
 #include "peripherals/devices/PeripheralImon.h"
 #include "music/infoscanner/MusicInfoScanner.h"
+#include "music/infoscanner/MusicLoudnessAnalyzer.h"
 
 // Windows includes
 #include "guilib/GUIWindowManager.h"
@@ -3626,6 +3627,9 @@ void CApplication::Stop(int exitCode)
     if (m_musicInfoScanner->IsScanning())
       m_musicInfoScanner->Stop();
 
+    if (MUSIC_INFO::CMusicLoudnessAnalyzer::GetInstance().IsAnalyzing())
+      MUSIC_INFO::CMusicLoudnessAnalyzer::GetInstance().Stop();
+
     if (m_videoInfoScanner->IsScanning())
       m_videoInfoScanner->Stop();
 
@@ -69,9 +69,12 @@ CSoftAE::CSoftAE():
   m_rawPassthrough     (false       ),
   m_soundMode          (AE_SOUND_OFF),
   m_streamsPlaying     (false       ),
+  m_freedUnderruns     (0           ),
+  m_freedProducerStalls(0           ),
   m_encoder            (NULL        ),
   m_converted          (NULL        ),
   m_convertedSize      (0           ),
+  m_mixVolumeFn        (CAEUtil::MixVolume()),
   m_masterStream       (NULL        ),
   m_outputStageFn      (NULL        ),
   m_streamStageFn      (NULL        )
@@ -154,7 +157,7 @@ inline CSoftAEStream *CSoftAE::GetMasterStream()
     {
       RemoveStream(m_playingStreams, stream);
       RemoveStream(m_streams       , stream);
-      delete stream;
+      DeleteStream(stream);
       continue;
     }
     ++itt;
@@ -388,8 +391,7 @@ void CSoftAE::InternalOpenSink()
       {
         /* invalidate the buffer */
         m_buffer.Empty();
-        if (m_encoder)
-          m_encoder->Reset();
+        m_transcoder.Reset();
       }
 
       /* configure the encoder */
@@ -480,14 +482,14 @@ void CSoftAE::InternalOpenSink()
 
 void CSoftAE::ResetEncoder()
 {
-  if (m_encoder)
-    m_encoder->Reset();
+  m_transcoder.Reset();
   m_encodedBuffer.Empty();
 }
 
 bool CSoftAE::SetupEncoder(AEAudioFormat &format)
 {
-  ResetEncoder();
+  m_transcoder.Deinitialize();
+  m_encodedBuffer.Empty();
   delete m_encoder;
   m_encoder = NULL;
 
@@ -496,7 +498,10 @@ bool CSoftAE::SetupEncoder(AEAudioFormat &format)
 
   m_encoder = new CAEEncoderFFmpeg();
   if (m_encoder->Initialize(format))
+  {
+    m_transcoder.Initialize(m_encoder, format);
     return true;
+  }
 
   delete m_encoder;
   m_encoder = NULL;
@@ -595,6 +600,12 @@ void CSoftAE::LoadSettings()
 
 void CSoftAE::VerifySoundDevice(std::string& device, bool passthrough)
 {
+  /* the profiler and null sinks are never enumerated but can always be opened */
+  std::string name = device, driver;
+  CAESinkFactory::ParseDevice(name, driver);
+  if (driver == "PROFILER" || driver == "NULL")
+    return;
+
   /* check that the specified device exists */
   std::string firstDevice;
   for (AESinkInfoList::iterator itt = m_sinkInfoList.begin(); itt != m_sinkInfoList.end(); ++itt)
@@ -659,6 +670,7 @@ void CSoftAE::Deinitialize()
     m_sink = NULL;
   }
 
+  m_transcoder.Deinitialize();
   delete m_encoder;
   m_encoder = NULL;
   ResetEncoder();
@@ -878,10 +890,31 @@ IAEStream *CSoftAE::FreeStream(IAEStream *stream)
     m_masterStream = NULL;
   }
 
-  delete (CSoftAEStream*)stream;
+  DeleteStream((CSoftAEStream*)stream);
   return NULL;
 }
 
+/* this method MUST be called while holding m_streamLock */
+void CSoftAE::DeleteStream(CSoftAEStream *stream)
+{
+  m_freedUnderruns      += stream->GetUnderruns();
+  m_freedProducerStalls += stream->GetProducerStalls();
+  delete stream;
+}
+
+void CSoftAE::GetStreamStats(unsigned int &underruns, unsigned int &producerStalls)
+{
+  CSingleLock streamLock(m_streamLock);
+  underruns      = m_freedUnderruns;
+  producerStalls = m_freedProducerStalls;
+
+  for (StreamList::iterator itt = m_streams.begin(); itt != m_streams.end(); ++itt)
+  {
+    underruns      += (*itt)->GetUnderruns();
+    producerStalls += (*itt)->GetProducerStalls();
+  }
+}
+
 double CSoftAE::GetDelay()
 {
   double delayBuffer = 0.0, delaySink = 0.0, delayTranscoder = 0.0;
@@ -893,7 +926,7 @@ double CSoftAE::GetDelay()
   if (m_transcode && m_encoder && !m_rawPassthrough)
   {
     delayBuffer     = (double)m_buffer.Used() * m_encoderInitFrameSizeMul * m_encoderInitSampleRateMul;
-    delayTranscoder = m_encoder->GetDelay((double)m_encodedBuffer.Used() * m_encoderFrameSizeMul);
+    delayTranscoder = m_transcoder.GetDelay((unsigned int)(m_encodedBuffer.Used() * m_encoderFrameSizeMul));
   }
   else
     delayBuffer = (double)m_buffer.Used() * m_sinkFormatFrameSizeMul *m_sinkFormatSampleRateMul;
@@ -912,7 +945,7 @@ double CSoftAE::GetCacheTime()
   if (m_transcode && m_encoder && !m_rawPassthrough)
   {
     timeBuffer     = (double)m_buffer.Used() * m_encoderInitFrameSizeMul * m_encoderInitSampleRateMul;
-    timeTranscoder = m_encoder->GetDelay((double)m_encodedBuffer.Used() * m_encoderFrameSizeMul);
+    timeTranscoder = m_transcoder.GetDelay((unsigned int)(m_encodedBuffer.Used() * m_encoderFrameSizeMul));
   }
   else
     timeBuffer = (double)m_buffer.Used() * m_sinkFormatFrameSizeMul *m_sinkFormatSampleRateMul;
@@ -931,7 +964,7 @@ double CSoftAE::GetCacheTotal()
   if (m_transcode && m_encoder && !m_rawPassthrough)
   {
     timeBuffer     = (double)m_buffer.Size() * m_encoderInitFrameSizeMul * m_encoderInitSampleRateMul;
-    timeTranscoder = m_encoder->GetDelay((double)m_encodedBuffer.Size() * m_encoderFrameSizeMul);
+    timeTranscoder = m_transcoder.GetCacheTotal((unsigned int)(m_encodedBuffer.Size() * m_encoderFrameSizeMul));
   }
   else
     timeBuffer = (double)m_buffer.Size() * m_sinkFormatFrameSizeMul *m_sinkFormatSampleRateMul;
@@ -1124,7 +1157,7 @@ void CSoftAE::AllocateConvIfNeeded(size_t convertedSize, bool prezero)
     memset(m_converted, 0x00, convertedSize);
 }
 
-unsigned int CSoftAE::MixSounds(float *buffer, unsigned int samples)
+unsigned int CSoftAE::MixSounds(float *buffer, unsigned int samples, float volume, bool &clip)
 {
   // no point doing anything if we have no sounds,
   // we do not have to take a lock just to check empty
@@ -1132,12 +1165,11 @@ unsigned int CSoftAE::MixSounds(float *buffer, unsigned int samples)
     return 0;
 
   SoundStateList::iterator itt;
-  unsigned int mixed = 0;
   CSingleLock lock(m_soundSampleLock);
+  m_soundSources.clear();
   for (itt = m_playing_sounds.begin(); itt != m_playing_sounds.end(); )
   {
     SoundState *ss = &(*itt);
-    float *out = buffer;
 
     /* no more frames, so remove it from the list */
     if (ss->sampleCount == 0)
@@ -1147,66 +1179,54 @@ unsigned int CSoftAE::MixSounds(float *buffer, unsigned int samples)
       continue;
     }
 
-    float volume = ss->owner->GetVolume();
-    unsigned int mixSamples = std::min(ss->sampleCount, samples);
-    #ifdef __SSE__
-      CAEUtil::SSEMulAddArray(out, ss->samples, volume, mixSamples);
-    #else
-      float *sample_buffer = ss->samples;
-      for (unsigned int i = 0; i < mixSamples; ++i)
-        *out++ += *sample_buffer++ * volume;
-    #endif
+    AEMixSource source;
+    source.samples = ss->samples;
+    source.volume  = ss->owner->GetVolume();
+    source.count   = std::min(ss->sampleCount, samples);
+    m_soundSources.push_back(source);
 
-    ss->sampleCount -= mixSamples;
-    ss->samples     += mixSamples;
+    ss->sampleCount -= source.count;
+    ss->samples     += source.count;
 
     ++itt;
-    ++mixed;
   }
-  return mixed;
+
+  if (m_soundSources.empty())
+    return 0;
+
+  /* the samples stay valid until the lock is released */
+  clip = m_mixVolumeFn(buffer, samples, &m_soundSources[0], m_soundSources.size(), volume);
+  return m_soundSources.size();
 }
 
 bool CSoftAE::FinalizeSamples(float *buffer, unsigned int samples, bool hasAudio)
 {
-  if (m_soundMode != AE_SOUND_OFF)
-    hasAudio |= (MixSounds(buffer, samples) > 0);
-
-  /* no need to process if we don't have audio (buffer is memset to 0) */
-  if (!hasAudio)
-    return false;
-
-  if (m_muted)
-  {
-    memset(buffer, 0, samples * sizeof(float));
-    return false;
-  }
-
   /* deamplify */
+  float volume = 1.0f;
   if (!m_sinkHandlesVolume && m_volume < 1.0)
+    volume = m_volume;
+
+  bool clip = false;
+  if (m_soundMode != AE_SOUND_OFF && MixSounds(buffer, samples, volume, clip) > 0)
+    hasAudio = true;
+  else
   {
-    #ifdef __SSE__
-      CAEUtil::SSEMulArray(buffer, m_volume, samples);
-    #else
-      float *fbuffer = buffer;
-      for (unsigned int i = 0; i < samples; i++)
-        *fbuffer++ *= m_volume;
-    #endif
+    /* no need to process if we don't have audio (buffer is memset to 0) */
+    if (!hasAudio)
+      return false;
+
+    if (!m_muted)
+      clip = m_mixVolumeFn(buffer, samples, NULL, 0, volume);
   }
 
-  /* check if we need to clamp */
-  bool clamp = false;
-  float *fbuffer = buffer;
-  for (unsigned int i = 0; i < samples; i++, fbuffer++)
+  if (m_muted)
   {
-    if (*fbuffer < -1.0f || *fbuffer > 1.0f)
-    {
-      clamp = true;
-      break;
-    }
+    memset(buffer, 0, samples * sizeof(float));
+    return false;
   }
 
   /* if there were no samples outside of the range, dont clamp the buffer */
-  if (!clamp)
+  if (!clip)
     return true;
 
   CLog::Log(LOGDEBUG, "CSoftAE::FinalizeSamples - Clamping buffer of %d samples", samples);
@@ -1295,39 +1315,40 @@ int CSoftAE::RunRawOutputStage(bool hasAudio)
 
 int CSoftAE::RunTranscodeStage(bool hasAudio)
 {
-  /* if we dont have enough samples to encode yet, return */
   unsigned int block     = m_encoderFormat.m_frames * m_encoderFormat.m_frameSize;
   unsigned int sinkBlock = m_sinkFormat.m_frames    * m_sinkFormat.m_frameSize;
 
+  /* hand a block to the transcoder if we have one and it has room for it */
   int encodedFrames = 0;
-  if (m_buffer.Used() >= block && m_encodedBuffer.Used() < sinkBlock * 2)
+  uint8_t *input;
+  if (m_buffer.Used() >= block && (input = m_transcoder.GetInputBuffer()))
   {
     hasAudio = FinalizeSamples((float*)m_buffer.Raw(block), m_encoderFormat.m_frameSamples, hasAudio);
 
-    void *buffer;
-    if (m_convertFn)
-    {
-      unsigned int newsize = m_encoderFormat.m_frames * m_encoderFormat.m_frameSize;
-      AllocateConvIfNeeded(newsize, !hasAudio);
-      if (hasAudio)
-        m_convertFn((float*)m_buffer.Raw(block),
-          m_encoderFormat.m_frames * m_encoderFormat.m_channelLayout.Count(), m_converted);
-      buffer = m_converted;
-    }
+    if (!hasAudio)
+      memset(input, 0, block);
+    else if (m_convertFn)
+      m_convertFn((float*)m_buffer.Raw(block),
+        m_encoderFormat.m_frames * m_encoderFormat.m_channelLayout.Count(), input);
     else
-      buffer = m_buffer.Raw(block);
+      memcpy(input, m_buffer.Raw(block), block);
 
-    encodedFrames = m_encoder->Encode((float*)buffer, m_encoderFormat.m_frames);
-    m_buffer.Shift(NULL, encodedFrames * m_encoderFormat.m_frameSize);
-
-    uint8_t *packet;
-    unsigned int size = m_encoder->GetData(&packet);
+    m_transcoder.PushInput();
+    m_buffer.Shift(NULL, block);
+    encodedFrames = m_encoderFormat.m_frames;
+  }
 
+  /* collect the packets that are ready */
+  uint8_t *packet;
+  unsigned int size;
+  while (m_encodedBuffer.Used() < sinkBlock * 2 && (size = m_transcoder.GetPacket(&packet)))
+  {
     /* if there is not enough space for another encoded packet enlarge the buffer */
     if (m_encodedBuffer.Free() < size)
       m_encodedBuffer.ReAlloc(m_encodedBuffer.Used() + size);
 
     m_encodedBuffer.Push(packet, size);
+    m_transcoder.PopPacket();
   }
 
   /* if we have enough data to write */
@@ -1345,6 +1366,12 @@ int CSoftAE::RunTranscodeStage(bool hasAudio)
 
     m_encodedBuffer.Shift(NULL, wroteFrames * m_sinkFormat.m_frameSize);
   }
+  else if (!encodedFrames && m_buffer.Used() >= block)
+  {
+    /* the transcoder is behind and our buffer is full, wait for it rather than spin */
+    m_transcoder.WaitForPacket(50);
+  }
+
   return encodedFrames;
 }
 
@@ -30,11 +30,13 @@
 
 #include "Interfaces/ThreadedAE.h"
 #include "Utils/AEBuffer.h"
+#include "Utils/AEUtil.h"
 #include "AEAudioFormat.h"
 #include "AESinkFactory.h"
 
 #include "SoftAEStream.h"
 #include "SoftAESound.h"
+#include "SoftAETranscoder.h"
 
 #include "cores/IAudioCallback.h"
 
@@ -46,6 +48,7 @@ class CSoftAE : public IThreadedAE
 {
 protected:
   friend class CAEFactory;
+  friend class CSoftAEBenchmark; /* runs the stages without the thread, see test/TestSoftAE.cpp */
   CSoftAE();
   virtual ~CSoftAE();
 
@@ -98,6 +101,9 @@ public:
   double GetCacheTime();
   double GetCacheTotal();
 
+  /* stream buffer underruns and producer stalls, summed over every stream since the engine started */
+  void GetStreamStats(unsigned int &underruns, unsigned int &producerStalls);
+
   virtual void EnumerateOutputDevices(AEDeviceList &devices, bool passthrough);
   virtual std::string GetDefaultDevice(bool passthrough);
   virtual bool SupportsRaw();
@@ -193,12 +199,17 @@ private:
   int            m_soundMode;
   bool           m_streamsPlaying;
 
+  /* statistics of the streams that have been freed, see GetStreamStats */
+  unsigned int   m_freedUnderruns;
+  unsigned int   m_freedProducerStalls;
+
   /* this will contain either float, or uint8_t depending on if we are in raw mode or not */
   CAEBuffer      m_buffer;
 
-  /* the encoder */
-  IAEEncoder    *m_encoder;
-  CAEBuffer      m_encodedBuffer;
+  /* the encoder, it runs on the transcoder's thread */
+  IAEEncoder        *m_encoder;
+  CSoftAETranscoder  m_transcoder;
+  CAEBuffer          m_encodedBuffer;
 
   /* the output conversion buffer  */
   uint8_t        *m_converted;
@@ -209,14 +220,18 @@ private:
   /* thread run stages */
 
   /*! \brief Mix UI sounds into the current stream.
+   The volume is applied in the same pass, the buffer is left untouched if no sounds are mixed.
    \param buffer the buffer to mix into.
    \param samples the number of samples in the buffer.
+   \param volume the volume to apply to the mixed buffer.
+   \param clip set to true if any sample of the mixed buffer is outside of [-1,1].
    \return the number of sounds mixed into the buffer.
    */
-  unsigned int MixSounds        (float *buffer, unsigned int samples);
+  unsigned int MixSounds        (float *buffer, unsigned int samples, float volume, bool &clip);
 
   /*! \brief Finalize samples ready for sending to the output device.
    Mixes in any UI sounds, applies volume adjustment, and clamps to [-1,1].
+   The mixing, volume and range check are done in a single pass over the buffer.
    \param buffer the audio data.
    \param samples the number of samples in the buffer.
    \param hasAudio whether we have audio from a stream (true) or silence (false)
@@ -224,6 +239,9 @@ private:
    */
   bool         FinalizeSamples  (float *buffer, unsigned int samples, bool hasAudio);
 
+  CAEUtil::AEMixVolumeFn   m_mixVolumeFn;
+  std::vector<AEMixSource> m_soundSources; /* the sounds being mixed, kept to avoid allocating each period */
+
   CSoftAEStream *m_masterStream;
 
   /*! \brief Run the output stage on the audio.
@@ -245,6 +263,7 @@ private:
   void         RunNormalizeStage (unsigned int channelCount, void *out, unsigned int mixed);
 
   void         RemoveStream(StreamList &streams, CSoftAEStream *stream);
+  void         DeleteStream(CSoftAEStream *stream);
   void         PrintSinks();
 };
 
@@ -20,7 +20,6 @@
 
 #include "Interfaces/AESound.h"
 
-#include <samplerate.h>
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "utils/EndianSwap.h"
@@ -37,56 +36,65 @@
 CSoftAESound::CSoftAESound(const std::string &filename) :
   IAESound         (filename),
   m_filename       (filename),
+  m_buffer         (NULL    ),
   m_volume         (1.0f    ),
   m_inUse          (0       )
 {
-  m_wavLoader.Load(filename);
 }
 
 CSoftAESound::~CSoftAESound()
 {
+  DeInitialize();
 }
 
 void CSoftAESound::DeInitialize()
 {
+  CSingleLock cs(m_critSection);
+  CAESoundCache::GetInstance().Release(m_buffer);
+  m_buffer = NULL;
 }
 
 bool CSoftAESound::IsCompatible()
 {
-  if (!m_wavLoader.IsValid())
+  CSingleLock cs(m_critSection);
+  if (!m_buffer)
     return false;
 
-  return m_wavLoader.IsCompatible(AE.GetSampleRate(), AE.GetChannelLayout());
+  return m_buffer->IsCompatible(AE.GetSampleRate(), AE.GetChannelLayout());
 }
 
 bool CSoftAESound::Initialize()
 {
-  if (!m_wavLoader.IsValid())
-    return false;
-
-  return m_wavLoader.Initialize(
+  /* the cache hands back the converted samples if any sound has used the file in this format */
+  CAESoundBuffer *buffer = CAESoundCache::GetInstance().Acquire(
+    m_filename,
     AE.GetSampleRate   (),
     AE.GetChannelLayout(),
     AE.GetStdChLayout  ()
   );
+
+  CSingleLock cs(m_critSection);
+  CAESoundCache::GetInstance().Release(m_buffer);
+  m_buffer = buffer;
+  return m_buffer != NULL;
 }
 
 unsigned int CSoftAESound::GetSampleCount()
 {
   CSingleLock cs(m_critSection);
-  if (m_wavLoader.IsValid())
-    return m_wavLoader.GetSampleCount();
+  if (m_buffer)
+    return m_buffer->GetSampleCount();
   return 0;
 }
 
 float* CSoftAESound::GetSamples()
 {
   CSingleLock cs(m_critSection);
-  if (!m_wavLoader.IsValid())
+  if (!m_buffer)
     return NULL;
 
   ++m_inUse;
-  return m_wavLoader.GetSamples();
+  return m_buffer->GetSamples();
 }
 
 void CSoftAESound::ReleaseSamples()
@@ -23,7 +23,7 @@
 #include "threads/CriticalSection.h"
 #include "threads/SharedSection.h"
 #include "Interfaces/AESound.h"
-#include "Utils/AEWAVLoader.h"
+#include "Utils/AESoundCache.h"
 
 class CSoftAESound : public IAESound
 {
@@ -50,7 +50,7 @@ public:
 private:
   CCriticalSection m_critSection;
   std::string      m_filename;
-  CAEWAVLoader     m_wavLoader;
+  CAESoundBuffer  *m_buffer;     /* the samples in the current output format, shared through CAESoundCache */
   float            m_volume;
   int              m_inUse;
 };
@@ -42,12 +42,17 @@ CSoftAEStream::CSoftAEStream(enum AEDataFormat dataFormat, unsigned int sampleRa
   m_delete          (false),
   m_volume          (1.0f ),
   m_rgain           (1.0f ),
-  m_refillBuffer    (0    ),
+  m_refilling       (false),
   m_convertFn       (NULL ),
-  m_ssrc            (NULL ),
-  m_framesBuffered  (0    ),
+  m_resampleBuffer  (NULL ),
+  m_resampleFrames  (0    ),
+  m_framesProduced  (0    ),
+  m_framesConsumed  (0    ),
   m_newPacket       (NULL ),
+  m_packetsPerProcess(0   ),
   m_packet          (NULL ),
+  m_underruns       (0    ),
+  m_producerStalls  (0    ),
   m_vizPacketPos    (NULL ),
   m_draining        (false),
   m_vizBufferSamples(0    ),
@@ -55,8 +60,6 @@ CSoftAEStream::CSoftAEStream(enum AEDataFormat dataFormat, unsigned int sampleRa
   m_fadeRunning     (false),
   m_slave           (NULL )
 {
-  m_ssrcData.data_out = NULL;
-
   m_initDataFormat        = dataFormat;
   m_initSampleRate        = sampleRate;
   m_initEncodedSampleRate = encodedSampleRate;
@@ -91,6 +94,9 @@ void CSoftAEStream::InitializeRemap()
       m_aeChannelLayout = AE.GetChannelLayout();
       m_samplesPerFrame = AE.GetChannelLayout().Count();
       m_aeBytesPerFrame = AE_IS_RAW(m_initDataFormat) ? m_bytesPerFrame : (m_samplesPerFrame * sizeof(float));
+
+      /* the packets are sized for the output layout */
+      AllocPackets();
     }
   }
 }
@@ -108,8 +114,8 @@ void CSoftAEStream::Initialize()
 
     if (m_resample)
     {
-      _aligned_free(m_ssrcData.data_out);
-      m_ssrcData.data_out = NULL;
+      _aligned_free(m_resampleBuffer);
+      m_resampleBuffer = NULL;
     }
   }
 
@@ -148,7 +154,7 @@ void CSoftAEStream::Initialize()
     // set the waterlevel to 6.25 percent of the number of frames per second.
     m_waterLevel = AE.GetSampleRate() / 16;
   }
-  m_refillBuffer    = m_waterLevel;
+  m_refilling      = true;
 
   m_format.m_dataFormat    = useDataFormat;
   m_format.m_sampleRate    = m_initSampleRate;
@@ -174,8 +180,6 @@ void CSoftAEStream::Initialize()
     m_newPacket->data.Alloc(m_format.m_frameSamples * sizeof(float));
   }
 
-  m_packet = NULL;
-
   m_inputBuffer.Alloc(m_format.m_frames * m_format.m_frameSize);
 
   m_resample      = (m_forceResample || m_initSampleRate != AE.GetSampleRate()) && !AE_IS_RAW(m_initDataFormat);
@@ -198,29 +202,49 @@ void CSoftAEStream::Initialize()
   /* if we need to resample, set it up */
   if (m_resample)
   {
-    int err;
-    m_ssrc                   = src_new(!m_lowLatency ? SRC_SINC_MEDIUM_QUALITY : SRC_SINC_FASTEST, m_initChannelLayout.Count(), &err);
-    m_ssrcData.data_in       = m_convertBuffer;
     m_internalRatio          = (double)AE.GetSampleRate() / (double)m_initSampleRate;
-    m_ssrcData.src_ratio     = m_internalRatio;
-    m_ssrcData.data_out      = (float*)_aligned_malloc(m_format.m_frameSamples * (int)std::ceil(m_ssrcData.src_ratio) * sizeof(float), 16);
-    m_ssrcData.output_frames = m_format.m_frames * (long)std::ceil(m_ssrcData.src_ratio);
-    m_ssrcData.end_of_input  = 0;
+    m_resampler.Initialize(m_initChannelLayout.Count(), m_internalRatio, !m_lowLatency ? CAEResample::QUALITY_MEDIUM : CAEResample::QUALITY_FAST);
+    m_resampleBuffer         = (float*)_aligned_malloc(m_format.m_frameSamples * (int)std::ceil(m_internalRatio) * sizeof(float), 16);
+    m_resampleFrames         = m_format.m_frames * (unsigned int)std::ceil(m_internalRatio);
     // we must buffer the same amount as before but taking the source sample rate into account
     // there is no reason to decrease the buffer for upsampling
     if (m_internalRatio < 1)
-    {
       m_waterLevel *= (1.0 / m_internalRatio);
-      m_refillBuffer = m_waterLevel;
-    }
   }
 
+  AllocPackets();
+
   m_limiter.SetSamplerate(AE.GetSampleRate());
 
   m_chLayoutCount = m_format.m_channelLayout.Count();
   m_valid = true;
 }
 
+void CSoftAEStream::AllocPackets()
+{
+  /* a full packet holds m_format.m_frames frames once resampled */
+  if (m_resample)
+    m_packetsPerProcess = m_resampleFrames / m_format.m_frames + 1;
+  else
+    m_packetsPerProcess = 2;
+
+  /*
+    enough packets to reach the water level plus some slack for ProcessFrameBuffer,
+    SetResampleRatio can raise m_packetsPerProcess but it can not realloc the packets
+  */
+  unsigned int count = (m_waterLevel + m_format.m_frames - 1) / m_format.m_frames + m_packetsPerProcess * 2 + 1;
+  m_outBuffer.Alloc(count);
+  m_packet = NULL;
+
+  for (unsigned int i = 0; i < m_outBuffer.Size(); ++i)
+  {
+    PPacket &pkt = m_outBuffer[i];
+    pkt.data.Alloc(m_format.m_frames * m_aeBytesPerFrame);
+    if (!AE_IS_RAW(m_initDataFormat))
+      pkt.vizData.Alloc(m_format.m_frames * 2 * sizeof(float));
+  }
+}
+
 void CSoftAEStream::Destroy()
 {
   CExclusiveLock lock(m_lock);
@@ -238,15 +262,12 @@ CSoftAEStream::~CSoftAEStream()
 
   if (m_resample)
   {
-    _aligned_free(m_ssrcData.data_out);
-    src_delete(m_ssrc);
-    m_ssrc = NULL;
+    _aligned_free(m_resampleBuffer);
   }
 
   delete m_newPacket;
-  delete m_packet;
 
-  CLog::Log(LOGDEBUG, "CSoftAEStream::~CSoftAEStream - Destructed");
+  CLog::Log(LOGDEBUG, "CSoftAEStream::~CSoftAEStream - Destructed, %u underruns, %u producer stalls", m_underruns, m_producerStalls);
 }
 
 unsigned int CSoftAEStream::GetSpace()
@@ -254,15 +275,21 @@ unsigned int CSoftAEStream::GetSpace()
   if (!m_valid || m_draining)
     return 0;
 
-  if (m_framesBuffered >= m_waterLevel)
+  unsigned int framesBuffered = GetFramesBuffered();
+  if (framesBuffered >= m_waterLevel)
     return 0;
 
-  return m_inputBuffer.Free() + (std::max(0U, (m_waterLevel - m_framesBuffered)) * m_format.m_frameSize);
+  /* the AE thread has not handed back enough packets, only the input buffer can take data */
+  if (m_outBuffer.Free() < m_packetsPerProcess)
+    return m_inputBuffer.Free();
+
+  return m_inputBuffer.Free() + (std::max(0U, (m_waterLevel - framesBuffered)) * m_format.m_frameSize);
 }
 
 unsigned int CSoftAEStream::AddData(void *data, unsigned int size)
 {
-  CExclusiveLock lock(m_lock);
+  /* shared as the AE thread only reads the packets we have pushed */
+  CSharedLock lock(m_lock);
   if (!m_valid || size == 0 || data == NULL)
     return 0;
 
@@ -270,7 +297,7 @@ unsigned int CSoftAEStream::AddData(void *data, unsigned int size)
   if (m_draining)
   {
     /* if the stream has finished draining, cork it */
-    if (m_packet && !m_packet->data.Used() && m_outBuffer.empty())
+    if (m_outBuffer.Empty())
       m_draining = false;
     else
       return 0;
@@ -297,13 +324,17 @@ unsigned int CSoftAEStream::AddData(void *data, unsigned int size)
     {
       unsigned int consumed = ProcessFrameBuffer();
       m_inputBuffer.Shift(NULL, consumed);
+
+      /* the input buffer is still full, take the rest later */
+      if (consumed == 0)
+        break;
     }
   }
 
   lock.Leave();
 
   /* if the stream is flagged to autoStart when the buffer is full, then do it */
-  if (m_autoStart && m_framesBuffered >= m_waterLevel)
+  if (m_autoStart && GetFramesBuffered() >= m_waterLevel)
     Resume();
 
   return taken;
@@ -314,6 +345,13 @@ unsigned int CSoftAEStream::ProcessFrameBuffer()
   uint8_t     *data;
   unsigned int frames, consumed, sampleSize;
 
+  /* wait for the AE thread if the packets this call may fill are not free */
+  if (m_outBuffer.Free() < m_packetsPerProcess)
+  {
+    ++m_producerStalls;
+    return 0;
+  }
+
   /* convert the data if we need to */
   unsigned int samples;
   if (m_convert)
@@ -339,12 +377,10 @@ unsigned int CSoftAEStream::ProcessFrameBuffer()
   /* resample it if we need to */
   if (m_resample)
   {
-    m_ssrcData.input_frames = samples / m_chLayoutCount;
-    if (src_process(m_ssrc, &m_ssrcData) != 0)
-      return 0;
-    data     = (uint8_t*)m_ssrcData.data_out;
-    frames   = m_ssrcData.output_frames_gen;
-    consumed = m_ssrcData.input_frames_used * m_bytesPerFrame;
+    unsigned int used;
+    frames   = m_resampler.Resample(m_convertBuffer, samples / m_chLayoutCount, used, m_resampleBuffer, m_resampleFrames);
+    data     = (uint8_t*)m_resampleBuffer;
+    consumed = used * m_bytesPerFrame;
     if (!frames)
       return consumed;
 
@@ -357,16 +393,8 @@ unsigned int CSoftAEStream::ProcessFrameBuffer()
     consumed = frames * m_bytesPerFrame;
   }
 
-  if (m_refillBuffer)
-  {
-    if (frames > m_refillBuffer)
-      m_refillBuffer = 0;
-    else
-      m_refillBuffer -= frames;
-  }
-
   /* buffer the data */
-  m_framesBuffered += frames;
+  m_framesProduced += frames;
   const unsigned int inputBlockSize = m_format.m_frames * m_format.m_channelLayout.Count() * sampleSize;
 
   size_t remaining = samples * sampleSize;
@@ -381,22 +409,25 @@ unsigned int CSoftAEStream::ProcessFrameBuffer()
     if ((!m_draining || remaining) && m_newPacket->data.Free() > 0)
       continue;
 
+    /* take the next free packet, the check above makes sure there is one */
+    PPacket *pkt = m_outBuffer.GetWriteSlot();
+    pkt->data   .Empty();
+    pkt->data   .CursorReset();
+    pkt->vizData.Empty();
+    pkt->vizData.CursorReset();
+
     /* if we have a full block of data */
     if (AE_IS_RAW(m_initDataFormat))
     {
-      m_outBuffer.push_back(m_newPacket);
-      m_newPacket = new PPacket();
-      m_newPacket->data.Alloc(inputBlockSize);
+      pkt->data.Push(m_newPacket->data.Raw(inputBlockSize), m_newPacket->data.Used());
+      m_outBuffer.Push();
+      m_newPacket->data.Empty();
       continue;
     }
 
-    /* make a new packet for downmix/remap */
-    PPacket *pkt = new PPacket();
-
     /* downmix/remap the data */
     size_t frames = m_newPacket->data.Used() / m_format.m_channelLayout.Count() / sizeof(float);
     size_t used   = frames * m_aeChannelLayout.Count() * sizeof(float);
-    pkt->data.Alloc(used);
     m_remap.Remap(
       (float*)m_newPacket->data.Raw (m_newPacket->data.Used()),
       (float*)pkt        ->data.Take(used),
@@ -407,7 +438,6 @@ unsigned int CSoftAEStream::ProcessFrameBuffer()
     if (m_audioCallback)
     {
       size_t vizUsed = frames * 2 * sizeof(float);
-      pkt->vizData.Alloc(vizUsed);
       m_vizRemap.Remap(
         (float*)m_newPacket->data   .Raw (m_newPacket->data.Used()),
         (float*)pkt        ->vizData.Take(vizUsed),
@@ -415,8 +445,8 @@ unsigned int CSoftAEStream::ProcessFrameBuffer()
       );
     }
 
-    /* add the packet to the output */
-    m_outBuffer.push_back(pkt);
+    /* hand the packet to the AE thread */
+    m_outBuffer.Push();
     m_newPacket->data.Empty();
   }
 
@@ -425,7 +455,8 @@ unsigned int CSoftAEStream::ProcessFrameBuffer()
 
 uint8_t* CSoftAEStream::GetFrame()
 {
-  CExclusiveLock lock(m_lock);
+  /* shared as AddData only writes packets we have not been handed yet */
+  CSharedLock lock(m_lock);
 
   /* if we are fading, this runs even if we have underrun as it is time based */
   if (m_fadeRunning)
@@ -444,18 +475,32 @@ uint8_t* CSoftAEStream::GetFrame()
     }
   }
 
-  /* if we have been deleted or are refilling but not draining */
-  if (!m_valid || m_delete || (m_refillBuffer && !m_draining))
+  /* if we have been deleted */
+  if (!m_valid || m_delete)
     return NULL;
 
-  /* if the packet is empty, advance to the next one */
-  if (!m_packet || m_packet->data.CursorEnd())
+  /* if we are refilling but not draining */
+  if (m_refilling && !m_draining)
+  {
+    if (GetFramesBuffered() < m_waterLevel)
+      return NULL;
+    m_refilling = false;
+  }
+
+  /* if the packet is empty, hand it back, the frame we returned last is no longer in use */
+  if (m_packet && m_packet->data.CursorEnd())
   {
-    delete m_packet;
+    m_outBuffer.Pop();
     m_packet = NULL;
+  }
+
+  /* advance to the next packet */
+  if (!m_packet)
+  {
+    m_packet = m_outBuffer.GetReadSlot();
 
     /* no more packets, return null */
-    if (m_outBuffer.empty())
+    if (!m_packet)
     {
       if (m_draining)
         return NULL;
@@ -463,15 +508,11 @@ uint8_t* CSoftAEStream::GetFrame()
       {
         /* underrun, we need to refill our buffers */
         CLog::Log(LOGDEBUG, "CSoftAEStream::GetFrame - Underrun");
-        ASSERT(m_waterLevel > m_framesBuffered);
-        m_refillBuffer = m_waterLevel - m_framesBuffered;
+        ++m_underruns;
+        m_refilling = true;
         return NULL;
       }
     }
-
-    /* get the next packet */
-    m_packet = m_outBuffer.front();
-    m_outBuffer.pop_front();
   }
 
   /* fetch one frame of data */
@@ -490,7 +531,7 @@ uint8_t* CSoftAEStream::GetFrame()
     }
   }
 
-  --m_framesBuffered;
+  ++m_framesConsumed;
   return ret;
 }
 
@@ -501,7 +542,7 @@ double CSoftAEStream::GetDelay()
 
   double delay = AE.GetDelay();
   delay += (double)(m_inputBuffer.Used() / m_format.m_frameSize) / (double)m_format.m_sampleRate;
-  delay += (double)m_framesBuffered                              / (double)AE.GetSampleRate();
+  delay += (double)GetFramesBuffered()                            / (double)AE.GetSampleRate();
   return delay;
 }
 
@@ -512,7 +553,7 @@ double CSoftAEStream::GetCacheTime()
 
   double time = AE.GetCacheTime();
   time += (double)(m_inputBuffer.Used() / m_format.m_frameSize) / (double)m_format.m_sampleRate;
-  time += (double)m_framesBuffered                              / (double)AE.GetSampleRate();
+  time += (double)GetFramesBuffered()                            / (double)AE.GetSampleRate();
   return time;
 }
 
@@ -553,7 +594,7 @@ void CSoftAEStream::Drain()
 bool CSoftAEStream::IsDrained()
 {
   CSharedLock lock(m_lock);
-  return (m_draining && !m_packet && m_outBuffer.empty());
+  return (m_draining && m_outBuffer.Empty());
 }
 
 void CSoftAEStream::Flush()
@@ -570,32 +611,25 @@ void CSoftAEStream::InternalFlush()
 {
   /* reset the resampler */
   if (m_resample)
-  {
-    m_ssrcData.end_of_input = 0;
-    src_reset(m_ssrc);
-  }
+    m_resampler.Reset();
 
   /* invalidate any incoming samples */
   m_newPacket->data.Empty();
 
   /*
-    clear the current buffered packet, we cant delete the data as it may be
-    in use by the AE thread, so we just seek to the end of the buffer
+    clear the current buffered packet, we cant hand it back yet as its data may
+    be in use by the AE thread, so we just seek to the end of the buffer
   */
   if (m_packet)
-    m_packet->data.CursorSeek(m_packet->data.Size());
+    m_packet->data.CursorSeek(m_packet->data.Used());
 
   /* clear any other buffered packets */
-  while (!m_outBuffer.empty())
-  {
-    PPacket *p = m_outBuffer.front();
-    m_outBuffer.pop_front();
-    delete p;
-  }
+  m_outBuffer.Drop(m_packet ? 1 : 0);
 
   /* reset our counts */
-  m_framesBuffered = 0;
-  m_refillBuffer   = m_waterLevel;
+  m_framesProduced = 0;
+  m_framesConsumed = 0;
+  m_refilling      = true;
   m_draining       = false;
 }
 
@@ -605,7 +639,7 @@ double CSoftAEStream::GetResampleRatio()
     return 1.0f;
 
   CSharedLock lock(m_lock);
-  return m_ssrcData.src_ratio;
+  return m_resampler.GetRatio();
 }
 
 bool CSoftAEStream::SetResampleRatio(double ratio)
@@ -613,21 +647,23 @@ bool CSoftAEStream::SetResampleRatio(double ratio)
   if (!m_resample)
     return false;
 
-  CSharedLock lock(m_lock);
-
-  int oldRatioInt = (int)std::ceil(m_ssrcData.src_ratio);
+  /* exclusive as AddData uses the resampler with the lock shared */
+  CExclusiveLock lock(m_lock);
 
   m_resampleRatio = ratio;
 
-  src_set_ratio(m_ssrc, m_resampleRatio * m_internalRatio);
-  m_ssrcData.src_ratio = m_resampleRatio * m_internalRatio;
+  /* the resampler ramps to the new ratio, it does not need a reset */
+  const double newRatio = m_resampleRatio * m_internalRatio;
+  if (!m_resampler.SetRatio(newRatio))
+    return false;
 
   //Check the resample buffer size and resize if necessary.
-  if (oldRatioInt < std::ceil(m_ssrcData.src_ratio))
+  if (m_resampleFrames < m_format.m_frames * std::ceil(newRatio))
   {
-    _aligned_free(m_ssrcData.data_out);
-    m_ssrcData.data_out      = (float*)_aligned_malloc(m_format.m_frameSamples * (int)std::ceil(m_ssrcData.src_ratio) * sizeof(float), 16);
-    m_ssrcData.output_frames = m_format.m_frames * (long)std::ceil(m_ssrcData.src_ratio);
+    _aligned_free(m_resampleBuffer);
+    m_resampleBuffer         = (float*)_aligned_malloc(m_format.m_frameSamples * (int)std::ceil(newRatio) * sizeof(float), 16);
+    m_resampleFrames         = m_format.m_frames * (unsigned int)std::ceil(newRatio);
+    m_packetsPerProcess      = m_resampleFrames / m_format.m_frames + 1;
   }
   return true;
 }
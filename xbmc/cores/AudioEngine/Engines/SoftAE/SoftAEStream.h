@@ -19,9 +19,6 @@
  *
  */
 
-#include <samplerate.h>
-#include <list>
-
 #include "threads/SharedSection.h"
 
 #include "AEAudioFormat.h"
@@ -30,12 +27,15 @@
 #include "Utils/AERemap.h"
 #include "Utils/AEBuffer.h"
 #include "Utils/AELimiter.h"
+#include "Utils/AEResample.h"
+#include "Utils/AESPSCQueue.h"
 
 class IAEPostProc;
 class CSoftAEStream : public IAEStream
 {
 protected:
   friend class CSoftAE;
+  friend class CSoftAEBenchmark;
   CSoftAEStream(enum AEDataFormat format, unsigned int sampleRate, unsigned int encodedSamplerate, CAEChannelInfo channelLayout, unsigned int options);
   virtual ~CSoftAEStream();
 
@@ -49,11 +49,15 @@ protected:
   bool IsValid    () { return m_valid;  }
   const bool IsRaw() const { return AE_IS_RAW(m_initDataFormat); }  
 
+  /* buffer statistics, underruns are counted on the AE thread, stalls on the thread adding data */
+  unsigned int GetUnderruns     () const { return m_underruns;      }
+  unsigned int GetProducerStalls() const { return m_producerStalls; }
+
 public:
   virtual unsigned int      GetSpace        ();
   virtual unsigned int      AddData         (void *data, unsigned int size);
   virtual double            GetDelay        ();
-  virtual bool              IsBuffering     () { return m_refillBuffer > 0; }
+  virtual bool              IsBuffering     () { return m_refilling && GetFramesBuffered() < m_waterLevel; }
   virtual double            GetCacheTime    ();
   virtual double            GetCacheTotal   ();
 
@@ -89,9 +93,12 @@ public:
   virtual void              RegisterSlave(IAEStream *stream);
 private:
   void InternalFlush();
-  void CheckResampleBuffers();
+  void AllocPackets();
 
-  CSharedSection    m_lock;
+  /* the producer only writes m_framesProduced and the AE thread only writes m_framesConsumed */
+  inline unsigned int GetFramesBuffered() const { return m_framesProduced - m_framesConsumed; }
+
+  CSharedSection    m_lock;  /* exclusive to reconfigure or flush, AddData and GetFrame only share it */
   enum AEDataFormat m_initDataFormat;
   unsigned int      m_initSampleRate;
   unsigned int      m_initEncodedSampleRate;
@@ -118,7 +125,7 @@ private:
   float                   m_volume;        /* the volume level */
   float                   m_rgain;         /* replay gain level */
   unsigned int            m_waterLevel;    /* the fill level to fall below before calling the data callback */
-  unsigned int            m_refillBuffer;  /* how many frames that need to be buffered before we return any frames */
+  volatile bool           m_refilling;     /* true if we need to buffer m_waterLevel frames before we return any frames */
 
   CAEConvert::AEConvertToFn m_convertFn;
 
@@ -128,13 +135,25 @@ private:
   unsigned int        m_samplesPerFrame;
   CAEChannelInfo      m_aeChannelLayout;
   unsigned int        m_aeBytesPerFrame;
-  SRC_STATE          *m_ssrc;
-  SRC_DATA            m_ssrcData;
-  unsigned int        m_framesBuffered;
-  std::list<PPacket*> m_outBuffer;
+  CAEResample         m_resampler;
+  float              *m_resampleBuffer; /* the resampled frames, m_resampleFrames long */
+  unsigned int        m_resampleFrames;
+  volatile unsigned int m_framesProduced;
+  volatile unsigned int m_framesConsumed;
   unsigned int        ProcessFrameBuffer();
   PPacket            *m_newPacket;
+
+  /*
+    remapped packets ready for the AE thread, AddData fills them and GetFrame
+    reads them without locking each other out. m_packet is the slot GetFrame
+    is reading, it is only handed back on the call after its last frame as
+    the AE thread may still be using that frame.
+  */
+  CAESPSCQueue<PPacket> m_outBuffer;
+  unsigned int        m_packetsPerProcess; /* the most packets one ProcessFrameBuffer call can fill */
   PPacket            *m_packet;
+  volatile unsigned int m_underruns;
+  volatile unsigned int m_producerStalls;
   uint8_t            *m_packetPos;
   float              *m_vizPacketPos;
   bool                m_paused;
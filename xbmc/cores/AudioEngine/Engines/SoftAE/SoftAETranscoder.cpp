@@ -0,0 +1,194 @@
+/*
+ *      Copyright (C) 2010-2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SoftAETranscoder.h"
+#include "Interfaces/AEEncoder.h"
+#include "threads/SystemClock.h"
+#include "utils/log.h"
+
+#include <string.h>
+
+CSoftAETranscoder::CSoftAETranscoder() :
+  CThread        ("SoftAETranscoder"),
+  m_encoder      (NULL),
+  m_frames       (0   ),
+  m_blockSize    (0   ),
+  m_sampleRateMul(0.0 ),
+  m_codecDelay   (0.0 ),
+  m_queued       (0   )
+{
+}
+
+CSoftAETranscoder::~CSoftAETranscoder()
+{
+  Deinitialize();
+}
+
+void CSoftAETranscoder::Initialize(IAEEncoder *encoder, const AEAudioFormat &format, unsigned int depth)
+{
+  Deinitialize();
+
+  m_encoder       = encoder;
+  m_frames        = format.m_frames;
+  m_blockSize     = format.m_frames * format.m_frameSize;
+  m_sampleRateMul = 1.0 / format.m_sampleRate;
+  /* nothing has been encoded yet so this is only what the codec holds back */
+  m_codecDelay    = m_encoder->GetDelay(0) * format.m_sampleRate;
+
+  m_input .Alloc(depth);
+  m_output.Alloc(depth);
+  for (unsigned int i = 0; i < m_input.Size(); ++i)
+    m_input[i].data.resize(m_blockSize);
+
+  Create();
+  SetPriority(THREAD_PRIORITY_ABOVE_NORMAL);
+}
+
+void CSoftAETranscoder::Deinitialize()
+{
+  StopWorker();
+  m_encoder = NULL;
+  m_input .Reset();
+  m_output.Reset();
+  m_queued  = 0;
+}
+
+void CSoftAETranscoder::Reset()
+{
+  if (!m_encoder)
+    return;
+
+  StopWorker();
+  m_input .Reset();
+  m_output.Reset();
+  m_queued = 0;
+  m_encoder->Reset();
+  m_packetReady.Reset();
+  Create();
+  SetPriority(THREAD_PRIORITY_ABOVE_NORMAL);
+}
+
+void CSoftAETranscoder::StopWorker()
+{
+  /* dont wait out the idle timeout */
+  StopThread(false);
+  m_wake.Set();
+  StopThread();
+}
+
+uint8_t* CSoftAETranscoder::GetInputBuffer()
+{
+  Block *block = m_input.GetWriteSlot();
+  return block ? &block->data[0] : NULL;
+}
+
+void CSoftAETranscoder::PushInput()
+{
+  m_input.Push();
+  ++m_queued;
+  m_wake.Set();
+}
+
+unsigned int CSoftAETranscoder::GetPacket(uint8_t **data)
+{
+  /* skip the blocks the encoder had no output for */
+  Block *block;
+  while ((block = m_output.GetReadSlot()) && !block->size)
+    PopPacket();
+
+  if (!block)
+    return 0;
+
+  *data = &block->data[0];
+  return block->size;
+}
+
+void CSoftAETranscoder::PopPacket()
+{
+  m_output.Pop();
+  --m_queued;
+  m_wake.Set();
+}
+
+bool CSoftAETranscoder::WaitForPacket(unsigned int timeout)
+{
+  /* the event can be left set by a packet that was already taken */
+  XbmcThreads::EndTime end(timeout);
+  while (m_output.Empty())
+  {
+    unsigned int left = end.MillisLeft();
+    if (!left || !m_packetReady.WaitMSec(left))
+      break;
+  }
+  return !m_output.Empty();
+}
+
+double CSoftAETranscoder::GetDelay(unsigned int encodedFrames) const
+{
+  if (!m_encoder)
+    return 0.0;
+
+  /* every queued block, encoded or not, is m_frames of audio */
+  return (m_codecDelay + (double)m_queued * m_frames + encodedFrames) * m_sampleRateMul;
+}
+
+double CSoftAETranscoder::GetCacheTotal(unsigned int encodedFrames) const
+{
+  if (!m_encoder)
+    return 0.0;
+
+  const unsigned int queued = m_input.Size() + m_output.Size();
+  return (m_codecDelay + (double)queued * m_frames + encodedFrames) * m_sampleRateMul;
+}
+
+void CSoftAETranscoder::Process()
+{
+  CLog::Log(LOGDEBUG, "CSoftAETranscoder::Process - Thread Started");
+
+  while (!m_bStop)
+  {
+    Block *in  = m_input .GetReadSlot();
+    Block *out = m_output.GetWriteSlot();
+    if (!in || !out)
+    {
+      m_wake.WaitMSec(100);
+      continue;
+    }
+
+    m_encoder->Encode((float*)&in->data[0], m_frames);
+
+    m_input.Pop();
+
+    /* an empty packet is still queued so the engine sees the block leave */
+    uint8_t *packet;
+    const int size = m_encoder->GetData(&packet);
+    out->size = size > 0 ? size : 0;
+    if (out->size)
+    {
+      if (out->data.size() < out->size)
+        out->data.resize(out->size);
+      memcpy(&out->data[0], packet, out->size);
+    }
+    m_output.Push();
+    m_packetReady.Set();
+  }
+
+  CLog::Log(LOGDEBUG, "CSoftAETranscoder::Process - Thread Stopped");
+}
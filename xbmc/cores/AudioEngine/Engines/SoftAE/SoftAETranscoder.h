@@ -0,0 +1,102 @@
+#pragma once
+/*
+ *      Copyright (C) 2010-2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <vector>
+#include <stdint.h>
+
+#include "threads/Thread.h"
+#include "threads/Event.h"
+#include "AEAudioFormat.h"
+#include "Utils/AESPSCQueue.h"
+
+class IAEEncoder;
+
+/*
+  Runs an encoder on its own thread for the SoftAE transcode stage.
+
+  The engine thread queues blocks of PCM in the encoder's input format and
+  collects the encoded IEC61937 packets, so a slow encode overlaps the sink
+  write instead of delaying it. Both queues are small and bounded, the latency
+  they add is reported by GetDelay.
+*/
+class CSoftAETranscoder : private CThread
+{
+public:
+  CSoftAETranscoder();
+  virtual ~CSoftAETranscoder();
+
+  /*!
+   \brief Start encoding on the worker thread.
+   \param encoder the initialized encoder, it is not owned and must outlive Deinitialize.
+   \param format the format the encoder was initialized with.
+   \param depth the number of blocks that can be queued in each direction.
+   */
+  void Initialize(IAEEncoder *encoder, const AEAudioFormat &format, unsigned int depth = 2);
+  void Deinitialize();
+
+  /* stop the worker, drop everything queued and reset the encoder */
+  void Reset();
+
+  bool IsInitialized() const { return m_encoder != NULL; }
+
+  /* engine side, returns a block of m_frames input frames to fill, or NULL if the queue is full */
+  uint8_t* GetInputBuffer();
+  void     PushInput();
+
+  /* engine side, returns the size of the oldest encoded packet, or 0 if there is none */
+  unsigned int GetPacket(uint8_t **data);
+  void         PopPacket();
+
+  /* wait for the worker to finish a packet, returns false on timeout */
+  bool WaitForPacket(unsigned int timeout);
+
+  /*!
+   \brief The delay of the transcoder in seconds.
+   \param encodedFrames the frames of encoded data the caller holds on to after GetPacket.
+   */
+  double GetDelay(unsigned int encodedFrames) const;
+  double GetCacheTotal(unsigned int encodedFrames) const;
+
+protected:
+  virtual void Process();
+
+private:
+  typedef struct
+  {
+    std::vector<uint8_t> data;
+    unsigned int         size;
+  } Block;
+
+  void StopWorker();
+
+  IAEEncoder          *m_encoder;
+  unsigned int         m_frames;       /* frames per block */
+  unsigned int         m_blockSize;    /* bytes per input block */
+  double               m_sampleRateMul;
+  double               m_codecDelay;   /* frames the codec itself holds back */
+  unsigned int         m_queued;       /* blocks pushed and not yet popped, only changed by the engine */
+
+  CAESPSCQueue<Block>  m_input;
+  CAESPSCQueue<Block>  m_output;
+  CEvent               m_wake;         /* an input was queued or a packet was taken */
+  CEvent               m_packetReady;
+};
+
@@ -0,0 +1,306 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+
+/* SoftAE is not built on darwin */
+#if !defined(TARGET_DARWIN)
+
+#include "cores/AudioEngine/AEFactory.h"
+#include "cores/AudioEngine/Engines/SoftAE/SoftAE.h"
+#include "cores/AudioEngine/Engines/SoftAE/SoftAEStream.h"
+#include "cores/AudioEngine/Utils/AEConvert.h"
+#include "cores/AudioEngine/Utils/AEUtil.h"
+#include "filesystem/File.h"
+#include "settings/AdvancedSettings.h"
+#include "settings/GUISettings.h"
+#include "test/TestUtils.h"
+#include "threads/SingleLock.h"
+#include "utils/EndianSwap.h"
+#include "utils/TimeUtils.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* one benchmark configuration, every stream is fed the same format */
+struct BenchmarkCase
+{
+  const char        *name;
+  const char        *device;     /* NULL:freerun or PROFILER:Profiler */
+  int                channels;   /* audiooutput.channels, limits the sink layout */
+  unsigned int       sinkRate;   /* forced sink rate, 0 follows the streams */
+  unsigned int       streams;
+  enum AEDataFormat  format;
+  unsigned int       sampleRate;
+  enum AEStdChLayout layout;
+  double             ratio;      /* resample ratio set on the streams, 0 leaves them alone */
+  bool               sound;      /* keep a GUI sound playing */
+  float              volume;     /* master volume */
+};
+
+/* time spent in each stage in ns per output frame */
+struct BenchmarkResult
+{
+  double       input;  /* AddData, the streams convert, resample and remap */
+  double       stream; /* the stream stage mixing the streams */
+  double       output; /* the output stage mixing sounds, applying the volume and converting for the sink */
+  unsigned int frames;
+  unsigned int underruns;
+};
+
+/*
+  drives the SoftAE stages from the calling thread instead of CSoftAE::Run, the
+  stream, stream stage and output stage are run in turn so every run processes
+  exactly the same data no matter how fast the host is
+*/
+class CSoftAEBenchmark
+{
+public:
+  CSoftAEBenchmark(CSoftAE *ae) : m_ae(ae) {}
+
+  void Run(const BenchmarkCase &c, unsigned int seconds, const CStdString &soundFile, BenchmarkResult &result)
+  {
+    memset(&result, 0, sizeof(result));
+
+    g_guiSettings.SetString("audiooutput.audiodevice", c.device);
+    g_guiSettings.SetInt   ("audiooutput.channels"   , c.channels);
+    g_advancedSettings.m_audioResample = c.sinkRate;
+
+    /* add the streams and open the sink for them like MakeStream would */
+    std::vector<CSoftAEStream*> streams;
+    CSingleLock streamLock(m_ae->m_streamLock);
+    for (unsigned int i = 0; i < c.streams; ++i)
+    {
+      CSoftAEStream *stream = new CSoftAEStream(c.format, c.sampleRate, 0, CAEChannelInfo(c.layout), c.ratio > 0.0 ? AESTREAM_FORCE_RESAMPLE : 0);
+      m_ae->m_newStreams.push_back(stream);
+      streams.push_back(stream);
+    }
+    streamLock.Leave();
+    m_ae->InternalOpenSink();
+
+    for (unsigned int i = 0; i < streams.size(); ++i)
+    {
+      ASSERT_TRUE(streams[i]->IsValid());
+      if (c.ratio > 0.0)
+        ASSERT_TRUE(streams[i]->SetResampleRatio(c.ratio));
+    }
+
+    IAESound *sound = NULL;
+    if (c.sound)
+    {
+      m_ae->SetSoundMode(AE_SOUND_ALWAYS);
+      ASSERT_TRUE((sound = m_ae->MakeSound(soundFile)) != NULL);
+    }
+    m_ae->SetVolume(c.volume);
+
+    const unsigned int frames = m_ae->GetSampleRate() * seconds;
+    unsigned int underruns, producerStalls;
+    m_ae->GetStreamStats(underruns, producerStalls);
+
+    /* a second of input, interleaved sines on every channel */
+    const unsigned int inChannels    = CAEChannelInfo(c.layout).Count();
+    const unsigned int bytesPerFrame = (CAEUtil::DataFormatToBits(c.format) >> 3) * inChannels;
+    std::vector<float>   samples(c.sampleRate * inChannels);
+    std::vector<uint8_t> data   (c.sampleRate * bytesPerFrame);
+    for (unsigned int i = 0; i < samples.size(); ++i)
+      samples[i] = 0.25f * (float)sin(2.0 * M_PI * (440.0 + 110.0 * (i % inChannels)) * (i / inChannels) / c.sampleRate);
+
+    if (c.format == AE_FMT_FLOAT)
+      memcpy(&data[0], &samples[0], data.size());
+    else
+      CAEConvert::FrFloat(c.format)(&samples[0], samples.size(), &data[0]);
+
+    std::vector<unsigned int> pos(streams.size(), 0);
+
+    /* fill the streams before timing so the input stage only refills what is mixed */
+    Fill(streams, data, pos);
+
+    int64_t input = 0, stream = 0, output = 0;
+    bool hasAudio = false;
+    while (result.frames < frames)
+    {
+      if (sound && !sound->IsPlaying())
+        sound->Play();
+
+      int64_t start = CurrentHostCounter();
+      Fill(streams, data, pos);
+      input += CurrentHostCounter() - start;
+
+      /* the stream stage runs a frame at a time until the output buffer is full */
+      bool restart = false;
+      start = CurrentHostCounter();
+      while (m_ae->m_buffer.Free() >= m_ae->m_frameSize)
+      {
+        uint8_t *out = (uint8_t*)m_ae->m_buffer.Take(m_ae->m_frameSize);
+        memset(out, 0, m_ae->m_frameSize);
+        if ((m_ae->*m_ae->m_streamStageFn)(m_ae->m_chLayout.Count(), out, restart) > 0)
+          hasAudio = true;
+      }
+      stream += CurrentHostCounter() - start;
+
+      start = CurrentHostCounter();
+      int wrote;
+      while ((wrote = (m_ae->*m_ae->m_outputStageFn)(hasAudio)) > 0)
+      {
+        result.frames += wrote;
+        hasAudio = false;
+      }
+      output += CurrentHostCounter() - start;
+
+      ASSERT_FALSE(m_ae->m_reOpen);
+    }
+
+    const double nsPerFrame = 1000000000.0 / CurrentHostFrequency() / result.frames;
+    result.input  = input  * nsPerFrame;
+    result.stream = stream * nsPerFrame;
+    result.output = output * nsPerFrame;
+
+    m_ae->GetStreamStats(result.underruns, producerStalls);
+    result.underruns -= underruns;
+
+    if (sound)
+    {
+      m_ae->FreeSound(sound);
+      m_ae->SetSoundMode(AE_SOUND_OFF);
+    }
+    m_ae->SetVolume(1.0f);
+
+    for (unsigned int i = 0; i < streams.size(); ++i)
+      m_ae->FreeStream(streams[i]);
+  }
+
+private:
+  /* adds data to every stream until it is full, the input wraps around */
+  void Fill(std::vector<CSoftAEStream*> &streams, const std::vector<uint8_t> &data, std::vector<unsigned int> &pos)
+  {
+    for (unsigned int i = 0; i < streams.size(); ++i)
+    {
+      unsigned int taken;
+      while ((taken = streams[i]->AddData((void*)&data[pos[i]], data.size() - pos[i])) > 0)
+        pos[i] = (pos[i] + taken) % data.size();
+    }
+  }
+
+  CSoftAE *m_ae;
+};
+
+/* writes a second of a 16 bit stereo sine as a WAV file */
+static XFILE::CFile *CreateSound()
+{
+  const unsigned int rate   = 48000;
+  const unsigned int frames = rate;
+  std::vector<int16_t> samples(frames * 2);
+  for (unsigned int i = 0; i < frames; ++i)
+    samples[i * 2] = samples[i * 2 + 1] = (int16_t)(8192.0 * sin(2.0 * M_PI * 880.0 * i / rate));
+
+  XFILE::CFile *file = XBMC_CREATETEMPFILE(".wav");
+  if (!file)
+    return NULL;
+  file->Close();
+  if (!file->OpenForWrite(XBMC_TEMPFILEPATH(file), true))
+    return file;
+
+  const uint32_t dataSize = samples.size() * sizeof(int16_t);
+  uint8_t header[44];
+  memcpy(header     , "RIFF", 4);
+  *(uint32_t*)(header +  4) = Endian_SwapLE32(36 + dataSize);
+  memcpy(header +  8, "WAVEfmt ", 8);
+  *(uint32_t*)(header + 16) = Endian_SwapLE32(16);
+  *(uint16_t*)(header + 20) = Endian_SwapLE16(1);        /* PCM */
+  *(uint16_t*)(header + 22) = Endian_SwapLE16(2);        /* channels */
+  *(uint32_t*)(header + 24) = Endian_SwapLE32(rate);
+  *(uint32_t*)(header + 28) = Endian_SwapLE32(rate * 4); /* byte rate */
+  *(uint16_t*)(header + 32) = Endian_SwapLE16(4);        /* block align */
+  *(uint16_t*)(header + 34) = Endian_SwapLE16(16);       /* bits per sample */
+  memcpy(header + 36, "data", 4);
+  *(uint32_t*)(header + 40) = Endian_SwapLE32(dataSize);
+
+  file->Write(header, sizeof(header));
+  file->Write(&samples[0], dataSize);
+  file->Close();
+  return file;
+}
+
+TEST(TestSoftAE, Benchmark)
+{
+  static const BenchmarkCase cases[] =
+  {
+    /* name                       , device             , ch, sink , n, format      , rate , layout          , ratio, sound, volume */
+    { "1x 2.0 float"              , "NULL:freerun"     ,  1, 0    , 1, AE_FMT_FLOAT, 48000, AE_CH_LAYOUT_2_0, 0.0  , false, 1.0f },
+    { "1x 5.1 s16 -> 2.0"         , "NULL:freerun"     ,  1, 0    , 1, AE_FMT_S16NE, 48000, AE_CH_LAYOUT_5_1, 0.0  , false, 1.0f },
+    { "1x 7.1 s32 -> 5.1"         , "NULL:freerun"     ,  8, 0    , 1, AE_FMT_S32NE, 48000, AE_CH_LAYOUT_7_1, 0.0  , false, 1.0f },
+    { "1x 2.0 s16 44.1k -> 48k"   , "NULL:freerun"     ,  1, 48000, 1, AE_FMT_S16NE, 44100, AE_CH_LAYOUT_2_0, 0.0  , false, 1.0f },
+    { "1x 2.0 s16 ratio 1.001"    , "NULL:freerun"     ,  1, 0    , 1, AE_FMT_S16NE, 48000, AE_CH_LAYOUT_2_0, 1.001, false, 1.0f },
+    { "4x 2.0 s16 sound volume"   , "NULL:freerun"     ,  1, 0    , 4, AE_FMT_S16NE, 48000, AE_CH_LAYOUT_2_0, 0.0  , true , 0.5f },
+    { "1x 5.1 float profiler"     , "PROFILER:Profiler", 10, 0    , 1, AE_FMT_FLOAT, 48000, AE_CH_LAYOUT_5_1, 0.0  , false, 1.0f }
+  };
+
+  /* the engine has to be the global one, the streams and sounds query it */
+#if defined(TARGET_LINUX)
+  setenv("AE_ENGINE", "SOFT", 1);
+#endif
+  ASSERT_TRUE(CAEFactory::LoadEngine());
+  CSoftAE *ae = dynamic_cast<CSoftAE*>(CAEFactory::GetEngine());
+  ASSERT_TRUE(ae != NULL);
+
+  XFILE::CFile *soundFile = CreateSound();
+  ASSERT_TRUE(soundFile != NULL);
+
+  const CStdString device    = g_guiSettings.GetString("audiooutput.audiodevice");
+  const int        channels  = g_guiSettings.GetInt   ("audiooutput.channels");
+  const bool       upmix     = g_guiSettings.GetBool  ("audiooutput.stereoupmix");
+  const bool       ac3       = g_guiSettings.GetBool  ("audiooutput.ac3passthrough");
+  const int        resample  = g_advancedSettings.m_audioResample;
+  g_guiSettings.SetBool("audiooutput.stereoupmix"   , false);
+  g_guiSettings.SetBool("audiooutput.ac3passthrough", false);
+
+  CSoftAEBenchmark benchmark(ae);
+  for (unsigned int i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i)
+  {
+    BenchmarkResult result;
+    benchmark.Run(cases[i], 5, XBMC_TEMPFILEPATH(soundFile), result);
+
+    EXPECT_EQ(0U, result.underruns) << cases[i].name;
+    std::cout << cases[i].name << ": "
+              << "input "  << testing::PrintToString(result.input ) << " ns/frame, "
+              << "stream " << testing::PrintToString(result.stream) << " ns/frame, "
+              << "output " << testing::PrintToString(result.output) << " ns/frame"
+              << std::endl;
+  }
+
+  g_guiSettings.SetString("audiooutput.audiodevice"   , device.c_str());
+  g_guiSettings.SetInt   ("audiooutput.channels"      , channels);
+  g_guiSettings.SetBool  ("audiooutput.stereoupmix"   , upmix);
+  g_guiSettings.SetBool  ("audiooutput.ac3passthrough", ac3);
+  g_advancedSettings.m_audioResample = resample;
+
+  CAEFactory::UnLoadEngine();
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(soundFile));
+}
+
+#endif
@@ -0,0 +1,192 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+
+/* SoftAE is not built on darwin */
+#if !defined(TARGET_DARWIN)
+
+#include "cores/AudioEngine/Engines/SoftAE/SoftAETranscoder.h"
+#include "cores/AudioEngine/Interfaces/AEEncoder.h"
+
+#include <string.h>
+
+#include "gtest/gtest.h"
+
+#define TEST_FRAMES   1536
+#define TEST_RATE     48000
+#define TEST_PACKET   6144
+#define TEST_DELAY    256
+
+/* "encodes" a block into a packet that starts with the first sample of the block */
+class CTestEncoder : public IAEEncoder
+{
+public:
+  CTestEncoder() : m_encoded(0), m_resets(0) {}
+
+  virtual bool IsCompatible(AEAudioFormat format) { return true; }
+  virtual bool Initialize(AEAudioFormat &format)
+  {
+    format.m_dataFormat   = AE_FMT_FLOAT;
+    format.m_frames       = TEST_FRAMES;
+    format.m_frameSamples = TEST_FRAMES * 2;
+    format.m_frameSize    = sizeof(float) * 2;
+    return true;
+  }
+  virtual void         Reset()      { m_resets++; }
+  virtual unsigned int GetBitRate() { return 640000; }
+  virtual CodecID      GetCodecID() { return CODEC_ID_AC3; }
+  virtual unsigned int GetFrames()  { return TEST_FRAMES; }
+
+  virtual int Encode(float *data, unsigned int frames)
+  {
+    memset(m_packet, 0, sizeof(m_packet));
+    memcpy(m_packet, data, sizeof(float));
+    m_encoded++;
+    return frames;
+  }
+
+  virtual int GetData(uint8_t **data)
+  {
+    *data = m_packet;
+    return sizeof(m_packet);
+  }
+
+  virtual double GetDelay(unsigned int bufferSize)
+  {
+    return (TEST_DELAY + bufferSize) / (double)TEST_RATE;
+  }
+
+  volatile unsigned int m_encoded;
+  unsigned int          m_resets;
+
+private:
+  uint8_t m_packet[TEST_PACKET];
+};
+
+class TestSoftAETranscoder : public testing::Test
+{
+protected:
+  TestSoftAETranscoder()
+  {
+    m_format.m_dataFormat    = AE_FMT_FLOAT;
+    m_format.m_sampleRate    = TEST_RATE;
+    m_format.m_channelLayout = CAEChannelInfo(AE_CH_LAYOUT_2_0);
+    m_encoder.Initialize(m_format);
+  }
+
+  bool Push(float value)
+  {
+    float *block = (float*)m_transcoder.GetInputBuffer();
+    if (!block)
+      return false;
+    for (unsigned int i = 0; i < TEST_FRAMES * 2; ++i)
+      block[i] = value;
+    m_transcoder.PushInput();
+    return true;
+  }
+
+  float Pop()
+  {
+    uint8_t *packet;
+    if (!m_transcoder.WaitForPacket(5000) || m_transcoder.GetPacket(&packet) != TEST_PACKET)
+      return -1.0f;
+
+    float value;
+    memcpy(&value, packet, sizeof(value));
+    m_transcoder.PopPacket();
+    return value;
+  }
+
+  AEAudioFormat     m_format;
+  CTestEncoder      m_encoder;
+  CSoftAETranscoder m_transcoder;
+};
+
+TEST_F(TestSoftAETranscoder, Order)
+{
+  m_transcoder.Initialize(&m_encoder, m_format);
+  for (unsigned int i = 0; i < 100; ++i)
+  {
+    ASSERT_TRUE(Push((float)i));
+    EXPECT_EQ((float)i, Pop());
+  }
+  EXPECT_EQ(100U, m_encoder.m_encoded);
+  m_transcoder.Deinitialize();
+  EXPECT_FALSE(m_transcoder.IsInitialized());
+}
+
+TEST_F(TestSoftAETranscoder, Bounded)
+{
+  m_transcoder.Initialize(&m_encoder, m_format, 2);
+
+  /* two blocks fit in each queue, once the worker has filled its output no more are taken */
+  CEvent idle;
+  unsigned int pushed = 0;
+  for (unsigned int i = 0; i < 500 && pushed < 4; ++i)
+  {
+    if (Push((float)pushed))
+      pushed++;
+    else
+      idle.WaitMSec(10);
+  }
+  EXPECT_EQ(4U, pushed);
+  idle.WaitMSec(50);
+  EXPECT_FALSE(Push(4.0f));
+
+  for (unsigned int i = 0; i < pushed; ++i)
+    EXPECT_EQ((float)i, Pop());
+}
+
+TEST_F(TestSoftAETranscoder, Delay)
+{
+  EXPECT_EQ(0.0, m_transcoder.GetDelay(0));
+
+  m_transcoder.Initialize(&m_encoder, m_format, 2);
+  EXPECT_DOUBLE_EQ(TEST_DELAY / (double)TEST_RATE, m_transcoder.GetDelay(0));
+  EXPECT_DOUBLE_EQ((TEST_DELAY + 100) / (double)TEST_RATE, m_transcoder.GetDelay(100));
+
+  /* a queued block is accounted for before and after it is encoded */
+  ASSERT_TRUE(Push(1.0f));
+  EXPECT_DOUBLE_EQ((TEST_DELAY + TEST_FRAMES) / (double)TEST_RATE, m_transcoder.GetDelay(0));
+  ASSERT_TRUE(m_transcoder.WaitForPacket(5000));
+  EXPECT_DOUBLE_EQ((TEST_DELAY + TEST_FRAMES) / (double)TEST_RATE, m_transcoder.GetDelay(0));
+  EXPECT_EQ(1.0f, Pop());
+  EXPECT_DOUBLE_EQ(TEST_DELAY / (double)TEST_RATE, m_transcoder.GetDelay(0));
+
+  EXPECT_DOUBLE_EQ((TEST_DELAY + 4 * TEST_FRAMES) / (double)TEST_RATE, m_transcoder.GetCacheTotal(0));
+}
+
+TEST_F(TestSoftAETranscoder, Reset)
+{
+  m_transcoder.Initialize(&m_encoder, m_format, 2);
+  ASSERT_TRUE(Push(1.0f));
+  ASSERT_TRUE(m_transcoder.WaitForPacket(5000));
+
+  m_transcoder.Reset();
+  EXPECT_EQ(1U, m_encoder.m_resets);
+
+  uint8_t *packet;
+  EXPECT_EQ(0U, m_transcoder.GetPacket(&packet));
+  ASSERT_TRUE(Push(2.0f));
+  EXPECT_EQ(2.0f, Pop());
+}
+
+#endif
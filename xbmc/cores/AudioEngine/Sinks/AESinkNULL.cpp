@@ -30,6 +30,7 @@
 CAESinkNULL::CAESinkNULL()
   : CThread("AESinkNull"),
     m_draining(false),
+    m_freeRunning(false),
     m_sink_frameSize(0),
     m_sinkbuffer_size(0),
     m_sinkbuffer_level(0),
@@ -56,6 +57,13 @@ bool CAESinkNULL::Initialize(AEAudioFormat &format, std::string &device)
   m_sinkbuffer_sec_per_byte = 1.0 / (double)(m_sink_frameSize * format.m_sampleRate);
 
   m_draining = false;
+
+  // the "freerun" device ignores the wall clock and takes every packet at once,
+  // this lets SoftAE be profiled as fast as it can run on hosts without a sound card
+  m_freeRunning = (device == "freerun");
+  if (m_freeRunning)
+    return true;
+
   m_wake.Reset();
   m_inited.Reset();
   Create();
@@ -101,6 +109,9 @@ double CAESinkNULL::GetCacheTotal()
 
 unsigned int CAESinkNULL::AddPackets(uint8_t *data, unsigned int frames, bool hasAudio)
 {
+  if (m_freeRunning)
+    return frames;
+
   unsigned int max_frames = (m_sinkbuffer_size - m_sinkbuffer_level) / m_sink_frameSize;
   if (frames > max_frames)
     frames = max_frames;
@@ -48,6 +48,7 @@ private:
   CEvent               m_wake;
   CEvent               m_inited;
   volatile bool        m_draining;
+  bool                 m_freeRunning;      ///< takes every packet at once, see Initialize
   AEAudioFormat        m_format;
   unsigned int         m_sink_frameSize;
   unsigned int         m_sinkbuffer_size;  ///< total size of the buffer
@@ -30,7 +30,8 @@
 #include "utils/TimeUtils.h"
 #include "settings/GUISettings.h"
 
-CAESinkProfiler::CAESinkProfiler()
+CAESinkProfiler::CAESinkProfiler() :
+  m_ts(0)
 {
 }
 
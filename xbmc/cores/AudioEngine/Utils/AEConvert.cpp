@@ -23,6 +23,8 @@
 
 #include "AEConvert.h"
 #include "AEUtil.h"
+#include "AESIMD.h"
+#include "utils/CPUInfo.h"
 #include "utils/MathUtils.h"
 #include "utils/EndianSwap.h"
 #include <stdint.h>
@@ -32,6 +34,7 @@
 #endif
 #include <math.h>
 #include <string.h>
+#include <algorithm>
 
 #ifdef __SSE__
 #include <xmmintrin.h>
@@ -42,31 +45,1049 @@
 #include <arm_neon.h>
 #endif
 
-#define CLAMP(x) std::min(-1.0f, std::max(1.0f, (float)(x)))
+#define CLAMP(x) std::max(-1.0f, std::min(1.0f, (float)(x)))
 
 #ifndef INT24_MAX
 #define INT24_MAX (0x7FFFFF)
 #endif
 
+#ifndef INT24_MIN
+#define INT24_MIN (-0x7FFFFF - 1)
+#endif
+
 #define INT32_SCALE (-1.0f / INT_MIN)
 
-static inline int safeRound(double f)
+static inline int safeRound(double f)
+{
+  /* if the value is larger then we can handle, then clamp it */
+  if (f >= INT_MAX)
+    return INT_MAX;
+  if (f <= INT_MIN)
+    return INT_MIN;
+
+  /* if the value is out of the MathUtils::round_int range, then round it normally */
+  if (f <= static_cast<double>(INT_MIN / 2) - 1.0 || f >= static_cast <double>(INT_MAX / 2) + 1.0)
+    return (int)floor(f+0.5);
+
+  return MathUtils::round_int(f);
+}
+
+/*
+  Round a float to the nearest integer the same way cvtps2dq does (ties to even,
+  saturating to INT_MAX/INT_MIN) so the scalar and the SIMD conversions give
+  bit identical results.
+*/
+static inline int32_t roundToInt(float f)
+{
+#ifdef __SSE__
+  if (f >= 2147483648.0f)
+    return INT32_MAX;
+  return _mm_cvtss_si32(_mm_set_ss(f));
+#else
+  return safeRound(f);
+#endif
+}
+
+static inline float clampf(float f, float min, float max)
+{
+  return std::min(std::max(f, min), max);
+}
+
+/* per sample conversions shared by the scalar paths and the SIMD tails */
+static inline float U8ToFloat(uint8_t v)
+{
+  return v * (2.0f / UINT8_MAX) - 1.0f;
+}
+
+static inline float S8ToFloat(uint8_t v)
+{
+  return (int8_t)v * (1.0f / (INT8_MAX + 0.5f));
+}
+
+static inline float S24ToFloat(uint8_t msb, uint8_t mid, uint8_t lsb)
+{
+  int s = (int)(((uint32_t)msb << 24) | ((uint32_t)mid << 16) | ((uint32_t)lsb << 8));
+  return (float)s * INT32_SCALE;
+}
+
+static inline uint8_t FloatToU8(float f)
+{
+  return (uint8_t)roundToInt(clampf((f + 1.0f) * ((float)INT8_MAX + .5f), 0.0f, (float)UINT8_MAX));
+}
+
+static inline uint8_t FloatToS8(float f)
+{
+  return (uint8_t)roundToInt(clampf(f * ((float)INT8_MAX + .5f), (float)INT8_MIN, (float)INT8_MAX));
+}
+
+static inline int16_t FloatToS16(float f, float dither)
+{
+  return (int16_t)roundToInt(clampf(f * ((float)INT16_MAX + dither), (float)INT16_MIN, (float)INT16_MAX));
+}
+
+static inline int32_t FloatToS24(float f)
+{
+  return roundToInt(clampf(f * ((float)INT24_MAX + .5f), (float)INT24_MIN, (float)INT24_MAX));
+}
+
+static inline int32_t FloatToS32(float f)
+{
+  return roundToInt(f * (float)INT32_MAX);
+}
+
+#if defined(AE_SIMD_SSE2)
+/*
+  SSE2 implementations, these must give exactly the same results as the scalar
+  versions (except for the dither in the S16 output formats), the unit tests
+  verify this for every format.
+*/
+static inline __m128i ByteSwap16_SSE2(__m128i v)
+{
+  return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+static inline __m128i ByteSwap32_SSE2(__m128i v)
+{
+  v = ByteSwap16_SSE2(v);
+  v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+  return _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+/* converts float samples to int32 the same way as FloatToS32 does */
+static inline __m128i FloatToS32_SSE2(__m128 in)
+{
+  const __m128 overflow = _mm_set_ps1(2147483648.0f);
+  /* cvtps2dq returns 0x80000000 on positive overflow, flip it to 0x7FFFFFFF */
+  __m128i con = _mm_cvtps_epi32(in);
+  return _mm_xor_si128(con, _mm_castps_si128(_mm_cmpge_ps(in, overflow)));
+}
+
+static unsigned int U8_Float_SSE2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128  mul  = _mm_set_ps1(2.0f / UINT8_MAX);
+  const __m128  one  = _mm_set_ps1(1.0f);
+  const __m128i zero = _mm_setzero_si128();
+
+  unsigned int i = 0;
+  for (; i + 16 <= samples; i += 16, data += 16, dest += 16)
+  {
+    __m128i in = _mm_loadu_si128((__m128i*)data);
+    __m128i lo = _mm_unpacklo_epi8(in, zero);
+    __m128i hi = _mm_unpackhi_epi8(in, zero);
+    _mm_storeu_ps(dest +  0, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), mul), one));
+    _mm_storeu_ps(dest +  4, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), mul), one));
+    _mm_storeu_ps(dest +  8, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), mul), one));
+    _mm_storeu_ps(dest + 12, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), mul), one));
+  }
+
+  for (; i < samples; ++i)
+    *dest++ = U8ToFloat(*data++);
+
+  return samples;
+}
+
+static unsigned int S8_Float_SSE2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128 mul = _mm_set_ps1(1.0f / (INT8_MAX + 0.5f));
+
+  unsigned int i = 0;
+  for (; i + 16 <= samples; i += 16, data += 16, dest += 16)
+  {
+    __m128i in = _mm_loadu_si128((__m128i*)data);
+    /* sign extend to 16 then 32 bits */
+    __m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(in, in), 8);
+    __m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(in, in), 8);
+    _mm_storeu_ps(dest +  0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16)), mul));
+    _mm_storeu_ps(dest +  4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16)), mul));
+    _mm_storeu_ps(dest +  8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16)), mul));
+    _mm_storeu_ps(dest + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16)), mul));
+  }
+
+  for (; i < samples; ++i)
+    *dest++ = S8ToFloat(*data++);
+
+  return samples;
+}
+
+static inline unsigned int S16_Float_SSE2(uint8_t *data, const unsigned int samples, float *dest, bool swap)
+{
+  const float  scale = 1.0f / (INT16_MAX + 0.5f);
+  const __m128 mul   = _mm_set_ps1(scale);
+
+  unsigned int i = 0;
+  for (; i + 8 <= samples; i += 8, data += 16, dest += 8)
+  {
+    __m128i in = _mm_loadu_si128((__m128i*)data);
+    if (swap)
+      in = ByteSwap16_SSE2(in);
+    _mm_storeu_ps(dest + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(in, in), 16)), mul));
+    _mm_storeu_ps(dest + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(in, in), 16)), mul));
+  }
+
+  for (; i < samples; ++i, data += 2)
+  {
+    const int16_t s = swap ? (int16_t)((data[0] << 8) | data[1]) : (int16_t)((data[1] << 8) | data[0]);
+    *dest++ = s * scale;
+  }
+
+  return samples;
+}
+
+static unsigned int S16LE_Float_SSE2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  return S16_Float_SSE2(data, samples, dest, false);
+}
+
+static unsigned int S16BE_Float_SSE2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  return S16_Float_SSE2(data, samples, dest, true);
+}
+
+static unsigned int S24LE4_Float_SSE2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128 mul = _mm_set_ps1(INT32_SCALE);
+
+  unsigned int i = 0;
+  for (; i + 4 <= samples; i += 4, data += 16, dest += 4)
+  {
+    __m128i in = _mm_slli_epi32(_mm_loadu_si128((__m128i*)data), 8);
+    _mm_storeu_ps(dest, _mm_mul_ps(_mm_cvtepi32_ps(in), mul));
+  }
+
+  for (; i < samples; ++i, data += 4)
+    *dest++ = S24ToFloat(data[2], data[1], data[0]);
+
+  return samples;
+}
+
+static unsigned int S24BE4_Float_SSE2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128  mul  = _mm_set_ps1(INT32_SCALE);
+  const __m128i mask = _mm_set1_epi32(0xFFFFFF00);
+
+  unsigned int i = 0;
+  for (; i + 4 <= samples; i += 4, data += 16, dest += 4)
+  {
+    __m128i in = _mm_and_si128(ByteSwap32_SSE2(_mm_loadu_si128((__m128i*)data)), mask);
+    _mm_storeu_ps(dest, _mm_mul_ps(_mm_cvtepi32_ps(in), mul));
+  }
+
+  for (; i < samples; ++i, data += 4)
+    *dest++ = S24ToFloat(data[0], data[1], data[2]);
+
+  return samples;
+}
+
+/* packed 24 bit samples can not be shuffled without SSSE3, only the int to float conversion is vectorized */
+#define S24_3(msb, mid, lsb) ((int)(((uint32_t)(msb) << 24) | ((uint32_t)(mid) << 16) | ((uint32_t)(lsb) << 8)))
+
+static unsigned int S24LE3_Float_SSE2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128 mul = _mm_set_ps1(INT32_SCALE);
+
+  unsigned int i = 0;
+  for (; i + 4 <= samples; i += 4, data += 12, dest += 4)
+  {
+    __m128i in = _mm_setr_epi32(
+      S24_3(data[ 2], data[ 1], data[ 0]),
+      S24_3(data[ 5], data[ 4], data[ 3]),
+      S24_3(data[ 8], data[ 7], data[ 6]),
+      S24_3(data[11], data[10], data[ 9]));
+    _mm_storeu_ps(dest, _mm_mul_ps(_mm_cvtepi32_ps(in), mul));
+  }
+
+  for (; i < samples; ++i, data += 3)
+    *dest++ = S24ToFloat(data[2], data[1], data[0]);
+
+  return samples;
+}
+
+static unsigned int S24BE3_Float_SSE2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128 mul = _mm_set_ps1(INT32_SCALE);
+
+  unsigned int i = 0;
+  for (; i + 4 <= samples; i += 4, data += 12, dest += 4)
+  {
+    __m128i in = _mm_setr_epi32(
+      S24_3(data[0], data[ 1], data[ 2]),
+      S24_3(data[3], data[ 4], data[ 5]),
+      S24_3(data[6], data[ 7], data[ 8]),
+      S24_3(data[9], data[10], data[11]));
+    _mm_storeu_ps(dest, _mm_mul_ps(_mm_cvtepi32_ps(in), mul));
+  }
+
+  for (; i < samples; ++i, data += 3)
+    *dest++ = S24ToFloat(data[0], data[1], data[2]);
+
+  return samples;
+}
+
+#undef S24_3
+
+static unsigned int S32LE_Float_SSE2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  static const float factor = 1.0f / (float)INT32_MAX;
+  const __m128 mul = _mm_set_ps1(factor);
+  int32_t *src = (int32_t*)data;
+
+  unsigned int i = 0;
+  for (; i + 8 <= samples; i += 8, src += 8, dest += 8)
+  {
+    _mm_storeu_ps(dest + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((__m128i*)(src + 0))), mul));
+    _mm_storeu_ps(dest + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((__m128i*)(src + 4))), mul));
+  }
+
+  for (; i < samples; ++i)
+    *dest++ = (float)*src++ * factor;
+
+  return samples;
+}
+
+static unsigned int S32BE_Float_SSE2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  static const float factor = 1.0f / (float)INT32_MAX;
+  const __m128 mul = _mm_set_ps1(factor);
+  int32_t *src = (int32_t*)data;
+
+  unsigned int i = 0;
+  for (; i + 8 <= samples; i += 8, src += 8, dest += 8)
+  {
+    _mm_storeu_ps(dest + 0, _mm_mul_ps(_mm_cvtepi32_ps(ByteSwap32_SSE2(_mm_loadu_si128((__m128i*)(src + 0)))), mul));
+    _mm_storeu_ps(dest + 4, _mm_mul_ps(_mm_cvtepi32_ps(ByteSwap32_SSE2(_mm_loadu_si128((__m128i*)(src + 4)))), mul));
+  }
+
+  for (; i < samples; ++i)
+    *dest++ = (float)(int32_t)Endian_Swap32(*src++) * factor;
+
+  return samples;
+}
+
+static unsigned int DOUBLE_Float_SSE2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128 min = _mm_set_ps1(-1.0f);
+  const __m128 max = _mm_set_ps1( 1.0f);
+  double *src = (double*)data;
+
+  unsigned int i = 0;
+  for (; i + 4 <= samples; i += 4, src += 4, dest += 4)
+  {
+    __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(src + 0));
+    __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(src + 2));
+    __m128 in = _mm_movelh_ps(lo, hi);
+    _mm_storeu_ps(dest, _mm_max_ps(min, _mm_min_ps(max, in)));
+  }
+
+  for (; i < samples; ++i)
+    *dest++ = CLAMP(*src++);
+
+  return samples;
+}
+
+static unsigned int Float_U8_SSE2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  const __m128 mul = _mm_set_ps1((float)INT8_MAX + .5f);
+  const __m128 add = _mm_set_ps1(1.0f);
+  const __m128 min = _mm_set_ps1(0.0f);
+  const __m128 max = _mm_set_ps1((float)UINT8_MAX);
+
+  unsigned int i = 0;
+  for (; i + 16 <= samples; i += 16, data += 16, dest += 16)
+  {
+    __m128i a = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(data +  0), add), mul), min), max));
+    __m128i b = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(data +  4), add), mul), min), max));
+    __m128i c = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(data +  8), add), mul), min), max));
+    __m128i d = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(data + 12), add), mul), min), max));
+    _mm_storeu_si128((__m128i*)dest, _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+  }
+
+  for (; i < samples; ++i)
+    *dest++ = FloatToU8(*data++);
+
+  return samples;
+}
+
+static unsigned int Float_S8_SSE2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  const __m128 mul = _mm_set_ps1((float)INT8_MAX + .5f);
+  const __m128 min = _mm_set_ps1((float)INT8_MIN);
+  const __m128 max = _mm_set_ps1((float)INT8_MAX);
+
+  unsigned int i = 0;
+  for (; i + 16 <= samples; i += 16, data += 16, dest += 16)
+  {
+    __m128i a = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(data +  0), mul), min), max));
+    __m128i b = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(data +  4), mul), min), max));
+    __m128i c = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(data +  8), mul), min), max));
+    __m128i d = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(data + 12), mul), min), max));
+    _mm_storeu_si128((__m128i*)dest, _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+  }
+
+  for (; i < samples; ++i)
+    *dest++ = FloatToS8(*data++);
+
+  return samples;
+}
+
+static inline unsigned int Float_S16_SSE2(float *data, const unsigned int samples, uint8_t *dest, bool swap)
+{
+  const __m128 mul = _mm_set_ps1((float)INT16_MAX);
+  const __m128 min = _mm_set_ps1((float)INT16_MIN);
+  const __m128 max = _mm_set_ps1((float)INT16_MAX);
+  int16_t *dst = (int16_t*)dest;
+
+  unsigned int i = 0;
+  for (; i + 8 <= samples; i += 8, data += 8, dst += 8)
+  {
+    /* random round to dither */
+    __m128 rand0, rand1;
+    CAEUtil::FloatRand4(-0.5f, 0.5f, NULL, &rand0);
+    CAEUtil::FloatRand4(-0.5f, 0.5f, NULL, &rand1);
+
+    __m128i a = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(data + 0), _mm_add_ps(mul, rand0)), min), max));
+    __m128i b = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(data + 4), _mm_add_ps(mul, rand1)), min), max));
+    __m128i con = _mm_packs_epi32(a, b);
+    if (swap)
+      con = ByteSwap16_SSE2(con);
+    _mm_storeu_si128((__m128i*)dst, con);
+  }
+
+  for (; i < samples; ++i)
+  {
+    const uint16_t s = (uint16_t)FloatToS16(*data++, CAEUtil::FloatRand1(-0.5f, 0.5f));
+    *dst++ = swap ? (int16_t)((s << 8) | (s >> 8)) : (int16_t)s;
+  }
+
+  return samples << 1;
+}
+
+static unsigned int Float_S16LE_SSE2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  return Float_S16_SSE2(data, samples, dest, false);
+}
+
+static unsigned int Float_S16BE_SSE2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  return Float_S16_SSE2(data, samples, dest, true);
+}
+
+static unsigned int Float_S24NE4_SSE2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  const __m128 mul = _mm_set_ps1((float)INT24_MAX + .5f);
+  const __m128 min = _mm_set_ps1((float)INT24_MIN);
+  const __m128 max = _mm_set_ps1((float)INT24_MAX);
+  int32_t *dst = (int32_t*)dest;
+
+  unsigned int i = 0;
+  for (; i + 4 <= samples; i += 4, data += 4, dst += 4)
+  {
+    __m128i con = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(data), mul), min), max));
+    _mm_storeu_si128((__m128i*)dst, _mm_slli_epi32(con, 8));
+  }
+
+  for (; i < samples; ++i)
+    *dst++ = (int32_t)((uint32_t)FloatToS24(*data++) << 8);
+
+  return samples << 2;
+}
+
+static unsigned int Float_S24NE3_SSE2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  const __m128 mul = _mm_set_ps1((float)INT24_MAX + .5f);
+  const __m128 min = _mm_set_ps1((float)INT24_MIN);
+  const __m128 max = _mm_set_ps1((float)INT24_MAX);
+  MEMALIGN(16, uint32_t s[4]);
+
+  unsigned int i = 0;
+  for (; i + 4 <= samples; i += 4, data += 4, dest += 12)
+  {
+    __m128i con = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(data), mul), min), max));
+    _mm_store_si128((__m128i*)s, con);
+
+    /* pack the four 24 bit little endian samples into three words */
+    const uint32_t packed[3] =
+    {
+      (s[0] & 0x00FFFFFF)       | (s[1] << 24),
+      ((s[1] >> 8) & 0x0000FFFF) | (s[2] << 16),
+      ((s[2] >> 16) & 0x000000FF) | (s[3] << 8)
+    };
+    memcpy(dest, packed, sizeof(packed));
+  }
+
+  for (; i < samples; ++i, dest += 3)
+  {
+    const int32_t v = FloatToS24(*data++);
+    dest[0] = (uint8_t)(v      );
+    dest[1] = (uint8_t)(v >> 8 );
+    dest[2] = (uint8_t)(v >> 16);
+  }
+
+  return samples * 3;
+}
+
+static unsigned int Float_S32LE_SSE2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  const __m128 mul = _mm_set_ps1((float)INT32_MAX);
+  int32_t *dst = (int32_t*)dest;
+
+  unsigned int i = 0;
+  for (; i + 8 <= samples; i += 8, data += 8, dst += 8)
+  {
+    _mm_storeu_si128((__m128i*)(dst + 0), FloatToS32_SSE2(_mm_mul_ps(_mm_loadu_ps(data + 0), mul)));
+    _mm_storeu_si128((__m128i*)(dst + 4), FloatToS32_SSE2(_mm_mul_ps(_mm_loadu_ps(data + 4), mul)));
+  }
+
+  for (; i < samples; ++i)
+    *dst++ = FloatToS32(*data++);
+
+  return samples << 2;
+}
+
+static unsigned int Float_S32BE_SSE2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  const __m128 mul = _mm_set_ps1((float)INT32_MAX);
+  int32_t *dst = (int32_t*)dest;
+
+  unsigned int i = 0;
+  for (; i + 8 <= samples; i += 8, data += 8, dst += 8)
+  {
+    _mm_storeu_si128((__m128i*)(dst + 0), ByteSwap32_SSE2(FloatToS32_SSE2(_mm_mul_ps(_mm_loadu_ps(data + 0), mul))));
+    _mm_storeu_si128((__m128i*)(dst + 4), ByteSwap32_SSE2(FloatToS32_SSE2(_mm_mul_ps(_mm_loadu_ps(data + 4), mul))));
+  }
+
+  for (; i < samples; ++i)
+    *dst++ = Endian_Swap32(FloatToS32(*data++));
+
+  return samples << 2;
+}
+
+static unsigned int Float_DOUBLE_SSE2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  double *dst = (double*)dest;
+
+  unsigned int i = 0;
+  for (; i + 4 <= samples; i += 4, data += 4, dst += 4)
+  {
+    __m128 in = _mm_loadu_ps(data);
+    _mm_storeu_pd(dst + 0, _mm_cvtps_pd(in));
+    _mm_storeu_pd(dst + 2, _mm_cvtps_pd(_mm_movehl_ps(in, in)));
+  }
+
+  for (; i < samples; ++i)
+    *dst++ = *data++;
+
+  return samples * sizeof(double);
+}
+#endif /* AE_SIMD_SSE2 */
+
+#if defined(AE_SIMD_AVX2)
+/*
+  AVX2 implementations, same rules as for the SSE2 ones. FMA is deliberately not
+  enabled for these functions as fusing the multiply and add would change the
+  rounding compared to the scalar versions.
+*/
+AE_TARGET_AVX2 static inline __m256 Clamp_AVX2(__m256 in, __m256 min, __m256 max)
+{
+  return _mm256_min_ps(_mm256_max_ps(in, min), max);
+}
+
+AE_TARGET_AVX2 static inline __m256i FloatToS32_AVX2(__m256 in)
+{
+  const __m256 overflow = _mm256_set1_ps(2147483648.0f);
+  __m256i con = _mm256_cvtps_epi32(in);
+  return _mm256_xor_si256(con, _mm256_castps_si256(_mm256_cmp_ps(in, overflow, _CMP_GE_OQ)));
+}
+
+AE_TARGET_AVX2 static unsigned int U8_Float_AVX2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m256 mul = _mm256_set1_ps(2.0f / UINT8_MAX);
+  const __m256 one = _mm256_set1_ps(1.0f);
+
+  unsigned int i = 0;
+  for (; i + 16 <= samples; i += 16, data += 16, dest += 16)
+  {
+    __m256i a = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*)(data + 0)));
+    __m256i b = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*)(data + 8)));
+    _mm256_storeu_ps(dest + 0, _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(a), mul), one));
+    _mm256_storeu_ps(dest + 8, _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(b), mul), one));
+  }
+
+  for (; i < samples; ++i)
+    *dest++ = U8ToFloat(*data++);
+
+  return samples;
+}
+
+AE_TARGET_AVX2 static unsigned int S8_Float_AVX2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m256 mul = _mm256_set1_ps(1.0f / (INT8_MAX + 0.5f));
+
+  unsigned int i = 0;
+  for (; i + 16 <= samples; i += 16, data += 16, dest += 16)
+  {
+    __m256i a = _mm256_cvtepi8_epi32(_mm_loadl_epi64((__m128i*)(data + 0)));
+    __m256i b = _mm256_cvtepi8_epi32(_mm_loadl_epi64((__m128i*)(data + 8)));
+    _mm256_storeu_ps(dest + 0, _mm256_mul_ps(_mm256_cvtepi32_ps(a), mul));
+    _mm256_storeu_ps(dest + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(b), mul));
+  }
+
+  for (; i < samples; ++i)
+    *dest++ = S8ToFloat(*data++);
+
+  return samples;
+}
+
+AE_TARGET_AVX2 static inline unsigned int S16_Float_AVX2(uint8_t *data, const unsigned int samples, float *dest, bool swap)
+{
+  const float  scale = 1.0f / (INT16_MAX + 0.5f);
+  const __m256 mul   = _mm256_set1_ps(scale);
+
+  unsigned int i = 0;
+  for (; i + 16 <= samples; i += 16, data += 32, dest += 16)
+  {
+    __m128i a = _mm_loadu_si128((__m128i*)(data +  0));
+    __m128i b = _mm_loadu_si128((__m128i*)(data + 16));
+    if (swap)
+    {
+      a = _mm_or_si128(_mm_slli_epi16(a, 8), _mm_srli_epi16(a, 8));
+      b = _mm_or_si128(_mm_slli_epi16(b, 8), _mm_srli_epi16(b, 8));
+    }
+    _mm256_storeu_ps(dest + 0, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(a)), mul));
+    _mm256_storeu_ps(dest + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(b)), mul));
+  }
+
+  for (; i < samples; ++i, data += 2)
+  {
+    const int16_t s = swap ? (int16_t)((data[0] << 8) | data[1]) : (int16_t)((data[1] << 8) | data[0]);
+    *dest++ = s * scale;
+  }
+
+  return samples;
+}
+
+AE_TARGET_AVX2 static unsigned int S16LE_Float_AVX2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  return S16_Float_AVX2(data, samples, dest, false);
+}
+
+AE_TARGET_AVX2 static unsigned int S16BE_Float_AVX2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  return S16_Float_AVX2(data, samples, dest, true);
+}
+
+/*
+  the 24 bit formats are expanded to a left aligned int32 with a byte shuffle,
+  a shuffle index of -1 (0x80) clears the byte
+*/
+AE_TARGET_AVX2 static inline unsigned int S24_4_Float_AVX2(uint8_t *data, const unsigned int samples, float *dest, const __m256i shuffle)
+{
+  const __m256 mul = _mm256_set1_ps(INT32_SCALE);
+
+  unsigned int i = 0;
+  for (; i + 8 <= samples; i += 8, data += 32, dest += 8)
+  {
+    __m256i in = _mm256_shuffle_epi8(_mm256_loadu_si256((__m256i*)data), shuffle);
+    _mm256_storeu_ps(dest, _mm256_mul_ps(_mm256_cvtepi32_ps(in), mul));
+  }
+
+  return i;
+}
+
+AE_TARGET_AVX2 static inline unsigned int S24_3_Float_AVX2(uint8_t *data, const unsigned int samples, float *dest, const __m256i shuffle)
+{
+  const __m256 mul = _mm256_set1_ps(INT32_SCALE);
+
+  /* each lane loads 16 bytes for 12 bytes of samples, stop before reading past the end */
+  unsigned int i = 0;
+  for (; i + 10 <= samples; i += 8, data += 24, dest += 8)
+  {
+    __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((__m128i*)(data + 0))),
+                                         _mm_loadu_si128((__m128i*)(data + 12)), 1);
+    in = _mm256_shuffle_epi8(in, shuffle);
+    _mm256_storeu_ps(dest, _mm256_mul_ps(_mm256_cvtepi32_ps(in), mul));
+  }
+
+  return i;
+}
+
+AE_TARGET_AVX2 static unsigned int S24LE4_Float_AVX2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m256i shuffle = _mm256_setr_epi8(
+    -1, 0, 1,  2, -1, 4, 5,  6, -1, 8, 9, 10, -1, 12, 13, 14,
+    -1, 0, 1,  2, -1, 4, 5,  6, -1, 8, 9, 10, -1, 12, 13, 14);
+
+  unsigned int i = S24_4_Float_AVX2(data, samples, dest, shuffle);
+  for (data += i * 4, dest += i; i < samples; ++i, data += 4)
+    *dest++ = S24ToFloat(data[2], data[1], data[0]);
+
+  return samples;
+}
+
+AE_TARGET_AVX2 static unsigned int S24BE4_Float_AVX2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m256i shuffle = _mm256_setr_epi8(
+    -1, 2, 1, 0, -1, 6, 5, 4, -1, 10, 9, 8, -1, 14, 13, 12,
+    -1, 2, 1, 0, -1, 6, 5, 4, -1, 10, 9, 8, -1, 14, 13, 12);
+
+  unsigned int i = S24_4_Float_AVX2(data, samples, dest, shuffle);
+  for (data += i * 4, dest += i; i < samples; ++i, data += 4)
+    *dest++ = S24ToFloat(data[0], data[1], data[2]);
+
+  return samples;
+}
+
+AE_TARGET_AVX2 static unsigned int S24LE3_Float_AVX2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m256i shuffle = _mm256_setr_epi8(
+    -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+    -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+
+  unsigned int i = S24_3_Float_AVX2(data, samples, dest, shuffle);
+  for (data += i * 3, dest += i; i < samples; ++i, data += 3)
+    *dest++ = S24ToFloat(data[2], data[1], data[0]);
+
+  return samples;
+}
+
+AE_TARGET_AVX2 static unsigned int S24BE3_Float_AVX2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m256i shuffle = _mm256_setr_epi8(
+    -1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9,
+    -1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9);
+
+  unsigned int i = S24_3_Float_AVX2(data, samples, dest, shuffle);
+  for (data += i * 3, dest += i; i < samples; ++i, data += 3)
+    *dest++ = S24ToFloat(data[0], data[1], data[2]);
+
+  return samples;
+}
+
+AE_TARGET_AVX2 static unsigned int S32LE_Float_AVX2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  static const float factor = 1.0f / (float)INT32_MAX;
+  const __m256 mul = _mm256_set1_ps(factor);
+  int32_t *src = (int32_t*)data;
+
+  unsigned int i = 0;
+  for (; i + 16 <= samples; i += 16, src += 16, dest += 16)
+  {
+    _mm256_storeu_ps(dest + 0, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256((__m256i*)(src + 0))), mul));
+    _mm256_storeu_ps(dest + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256((__m256i*)(src + 8))), mul));
+  }
+
+  for (; i < samples; ++i)
+    *dest++ = (float)*src++ * factor;
+
+  return samples;
+}
+
+AE_TARGET_AVX2 static unsigned int S32BE_Float_AVX2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  static const float factor = 1.0f / (float)INT32_MAX;
+  const __m256  mul     = _mm256_set1_ps(factor);
+  const __m256i shuffle = _mm256_setr_epi8(
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  int32_t *src = (int32_t*)data;
+
+  unsigned int i = 0;
+  for (; i + 16 <= samples; i += 16, src += 16, dest += 16)
+  {
+    __m256i a = _mm256_shuffle_epi8(_mm256_loadu_si256((__m256i*)(src + 0)), shuffle);
+    __m256i b = _mm256_shuffle_epi8(_mm256_loadu_si256((__m256i*)(src + 8)), shuffle);
+    _mm256_storeu_ps(dest + 0, _mm256_mul_ps(_mm256_cvtepi32_ps(a), mul));
+    _mm256_storeu_ps(dest + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(b), mul));
+  }
+
+  for (; i < samples; ++i)
+    *dest++ = (float)(int32_t)Endian_Swap32(*src++) * factor;
+
+  return samples;
+}
+
+AE_TARGET_AVX2 static unsigned int DOUBLE_Float_AVX2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m256 min = _mm256_set1_ps(-1.0f);
+  const __m256 max = _mm256_set1_ps( 1.0f);
+  double *src = (double*)data;
+
+  unsigned int i = 0;
+  for (; i + 8 <= samples; i += 8, src += 8, dest += 8)
+  {
+    __m128 lo = _mm256_cvtpd_ps(_mm256_loadu_pd(src + 0));
+    __m128 hi = _mm256_cvtpd_ps(_mm256_loadu_pd(src + 4));
+    __m256 in = _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+    _mm256_storeu_ps(dest, _mm256_max_ps(min, _mm256_min_ps(max, in)));
+  }
+
+  for (; i < samples; ++i)
+    *dest++ = CLAMP(*src++);
+
+  return samples;
+}
+
+AE_TARGET_AVX2 static unsigned int Float_U8_AVX2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  const __m256 mul = _mm256_set1_ps((float)INT8_MAX + .5f);
+  const __m256 add = _mm256_set1_ps(1.0f);
+  const __m256 min = _mm256_set1_ps(0.0f);
+  const __m256 max = _mm256_set1_ps((float)UINT8_MAX);
+
+  unsigned int i = 0;
+  for (; i + 16 <= samples; i += 16, data += 16, dest += 16)
+  {
+    __m256i a = _mm256_cvtps_epi32(Clamp_AVX2(_mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(data + 0), add), mul), min, max));
+    __m256i b = _mm256_cvtps_epi32(Clamp_AVX2(_mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(data + 8), add), mul), min, max));
+    __m128i lo = _mm_packs_epi32(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+    __m128i hi = _mm_packs_epi32(_mm256_castsi256_si128(b), _mm256_extracti128_si256(b, 1));
+    _mm_storeu_si128((__m128i*)dest, _mm_packus_epi16(lo, hi));
+  }
+
+  for (; i < samples; ++i)
+    *dest++ = FloatToU8(*data++);
+
+  return samples;
+}
+
+AE_TARGET_AVX2 static unsigned int Float_S8_AVX2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  const __m256 mul = _mm256_set1_ps((float)INT8_MAX + .5f);
+  const __m256 min = _mm256_set1_ps((float)INT8_MIN);
+  const __m256 max = _mm256_set1_ps((float)INT8_MAX);
+
+  unsigned int i = 0;
+  for (; i + 16 <= samples; i += 16, data += 16, dest += 16)
+  {
+    __m256i a = _mm256_cvtps_epi32(Clamp_AVX2(_mm256_mul_ps(_mm256_loadu_ps(data + 0), mul), min, max));
+    __m256i b = _mm256_cvtps_epi32(Clamp_AVX2(_mm256_mul_ps(_mm256_loadu_ps(data + 8), mul), min, max));
+    __m128i lo = _mm_packs_epi32(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+    __m128i hi = _mm_packs_epi32(_mm256_castsi256_si128(b), _mm256_extracti128_si256(b, 1));
+    _mm_storeu_si128((__m128i*)dest, _mm_packs_epi16(lo, hi));
+  }
+
+  for (; i < samples; ++i)
+    *dest++ = FloatToS8(*data++);
+
+  return samples;
+}
+
+AE_TARGET_AVX2 static inline unsigned int Float_S16_AVX2(float *data, const unsigned int samples, uint8_t *dest, bool swap)
+{
+  const __m256 mul = _mm256_set1_ps((float)INT16_MAX);
+  const __m256 min = _mm256_set1_ps((float)INT16_MIN);
+  const __m256 max = _mm256_set1_ps((float)INT16_MAX);
+  int16_t *dst = (int16_t*)dest;
+
+  unsigned int i = 0;
+  for (; i + 8 <= samples; i += 8, data += 8, dst += 8)
+  {
+    /* random round to dither */
+    __m128 rand0, rand1;
+    CAEUtil::FloatRand4(-0.5f, 0.5f, NULL, &rand0);
+    CAEUtil::FloatRand4(-0.5f, 0.5f, NULL, &rand1);
+    __m256 rand = _mm256_insertf128_ps(_mm256_castps128_ps256(rand0), rand1, 1);
+
+    __m256i in  = _mm256_cvtps_epi32(Clamp_AVX2(_mm256_mul_ps(_mm256_loadu_ps(data), _mm256_add_ps(mul, rand)), min, max));
+    __m128i con = _mm_packs_epi32(_mm256_castsi256_si128(in), _mm256_extracti128_si256(in, 1));
+    if (swap)
+      con = _mm_or_si128(_mm_slli_epi16(con, 8), _mm_srli_epi16(con, 8));
+    _mm_storeu_si128((__m128i*)dst, con);
+  }
+
+  for (; i < samples; ++i)
+  {
+    const uint16_t s = (uint16_t)FloatToS16(*data++, CAEUtil::FloatRand1(-0.5f, 0.5f));
+    *dst++ = swap ? (int16_t)((s << 8) | (s >> 8)) : (int16_t)s;
+  }
+
+  return samples << 1;
+}
+
+AE_TARGET_AVX2 static unsigned int Float_S16LE_AVX2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  return Float_S16_AVX2(data, samples, dest, false);
+}
+
+AE_TARGET_AVX2 static unsigned int Float_S16BE_AVX2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  return Float_S16_AVX2(data, samples, dest, true);
+}
+
+AE_TARGET_AVX2 static unsigned int Float_S24NE4_AVX2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  const __m256 mul = _mm256_set1_ps((float)INT24_MAX + .5f);
+  const __m256 min = _mm256_set1_ps((float)INT24_MIN);
+  const __m256 max = _mm256_set1_ps((float)INT24_MAX);
+  int32_t *dst = (int32_t*)dest;
+
+  unsigned int i = 0;
+  for (; i + 8 <= samples; i += 8, data += 8, dst += 8)
+  {
+    __m256i con = _mm256_cvtps_epi32(Clamp_AVX2(_mm256_mul_ps(_mm256_loadu_ps(data), mul), min, max));
+    _mm256_storeu_si256((__m256i*)dst, _mm256_slli_epi32(con, 8));
+  }
+
+  for (; i < samples; ++i)
+    *dst++ = (int32_t)((uint32_t)FloatToS24(*data++) << 8);
+
+  return samples << 2;
+}
+
+AE_TARGET_AVX2 static unsigned int Float_S24NE3_AVX2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  const __m256 mul = _mm256_set1_ps((float)INT24_MAX + .5f);
+  const __m256 min = _mm256_set1_ps((float)INT24_MIN);
+  const __m256 max = _mm256_set1_ps((float)INT24_MAX);
+  /* drop the top byte of each sample, packing 4 samples into the low 12 bytes of each lane */
+  const __m256i shuffle = _mm256_setr_epi8(
+    0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+    0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+  unsigned int i = 0;
+  for (; i + 8 <= samples; i += 8, data += 8, dest += 24)
+  {
+    __m256i con = _mm256_cvtps_epi32(Clamp_AVX2(_mm256_mul_ps(_mm256_loadu_ps(data), mul), min, max));
+    con = _mm256_shuffle_epi8(con, shuffle);
+
+    __m128i lo = _mm256_castsi256_si128(con);
+    __m128i hi = _mm256_extracti128_si256(con, 1);
+    const uint32_t loTail = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(lo, 8));
+    const uint32_t hiTail = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(hi, 8));
+    _mm_storel_epi64((__m128i*)(dest +  0), lo);
+    memcpy(dest +  8, &loTail, sizeof(loTail));
+    _mm_storel_epi64((__m128i*)(dest + 12), hi);
+    memcpy(dest + 20, &hiTail, sizeof(hiTail));
+  }
+
+  for (; i < samples; ++i, dest += 3)
+  {
+    const int32_t v = FloatToS24(*data++);
+    dest[0] = (uint8_t)(v      );
+    dest[1] = (uint8_t)(v >> 8 );
+    dest[2] = (uint8_t)(v >> 16);
+  }
+
+  return samples * 3;
+}
+
+AE_TARGET_AVX2 static unsigned int Float_S32LE_AVX2(float *data, const unsigned int samples, uint8_t *dest)
 {
-  /* if the value is larger then we can handle, then clamp it */
-  if (f >= INT_MAX)
-    return INT_MAX;
-  if (f <= INT_MIN)
-    return INT_MIN;
+  const __m256 mul = _mm256_set1_ps((float)INT32_MAX);
+  int32_t *dst = (int32_t*)dest;
 
-  /* if the value is out of the MathUtils::round_int range, then round it normally */
-  if (f <= static_cast<double>(INT_MIN / 2) - 1.0 || f >= static_cast <double>(INT_MAX / 2) + 1.0)
-    return (int)floor(f+0.5);
+  unsigned int i = 0;
+  for (; i + 16 <= samples; i += 16, data += 16, dst += 16)
+  {
+    _mm256_storeu_si256((__m256i*)(dst + 0), FloatToS32_AVX2(_mm256_mul_ps(_mm256_loadu_ps(data + 0), mul)));
+    _mm256_storeu_si256((__m256i*)(dst + 8), FloatToS32_AVX2(_mm256_mul_ps(_mm256_loadu_ps(data + 8), mul)));
+  }
 
-  return MathUtils::round_int(f);
+  for (; i < samples; ++i)
+    *dst++ = FloatToS32(*data++);
+
+  return samples << 2;
+}
+
+AE_TARGET_AVX2 static unsigned int Float_S32BE_AVX2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  const __m256  mul     = _mm256_set1_ps((float)INT32_MAX);
+  const __m256i shuffle = _mm256_setr_epi8(
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  int32_t *dst = (int32_t*)dest;
+
+  unsigned int i = 0;
+  for (; i + 16 <= samples; i += 16, data += 16, dst += 16)
+  {
+    __m256i a = _mm256_shuffle_epi8(FloatToS32_AVX2(_mm256_mul_ps(_mm256_loadu_ps(data + 0), mul)), shuffle);
+    __m256i b = _mm256_shuffle_epi8(FloatToS32_AVX2(_mm256_mul_ps(_mm256_loadu_ps(data + 8), mul)), shuffle);
+    _mm256_storeu_si256((__m256i*)(dst + 0), a);
+    _mm256_storeu_si256((__m256i*)(dst + 8), b);
+  }
+
+  for (; i < samples; ++i)
+    *dst++ = Endian_Swap32(FloatToS32(*data++));
+
+  return samples << 2;
+}
+
+AE_TARGET_AVX2 static unsigned int Float_DOUBLE_AVX2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  double *dst = (double*)dest;
+
+  unsigned int i = 0;
+  for (; i + 8 <= samples; i += 8, data += 8, dst += 8)
+  {
+    _mm256_storeu_pd(dst + 0, _mm256_cvtps_pd(_mm_loadu_ps(data + 0)));
+    _mm256_storeu_pd(dst + 4, _mm256_cvtps_pd(_mm_loadu_ps(data + 4)));
+  }
+
+  for (; i < samples; ++i)
+    *dst++ = *data++;
+
+  return samples * sizeof(double);
 }
+#endif /* AE_SIMD_AVX2 */
 
 CAEConvert::AEConvertToFn CAEConvert::ToFloat(enum AEDataFormat dataFormat)
 {
+  return ToFloat(dataFormat, g_cpuInfo.GetCPUFeatures());
+}
+
+CAEConvert::AEConvertToFn CAEConvert::ToFloat(enum AEDataFormat dataFormat, unsigned int cpuFeatures)
+{
+#if defined(AE_SIMD_AVX2)
+  if (cpuFeatures & CPU_FEATURE_AVX2)
+  {
+    switch (dataFormat)
+    {
+      case AE_FMT_U8    : return &U8_Float_AVX2;
+      case AE_FMT_S8    : return &S8_Float_AVX2;
+      case AE_FMT_S16NE :
+      case AE_FMT_S16LE : return &S16LE_Float_AVX2;
+      case AE_FMT_S16BE : return &S16BE_Float_AVX2;
+      case AE_FMT_S24NE4:
+      case AE_FMT_S24LE4: return &S24LE4_Float_AVX2;
+      case AE_FMT_S24BE4: return &S24BE4_Float_AVX2;
+      case AE_FMT_S24NE3:
+      case AE_FMT_S24LE3: return &S24LE3_Float_AVX2;
+      case AE_FMT_S24BE3: return &S24BE3_Float_AVX2;
+      case AE_FMT_S32NE :
+      case AE_FMT_S32LE : return &S32LE_Float_AVX2;
+      case AE_FMT_S32BE : return &S32BE_Float_AVX2;
+      case AE_FMT_DOUBLE: return &DOUBLE_Float_AVX2;
+      default:
+        return NULL;
+    }
+  }
+#endif
+
+#if defined(AE_SIMD_SSE2)
+  if (cpuFeatures & CPU_FEATURE_SSE2)
+  {
+    switch (dataFormat)
+    {
+      case AE_FMT_U8    : return &U8_Float_SSE2;
+      case AE_FMT_S8    : return &S8_Float_SSE2;
+      case AE_FMT_S16NE :
+      case AE_FMT_S16LE : return &S16LE_Float_SSE2;
+      case AE_FMT_S16BE : return &S16BE_Float_SSE2;
+      case AE_FMT_S24NE4:
+      case AE_FMT_S24LE4: return &S24LE4_Float_SSE2;
+      case AE_FMT_S24BE4: return &S24BE4_Float_SSE2;
+      case AE_FMT_S24NE3:
+      case AE_FMT_S24LE3: return &S24LE3_Float_SSE2;
+      case AE_FMT_S24BE3: return &S24BE3_Float_SSE2;
+      case AE_FMT_S32NE :
+      case AE_FMT_S32LE : return &S32LE_Float_SSE2;
+      case AE_FMT_S32BE : return &S32BE_Float_SSE2;
+      case AE_FMT_DOUBLE: return &DOUBLE_Float_SSE2;
+      default:
+        return NULL;
+    }
+  }
+#endif
+
   switch (dataFormat)
   {
     case AE_FMT_U8    : return &U8_Float;
@@ -103,6 +1124,55 @@ CAEConvert::AEConvertToFn CAEConvert::ToFloat(enum AEDataFormat dataFormat)
 
 CAEConvert::AEConvertFrFn CAEConvert::FrFloat(enum AEDataFormat dataFormat)
 {
+  return FrFloat(dataFormat, g_cpuInfo.GetCPUFeatures());
+}
+
+CAEConvert::AEConvertFrFn CAEConvert::FrFloat(enum AEDataFormat dataFormat, unsigned int cpuFeatures)
+{
+#if defined(AE_SIMD_AVX2)
+  if (cpuFeatures & CPU_FEATURE_AVX2)
+  {
+    switch (dataFormat)
+    {
+      case AE_FMT_U8    : return &Float_U8_AVX2;
+      case AE_FMT_S8    : return &Float_S8_AVX2;
+      case AE_FMT_S16NE :
+      case AE_FMT_S16LE : return &Float_S16LE_AVX2;
+      case AE_FMT_S16BE : return &Float_S16BE_AVX2;
+      case AE_FMT_S24NE4: return &Float_S24NE4_AVX2;
+      case AE_FMT_S24NE3: return &Float_S24NE3_AVX2;
+      case AE_FMT_S32NE :
+      case AE_FMT_S32LE : return &Float_S32LE_AVX2;
+      case AE_FMT_S32BE : return &Float_S32BE_AVX2;
+      case AE_FMT_DOUBLE: return &Float_DOUBLE_AVX2;
+      default:
+        return NULL;
+    }
+  }
+#endif
+
+#if defined(AE_SIMD_SSE2)
+  if (cpuFeatures & CPU_FEATURE_SSE2)
+  {
+    switch (dataFormat)
+    {
+      case AE_FMT_U8    : return &Float_U8_SSE2;
+      case AE_FMT_S8    : return &Float_S8_SSE2;
+      case AE_FMT_S16NE :
+      case AE_FMT_S16LE : return &Float_S16LE_SSE2;
+      case AE_FMT_S16BE : return &Float_S16BE_SSE2;
+      case AE_FMT_S24NE4: return &Float_S24NE4_SSE2;
+      case AE_FMT_S24NE3: return &Float_S24NE3_SSE2;
+      case AE_FMT_S32NE :
+      case AE_FMT_S32LE : return &Float_S32LE_SSE2;
+      case AE_FMT_S32BE : return &Float_S32BE_SSE2;
+      case AE_FMT_DOUBLE: return &Float_DOUBLE_SSE2;
+      default:
+        return NULL;
+    }
+  }
+#endif
+
   switch (dataFormat)
   {
     case AE_FMT_U8    : return &Float_U8;
@@ -133,20 +1203,16 @@ CAEConvert::AEConvertFrFn CAEConvert::FrFloat(enum AEDataFormat dataFormat)
 
 unsigned int CAEConvert::U8_Float(uint8_t *data, const unsigned int samples, float *dest)
 {
-  const float mul = 2.0f / UINT8_MAX;
-
   for (unsigned int i = 0; i < samples; ++i)
-    *dest++ = *data++ * mul - 1.0f;
+    *dest++ = U8ToFloat(*data++);
 
   return samples;
 }
 
 unsigned int CAEConvert::S8_Float(uint8_t *data, const unsigned int samples, float *dest)
 {
-  const float mul = 1.0f / (INT8_MAX + 0.5f);
-
   for (unsigned int i = 0; i < samples; ++i)
-    *dest++ = *data++ * mul;
+    *dest++ = S8ToFloat(*data++);
 
   return samples;
 }
@@ -176,7 +1242,7 @@ unsigned int CAEConvert::S16LE_Float(uint8_t* data, const unsigned int samples,
   }
 #else
   for (unsigned int i = 0; i < samples; ++i, data += 2)
-    *dest++ = Endian_SwapLE16(*(int16_t*)data) * mul;
+    *dest++ = (int16_t)Endian_SwapLE16(*(int16_t*)data) * mul;
 #endif
 
   return samples;
@@ -207,7 +1273,7 @@ unsigned int CAEConvert::S16BE_Float(uint8_t* data, const unsigned int samples,
   }
 #else
   for (unsigned int i = 0; i < samples; ++i, data += 2)
-    *dest++ = Endian_SwapBE16(*(int16_t*)data) * mul;
+    *dest++ = (int16_t)Endian_SwapBE16(*(int16_t*)data) * mul;
 #endif
 
   return samples;
@@ -216,40 +1282,32 @@ unsigned int CAEConvert::S16BE_Float(uint8_t* data, const unsigned int samples,
 unsigned int CAEConvert::S24LE4_Float(uint8_t *data, const unsigned int samples, float *dest)
 {
   for (unsigned int i = 0; i < samples; ++i, data += 4)
-  {
-    int s = (data[2] << 24) | (data[1] << 16) | (data[0] << 8);
-    *dest++ = (float)s * INT32_SCALE;
-  }
+    *dest++ = S24ToFloat(data[2], data[1], data[0]);
+
   return samples;
 }
 
 unsigned int CAEConvert::S24BE4_Float(uint8_t *data, const unsigned int samples, float *dest)
 {
   for (unsigned int i = 0; i < samples; ++i, data += 4)
-  {
-    int s = (data[0] << 24) | (data[1] << 16) | (data[2] << 8);
-    *dest++ = (float)s * INT32_SCALE;
-  }
+    *dest++ = S24ToFloat(data[0], data[1], data[2]);
+
   return samples;
 }
 
 unsigned int CAEConvert::S24LE3_Float(uint8_t *data, const unsigned int samples, float *dest)
 {
   for (unsigned int i = 0; i < samples; ++i, data += 3)
-  {
-    int s = (data[2] << 24) | (data[1] << 16) | (data[0] << 8);
-    *dest++ = (float)s * INT32_SCALE;
-  }
+    *dest++ = S24ToFloat(data[2], data[1], data[0]);
+
   return samples;
 }
 
 unsigned int CAEConvert::S24BE3_Float(uint8_t *data, const unsigned int samples, float *dest)
 {
   for (unsigned int i = 0; i < samples; ++i, data += 3)
-  {
-    int s = (data[1] << 24) | (data[2] << 16) | (data[3] << 8);
-    *dest++ = (float)s * INT32_SCALE;
-  }
+    *dest++ = S24ToFloat(data[0], data[1], data[2]);
+
   return samples;
 }
 
@@ -261,15 +1319,15 @@ unsigned int CAEConvert::S32LE_Float(uint8_t *data, const unsigned int samples,
   /* do this in groups of 4 to give the compiler a better chance of optimizing this */
   for (float *end = dest + (samples & ~0x3); dest < end;)
   {
-    *dest++ = (float)Endian_SwapLE32(*src++) * factor;
-    *dest++ = (float)Endian_SwapLE32(*src++) * factor;
-    *dest++ = (float)Endian_SwapLE32(*src++) * factor;
-    *dest++ = (float)Endian_SwapLE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapLE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapLE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapLE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapLE32(*src++) * factor;
   }
 
   /* process any remaining samples */
   for (float *end = dest + (samples & 0x3); dest < end;)
-    *dest++ = (float)Endian_SwapLE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapLE32(*src++) * factor;
 
   return samples;
 }
@@ -320,15 +1378,15 @@ unsigned int CAEConvert::S32BE_Float(uint8_t *data, const unsigned int samples,
   /* do this in groups of 4 to give the compiler a better chance of optimizing this */
   for (float *end = dest + (samples & ~0x3); dest < end;)
   {
-    *dest++ = (float)Endian_SwapBE32(*src++) * factor;
-    *dest++ = (float)Endian_SwapBE32(*src++) * factor;
-    *dest++ = (float)Endian_SwapBE32(*src++) * factor;
-    *dest++ = (float)Endian_SwapBE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapBE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapBE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapBE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapBE32(*src++) * factor;
   }
 
   /* process any remaining samples */
   for (float *end = dest + (samples & 0x3); dest < end;)
-    *dest++ = (float)Endian_SwapBE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapBE32(*src++) * factor;
 
   return samples;
 }
@@ -375,141 +1433,23 @@ unsigned int CAEConvert::DOUBLE_Float(uint8_t *data, const unsigned int samples,
 {
   double *src = (double*)data;
   for (unsigned int i = 0; i < samples; ++i)
-    *dest++ = CLAMP(*src++ / (float)INT32_MAX);
+    *dest++ = CLAMP(*src++);
 
   return samples;
 }
 
 unsigned int CAEConvert::Float_U8(float *data, const unsigned int samples, uint8_t *dest)
 {
-  #ifdef __SSE__
-  const __m128 mul = _mm_set_ps1((float)INT8_MAX+.5f);
-  const __m128 add = _mm_set_ps1(1.0f);
-  unsigned int count = samples;
-
-  /* work around invalid alignment */
-  while ((((uintptr_t)data & 0xF) || ((uintptr_t)dest & 0xF)) && count > 0)
-  {
-    dest[0] = safeRound((data[0] + 1.0f) * ((float)INT8_MAX+.5f));
-    ++data;
-    ++dest;
-    --count;
-  }
-
-  const uint32_t even = count & ~0x3;
-  for (uint32_t i = 0; i < even; i += 4, data += 4)
-  {
-    __m128 in  = _mm_mul_ps(_mm_add_ps(_mm_load_ps(data), add), mul);
-    __m64  con = _mm_cvtps_pi16(in);
-
-    int16_t temp[4];
-    memcpy(temp, &con, sizeof(temp));
-    *dest++ = (uint8_t)temp[0];
-    *dest++ = (uint8_t)temp[1];
-    *dest++ = (uint8_t)temp[2];
-    *dest++ = (uint8_t)temp[3];
-  }
-
-  if (count != even)
-  {
-    const uint32_t odd = count - even;
-    if (odd == 1)
-    {
-      _mm_empty();
-      dest[0] = safeRound((data[0] + 1.0f) * ((float)INT8_MAX+.5f));
-    }
-    else
-    {
-      __m128 in;
-      if (odd == 2)
-      {
-        in = _mm_setr_ps(data[0], data[1], 0, 0);
-        in = _mm_mul_ps(_mm_add_ps(_mm_load_ps(data), add), mul);
-        __m64 con = _mm_cvtps_pi16(in);
-
-        int16_t temp[2];
-        memcpy(temp, &con, sizeof(temp));
-        dest[0] = (uint8_t)temp[0];
-        dest[1] = (uint8_t)temp[1];
-      }
-      else
-      {
-        in = _mm_setr_ps(data[0], data[1], data[2], 0);
-        in = _mm_mul_ps(_mm_add_ps(_mm_load_ps(data), add), mul);
-        __m64 con = _mm_cvtps_pi16(in);
-
-        int16_t temp[3];
-        memcpy(temp, &con, sizeof(temp));
-        dest[0] = (uint8_t)temp[0];
-        dest[1] = (uint8_t)temp[1];
-        dest[2] = (uint8_t)temp[2];
-      }
-    }
-  }
-  _mm_empty();
-  #else /* no SSE */
   for (uint32_t i = 0; i < samples; ++i)
-    *dest++ = safeRound((*data++ + 1.0f) * ((float)INT8_MAX+.5f));
-  #endif
+    *dest++ = FloatToU8(*data++);
 
   return samples;
 }
 
 unsigned int CAEConvert::Float_S8(float *data, const unsigned int samples, uint8_t *dest)
 {
-  #ifdef __SSE__
-  const __m128 mul = _mm_set_ps1((float)INT8_MAX+.5f);
-  unsigned int count = samples;
-
-  /* work around invalid alignment */
-  while ((((uintptr_t)data & 0xF) || ((uintptr_t)dest & 0xF)) && count > 0)
-  {
-    dest[0] = safeRound(data[0] * ((float)INT8_MAX+.5f));
-    ++data;
-    ++dest;
-    --count;
-  }
-
-  const uint32_t even = count & ~0x3;
-  for (uint32_t i = 0; i < even; i += 4, data += 4, dest += 4)
-  {
-    __m128 in  = _mm_mul_ps(_mm_load_ps(data), mul);
-    __m64  con = _mm_cvtps_pi8(in);
-    memcpy(dest, &con, 4);
-  }
-
-  if (count != even)
-  {
-    const uint32_t odd = count - even;
-    if (odd == 1)
-    {
-      _mm_empty();
-      dest[0] = safeRound(data[0] * ((float)INT8_MAX+.5f));
-    }
-    else
-    {
-      __m128 in;
-      if (odd == 2)
-      {
-        in = _mm_setr_ps(data[0], data[1], 0, 0);
-        in = _mm_mul_ps(_mm_load_ps(data), mul);
-        __m64 con = _mm_cvtps_pi8(in);
-        memcpy(dest, &con, 2);
-      }
-      else
-      {
-        in = _mm_setr_ps(data[0], data[1], data[2], 0);
-        in = _mm_mul_ps(_mm_load_ps(data), mul);
-        __m64 con = _mm_cvtps_pi8(in);
-        memcpy(dest, &con, 3);
-      }
-    }
-  }
-  _mm_empty();
-  #else /* no SSE */
   for (uint32_t i = 0; i < samples; ++i)
-    *dest++ = safeRound(*data++ * ((float)INT8_MAX+.5f));
-  #endif
+    *dest++ = FloatToS8(*data++);
 
   return samples;
 }
@@ -517,114 +1457,6 @@ unsigned int CAEConvert::Float_S8(float *data, const unsigned int samples, uint8
 unsigned int CAEConvert::Float_S16LE(float *data, const unsigned int samples, uint8_t *dest)
 {
   int16_t *dst = (int16_t*)dest;
-  #ifdef __SSE__
-
-  unsigned int count     = samples;
-  unsigned int unaligned = (0x10 - ((uintptr_t)data & 0xF)) >> 2;
-  if (unaligned == 4)
-    unaligned = 0;
-
-  /*
-    if we are only out by one, dont use SSE to correct it.
-    this must run before we do any SSE work so that the FPU
-    is in a working state without having to first call
-    _mm_empty()
-  */
-  if (unaligned == 1)
-    dst[0] = Endian_SwapLE16(safeRound(data[0] * ((float)INT16_MAX + CAEUtil::FloatRand1(-0.5f, 0.5f))));
-
-  MEMALIGN(16, static const __m128  mul) = _mm_set_ps1((float)INT16_MAX);
-  MEMALIGN(16, __m128  rand);
-  MEMALIGN(16, __m128  in  );
-  MEMALIGN(16, __m128i con );
-
-  /* if unaligned is greater then one, use SSE to correct it */
-  if (unaligned > 1)
-  {
-    switch (unaligned)
-    {
-      case 1: in = _mm_setr_ps(data[0], 0      , 0      , 0); break;
-      case 2: in = _mm_setr_ps(data[0], data[1], 0      , 0); break;
-      case 3: in = _mm_setr_ps(data[0], data[1], data[2], 0); break;
-    }
-
-    /* random round to dither */
-    CAEUtil::FloatRand4(-0.5f, 0.5f, NULL, &rand);
-    in  = _mm_mul_ps(in, _mm_add_ps(mul, rand));
-    con = _mm_cvtps_epi32(in);
-
-    #ifdef __BIG_ENDIAN__
-    con = _mm_or_si128(_mm_slli_epi16(con, 8), _mm_srli_epi16(con, 8));
-    #endif
-
-    dst[0] = _mm_extract_epi16(con, 0);
-    if (unaligned == 3)
-    {
-      dst[1] = _mm_extract_epi16(con, 2);
-      dst[2] = _mm_extract_epi16(con, 4);
-    }
-    else if (unaligned == 2)
-      dst[1] = _mm_extract_epi16(con, 2);
-  }
-
-  /* update our pointers and sample count */
-  data  += unaligned;
-  dst   += unaligned;
-  count -= unaligned;
-
-  const uint32_t even = count & ~0x3;
-  for (uint32_t i = 0; i < even; i += 4, data += 4, dst += 4)
-  {
-    /* random round to dither */
-    CAEUtil::FloatRand4(-0.5f, 0.5f, NULL, &rand);
-    in   = _mm_mul_ps(_mm_load_ps(data), _mm_add_ps(mul, rand));
-    con  = _mm_cvtps_epi32(in);
-
-    #ifdef __BIG_ENDIAN__
-    con = _mm_or_si128(_mm_slli_epi16(con, 8), _mm_srli_epi16(con, 8));
-    #endif
-
-    dst[0] = _mm_extract_epi16(con, 0);
-    dst[1] = _mm_extract_epi16(con, 2);
-    dst[2] = _mm_extract_epi16(con, 4);
-    dst[3] = _mm_extract_epi16(con, 6);
-  }
-
-  /* calculate the final unaligned samples if there is any */
-  if (samples != even)
-  {
-    unaligned = samples - even;
-    switch (unaligned)
-    {
-      case 1: in = _mm_setr_ps(data[0], 0      , 0      , 0); break;
-      case 2: in = _mm_setr_ps(data[0], data[1], 0      , 0); break;
-      case 3: in = _mm_setr_ps(data[0], data[1], data[2], 0); break;
-    }
-
-    /* random round to dither */
-    CAEUtil::FloatRand4(-0.5f, 0.5f, NULL, &rand);
-    in  = _mm_mul_ps(in, _mm_add_ps(mul, rand));
-    con = _mm_cvtps_epi32(in);
-
-    #ifdef __BIG_ENDIAN__
-    con = _mm_or_si128(_mm_slli_epi16(con, 8), _mm_srli_epi16(con, 8));
-    #endif
-
-    dst[0] = _mm_extract_epi16(con, 0);
-    if (unaligned == 3)
-    {
-      dst[1] = _mm_extract_epi16(con, 2);
-      dst[2] = _mm_extract_epi16(con, 4);
-    }
-    else if (unaligned == 2)
-      dst[1] = _mm_extract_epi16(con, 2);
-  }
-
-  /* cleanup */
-  _mm_empty();
-
-  #else /* no SSE */
-
   uint32_t i    = 0;
   uint32_t even = samples & ~0x3;
 
@@ -634,16 +1466,14 @@ unsigned int CAEConvert::Float_S16LE(float *data, const unsigned int samples, ui
     float rand[4];
     CAEUtil::FloatRand4(-0.5f, 0.5f, rand);
 
-    *dst++ = Endian_SwapLE16(safeRound(*data++ * ((float)INT16_MAX + rand[0])));
-    *dst++ = Endian_SwapLE16(safeRound(*data++ * ((float)INT16_MAX + rand[1])));
-    *dst++ = Endian_SwapLE16(safeRound(*data++ * ((float)INT16_MAX + rand[2])));
-    *dst++ = Endian_SwapLE16(safeRound(*data++ * ((float)INT16_MAX + rand[3])));
+    *dst++ = Endian_SwapLE16(FloatToS16(*data++, rand[0]));
+    *dst++ = Endian_SwapLE16(FloatToS16(*data++, rand[1]));
+    *dst++ = Endian_SwapLE16(FloatToS16(*data++, rand[2]));
+    *dst++ = Endian_SwapLE16(FloatToS16(*data++, rand[3]));
   }
 
   for(; i < samples; ++i)
-    *dst++ = Endian_SwapLE16(safeRound(*data++ * ((float)INT16_MAX + CAEUtil::FloatRand1(-0.5f, 0.5f))));
-
-  #endif
+    *dst++ = Endian_SwapLE16(FloatToS16(*data++, CAEUtil::FloatRand1(-0.5f, 0.5f)));
 
   return samples << 1;
 }
@@ -651,114 +1481,6 @@ unsigned int CAEConvert::Float_S16LE(float *data, const unsigned int samples, ui
 unsigned int CAEConvert::Float_S16BE(float *data, const unsigned int samples, uint8_t *dest)
 {
   int16_t *dst = (int16_t*)dest;
-  #ifdef __SSE__
-
-  unsigned int count     = samples;
-  unsigned int unaligned = (0x10 - ((uintptr_t)data & 0xF)) >> 2;
-  if (unaligned == 4)
-    unaligned = 0;
-
-  /*
-    if we are only out by one, dont use SSE to correct it.
-    this must run before we do any SSE work so that the FPU
-    is in a working state without having to first call
-    _mm_empty()
-  */
-  if (unaligned == 1)
-     dst[0] = Endian_SwapBE16(safeRound(data[0] * ((float)INT16_MAX + CAEUtil::FloatRand1(-0.5f, 0.5f))));
-
-  MEMALIGN(16, static const __m128  mul) = _mm_set_ps1((float)INT16_MAX);
-  MEMALIGN(16, __m128  rand);
-  MEMALIGN(16, __m128  in  ) = _mm_setr_ps(0, 0, 0, 0);
-  MEMALIGN(16, __m128i con );
-
-  /* if unaligned is greater then one, use SSE to correct it */
-  if (unaligned > 1)
-  {
-    switch (unaligned)
-    {
-      case 1: in = _mm_setr_ps(data[0], 0      , 0      , 0); break;
-      case 2: in = _mm_setr_ps(data[0], data[1], 0      , 0); break;
-      case 3: in = _mm_setr_ps(data[0], data[1], data[2], 0); break;
-    }
-
-    /* random round to dither */
-    CAEUtil::FloatRand4(-0.5f, 0.5f, NULL, &rand);
-    in  = _mm_mul_ps(in, _mm_add_ps(mul, rand));
-    con = _mm_cvtps_epi32(in);
-
-    #ifndef __BIG_ENDIAN__
-    con = _mm_or_si128(_mm_slli_epi16(con, 8), _mm_srli_epi16(con, 8));
-    #endif
-
-    dst[0] = _mm_extract_epi16(con, 0);
-    if (unaligned == 3)
-    {
-      dst[1] = _mm_extract_epi16(con, 2);
-      dst[2] = _mm_extract_epi16(con, 4);
-    }
-    else if (unaligned == 2)
-      dst[1] = _mm_extract_epi16(con, 2);
-  }
-
-  /* update our pointers and sample count */
-  data  += unaligned;
-  dst   += unaligned;
-  count -= unaligned;
-
-  const uint32_t even = count & ~0x3;
-  for (uint32_t i = 0; i < even; i += 4, data += 4, dst += 4)
-  {
-    /* random round to dither */
-    CAEUtil::FloatRand4(-0.5f, 0.5f, NULL, &rand);
-    in   = _mm_mul_ps(_mm_load_ps(data), _mm_add_ps(mul, rand));
-    con  = _mm_cvtps_epi32(in);
-
-    #ifndef __BIG_ENDIAN__
-    con = _mm_or_si128(_mm_slli_epi16(con, 8), _mm_srli_epi16(con, 8));
-    #endif
-
-    dst[0] = _mm_extract_epi16(con, 0);
-    dst[1] = _mm_extract_epi16(con, 2);
-    dst[2] = _mm_extract_epi16(con, 4);
-    dst[3] = _mm_extract_epi16(con, 6);
-  }
-
-  /* calculate the final unaligned samples if there is any */
-  if (samples != even)
-  {
-    unaligned = samples - even;
-    switch (unaligned)
-    {
-      case 1: in = _mm_setr_ps(data[0], 0      , 0      , 0); break;
-      case 2: in = _mm_setr_ps(data[0], data[1], 0      , 0); break;
-      case 3: in = _mm_setr_ps(data[0], data[1], data[2], 0); break;
-    }
-
-    /* random round to dither */
-    CAEUtil::FloatRand4(-0.5f, 0.5f, NULL, &rand);
-    in  = _mm_mul_ps(in, _mm_add_ps(mul, rand));
-    con = _mm_cvtps_epi32(in);
-
-    #ifndef __BIG_ENDIAN__
-    con = _mm_or_si128(_mm_slli_epi16(con, 8), _mm_srli_epi16(con, 8));
-    #endif
-
-    dst[0] = _mm_extract_epi16(con, 0);
-    if (unaligned == 3)
-    {
-      dst[1] = _mm_extract_epi16(con, 2);
-      dst[2] = _mm_extract_epi16(con, 4);
-    }
-    else if (unaligned == 2)
-      dst[1] = _mm_extract_epi16(con, 2);
-  }
-
-  /* cleanup */
-  _mm_empty();
-
-  #else /* no SSE */
-
   uint32_t i    = 0;
   uint32_t even = samples & ~0x3;
 
@@ -768,16 +1490,14 @@ unsigned int CAEConvert::Float_S16BE(float *data, const unsigned int samples, ui
     float rand[4];
     CAEUtil::FloatRand4(-0.5f, 0.5f, rand);
 
-    *dst++ = Endian_SwapBE16(safeRound(*data++ * ((float)INT16_MAX + rand[0])));
-    *dst++ = Endian_SwapBE16(safeRound(*data++ * ((float)INT16_MAX + rand[1])));
-    *dst++ = Endian_SwapBE16(safeRound(*data++ * ((float)INT16_MAX + rand[2])));
-    *dst++ = Endian_SwapBE16(safeRound(*data++ * ((float)INT16_MAX + rand[3])));
+    *dst++ = Endian_SwapBE16(FloatToS16(*data++, rand[0]));
+    *dst++ = Endian_SwapBE16(FloatToS16(*data++, rand[1]));
+    *dst++ = Endian_SwapBE16(FloatToS16(*data++, rand[2]));
+    *dst++ = Endian_SwapBE16(FloatToS16(*data++, rand[3]));
   }
 
-  for(; i < samples; ++i, data++, dst++)
-    *dst++ = Endian_SwapBE16(safeRound(*data++ * ((float)INT16_MAX + CAEUtil::FloatRand1(-0.5f, 0.5f))));
-
-  #endif
+  for(; i < samples; ++i)
+    *dst++ = Endian_SwapBE16(FloatToS16(*data++, CAEUtil::FloatRand1(-0.5f, 0.5f)));
 
   return samples << 1;
 }
@@ -785,139 +1505,27 @@ unsigned int CAEConvert::Float_S16BE(float *data, const unsigned int samples, ui
 unsigned int CAEConvert::Float_S24NE4(float *data, const unsigned int samples, uint8_t *dest)
 {
   int32_t *dst = (int32_t*)dest;
-  #ifdef __SSE__
-
-  const __m128 mul = _mm_set_ps1((float)INT24_MAX+.5f);
-  unsigned int count = samples;
-
-  /* work around invalid alignment */
-  while ((((uintptr_t)data & 0xF) || ((uintptr_t)dest & 0xF)) && count > 0)
-  {
-    dst[0] = safeRound(data[0] * ((float)INT24_MAX+.5f));
-    ++data;
-    ++dst;
-    --count;
-  }
-
-  const uint32_t even = count & ~0x3;
-  for (uint32_t i = 0; i < even; i += 4, data += 4, dst += 4)
-  {
-    __m128  in  = _mm_mul_ps(_mm_load_ps(data), mul);
-    __m128i con = _mm_cvtps_epi32(in);
-    con         = _mm_slli_epi32(con, 8);
-    memcpy(dst, &con, sizeof(int32_t) * 4);
-  }
-
-  if (samples != even)
-  {
-    const uint32_t odd = samples - even;
-    if (odd == 1)
-      dst[0] = safeRound(data[0] * ((float)INT24_MAX+.5f));
-    else
-    {
-      __m128 in;
-      if (odd == 2)
-      {
-        in = _mm_setr_ps(data[0], data[1], 0, 0);
-        in = _mm_mul_ps(in, mul);
-        __m64 con = _mm_cvtps_pi32(in);
-        con       = _mm_slli_pi32(con, 8);
-        memcpy(dst, &con, sizeof(int32_t) * 2);
-      }
-      else
-      {
-        in = _mm_setr_ps(data[0], data[1], data[2], 0);
-        in = _mm_mul_ps(in, mul);
-        __m128i con = _mm_cvtps_epi32(in);
-        con         = _mm_slli_epi32(con, 8);
-        memcpy(dst, &con, sizeof(int32_t) * 3);
-      }
-    }
-  }
-  _mm_empty();
-  #else /* no SSE */
   for (uint32_t i = 0; i < samples; ++i)
-    *dst++ = (safeRound(*data++ * ((float)INT24_MAX+.5f)) & 0xFFFFFF) << 8;
-  #endif
+    *dst++ = (int32_t)((uint32_t)FloatToS24(*data++) << 8);
 
   return samples << 2;
 }
 
 unsigned int CAEConvert::Float_S24NE3(float *data, const unsigned int samples, uint8_t *dest)
 {
-  /* We do not want to shift for S24LE3, since left-shifting would actually
-   * push the MSB to the 4th byte. */
-  const int leftShift =
+  for (uint32_t i = 0; i < samples; ++i, dest += 3)
+  {
+    const int32_t s = FloatToS24(*data++);
 #ifdef __BIG_ENDIAN__
-    8;
+    dest[0] = (uint8_t)(s >> 16);
+    dest[1] = (uint8_t)(s >> 8 );
+    dest[2] = (uint8_t)(s      );
 #else
-    0;
+    dest[0] = (uint8_t)(s      );
+    dest[1] = (uint8_t)(s >> 8 );
+    dest[2] = (uint8_t)(s >> 16);
 #endif
-
-  /* disabled as it does not currently work */
-  #if 0 && defined(__SSE__)
-  int32_t *dst = (int32_t*)dest;
-
-  const __m128 mul = _mm_set_ps1((float)INT24_MAX+.5f);
-  unsigned int count = samples;
-
-  /* work around invalid alignment */
-  while ((((uintptr_t)data & 0xF) || ((uintptr_t)dest & 0xF)) && count > 0)
-  {
-    *((uint32_t*)(dest)) = (safeRound(*data * ((float)INT24_MAX+.5f)) & 0xFFFFFF) << leftShift;
-    ++dest;
-    --count;
-  }
-
-  const uint32_t even = count & ~0x3;
-  for (uint32_t i = 0; i < count; i += 4, data += 4, dest += 12)
-  {
-    __m128  in  = _mm_mul_ps(_mm_load_ps(data), mul);
-    __m128i con = _mm_cvtps_epi32(in);
-    con         = _mm_slli_epi32(con, 8);
-    memcpy(dst, &con, sizeof(int32_t) * 4);
-    *((uint32_t*)(dest + 0)) = (dst[0] & 0xFFFFFF) << leftShift;
-    *((uint32_t*)(dest + 3)) = (dst[1] & 0xFFFFFF) << leftShift;
-    *((uint32_t*)(dest + 6)) = (dst[2] & 0xFFFFFF) << leftShift;
-    *((uint32_t*)(dest + 9)) = (dst[3] & 0xFFFFFF) << leftShift;
-  }
-
-  if (samples != even)
-  {
-    const uint32_t odd = samples - even;
-    if (odd == 1)
-      dst[0] = safeRound(data[0] * ((float)INT24_MAX+.5f)) & 0xFFFFFF;
-    else
-    {
-      __m128 in;
-      if (odd == 2)
-      {
-        in = _mm_setr_ps(data[0], data[1], 0, 0);
-        in = _mm_mul_ps(in, mul);
-        __m64 con = _mm_cvtps_pi32(in);
-        con       = _mm_slli_pi32(con, 8);
-        memcpy(dst, &con, sizeof(int32_t) * 2);
-        *((uint32_t*)(dest + 0)) = (dst[0] & 0xFFFFFF) << leftShift;
-        *((uint32_t*)(dest + 3)) = (dst[1] & 0xFFFFFF) << leftShift;
-      }
-      else
-      {
-        in = _mm_setr_ps(data[0], data[1], data[2], 0);
-        in = _mm_mul_ps(in, mul);
-        __m128i con = _mm_cvtps_epi32(in);
-        con         = _mm_slli_epi32(con, 8);
-        memcpy(dst, &con, sizeof(int32_t) * 3);
-        *((uint32_t*)(dest + 0)) = (dst[0] & 0xFFFFFF) << leftShift;
-        *((uint32_t*)(dest + 3)) = (dst[1] & 0xFFFFFF) << leftShift;
-        *((uint32_t*)(dest + 6)) = (dst[2] & 0xFFFFFF) << leftShift;
-      }
-    }
   }
-  _mm_empty();
-  #else /* no SSE */
-  for (uint32_t i = 0; i < samples; ++i, ++data, dest += 3)
-    *((uint32_t*)(dest)) = (safeRound(*data * ((float)INT24_MAX+.5f)) & 0xFFFFFF) << leftShift;
-  #endif
 
   return samples * 3;
 }
@@ -925,77 +1533,12 @@ unsigned int CAEConvert::Float_S24NE3(float *data, const unsigned int samples, u
 unsigned int CAEConvert::Float_S32LE(float *data, const unsigned int samples, uint8_t *dest)
 {
   int32_t *dst = (int32_t*)dest;
-  #ifdef __SSE__
-  const __m128 mul = _mm_set_ps1((float)INT32_MAX);
-  unsigned int count = samples;
-
-  /* work around invalid alignment */
-  while ((((uintptr_t)data & 0xF) || ((uintptr_t)dest & 0xF)) && count > 0)
-  {
-    dst[0] = safeRound(data[0] * (float)INT32_MAX);
-    ++data;
-    ++dst;
-    --count;
-  }
-
-  const uint32_t even = count & ~0x3;
-  for (uint32_t i = 0; i < even; i += 4, data += 4, dst += 4)
-  {
-    __m128  in  = _mm_mul_ps(_mm_load_ps(data), mul);
-    __m128i con = _mm_cvtps_epi32(in);
-    memcpy(dst, &con, sizeof(int32_t) * 4);
-    dst[0] = Endian_SwapLE32(dst[0]);
-    dst[1] = Endian_SwapLE32(dst[1]);
-    dst[2] = Endian_SwapLE32(dst[2]);
-    dst[3] = Endian_SwapLE32(dst[3]);
-  }
-
-  if (samples != even)
-  {
-    const uint32_t odd = samples - even;
-    if (odd == 1)
-    {
-      dst[0] = safeRound(data[0] * (float)INT32_MAX);
-      dst[0] = Endian_SwapLE32(dst[0]);
-    }
-    else
-    {
-      __m128 in;
-      if (odd == 2)
-      {
-        in = _mm_setr_ps(data[0], data[1], 0, 0);
-        in = _mm_mul_ps(in, mul);
-        __m64 con = _mm_cvtps_pi32(in);
-        memcpy(dst, &con, sizeof(int32_t) * 2);
-        dst[0] = Endian_SwapLE32(dst[0]);
-        dst[1] = Endian_SwapLE32(dst[1]);
-      }
-      else
-      {
-        in = _mm_setr_ps(data[0], data[1], data[2], 0);
-        in = _mm_mul_ps(in, mul);
-        __m128i con = _mm_cvtps_epi32(in);
-        memcpy(dst, &con, sizeof(int32_t) * 3);
-        dst[0] = Endian_SwapLE32(dst[0]);
-        dst[1] = Endian_SwapLE32(dst[1]);
-        dst[2] = Endian_SwapLE32(dst[2]);
-      }
-    }
-  }
-  _mm_empty();
-  #else
+  for (uint32_t i = 0; i < samples; ++i)
+    *dst++ = Endian_SwapLE32(FloatToS32(*data++));
 
-  /* no SIMD */
-  for (uint32_t i = 0; i < samples; ++i, ++data, ++dst)
-  {
-    dst[0] = safeRound(data[0] * (float)INT32_MAX);
-    dst[0] = Endian_SwapLE32(dst[0]);
-  }
-  #endif
   return samples << 2;
 }
 
-
 unsigned int CAEConvert::Float_S32LE_Neon(float *data, const unsigned int samples, uint8_t *dest)
 {
 #if defined(__ARM_NEON__)
@@ -1034,72 +1577,8 @@ unsigned int CAEConvert::Float_S32LE_Neon(float *data, const unsigned int sample
 unsigned int CAEConvert::Float_S32BE(float *data, const unsigned int samples, uint8_t *dest)
 {
   int32_t *dst = (int32_t*)dest;
-  #ifdef __SSE__
-  const __m128 mul = _mm_set_ps1((float)INT32_MAX);
-  unsigned int count = samples;
-
-  /* work around invalid alignment */
-  while ((((uintptr_t)data & 0xF) || ((uintptr_t)dest & 0xF)) && count > 0)
-  {
-    dst[0] = safeRound(data[0] * (float)INT32_MAX);
-    ++data;
-    ++dst;
-    --count;
-  }
-
-  const uint32_t even = count & ~0x3;
-  for (uint32_t i = 0; i < even; i += 4, data += 4, dst += 4)
-  {
-    __m128  in  = _mm_mul_ps(_mm_load_ps(data), mul);
-    __m128i con = _mm_cvtps_epi32(in);
-    memcpy(dst, &con, sizeof(int32_t) * 4);
-    dst[0] = Endian_SwapBE32(dst[0]);
-    dst[1] = Endian_SwapBE32(dst[1]);
-    dst[2] = Endian_SwapBE32(dst[2]);
-    dst[3] = Endian_SwapBE32(dst[3]);
-  }
-
-  if (samples != even)
-  {
-    const uint32_t odd = samples - even;
-    if (odd == 1)
-    {
-      dst[0] = safeRound(data[0] * (float)INT32_MAX);
-      dst[0] = Endian_SwapBE32(dst[0]);
-    }
-    else
-    {
-      __m128 in;
-      if (odd == 2)
-      {
-        in = _mm_setr_ps(data[0], data[1], 0, 0);
-        in = _mm_mul_ps(in, mul);
-        __m64 con = _mm_cvtps_pi32(in);
-        memcpy(dst, &con, sizeof(int32_t) * 2);
-        dst[0] = Endian_SwapBE32(dst[0]);
-        dst[1] = Endian_SwapBE32(dst[1]);
-      }
-      else
-      {
-        in = _mm_setr_ps(data[0], data[1], data[2], 0);
-        in = _mm_mul_ps(in, mul);
-        __m128i con = _mm_cvtps_epi32(in);
-        memcpy(dst, &con, sizeof(int32_t) * 3);
-        dst[0] = Endian_SwapBE32(dst[0]);
-        dst[1] = Endian_SwapBE32(dst[1]);
-        dst[2] = Endian_SwapBE32(dst[2]);
-      }
-    }
-  }
-  _mm_empty();
-  #else
-  /* no SIMD */
-  for (uint32_t i = 0; i < samples; ++i, ++data, ++dst)
-  {
-    dst[0] = safeRound(data[0] * (float)INT32_MAX);
-    dst[0] = Endian_SwapBE32(dst[0]);
-  }
-  #endif
+  for (uint32_t i = 0; i < samples; ++i)
+    *dst++ = Endian_SwapBE32(FloatToS32(*data++));
 
   return samples << 2;
 }
@@ -1147,4 +1626,3 @@ unsigned int CAEConvert::Float_DOUBLE(float *data, const unsigned int samples, u
 
   return samples * sizeof(double);
 }
-
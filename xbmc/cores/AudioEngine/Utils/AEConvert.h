@@ -55,7 +55,12 @@ public:
   typedef unsigned int (*AEConvertToFn)(uint8_t *data, const unsigned int samples, float   *dest);
   typedef unsigned int (*AEConvertFrFn)(float   *data, const unsigned int samples, uint8_t *dest);
 
+  /* returns the fastest conversion for the running CPU */
   static AEConvertToFn ToFloat(enum AEDataFormat dataFormat);
   static AEConvertFrFn FrFloat(enum AEDataFormat dataFormat);
+
+  /* returns the conversion for the given CPU_FEATURE_* flags, 0 selects the scalar version */
+  static AEConvertToFn ToFloat(enum AEDataFormat dataFormat, unsigned int cpuFeatures);
+  static AEConvertFrFn FrFloat(enum AEDataFormat dataFormat, unsigned int cpuFeatures);
 };
 
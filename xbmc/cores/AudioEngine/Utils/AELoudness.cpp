@@ -0,0 +1,290 @@
+/*
+ *      Copyright (C) 2010-2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AELoudness.h"
+
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* taps per phase of the true peak oversampling filter */
+#define AE_LOUDNESS_TP_TAPS 12
+
+/* BS.1770 gates, in LUFS and LU */
+#define AE_LOUDNESS_ABSOLUTE_GATE -70.0
+#define AE_LOUDNESS_RELATIVE_GATE -10.0
+
+static inline double EnergyToLoudness(double energy)
+{
+  return -0.691 + 10.0 * log10(energy);
+}
+
+CAELoudness::CAELoudness() :
+  m_channels      (0),
+  m_sampleRate    (0),
+  m_subBlockFrames(0),
+  m_subBlockFill  (0),
+  m_subBlockEnergy(0.0),
+  m_subBlockCount (0),
+  m_oversample    (1),
+  m_tpIndex       (0),
+  m_truePeak      (0.0)
+{
+}
+
+CAELoudness::~CAELoudness()
+{
+}
+
+bool CAELoudness::Initialize(const CAEChannelInfo &channelLayout, unsigned int sampleRate)
+{
+  m_channels   = channelLayout.Count();
+  m_sampleRate = sampleRate;
+  if (!m_channels || m_sampleRate < 8000)
+  {
+    m_channels = 0;
+    return false;
+  }
+
+  m_weights.resize(m_channels);
+  for (unsigned int c = 0; c < m_channels; ++c)
+  {
+    switch (channelLayout[c])
+    {
+      case AE_CH_LFE:
+        m_weights[c] = 0.0;
+        break;
+
+      case AE_CH_SL:
+      case AE_CH_SR:
+      case AE_CH_BL:
+      case AE_CH_BR:
+        m_weights[c] = 1.41;
+        break;
+
+      default:
+        m_weights[c] = 1.0;
+        break;
+    }
+  }
+
+  m_subBlockFrames = m_sampleRate / 10;
+
+  /* BS.1770 asks for at least 192kHz, so oversample everything below it */
+  if      (m_sampleRate <  96000) m_oversample = 4;
+  else if (m_sampleRate < 192000) m_oversample = 2;
+  else                            m_oversample = 1;
+
+  SetupFilters();
+  Reset();
+  return true;
+}
+
+void CAELoudness::SetupFilters()
+{
+  /*
+    the K-weighting filters of BS.1770 are only specified at 48kHz, these are
+    the analog prototypes they were derived from so any rate can be used
+  */
+  const double rate = (double)m_sampleRate;
+
+  /* stage 1, a +4dB high shelf modelling the head */
+  {
+    const double f0 = 1681.974450955533;
+    const double G  = 3.999843853973347;
+    const double Q  = 0.7071752369554196;
+    const double K  = tan(M_PI * f0 / rate);
+    const double Vh = pow(10.0, G / 20.0);
+    const double Vb = pow(Vh, 0.4996667741545416);
+    const double a0 = 1.0 + K / Q + K * K;
+
+    m_shelf.b0 = (Vh + Vb * K / Q + K * K) / a0;
+    m_shelf.b1 = 2.0 * (K * K - Vh) / a0;
+    m_shelf.b2 = (Vh - Vb * K / Q + K * K) / a0;
+    m_shelf.a1 = 2.0 * (K * K - 1.0) / a0;
+    m_shelf.a2 = (1.0 - K / Q + K * K) / a0;
+  }
+
+  /* stage 2, the RLB high pass */
+  {
+    const double f0 = 38.13547087602444;
+    const double Q  = 0.5003270373238773;
+    const double K  = tan(M_PI * f0 / rate);
+    const double a0 = 1.0 + K / Q + K * K;
+
+    m_highPass.b0 =  1.0;
+    m_highPass.b1 = -2.0;
+    m_highPass.b2 =  1.0;
+    m_highPass.a1 = 2.0 * (K * K - 1.0) / a0;
+    m_highPass.a2 = (1.0 - K / Q + K * K) / a0;
+  }
+
+  /*
+    hann windowed sinc cut off at the input nyquist frequency, each phase is
+    normalised to unity gain so a constant signal reads the same at any phase
+  */
+  const unsigned int length = AE_LOUDNESS_TP_TAPS * m_oversample;
+  m_tpFilter.resize(length);
+  for (unsigned int i = 0; i < length; ++i)
+  {
+    const double x      = ((double)i - (length - 1) * 0.5) / m_oversample;
+    const double sinc   = x == 0.0 ? 1.0 : sin(M_PI * x) / (M_PI * x);
+    const double window = 0.5 - 0.5 * cos(2.0 * M_PI * (i + 0.5) / length);
+    m_tpFilter[i] = (float)(sinc * window);
+  }
+
+  /* store each phase contiguously, tap k of phase p multiplies the input k frames back */
+  std::vector<float> phases(length);
+  for (unsigned int p = 0; p < m_oversample; ++p)
+  {
+    double sum = 0.0;
+    for (unsigned int k = 0; k < AE_LOUDNESS_TP_TAPS; ++k)
+      sum += m_tpFilter[p + k * m_oversample];
+    for (unsigned int k = 0; k < AE_LOUDNESS_TP_TAPS; ++k)
+      phases[p * AE_LOUDNESS_TP_TAPS + k] = (float)(m_tpFilter[p + k * m_oversample] / sum);
+  }
+  m_tpFilter.swap(phases);
+}
+
+void CAELoudness::Reset()
+{
+  BiquadState zero = { 0.0, 0.0, 0.0, 0.0 };
+  m_state.assign(m_channels * 2, zero);
+
+  m_subBlockFill   = 0;
+  m_subBlockEnergy = 0.0;
+  m_subBlockCount  = 0;
+  for (unsigned int i = 0; i < 4; ++i)
+    m_subBlocks[i] = 0.0;
+  m_blocks.clear();
+
+  m_tpHistory.assign(m_channels * AE_LOUDNESS_TP_TAPS * 2, 0.0f);
+  m_tpIndex  = 0;
+  m_truePeak = 0.0;
+}
+
+void CAELoudness::Process(const float *data, unsigned int frames)
+{
+  if (!m_channels)
+    return;
+
+  const Biquad &s = m_shelf;
+  const Biquad &h = m_highPass;
+
+  for (unsigned int f = 0; f < frames; ++f, data += m_channels)
+  {
+    /* the history runs backwards so the newest frame is always at m_tpIndex */
+    m_tpIndex = (m_tpIndex + AE_LOUDNESS_TP_TAPS - 1) % AE_LOUDNESS_TP_TAPS;
+
+    for (unsigned int c = 0; c < m_channels; ++c)
+    {
+      const double x = data[c];
+
+      if (m_weights[c] != 0.0)
+      {
+        BiquadState &s1 = m_state[c * 2    ];
+        BiquadState &s2 = m_state[c * 2 + 1];
+
+        const double y1 = s.b0 * x + s.b1 * s1.x1 + s.b2 * s1.x2 - s.a1 * s1.y1 - s.a2 * s1.y2;
+        s1.x2 = s1.x1; s1.x1 = x;
+        s1.y2 = s1.y1; s1.y1 = y1;
+
+        const double y2 = h.b0 * y1 + h.b1 * s2.x1 + h.b2 * s2.x2 - h.a1 * s2.y1 - h.a2 * s2.y2;
+        s2.x2 = s2.x1; s2.x1 = y1;
+        s2.y2 = s2.y1; s2.y1 = y2;
+
+        m_subBlockEnergy += m_weights[c] * y2 * y2;
+      }
+
+      float *hist = &m_tpHistory[c * AE_LOUDNESS_TP_TAPS * 2];
+      hist[m_tpIndex] = hist[m_tpIndex + AE_LOUDNESS_TP_TAPS] = data[c];
+      hist += m_tpIndex;
+
+      const float *phase = &m_tpFilter[0];
+      for (unsigned int p = 0; p < m_oversample; ++p, phase += AE_LOUDNESS_TP_TAPS)
+      {
+        float sum = 0.0f;
+        for (unsigned int k = 0; k < AE_LOUDNESS_TP_TAPS; ++k)
+          sum += phase[k] * hist[k];
+        if (fabs(sum) > m_truePeak)
+          m_truePeak = fabs(sum);
+      }
+
+      /* the interpolation can miss a sample peak by a hair, never report less than it */
+      if (fabs(x) > m_truePeak)
+        m_truePeak = fabs(x);
+    }
+
+    if (++m_subBlockFill == m_subBlockFrames)
+      EndSubBlock();
+  }
+}
+
+void CAELoudness::EndSubBlock()
+{
+  m_subBlocks[m_subBlockCount & 3] = m_subBlockEnergy;
+  m_subBlockEnergy = 0.0;
+  m_subBlockFill   = 0;
+
+  /* gating blocks are 400ms long and overlap by 75% */
+  if (++m_subBlockCount < 4)
+    return;
+
+  const double energy = m_subBlocks[0] + m_subBlocks[1] + m_subBlocks[2] + m_subBlocks[3];
+  m_blocks.push_back(energy / (4.0 * m_subBlockFrames));
+}
+
+bool CAELoudness::GetIntegratedLoudness(double &loudness) const
+{
+  /* the absolute gate, blocks of near silence are ignored */
+  const double absolute = pow(10.0, (AE_LOUDNESS_ABSOLUTE_GATE + 0.691) / 10.0);
+  double sum   = 0.0;
+  size_t count = 0;
+  for (std::vector<double>::const_iterator it = m_blocks.begin(); it != m_blocks.end(); ++it)
+    if (*it > absolute)
+    {
+      sum += *it;
+      ++count;
+    }
+
+  if (!count)
+    return false;
+
+  /* the relative gate, 10 LU below the loudness of what passed the absolute one */
+  const double relative = sum / count * pow(10.0, AE_LOUDNESS_RELATIVE_GATE / 10.0);
+  const double gate     = relative > absolute ? relative : absolute;
+  sum   = 0.0;
+  count = 0;
+  for (std::vector<double>::const_iterator it = m_blocks.begin(); it != m_blocks.end(); ++it)
+    if (*it > gate)
+    {
+      sum += *it;
+      ++count;
+    }
+
+  if (!count)
+    return false;
+
+  loudness = EnergyToLoudness(sum / count);
+  return true;
+}
+
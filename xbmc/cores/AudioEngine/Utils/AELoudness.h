@@ -0,0 +1,100 @@
+#pragma once
+/*
+ *      Copyright (C) 2010-2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <vector>
+#include "AEChannelInfo.h"
+
+/*
+  EBU R128 / ITU-R BS.1770 loudness meter for interleaved float audio.
+
+  Measures the integrated (gated) loudness of everything passed to Process, and
+  the true peak from a 4x oversampled signal.
+*/
+class CAELoudness
+{
+public:
+  CAELoudness();
+  ~CAELoudness();
+
+  /*!
+   \brief Set up the meter, can be called again to measure another stream.
+   \param channelLayout the layout of the interleaved frames, LFE channels are not measured.
+   \param sampleRate the sample rate of the frames.
+   \return false if the parameters are invalid.
+   */
+  bool Initialize(const CAEChannelInfo &channelLayout, unsigned int sampleRate);
+
+  /* forget everything measured so far */
+  void Reset();
+
+  /* measure interleaved frames, the stream can be split at any point */
+  void Process(const float *data, unsigned int frames);
+
+  /*!
+   \brief Get the integrated loudness of everything processed.
+   \param loudness set to the loudness in LUFS.
+   \return false if there was no block above the absolute gate, eg. silence or
+           less than 400ms of audio.
+   */
+  bool GetIntegratedLoudness(double &loudness) const;
+
+  /* the true peak of everything processed, as a linear amplitude */
+  double GetTruePeak() const { return m_truePeak; }
+
+private:
+  typedef struct
+  {
+    double b0, b1, b2, a1, a2;
+  } Biquad;
+
+  typedef struct
+  {
+    double x1, x2, y1, y2;
+  } BiquadState;
+
+  void SetupFilters();
+  void EndSubBlock();
+
+  unsigned int              m_channels;
+  unsigned int              m_sampleRate;
+  std::vector<double>       m_weights;    /* BS.1770 channel weights, 0 for LFE */
+
+  /* K-weighting, a high shelf followed by a high pass, two states per channel */
+  Biquad                    m_shelf;
+  Biquad                    m_highPass;
+  std::vector<BiquadState>  m_state;
+
+  /* 100ms sub blocks, four of them make one 400ms gating block */
+  unsigned int              m_subBlockFrames;
+  unsigned int              m_subBlockFill;
+  double                    m_subBlockEnergy;
+  double                    m_subBlocks[4];
+  unsigned int              m_subBlockCount;
+  std::vector<double>       m_blocks;     /* the mean square of each gating block */
+
+  /* true peak, polyphase oversampling with a history per channel */
+  unsigned int              m_oversample;
+  std::vector<float>        m_tpFilter;   /* m_oversample phases of AE_LOUDNESS_TP_TAPS */
+  std::vector<float>        m_tpHistory;  /* twice the taps per channel so it can be read without wrapping */
+  unsigned int              m_tpIndex;
+  double                    m_truePeak;
+};
+
@@ -17,6 +17,7 @@
  *  <http://www.gnu.org/licenses/>.
  *
  */
+#include <algorithm>
 #include <math.h>
 #include <sstream>
 
@@ -28,9 +29,10 @@
 
 using namespace std;
 
-CAERemap::CAERemap() : m_inChannels(0), m_outChannels(0) 
+CAERemap::CAERemap() : m_inChannels(0), m_outChannels(0), m_matrixStride(0), m_remapFn(NULL)
 {
   memset(m_mixInfo, 0, sizeof(m_mixInfo));
+  memset(m_matrix , 0, sizeof(m_matrix ));
 }
 
 CAERemap::~CAERemap()
@@ -44,7 +46,8 @@ bool CAERemap::Initialize(CAEChannelInfo input, CAEChannelInfo output, bool fina
 
   /* build the downmix matrix */
   memset(m_mixInfo, 0, sizeof(m_mixInfo));
-  m_output = output;
+  m_output  = output;
+  m_remapFn = NULL;
 
   /* figure which channels we have */
   for (unsigned int o = 0; o < output.Count(); ++o)
@@ -87,7 +90,10 @@ bool CAERemap::Initialize(CAEChannelInfo input, CAEChannelInfo output, bool fina
 
   /* the final stage does not need any down/upmix */
   if (finalStage)
+  {
+    BuildMatrix();
     return true;
+  }
 
   /* downmix from the specified channel to the specified list of channels */
   #define RM(from, ...) \
@@ -253,6 +259,7 @@ bool CAERemap::Initialize(CAEChannelInfo input, CAEChannelInfo output, bool fina
   CLog::Log(LOGINFO, "====================\n");
 #endif
 
+  BuildMatrix();
   return true;
 }
 
@@ -293,8 +300,219 @@ void CAERemap::ResolveMix(const AEChannel from, CAEChannelInfo to)
   fromInfo->in_src   = false;
 }
 
-/* This method has unrolled loop for higher performance */
+#ifdef __SSE__
+/* stores the first count lanes of v */
+static inline void StorePartial(float *dst, const __m128 v, const unsigned int count)
+{
+  switch (count)
+  {
+    case 4: _mm_storeu_ps(dst, v); break;
+    case 3: _mm_storel_pi((__m64*)dst, v); _mm_store_ss(dst + 2, _mm_movehl_ps(v, v)); break;
+    case 2: _mm_storel_pi((__m64*)dst, v); break;
+    case 1: _mm_store_ss(dst, v); break;
+  }
+}
+
+/* any layout, each frame is mixed four output channels at a time */
+static void Remap_SSE(const float *matrix, const unsigned int stride, const float *in, float *out, const unsigned int frames, const unsigned int inChannels, const unsigned int outChannels)
+{
+  for (unsigned int f = 0; f < frames; ++f, in += inChannels, out += outChannels)
+  {
+    for (unsigned int o = 0; o < outChannels; o += 4)
+    {
+      const float *col = matrix + o;
+      __m128 acc = _mm_mul_ps(_mm_set1_ps(in[0]), _mm_loadu_ps(col));
+      for (unsigned int i = 1; i < inChannels; ++i)
+      {
+        col += stride;
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(in[i]), _mm_loadu_ps(col)));
+      }
+      StorePartial(out + o, acc, std::min(outChannels - o, 4U));
+    }
+  }
+}
+
+/*
+  the 6 channel output kernels work on two frames at a time so the twelve output
+  samples can be written as three whole vectors, for each input channel this needs
+  the column as outputs 0-3 (lo), outputs 4, 5, 0, 1 (mid) and outputs 2-5 (hi)
+*/
+static inline void LoadColumn6(const float *col, __m128 &lo, __m128 &mid, __m128 &hi)
+{
+  const __m128 a = _mm_loadu_ps(col    );
+  const __m128 b = _mm_loadu_ps(col + 4); /* the padding makes this safe */
+  lo  = a;
+  mid = _mm_shuffle_ps(b, a, _MM_SHUFFLE(1, 0, 1, 0));
+  hi  = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 3, 2));
+}
+
+/* stereo upmix to 5.1 */
+static void Remap_2_6_SSE(const float *matrix, const unsigned int stride, const float *in, float *out, const unsigned int frames, const unsigned int inChannels, const unsigned int outChannels)
+{
+  __m128 lo0, mid0, hi0, lo1, mid1, hi1;
+  LoadColumn6(matrix         , lo0, mid0, hi0);
+  LoadColumn6(matrix + stride, lo1, mid1, hi1);
+
+  unsigned int f = 0;
+  for (; f + 2 <= frames; f += 2, in += 4, out += 12)
+  {
+    const __m128 x = _mm_loadu_ps(in); /* L0 R0 L1 R1 */
+    _mm_storeu_ps(out    , _mm_add_ps(
+      _mm_mul_ps(_mm_shuffle_ps(x, x, _MM_SHUFFLE(0, 0, 0, 0)), lo0),
+      _mm_mul_ps(_mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 1, 1, 1)), lo1)));
+    _mm_storeu_ps(out + 4, _mm_add_ps(
+      _mm_mul_ps(_mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 2, 0, 0)), mid0),
+      _mm_mul_ps(_mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 3, 1, 1)), mid1)));
+    _mm_storeu_ps(out + 8, _mm_add_ps(
+      _mm_mul_ps(_mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 2, 2, 2)), hi0),
+      _mm_mul_ps(_mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 3, 3, 3)), hi1)));
+  }
+
+  if (f < frames)
+    Remap_SSE(matrix, stride, in, out, frames - f, inChannels, outChannels);
+}
+
+/* 5.1 downmix to stereo, two frames fill one output vector */
+static void Remap_6_2_SSE(const float *matrix, const unsigned int stride, const float *in, float *out, const unsigned int frames, const unsigned int inChannels, const unsigned int outChannels)
+{
+  __m128 c[6];
+  for (unsigned int i = 0; i < 6; ++i)
+  {
+    const float *col = matrix + i * stride;
+    c[i] = _mm_set_ps(col[1], col[0], col[1], col[0]);
+  }
+
+  unsigned int f = 0;
+  for (; f + 2 <= frames; f += 2, in += 12, out += 4)
+  {
+    const __m128 x0 = _mm_loadu_ps(in    );
+    const __m128 x1 = _mm_loadu_ps(in + 4);
+    const __m128 x2 = _mm_loadu_ps(in + 8);
+
+    /* each shuffle gives channel i of the first frame twice and then of the second frame twice */
+    __m128 acc =          _mm_mul_ps(_mm_shuffle_ps(x0, x1, _MM_SHUFFLE(2, 2, 0, 0)), c[0]);
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_shuffle_ps(x0, x1, _MM_SHUFFLE(3, 3, 1, 1)), c[1]));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_shuffle_ps(x0, x2, _MM_SHUFFLE(0, 0, 2, 2)), c[2]));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_shuffle_ps(x0, x2, _MM_SHUFFLE(1, 1, 3, 3)), c[3]));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_shuffle_ps(x1, x2, _MM_SHUFFLE(2, 2, 0, 0)), c[4]));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_shuffle_ps(x1, x2, _MM_SHUFFLE(3, 3, 1, 1)), c[5]));
+    _mm_storeu_ps(out, acc);
+  }
+
+  if (f < frames)
+    Remap_SSE(matrix, stride, in, out, frames - f, inChannels, outChannels);
+}
+
+/* any downmix to stereo, as above but the input channel count is not fixed */
+static void Remap_X_2_SSE(const float *matrix, const unsigned int stride, const float *in, float *out, const unsigned int frames, const unsigned int inChannels, const unsigned int outChannels)
+{
+  __m128 c[AE_CH_MAX];
+  for (unsigned int i = 0; i < inChannels; ++i)
+  {
+    const float *col = matrix + i * stride;
+    c[i] = _mm_set_ps(col[1], col[0], col[1], col[0]);
+  }
+
+  unsigned int f = 0;
+  for (; f + 2 <= frames; f += 2, in += inChannels * 2, out += 4)
+  {
+    const float *a = in;
+    const float *b = in + inChannels;
+    __m128 acc = _mm_mul_ps(_mm_set_ps(b[0], b[0], a[0], a[0]), c[0]);
+    for (unsigned int i = 1; i < inChannels; ++i)
+      acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set_ps(b[i], b[i], a[i], a[i]), c[i]));
+    _mm_storeu_ps(out, acc);
+  }
+
+  if (f < frames)
+    Remap_SSE(matrix, stride, in, out, frames - f, inChannels, outChannels);
+}
+
+/* 7.1 downmix to 5.1 */
+static void Remap_8_6_SSE(const float *matrix, const unsigned int stride, const float *in, float *out, const unsigned int frames, const unsigned int inChannels, const unsigned int outChannels)
+{
+  __m128 lo[8], mid[8], hi[8];
+  for (unsigned int i = 0; i < 8; ++i)
+    LoadColumn6(matrix + i * stride, lo[i], mid[i], hi[i]);
+
+  #define MIX(a, b, i, n) \
+    v0 = _mm_add_ps(v0, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(n, n, n, n)), lo [i])); \
+    v1 = _mm_add_ps(v1, _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(n, n, n, n)), mid[i])); \
+    v2 = _mm_add_ps(v2, _mm_mul_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(n, n, n, n)), hi [i]));
+
+  unsigned int f = 0;
+  for (; f + 2 <= frames; f += 2, in += 16, out += 12)
+  {
+    const __m128 a0 = _mm_loadu_ps(in     ); /* first frame, channels 0-3  */
+    const __m128 a1 = _mm_loadu_ps(in +  4); /* first frame, channels 4-7  */
+    const __m128 b0 = _mm_loadu_ps(in +  8); /* second frame, channels 0-3 */
+    const __m128 b1 = _mm_loadu_ps(in + 12); /* second frame, channels 4-7 */
+
+    __m128 v0 = _mm_mul_ps(_mm_shuffle_ps(a0, a0, _MM_SHUFFLE(0, 0, 0, 0)), lo [0]);
+    __m128 v1 = _mm_mul_ps(_mm_shuffle_ps(a0, b0, _MM_SHUFFLE(0, 0, 0, 0)), mid[0]);
+    __m128 v2 = _mm_mul_ps(_mm_shuffle_ps(b0, b0, _MM_SHUFFLE(0, 0, 0, 0)), hi [0]);
+    MIX(a0, b0, 1, 1);
+    MIX(a0, b0, 2, 2);
+    MIX(a0, b0, 3, 3);
+    MIX(a1, b1, 4, 0);
+    MIX(a1, b1, 5, 1);
+    MIX(a1, b1, 6, 2);
+    MIX(a1, b1, 7, 3);
+
+    _mm_storeu_ps(out    , v0);
+    _mm_storeu_ps(out + 4, v1);
+    _mm_storeu_ps(out + 8, v2);
+  }
+
+  #undef MIX
+
+  if (f < frames)
+    Remap_SSE(matrix, stride, in, out, frames - f, inChannels, outChannels);
+}
+#endif
+
+void CAERemap::BuildMatrix()
+{
+  memset(m_matrix, 0, sizeof(m_matrix));
+  m_matrixStride = (m_outChannels + 3) & ~3;
+
+  for (int o = 0; o < m_outChannels; ++o)
+  {
+    const AEMixInfo *info = &m_mixInfo[m_output[o]];
+    if (!info->in_dst)
+      continue;
+
+    /* if there is only 1 source, just copy it so we dont break DPL */
+    if (info->srcCount == 1)
+    {
+      m_matrix[info->srcIndex[0].index * m_matrixStride + o] = 1.0f;
+      continue;
+    }
+
+    for (int i = 0; i < info->srcCount; ++i)
+      m_matrix[info->srcIndex[i].index * m_matrixStride + o] += info->srcIndex[i].level;
+  }
+
+  /* without SSE the sparse loop is cheaper than walking the whole matrix */
+#ifdef __SSE__
+  if      (m_inChannels == 2 && m_outChannels == 6) m_remapFn = Remap_2_6_SSE;
+  else if (m_inChannels == 6 && m_outChannels == 2) m_remapFn = Remap_6_2_SSE;
+  else if (m_inChannels == 8 && m_outChannels == 6) m_remapFn = Remap_8_6_SSE;
+  else if (m_outChannels == 2)                      m_remapFn = Remap_X_2_SSE;
+  else                                              m_remapFn = Remap_SSE;
+#endif
+}
+
 void CAERemap::Remap(float * const in, float * const out, const unsigned int frames) const
+{
+  if (m_remapFn)
+    m_remapFn(m_matrix, m_matrixStride, in, out, frames, m_inChannels, m_outChannels);
+  else
+    RemapSparse(in, out, frames);
+}
+
+/* This method has unrolled loop for higher performance */
+void CAERemap::RemapSparse(float * const in, float * const out, const unsigned int frames) const
 {
   const unsigned int frameBlocks = frames & ~0x3;
 
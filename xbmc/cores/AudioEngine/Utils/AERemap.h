@@ -30,6 +30,9 @@ public:
   void Remap(float * const in, float * const out, const unsigned int frames) const;
 
 private:
+  /* output frame = sum of input channels weighted by a column of the dense matrix */
+  typedef void (*RemapFn)(const float *matrix, const unsigned int stride, const float *in, float *out, const unsigned int frames, const unsigned int inChannels, const unsigned int outChannels);
+
   typedef struct {
     int       index;
     float     level;
@@ -49,6 +52,16 @@ private:
   int            m_inChannels;
   int            m_outChannels;
 
+  /*
+    dense copy of m_mixInfo, one column per input channel holding the level of
+    that channel in each output channel, columns are padded to m_matrixStride
+  */
+  float          m_matrix[AE_CH_MAX * ((AE_CH_MAX + 3) & ~3)];
+  unsigned int   m_matrixStride;
+  RemapFn        m_remapFn;
+
+  void BuildMatrix();
+  void RemapSparse(float * const in, float * const out, const unsigned int frames) const;
   void ResolveMix(const AEChannel from, CAEChannelInfo to);
   void BuildUpmixMatrix(const CAEChannelInfo& input, const CAEChannelInfo& output);
 };
@@ -0,0 +1,477 @@
+/*
+ *      Copyright (C) 2010-2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "utils/StdString.h" /* needed for _aligned_malloc */
+#include "AEResample.h"
+#include "AESIMD.h"
+#include "utils/CPUInfo.h"
+#include "utils/log.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* frames of input buffered between compactions of the history */
+#define AE_RESAMPLE_BLOCK 512
+/* output frames a ratio change is ramped over */
+#define AE_RESAMPLE_RAMP  512
+/* the supported ratio range, the same as libsamplerate */
+#define AE_RESAMPLE_MAX_RATIO 256.0
+
+typedef struct
+{
+  unsigned int taps;        /* filter length at a ratio >= 1 */
+  unsigned int phases;      /* filter bank rows between two input frames */
+  double       attenuation; /* stopband attenuation in dB */
+} AEResamplePreset;
+
+static const AEResamplePreset g_presets[] =
+{
+  /* QUALITY_LOW    */ { 16 ,  64, 60.0 },
+  /* QUALITY_FAST   */ { 64 , 128, 97.0 },
+  /* QUALITY_MEDIUM */ { 128, 256, 97.0 },
+  /* QUALITY_HIGH   */ { 384, 256, 97.0 }
+};
+
+/* zeroth order modified bessel function of the first kind, for the kaiser window */
+static double BesselI0(double x)
+{
+  double sum  = 1.0;
+  double term = 1.0;
+  const double x2 = x * x / 4.0;
+  for (int k = 1; k < 64; ++k)
+  {
+    term *= x2 / ((double)k * k);
+    sum  += term;
+    if (term < sum * 1e-16)
+      break;
+  }
+  return sum;
+}
+
+/*
+  ResampleFrame implementations, the coefficients of the two nearest phases are
+  interpolated once then applied to every channel. The SIMD versions run four
+  channels at a time with independent accumulators and differ from the C one
+  only in summation order.
+*/
+static void ResampleFrame_C(const float *row, const float frac, const unsigned int taps, float *coef, const float *hist, const unsigned int stride, const unsigned int channels, float *out)
+{
+  const float *next = row + taps;
+  for (unsigned int k = 0; k < taps; ++k)
+    coef[k] = row[k] + (next[k] - row[k]) * frac;
+
+  for (unsigned int c = 0; c < channels; ++c, hist += stride)
+  {
+    float sum = 0.0f;
+    for (unsigned int k = 0; k < taps; ++k)
+      sum += hist[k] * coef[k];
+    out[c] = sum;
+  }
+}
+
+#if defined(AE_SIMD_SSE2)
+/* the horizontal sums of four vectors */
+static inline __m128 HorizontalSum4(const __m128 a0, const __m128 a1, const __m128 a2, const __m128 a3)
+{
+  const __m128 t0 = _mm_add_ps(_mm_unpacklo_ps(a0, a1), _mm_unpackhi_ps(a0, a1));
+  const __m128 t1 = _mm_add_ps(_mm_unpacklo_ps(a2, a3), _mm_unpackhi_ps(a2, a3));
+  return _mm_add_ps(_mm_movelh_ps(t0, t1), _mm_movehl_ps(t1, t0));
+}
+
+static inline float HorizontalSum(__m128 a)
+{
+  a = _mm_add_ps(a, _mm_movehl_ps(a, a));
+  return _mm_cvtss_f32(_mm_add_ss(a, _mm_shuffle_ps(a, a, 1)));
+}
+
+static void ResampleFrame_SSE2(const float *row, const float frac, const unsigned int taps, float *coef, const float *hist, const unsigned int stride, const unsigned int channels, float *out)
+{
+  const float *next = row + taps;
+  const __m128 f = _mm_set1_ps(frac);
+  for (unsigned int k = 0; k < taps; k += 4)
+  {
+    const __m128 r = _mm_load_ps(row + k);
+    _mm_store_ps(coef + k, _mm_add_ps(r, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(next + k), r), f)));
+  }
+
+  unsigned int c = 0;
+  for (; c + 4 <= channels; c += 4, hist += stride * 4)
+  {
+    const float *h0 = hist, *h1 = hist + stride, *h2 = h1 + stride, *h3 = h2 + stride;
+    __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps(), a2 = _mm_setzero_ps(), a3 = _mm_setzero_ps();
+    for (unsigned int k = 0; k < taps; k += 4)
+    {
+      const __m128 w = _mm_load_ps(coef + k);
+      a0 = _mm_add_ps(a0, _mm_mul_ps(_mm_loadu_ps(h0 + k), w));
+      a1 = _mm_add_ps(a1, _mm_mul_ps(_mm_loadu_ps(h1 + k), w));
+      a2 = _mm_add_ps(a2, _mm_mul_ps(_mm_loadu_ps(h2 + k), w));
+      a3 = _mm_add_ps(a3, _mm_mul_ps(_mm_loadu_ps(h3 + k), w));
+    }
+    _mm_storeu_ps(out + c, HorizontalSum4(a0, a1, a2, a3));
+  }
+
+  for (; c < channels; ++c, hist += stride)
+  {
+    __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps();
+    for (unsigned int k = 0; k < taps; k += 8)
+    {
+      a0 = _mm_add_ps(a0, _mm_mul_ps(_mm_loadu_ps(hist + k    ), _mm_load_ps(coef + k    )));
+      a1 = _mm_add_ps(a1, _mm_mul_ps(_mm_loadu_ps(hist + k + 4), _mm_load_ps(coef + k + 4)));
+    }
+    out[c] = HorizontalSum(_mm_add_ps(a0, a1));
+  }
+}
+#endif /* AE_SIMD_SSE2 */
+
+#if defined(AE_SIMD_AVX2)
+AE_TARGET_AVX2 static inline __m128 Fold(const __m256 a)
+{
+  return _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+}
+
+AE_TARGET_AVX2 static void ResampleFrame_AVX2(const float *row, const float frac, const unsigned int taps, float *coef, const float *hist, const unsigned int stride, const unsigned int channels, float *out)
+{
+  const float *next = row + taps;
+  const __m256 f = _mm256_set1_ps(frac);
+  for (unsigned int k = 0; k < taps; k += 8)
+  {
+    const __m256 r = _mm256_load_ps(row + k);
+    _mm256_store_ps(coef + k, _mm256_add_ps(r, _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(next + k), r), f)));
+  }
+
+  unsigned int c = 0;
+  for (; c + 4 <= channels; c += 4, hist += stride * 4)
+  {
+    const float *h0 = hist, *h1 = hist + stride, *h2 = h1 + stride, *h3 = h2 + stride;
+    __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps(), a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+    for (unsigned int k = 0; k < taps; k += 8)
+    {
+      const __m256 w = _mm256_load_ps(coef + k);
+      a0 = _mm256_add_ps(a0, _mm256_mul_ps(_mm256_loadu_ps(h0 + k), w));
+      a1 = _mm256_add_ps(a1, _mm256_mul_ps(_mm256_loadu_ps(h1 + k), w));
+      a2 = _mm256_add_ps(a2, _mm256_mul_ps(_mm256_loadu_ps(h2 + k), w));
+      a3 = _mm256_add_ps(a3, _mm256_mul_ps(_mm256_loadu_ps(h3 + k), w));
+    }
+    _mm_storeu_ps(out + c, HorizontalSum4(Fold(a0), Fold(a1), Fold(a2), Fold(a3)));
+  }
+
+  for (; c < channels; ++c, hist += stride)
+  {
+    __m256 a0 = _mm256_setzero_ps();
+    for (unsigned int k = 0; k < taps; k += 8)
+      a0 = _mm256_add_ps(a0, _mm256_mul_ps(_mm256_loadu_ps(hist + k), _mm256_load_ps(coef + k)));
+    out[c] = HorizontalSum(Fold(a0));
+  }
+}
+#endif /* AE_SIMD_AVX2 */
+
+CAEResample::CAEResample() :
+  m_channels   (0),
+  m_quality    (QUALITY_MEDIUM),
+  m_frameFn    (NULL),
+  m_bank       (NULL),
+  m_bankSize   (0),
+  m_phases     (0),
+  m_taps       (0),
+  m_cutoffRatio(1.0),
+  m_coef       (NULL),
+  m_hist       (NULL),
+  m_histStride (0),
+  m_histFill   (0),
+  m_index      (0),
+  m_frac       (0.0),
+  m_ratio      (1.0),
+  m_step       (1.0),
+  m_targetStep (1.0),
+  m_stepDelta  (0.0),
+  m_rampFrames (0)
+{
+}
+
+CAEResample::~CAEResample()
+{
+  Deinitialize();
+}
+
+void CAEResample::Deinitialize()
+{
+  _aligned_free(m_bank);
+  _aligned_free(m_coef);
+  _aligned_free(m_hist);
+  m_bank     = NULL;
+  m_coef     = NULL;
+  m_hist     = NULL;
+  m_bankSize = 0;
+  m_taps     = 0;
+  m_channels = 0;
+  m_frameFn  = NULL;
+}
+
+bool CAEResample::Initialize(unsigned int channels, double ratio, enum Quality quality)
+{
+  return Initialize(channels, ratio, quality, g_cpuInfo.GetCPUFeatures());
+}
+
+bool CAEResample::Initialize(unsigned int channels, double ratio, enum Quality quality, unsigned int cpuFeatures)
+{
+  Deinitialize();
+
+  if (channels == 0 || quality < QUALITY_LOW || quality > QUALITY_HIGH ||
+      ratio < 1.0 / AE_RESAMPLE_MAX_RATIO || ratio > AE_RESAMPLE_MAX_RATIO)
+  {
+    CLog::Log(LOGERROR, "CAEResample::Initialize - Invalid parameters, %u channels, ratio %f", channels, ratio);
+    return false;
+  }
+
+  m_frameFn = &ResampleFrame_C;
+#if defined(AE_SIMD_SSE2)
+  if (cpuFeatures & CPU_FEATURE_SSE2)
+    m_frameFn = &ResampleFrame_SSE2;
+#endif
+#if defined(AE_SIMD_AVX2)
+  if (cpuFeatures & CPU_FEATURE_AVX2)
+    m_frameFn = &ResampleFrame_AVX2;
+#endif
+
+  m_channels    = channels;
+  m_quality     = quality;
+  m_ratio       = ratio;
+  m_targetStep  = 1.0 / ratio;
+  m_cutoffRatio = std::min(1.0, ratio);
+  BuildBank();
+  Reset();
+  return true;
+}
+
+void CAEResample::BuildBank()
+{
+  const AEResamplePreset &preset = g_presets[m_quality];
+
+  /* when downsampling the cutoff drops with the ratio, the filter gets longer to keep the transition width */
+  unsigned int taps = (unsigned int)ceil(preset.taps / m_cutoffRatio);
+  taps = (taps + 7) & ~7;
+
+  if (taps != m_taps)
+  {
+    /*
+      re-window the history for the new filter length around the next output
+      frame, missing older frames are zero and no buffered input is dropped
+    */
+    const unsigned int half   = taps / 2 - 1;
+    const unsigned int first  = m_hist && m_index > half ? m_index - half : 0;
+    const unsigned int pad    = !m_hist ? half : m_index < half ? half - m_index : 0;
+    const unsigned int frames = m_hist ? m_histFill - first : 0;
+    const unsigned int stride = std::max(taps + AE_RESAMPLE_BLOCK, pad + frames);
+
+    float *hist = (float*)_aligned_malloc(stride * m_channels * sizeof(float), 32);
+    for (unsigned int c = 0; c < m_channels; ++c)
+    {
+      memset(hist + c * stride, 0, pad * sizeof(float));
+      if (frames)
+        memcpy(hist + c * stride + pad, m_hist + c * m_histStride + first, frames * sizeof(float));
+    }
+
+    if (m_hist)
+    {
+      m_index    = m_index - first + pad;
+      m_histFill = pad + frames;
+    }
+
+    _aligned_free(m_coef);
+    _aligned_free(m_hist);
+    m_taps       = taps;
+    m_histStride = stride;
+    m_hist       = hist;
+    m_coef       = (float*)_aligned_malloc(m_taps * sizeof(float), 32);
+  }
+
+  m_phases = preset.phases;
+  const unsigned int size = (m_phases + 1) * m_taps;
+  if (size > m_bankSize)
+  {
+    _aligned_free(m_bank);
+    m_bank     = (float*)_aligned_malloc(size * sizeof(float), 32);
+    m_bankSize = size;
+  }
+
+  /*
+    kaiser windowed sinc, the transition band ends at the nyquist frequency of
+    the lower of the two rates so nothing aliases into the passband
+  */
+  const double A    = preset.attenuation;
+  const double beta = A > 50.0 ? 0.1102 * (A - 8.7) : 0.5842 * pow(A - 21.0, 0.4) + 0.07886 * (A - 21.0);
+  const double transition = (A - 7.95) / (14.36 * (preset.taps - 1)) * 2.0;
+  const double cutoff     = (1.0 - transition / 2.0) * m_cutoffRatio;
+  const double half       = m_taps / 2;
+  const double i0beta     = BesselI0(beta);
+
+  std::vector<double> coef(m_taps);
+  for (unsigned int p = 0; p <= m_phases; ++p)
+  {
+    float *row = m_bank + p * m_taps;
+    const double phase = (double)p / m_phases;
+    double sum = 0.0;
+
+    for (unsigned int k = 0; k < m_taps; ++k)
+    {
+      const double t = phase + half - 1.0 - k;
+      const double x = t / half;
+      double h = cutoff;
+      if (t != 0.0)
+        h = sin(M_PI * cutoff * t) / (M_PI * t);
+      h *= x * x < 1.0 ? BesselI0(beta * sqrt(1.0 - x * x)) / i0beta : 0.0;
+
+      coef[k] = h;
+      sum    += h;
+    }
+
+    /* unity gain at DC for every phase */
+    for (unsigned int k = 0; k < m_taps; ++k)
+      row[k] = (float)(coef[k] / sum);
+  }
+
+  CLog::Log(LOGDEBUG, "CAEResample::BuildBank - %u taps, %u phases, cutoff %f", m_taps, m_phases, cutoff);
+}
+
+bool CAEResample::SetRatio(double ratio)
+{
+  if (!m_frameFn || ratio < 1.0 / AE_RESAMPLE_MAX_RATIO || ratio > AE_RESAMPLE_MAX_RATIO)
+    return false;
+
+  m_ratio      = ratio;
+  m_targetStep = 1.0 / ratio;
+
+  /*
+    the video clock sync only moves the ratio by a fraction of a percent, the
+    bank is only redesigned for bigger changes that would alias or needlessly
+    cut the bandwidth
+  */
+  const double cutoffRatio = std::min(1.0, ratio);
+  if (cutoffRatio < m_cutoffRatio * 0.99 || cutoffRatio > m_cutoffRatio * 1.05)
+  {
+    m_cutoffRatio = cutoffRatio;
+    BuildBank();
+  }
+
+  m_rampFrames = AE_RESAMPLE_RAMP;
+  m_stepDelta  = (m_targetStep - m_step) / AE_RESAMPLE_RAMP;
+  return true;
+}
+
+void CAEResample::Reset()
+{
+  if (!m_hist)
+    return;
+
+  /* prime the history so the first output frame lines up with the first input frame */
+  m_histFill   = m_taps / 2 - 1;
+  m_index      = m_histFill;
+  m_frac       = 0.0;
+  m_step       = m_targetStep;
+  m_stepDelta  = 0.0;
+  m_rampFrames = 0;
+  for (unsigned int c = 0; c < m_channels; ++c)
+    memset(m_hist + c * m_histStride, 0, m_histFill * sizeof(float));
+}
+
+unsigned int CAEResample::Fill(const float *in, unsigned int frames)
+{
+  frames = std::min(frames, m_histStride - m_histFill);
+  for (unsigned int c = 0; c < m_channels; ++c)
+  {
+    float *dst = m_hist + c * m_histStride + m_histFill;
+    const float *src = in + c;
+    for (unsigned int i = 0; i < frames; ++i, src += m_channels)
+      dst[i] = *src;
+  }
+
+  m_histFill += frames;
+  return frames;
+}
+
+void CAEResample::Compact()
+{
+  /* drop the frames before the first tap of the next output frame */
+  const unsigned int first = m_index - (m_taps / 2 - 1);
+  const unsigned int drop  = std::min(first, m_histFill);
+  if (!drop)
+    return;
+
+  for (unsigned int c = 0; c < m_channels; ++c)
+  {
+    float *hist = m_hist + c * m_histStride;
+    memmove(hist, hist + drop, (m_histFill - drop) * sizeof(float));
+  }
+
+  m_histFill -= drop;
+  m_index    -= drop;
+}
+
+unsigned int CAEResample::Resample(const float *in, unsigned int inFrames, unsigned int &inUsed, float *out, unsigned int outFrames)
+{
+  inUsed = 0;
+  if (!m_frameFn)
+    return 0;
+
+  const unsigned int half = m_taps / 2;
+  unsigned int produced = 0;
+  for (;;)
+  {
+    /* run the filter while the history holds all the taps */
+    while (produced < outFrames)
+    {
+      if (m_index + half >= m_histFill)
+        break;
+
+      const double       frac  = m_frac * m_phases;
+      const unsigned int phase = (unsigned int)frac;
+      m_frameFn(m_bank + phase * m_taps, (float)(frac - phase), m_taps, m_coef,
+        m_hist + m_index - (half - 1), m_histStride, m_channels, out + produced * m_channels);
+      ++produced;
+
+      if (m_rampFrames)
+      {
+        m_step += m_stepDelta;
+        if (--m_rampFrames == 0)
+          m_step = m_targetStep;
+      }
+
+      /* the fraction is kept apart so compacting the history does not change its rounding */
+      m_frac += m_step;
+      const unsigned int advance = (unsigned int)m_frac;
+      m_index += advance;
+      m_frac  -= advance;
+    }
+
+    if (produced == outFrames || inUsed == inFrames)
+      break;
+
+    Compact();
+    inUsed += Fill(in + inUsed * m_channels, inFrames - inUsed);
+  }
+
+  return produced;
+}
@@ -0,0 +1,121 @@
+#pragma once
+/*
+ *      Copyright (C) 2010-2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+
+/*
+  Polyphase windowed sinc resampler for interleaved float audio.
+
+  The filter bank is computed once for the quality and ratio, each output frame
+  interpolates the coefficients between the two nearest phases so any ratio can
+  be used, and ratio changes are ramped in so the video clock sync adjustments
+  are free of clicks.
+*/
+class CAEResample
+{
+public:
+  enum Quality
+  {
+    QUALITY_LOW,    /* 16 taps, ~60dB, for previews and slow machines        */
+    QUALITY_FAST,   /* 64 taps, ~97dB, 80% bandwidth (SRC_SINC_FASTEST)      */
+    QUALITY_MEDIUM, /* 128 taps, ~97dB, 90% bandwidth (SRC_SINC_MEDIUM)      */
+    QUALITY_HIGH    /* 384 taps, ~97dB, 97% bandwidth (SRC_SINC_BEST)        */
+  };
+
+  CAEResample();
+  ~CAEResample();
+
+  /*!
+   \brief Set up the resampler, can be called again to reconfigure it.
+   \param channels the number of interleaved channels.
+   \param ratio the output rate divided by the input rate.
+   \param quality the filter preset.
+   \param cpuFeatures the CPU features to select the kernel with, 0 for the C one.
+   \return false if the parameters are invalid.
+   */
+  bool Initialize(unsigned int channels, double ratio, enum Quality quality);
+  bool Initialize(unsigned int channels, double ratio, enum Quality quality, unsigned int cpuFeatures);
+  void Deinitialize();
+
+  /*!
+   \brief Change the ratio, the new ratio is ramped in over the next few hundred frames.
+   The filter bank is only rebuilt if the ratio moves far enough from the one it was
+   designed for to change the cutoff frequency, the history is kept across the rebuild.
+   */
+  bool SetRatio(double ratio);
+  double GetRatio() const { return m_ratio; }
+
+  /* drop any buffered input and jump to the target ratio */
+  void Reset();
+
+  /*!
+   \brief Resample interleaved frames.
+   Input is consumed until either it runs out or the output is full, the filter
+   history is kept so the next call continues where this one stopped.
+   \param in the input frames.
+   \param inFrames the number of input frames.
+   \param inUsed set to the number of input frames consumed.
+   \param out the output buffer.
+   \param outFrames the size of the output buffer in frames.
+   \return the number of frames written to out.
+   */
+  unsigned int Resample(const float *in, unsigned int inFrames, unsigned int &inUsed, float *out, unsigned int outFrames);
+
+  /* the delay of the filter in input frames */
+  unsigned int GetDelay() const { return m_taps / 2; }
+
+  /*
+    computes one output frame, the coefficients are interpolated into coef then
+    applied to every channel of the planar history
+  */
+  typedef void (*ResampleFrameFn)(const float *row, const float frac, const unsigned int taps, float *coef, const float *hist, const unsigned int stride, const unsigned int channels, float *out);
+
+private:
+  void BuildBank();
+  unsigned int Fill(const float *in, unsigned int frames);
+  void Compact();
+
+  unsigned int    m_channels;
+  enum Quality    m_quality;
+  ResampleFrameFn m_frameFn;
+
+  /* filter bank, m_phases + 1 rows of m_taps coefficients */
+  float          *m_bank;
+  unsigned int    m_bankSize;
+  unsigned int    m_phases;
+  unsigned int    m_taps;
+  double          m_cutoffRatio; /* min(1, ratio) the bank was designed for */
+  float          *m_coef;        /* the interpolated coefficients of the current frame */
+
+  /* planar input history, m_histStride floats per channel */
+  float          *m_hist;
+  unsigned int    m_histStride;
+  unsigned int    m_histFill;
+  unsigned int    m_index;       /* the history frame the next output frame is at */
+  double          m_frac;        /* and the fraction of a frame past it */
+
+  /* ratio, m_step is the input advance per output frame */
+  double          m_ratio;
+  double          m_step;
+  double          m_targetStep;
+  double          m_stepDelta;
+  unsigned int    m_rampFrames;
+};
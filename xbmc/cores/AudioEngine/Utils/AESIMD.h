@@ -0,0 +1,43 @@
+#pragma once
+/*
+ *      Copyright (C) 2010-2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stddef.h>
+
+/*
+  The x86 SIMD kernels are selected at runtime from the CPU features, the SSE2
+  ones need SSE2 to be the compiler baseline (always true for x86_64), the AVX2
+  ones are compiled with a per function target (AE_TARGET_AVX2) so the rest of
+  the file does not require an AVX2 capable CPU.
+*/
+#if defined(__SSE2__) || (defined(_MSC_VER) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)))
+  #define AE_SIMD_SSE2
+  #include <emmintrin.h>
+  #if defined(__GNUC__) && (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+    #define AE_SIMD_AVX2
+    #define AE_TARGET_AVX2 __attribute__((target("avx2")))
+  #elif defined(_MSC_VER) && _MSC_VER >= 1700
+    #define AE_SIMD_AVX2
+    #define AE_TARGET_AVX2
+  #endif
+  #ifdef AE_SIMD_AVX2
+    #include <immintrin.h>
+  #endif
+#endif
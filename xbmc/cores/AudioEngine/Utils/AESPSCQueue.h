@@ -0,0 +1,131 @@
+#pragma once
+/*
+ *      Copyright (C) 2010-2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stddef.h>
+#include "threads/Atomics.h"
+
+/**
+ * Bounded queue of preallocated items for exactly one producer and one
+ * consumer thread.
+ *
+ * The producer fills the item returned by GetWriteSlot() and publishes it with
+ * Push(), the consumer reads the item returned by GetReadSlot() and hands it
+ * back with Pop(). Neither side takes a lock, items are never allocated or
+ * freed while the queue is in use.
+ *
+ * Alloc(), Reset() and Drop() are not thread-safe, the caller must make sure
+ * neither side is running while they are called.
+ */
+template<class T>
+class CAESPSCQueue
+{
+public:
+  CAESPSCQueue() :
+    m_items  (NULL),
+    m_mask   (0   ),
+    m_read   (0   ),
+    m_written(0   )
+  {
+  }
+
+  ~CAESPSCQueue()
+  {
+    delete[] m_items;
+  }
+
+  /**
+   * Allocates at least size items, the size is rounded up to a power of two
+   * so the positions can wrap around freely.
+   */
+  void Alloc(unsigned int size)
+  {
+    unsigned int count = 1;
+    while (count < size)
+      count <<= 1;
+
+    delete[] m_items;
+    m_items = new T[count];
+    m_mask  = count - 1;
+    Reset();
+  }
+
+  /* drops all queued items */
+  void Reset()
+  {
+    m_read    = 0;
+    m_written = 0;
+  }
+
+  /* drops all but the first keep queued items */
+  void Drop(unsigned int keep)
+  {
+    if (keep < Used())
+      m_written = m_read + keep;
+  }
+
+  unsigned int Size () const { return m_items ? m_mask + 1 : 0; }
+  unsigned int Used () const { return (unsigned int)(m_written - m_read); }
+  unsigned int Free () const { return Size() - Used(); }
+  bool         Empty() const { return m_written == m_read; }
+
+  /* direct access to the items for preallocation */
+  T& operator[](unsigned int i) { return m_items[i]; }
+
+  /* producer methods */
+
+  /* returns the next item to fill, or NULL if the queue is full */
+  T* GetWriteSlot()
+  {
+    if (!m_items || Free() == 0)
+      return NULL;
+    return &m_items[m_written & m_mask];
+  }
+
+  /* publishes the item returned by GetWriteSlot to the consumer */
+  void Push()
+  {
+    /* the increment is a full barrier, the item is complete before it is visible */
+    AtomicIncrement(&m_written);
+  }
+
+  /* consumer methods */
+
+  /* returns the oldest queued item, or NULL if the queue is empty */
+  T* GetReadSlot()
+  {
+    /* read with a barrier so the item is not read before the position */
+    if (!m_items || AtomicAdd(&m_written, 0) == m_read)
+      return NULL;
+    return &m_items[m_read & m_mask];
+  }
+
+  /* hands the item returned by GetReadSlot back to the producer */
+  void Pop()
+  {
+    AtomicIncrement(&m_read);
+  }
+
+private:
+  T             *m_items;
+  unsigned int   m_mask;
+  volatile long  m_read;    /* only written by the consumer */
+  volatile long  m_written; /* only written by the producer */
+};
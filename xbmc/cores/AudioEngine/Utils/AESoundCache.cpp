@@ -0,0 +1,178 @@
+/*
+ *      Copyright (C) 2010-2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AESoundCache.h"
+
+#include "system.h"
+#include "filesystem/File.h"
+#include "threads/SingleLock.h"
+#include "utils/log.h"
+#include "utils/StringUtils.h"
+
+/* bytes of unreferenced buffers kept for reuse, enough for the sounds of a skin */
+#define AE_SOUND_CACHE_IDLE_LIMIT (8 * 1024 * 1024)
+
+CAESoundBuffer::CAESoundBuffer(const std::string &filename, unsigned int sampleRate, const CAEChannelInfo &channelLayout) :
+  m_filename     (filename     ),
+  m_sampleRate   (sampleRate   ),
+  m_channelLayout(channelLayout),
+  m_size         (0            ),
+  m_modified     (0            ),
+  m_refs         (0            ),
+  m_lastUsed     (0            )
+{
+}
+
+bool CAESoundBuffer::IsCompatible(const unsigned int sampleRate, const CAEChannelInfo &channelInfo) const
+{
+  CAEChannelInfo layout(m_channelLayout);
+  return m_sampleRate == sampleRate && layout == channelInfo;
+}
+
+CAESoundCache::CAESoundCache() :
+  m_size      (0),
+  m_idleSize  (0),
+  m_useCounter(0)
+{
+}
+
+CAESoundCache::~CAESoundCache()
+{
+  for (BufferMap::iterator itt = m_buffers.begin(); itt != m_buffers.end(); ++itt)
+    delete itt->second;
+}
+
+CAESoundCache& CAESoundCache::GetInstance()
+{
+  static CAESoundCache sCache;
+  return sCache;
+}
+
+std::string CAESoundCache::GetKey(const std::string &filename, unsigned int sampleRate, const CAEChannelInfo &channelLayout, enum AEStdChLayout stdChLayout)
+{
+  CAEChannelInfo layout(channelLayout);
+  return StringUtils::Format("%u|%s|%d|", sampleRate, ((std::string)layout).c_str(), (int)stdChLayout) + filename;
+}
+
+int64_t CAESoundCache::GetModified(const std::string &filename)
+{
+  struct __stat64 st;
+  if (XFILE::CFile::Stat(filename, &st) != 0)
+    return 0;
+  return (int64_t)st.st_mtime;
+}
+
+CAESoundBuffer* CAESoundCache::Acquire(const std::string &filename, unsigned int sampleRate, const CAEChannelInfo &channelLayout, enum AEStdChLayout stdChLayout/* = AE_CH_LAYOUT_INVALID */)
+{
+  CSingleLock lock(m_lock);
+
+  const std::string key      = GetKey(filename, sampleRate, channelLayout, stdChLayout);
+  const int64_t     modified = GetModified(filename);
+
+  BufferMap::iterator itt = m_buffers.find(key);
+  if (itt != m_buffers.end())
+  {
+    CAESoundBuffer *buffer = itt->second;
+
+    /* a file that changed since it was loaded is loaded again once nothing plays the old samples */
+    if (buffer->m_modified == modified || buffer->m_refs > 0)
+    {
+      if (buffer->m_refs++ == 0)
+        m_idleSize -= buffer->m_size;
+      return buffer;
+    }
+
+    m_size     -= buffer->m_size;
+    m_idleSize -= buffer->m_size;
+    delete buffer;
+    m_buffers.erase(itt);
+  }
+
+  CAESoundBuffer *buffer = new CAESoundBuffer(filename, sampleRate, channelLayout);
+  if (!buffer->m_loader.Load(filename) ||
+      !buffer->m_loader.Initialize(sampleRate, channelLayout, stdChLayout))
+  {
+    delete buffer;
+    return NULL;
+  }
+
+  buffer->m_size     = buffer->m_loader.GetMemoryUsage();
+  buffer->m_modified = modified;
+  buffer->m_refs     = 1;
+  m_buffers[key]     = buffer;
+  m_size            += buffer->m_size;
+
+  CLog::Log(LOGDEBUG, "CAESoundCache::Acquire - Loaded %s at %uHz, %u sounds cached in %u KB",
+            filename.c_str(), sampleRate, (unsigned int)m_buffers.size(), (unsigned int)(m_size / 1024));
+  return buffer;
+}
+
+void CAESoundCache::Release(CAESoundBuffer *buffer)
+{
+  if (!buffer)
+    return;
+
+  CSingleLock lock(m_lock);
+  ASSERT(buffer->m_refs > 0);
+  if (--buffer->m_refs > 0)
+    return;
+
+  buffer->m_lastUsed = ++m_useCounter;
+  m_idleSize += buffer->m_size;
+  Trim(AE_SOUND_CACHE_IDLE_LIMIT);
+}
+
+void CAESoundCache::Clear()
+{
+  CSingleLock lock(m_lock);
+  Trim(0);
+}
+
+void CAESoundCache::Trim(size_t idleLimit)
+{
+  while (m_idleSize > idleLimit)
+  {
+    /* drop the least recently used buffer that is not referenced */
+    BufferMap::iterator oldest = m_buffers.end();
+    for (BufferMap::iterator itt = m_buffers.begin(); itt != m_buffers.end(); ++itt)
+      if (itt->second->m_refs == 0 && (oldest == m_buffers.end() || itt->second->m_lastUsed < oldest->second->m_lastUsed))
+        oldest = itt;
+
+    if (oldest == m_buffers.end())
+      break;
+
+    m_size     -= oldest->second->m_size;
+    m_idleSize -= oldest->second->m_size;
+    delete oldest->second;
+    m_buffers.erase(oldest);
+  }
+}
+
+size_t CAESoundCache::GetMemoryUsage()
+{
+  CSingleLock lock(m_lock);
+  return m_size;
+}
+
+unsigned int CAESoundCache::GetCount()
+{
+  CSingleLock lock(m_lock);
+  return m_buffers.size();
+}
@@ -0,0 +1,117 @@
+#pragma once
+/*
+ *      Copyright (C) 2010-2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <map>
+#include <string>
+#include <stdint.h>
+
+#include "threads/CriticalSection.h"
+#include "AEAudioFormat.h"
+#include "AEWAVLoader.h"
+
+class CAESoundCache;
+
+/**
+ * The samples of a sound file converted to one output format. A buffer is
+ * shared by every sound that plays the same file in the same format, and the
+ * samples do not change while it is referenced.
+ */
+class CAESoundBuffer
+{
+public:
+  const std::string& GetFilename   () const { return m_filename; }
+  unsigned int       GetSampleRate () const { return m_sampleRate; }
+  float*             GetSamples    ()       { return m_loader.GetSamples    (); }
+  unsigned int       GetSampleCount()       { return m_loader.GetSampleCount(); }
+  bool               IsCompatible(const unsigned int sampleRate, const CAEChannelInfo &channelInfo) const;
+
+private:
+  friend class CAESoundCache;
+  CAESoundBuffer(const std::string &filename, unsigned int sampleRate, const CAEChannelInfo &channelLayout);
+
+  std::string    m_filename;
+  unsigned int   m_sampleRate;
+  CAEChannelInfo m_channelLayout;
+  CAEWAVLoader   m_loader;
+  size_t         m_size;      /* bytes of samples held */
+  int64_t        m_modified;  /* the mtime of the file when it was loaded */
+  int            m_refs;
+  unsigned int   m_lastUsed;  /* the cache's use counter when it was last released */
+};
+
+/**
+ * Process wide cache of sound buffers keyed by file and output format.
+ *
+ * Sinks that reopen in the same format, and skins that reload their sounds,
+ * get the already converted samples back instead of decoding and resampling
+ * every file again. Buffers that are no longer referenced are kept until
+ * their total size passes AE_SOUND_CACHE_IDLE_LIMIT, the least recently
+ * used going first.
+ */
+class CAESoundCache
+{
+public:
+  static CAESoundCache& GetInstance();
+
+  /**
+   * Get the samples of a file in the given output format, loading and
+   * converting it if it is not cached
+   * @param filename      The WAV file to load
+   * @param sampleRate    The output sample rate
+   * @param channelLayout The output channel layout
+   * @param stdChLayout   The channels that are actually used in the layout
+   * @return the buffer, which must be given back with Release, or NULL if the file could not be loaded
+   */
+  CAESoundBuffer* Acquire(const std::string &filename, unsigned int sampleRate, const CAEChannelInfo &channelLayout, enum AEStdChLayout stdChLayout = AE_CH_LAYOUT_INVALID);
+  void            Release(CAESoundBuffer *buffer);
+
+  /**
+   * Drop every buffer that is not referenced
+   */
+  void Clear();
+
+  /**
+   * The memory used by all the cached buffers, referenced or not
+   * @return the size in bytes
+   */
+  size_t       GetMemoryUsage();
+  unsigned int GetCount();
+
+private:
+  CAESoundCache();
+  ~CAESoundCache();
+  CAESoundCache(const CAESoundCache&);
+  CAESoundCache const& operator=(CAESoundCache const&);
+
+  typedef std::map<std::string, CAESoundBuffer*> BufferMap;
+
+  static std::string GetKey(const std::string &filename, unsigned int sampleRate, const CAEChannelInfo &channelLayout, enum AEStdChLayout stdChLayout);
+  static int64_t     GetModified(const std::string &filename);
+
+  void Trim(size_t idleLimit);
+
+  CCriticalSection m_lock;
+  BufferMap        m_buffers;
+  size_t           m_size;      /* bytes held by all buffers */
+  size_t           m_idleSize;  /* bytes held by the buffers that are not referenced */
+  unsigned int     m_useCounter;
+};
+
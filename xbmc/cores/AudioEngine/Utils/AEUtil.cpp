@@ -23,6 +23,8 @@
 
 #include "utils/StdString.h"
 #include "AEUtil.h"
+#include "AESIMD.h"
+#include "utils/CPUInfo.h"
 #include "utils/log.h"
 #include "utils/TimeUtils.h"
 
@@ -372,6 +374,136 @@ void CAEUtil::ClampArray(float *data, uint32_t count)
 #endif
 }
 
+/*
+  MixVolume implementations, the sources are mixed in order with a separate
+  multiply and add so every variant gives the same result as the plain C one.
+*/
+static inline float MixSample(float value, const uint32_t i, const AEMixSource *sources, const unsigned int sourceCount)
+{
+  for (unsigned int s = 0; s < sourceCount; ++s)
+    if (i < sources[s].count)
+      value += sources[s].samples[i] * sources[s].volume;
+  return value;
+}
+
+static bool MixVolume_C(float *data, uint32_t count, const AEMixSource *sources, unsigned int sourceCount, const float volume)
+{
+  bool clip = false;
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    const float value = MixSample(data[i], i, sources, sourceCount) * volume;
+    clip |= value < -1.0f || value > 1.0f;
+    data[i] = value;
+  }
+  return clip;
+}
+
+#if defined(AE_SIMD_SSE2)
+static bool MixVolume_SSE2(float *data, uint32_t count, const AEMixSource *sources, unsigned int sourceCount, const float volume)
+{
+  const __m128 vol = _mm_set1_ps(volume);
+  const __m128 max = _mm_set1_ps( 1.0f);
+  const __m128 min = _mm_set1_ps(-1.0f);
+  __m128 clip = _mm_setzero_ps();
+
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 value = _mm_loadu_ps(data + i);
+    for (unsigned int s = 0; s < sourceCount; ++s)
+    {
+      const AEMixSource &src = sources[s];
+      if (i + 4 <= src.count)
+        value = _mm_add_ps(value, _mm_mul_ps(_mm_loadu_ps(src.samples + i), _mm_set1_ps(src.volume)));
+      else if (i < src.count)
+      {
+        /* the source ends in this block */
+        MEMALIGN(16, float partial[4]);
+        _mm_store_ps(partial, value);
+        for (uint32_t j = i; j < src.count; ++j)
+          partial[j - i] += src.samples[j] * src.volume;
+        value = _mm_load_ps(partial);
+      }
+    }
+
+    value = _mm_mul_ps(value, vol);
+    clip  = _mm_or_ps(clip, _mm_or_ps(_mm_cmpgt_ps(value, max), _mm_cmplt_ps(value, min)));
+    _mm_storeu_ps(data + i, value);
+  }
+
+  bool clipped = _mm_movemask_ps(clip) != 0;
+  for (; i < count; ++i)
+  {
+    const float value = MixSample(data[i], i, sources, sourceCount) * volume;
+    clipped |= value < -1.0f || value > 1.0f;
+    data[i] = value;
+  }
+  return clipped;
+}
+#endif /* AE_SIMD_SSE2 */
+
+#if defined(AE_SIMD_AVX2)
+AE_TARGET_AVX2 static bool MixVolume_AVX2(float *data, uint32_t count, const AEMixSource *sources, unsigned int sourceCount, const float volume)
+{
+  const __m256 vol = _mm256_set1_ps(volume);
+  const __m256 max = _mm256_set1_ps( 1.0f);
+  const __m256 min = _mm256_set1_ps(-1.0f);
+  __m256 clip = _mm256_setzero_ps();
+
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 value = _mm256_loadu_ps(data + i);
+    for (unsigned int s = 0; s < sourceCount; ++s)
+    {
+      const AEMixSource &src = sources[s];
+      if (i + 8 <= src.count)
+        value = _mm256_add_ps(value, _mm256_mul_ps(_mm256_loadu_ps(src.samples + i), _mm256_set1_ps(src.volume)));
+      else if (i < src.count)
+      {
+        /* the source ends in this block */
+        MEMALIGN(32, float partial[8]);
+        _mm256_store_ps(partial, value);
+        for (uint32_t j = i; j < src.count; ++j)
+          partial[j - i] += src.samples[j] * src.volume;
+        value = _mm256_load_ps(partial);
+      }
+    }
+
+    value = _mm256_mul_ps(value, vol);
+    clip  = _mm256_or_ps(clip, _mm256_or_ps(_mm256_cmp_ps(value, max, _CMP_GT_OQ), _mm256_cmp_ps(value, min, _CMP_LT_OQ)));
+    _mm256_storeu_ps(data + i, value);
+  }
+
+  bool clipped = _mm256_movemask_ps(clip) != 0;
+  for (; i < count; ++i)
+  {
+    const float value = MixSample(data[i], i, sources, sourceCount) * volume;
+    clipped |= value < -1.0f || value > 1.0f;
+    data[i] = value;
+  }
+  return clipped;
+}
+#endif /* AE_SIMD_AVX2 */
+
+CAEUtil::AEMixVolumeFn CAEUtil::MixVolume()
+{
+  return MixVolume(g_cpuInfo.GetCPUFeatures());
+}
+
+CAEUtil::AEMixVolumeFn CAEUtil::MixVolume(unsigned int cpuFeatures)
+{
+#if defined(AE_SIMD_AVX2)
+  if (cpuFeatures & CPU_FEATURE_AVX2)
+    return &MixVolume_AVX2;
+#endif
+#if defined(AE_SIMD_SSE2)
+  if (cpuFeatures & CPU_FEATURE_SSE2)
+    return &MixVolume_SSE2;
+#endif
+  return &MixVolume_C;
+}
+
 /*
   Rand implementations based on:
   http://software.intel.com/en-us/articles/fast-random-number-generator-on-the-intel-pentiumr-4-processor/
@@ -42,6 +42,14 @@
   #define MEMALIGN(b, x) __declspec(align(b)) x
 #endif
 
+/* a buffer to mix in, see CAEUtil::AEMixVolumeFn */
+typedef struct
+{
+  const float *samples;
+  float        volume;
+  uint32_t     count;   /* may be less than the samples being mixed into */
+} AEMixSource;
+
 class CAEUtil
 {
 private:
@@ -112,6 +120,22 @@ public:
   #endif
   static void ClampArray(float *data, uint32_t count);
 
+  /*! \brief Mix, apply the volume and check the range in a single pass.
+   Each sample becomes (data + source * source volume ...) * volume, the sources
+   are added in order so the result matches mixing and scaling separately.
+   \param data the buffer to mix into, it is modified in place.
+   \param count the number of samples in data.
+   \param sources the buffers to mix in, may be NULL if sourceCount is 0.
+   \param sourceCount the number of sources.
+   \param volume the volume to apply after mixing.
+   \return true if any resulting sample is outside of [-1, 1].
+   */
+  typedef bool (*AEMixVolumeFn)(float *data, uint32_t count, const AEMixSource *sources, unsigned int sourceCount, const float volume);
+
+  /* returns the fastest MixVolume implementation for this, or the specified, CPU */
+  static AEMixVolumeFn MixVolume();
+  static AEMixVolumeFn MixVolume(unsigned int cpuFeatures);
+
   /*
     Rand implementations based on:
     http://software.intel.com/en-us/articles/fast-random-number-generator-on-the-intel-pentiumr-4-processor/
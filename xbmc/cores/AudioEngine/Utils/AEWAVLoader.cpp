@@ -25,9 +25,19 @@
 #include "utils/log.h"
 #include "utils/EndianSwap.h"
 #include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
 #include "URL.h"
 #include <samplerate.h>
 
+#include <vector>
+
+#if defined(TARGET_POSIX)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "AEConvert.h"
 #include "AEUtil.h"
 #include "AERemap.h"
@@ -62,20 +72,58 @@ bool CAEWAVLoader::Load(const std::string &filename)
 
   m_filename = filename;
 
+#if defined(TARGET_POSIX)
+  /* map local files instead of reading them, the samples are converted straight from the page cache without a heap copy of the file */
+  CStdString path = CSpecialProtocol::TranslatePath(m_filename);
+  if (CURL(path).GetProtocol().IsEmpty())
+  {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+      struct stat st;
+      void *map = MAP_FAILED;
+      if (fstat(fd, &st) == 0 && st.st_size > 0)
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      close(fd);
+
+      if (map != MAP_FAILED)
+      {
+        bool ret = Parse((const uint8_t*)map, st.st_size);
+        munmap(map, st.st_size);
+        return ret;
+      }
+    }
+  }
+#endif
+
   XFILE::CFile file;
   if (!file.Open(m_filename))
   {
-    CLog::Log(LOGERROR, "CAEWAVLoader::Initialize - Failed to create loader: %s", m_filename.c_str());
+    CLog::Log(LOGERROR, "CAEWAVLoader::Load - Failed to create loader: %s", m_filename.c_str());
+    return false;
+  }
+
+  int64_t length = file.GetLength();
+  if (length <= 0 || length > 0x7FFFFFFF)
+  {
+    CLog::Log(LOGERROR, "CAEWAVLoader::Load - Failed to stat file: %s", m_filename.c_str());
     return false;
   }
 
-  struct __stat64 st;
-  if (file.Stat(&st) < 0)
+  std::vector<uint8_t> data((size_t)length);
+  if (file.Read(&data[0], data.size()) != data.size())
   {
-    CLog::Log(LOGERROR, "CAEWAVLoader::Initialize - Failed to stat file: %s", m_filename.c_str());
+    CLog::Log(LOGERROR, "CAEWAVLoader::Load - Failed to read file: %s", m_filename.c_str());
     return false;
   }
 
+  /* close the file as we have the data now */
+  file.Close();
+  return Parse(&data[0], data.size());
+}
+
+bool CAEWAVLoader::Parse(const uint8_t *data, size_t size)
+{
   bool isRIFF = false;
   bool isWAVE = false;
   bool isFMT  = false;
@@ -87,9 +135,14 @@ bool CAEWAVLoader::Load(const std::string &filename)
   uint16_t blockAlign;
   uint16_t bitsPerSample;
 
+  const uint8_t *pos = data;
+  const uint8_t *end = data + size;
+
   WAVE_CHUNK chunk;
-  while (file.Read(&chunk, sizeof(chunk)) == sizeof(chunk))
+  while (end - pos >= (ptrdiff_t)sizeof(chunk))
   {
+    memcpy(&chunk, pos, sizeof(chunk));
+    pos += sizeof(chunk);
     chunk.chunksize = Endian_SwapLE32(chunk.chunksize);
 
     /* if its the RIFF header */
@@ -98,22 +151,21 @@ bool CAEWAVLoader::Load(const std::string &filename)
       isRIFF = true;
 
       /* work around invalid chunksize, I have seen this in one file so far (shutter.wav) */
-      if (chunk.chunksize == st.st_size)
+      if (chunk.chunksize == size)
         chunk.chunksize -= 8;
 
       /* sanity check on the chunksize */
-      if (chunk.chunksize > st.st_size - 8)
+      if (chunk.chunksize > size - 8)
       {
-        CLog::Log(LOGERROR, "CAEWAVLoader::Initialize - Corrupt WAV header: %s", m_filename.c_str());
-        file.Close();
+        CLog::Log(LOGERROR, "CAEWAVLoader::Load - Corrupt WAV header: %s", m_filename.c_str());
         return false;
       }
 
       /* we only support WAVE files */
-      char format[4];
-      if (file.Read(&format, 4) != 4)
+      if (end - pos < 4)
         break;
-      isWAVE = memcmp(format, "WAVE", 4) == 0;
+      isWAVE = memcmp(pos, "WAVE", 4) == 0;
+      pos += 4;
       if (!isWAVE)
         break;
     }
@@ -121,30 +173,26 @@ bool CAEWAVLoader::Load(const std::string &filename)
     else if (!isFMT && memcmp(chunk.chunk_id, "fmt ", 4) == 0)
     {
       isFMT = true;
-      if (chunk.chunksize < 16)
+      if (chunk.chunksize < 16 || end - pos < (ptrdiff_t)chunk.chunksize)
         break;
+
       uint16_t format;
-      if (file.Read(&format, sizeof(format)) != sizeof(format))
-        break;
+      uint16_t channelCount;
+      memcpy(&format       , pos +  0, 2);
+      memcpy(&channelCount , pos +  2, 2);
+      memcpy(&sampleRate   , pos +  4, 4);
+      memcpy(&byteRate     , pos +  8, 4);
+      memcpy(&blockAlign   , pos + 12, 2);
+      memcpy(&bitsPerSample, pos + 14, 2);
+      pos += chunk.chunksize;
+
       format = Endian_SwapLE16(format);
       if (format != WAVE_FORMAT_PCM)
         break;
 
-      uint16_t channelCount;
-      if (file.Read(&channelCount , 2) != 2)
-        break;
-      if (file.Read(&sampleRate   , 4) != 4)
-        break;
-      if (file.Read(&byteRate     , 4) != 4)
-        break;
-      if (file.Read(&blockAlign   , 2) != 2)
-        break;
-      if (file.Read(&bitsPerSample, 2) != 2)
-        break;
-
       channelCount = Endian_SwapLE16(channelCount);
       /* TODO: support > 2 channel count */
-      if (channelCount > 2)
+      if (channelCount < 1 || channelCount > 2)
         break;
 
       static AEChannel layouts[][3] = {
@@ -158,18 +206,10 @@ bool CAEWAVLoader::Load(const std::string &filename)
       blockAlign     = Endian_SwapLE16(blockAlign   );
       bitsPerSample  = Endian_SwapLE16(bitsPerSample);
       isPCM          = true;
-
-      if (chunk.chunksize > 16)
-        file.Seek(chunk.chunksize - 16, SEEK_CUR);
     }
     /* if we have the PCM info and its the DATA section */
     else if (isPCM && !isDATA && memcmp(chunk.chunk_id, "data", 4) == 0)
     {
-       unsigned int bytesPerSample = bitsPerSample >> 3;
-       m_sampleCount = chunk.chunksize / bytesPerSample;
-       m_frameCount  = m_sampleCount / m_channels.Count();
-       isDATA        = m_frameCount > 0;
-
        /* get the conversion function */
        CAEConvert::AEConvertToFn convertFn;
        switch (bitsPerSample)
@@ -178,53 +218,60 @@ bool CAEWAVLoader::Load(const std::string &filename)
          case 16: convertFn = CAEConvert::ToFloat(AE_FMT_S16LE); break;
          case 32: convertFn = CAEConvert::ToFloat(AE_FMT_S32LE); break;
          default:
-           CLog::Log(LOGERROR, "CAEWAVLoader::Initialize - Unsupported data format in wav: %s", m_filename.c_str());
-           file.Close();
+           CLog::Log(LOGERROR, "CAEWAVLoader::Load - Unsupported data format in wav: %s", m_filename.c_str());
            return false;
        }
 
-       /* read in each sample */
-       unsigned int size = bytesPerSample * m_sampleCount;
-       m_samples    = (float*   )_aligned_malloc(sizeof(float) * m_sampleCount, 16);
-       uint8_t *raw = (uint8_t *)_aligned_malloc(size, 16);
-       if (file.Read(raw, size) != size)
+       unsigned int bytesPerSample = bitsPerSample >> 3;
+       if (end - pos < (ptrdiff_t)chunk.chunksize)
        {
-         CLog::Log(LOGERROR, "CAEWAVLoader::Initialize - WAV data shorter then expected: %s", m_filename.c_str());
-         _aligned_free(m_samples);
-         _aligned_free(raw);
-         m_samples = NULL;
-         file.Close();
+         CLog::Log(LOGERROR, "CAEWAVLoader::Load - WAV data shorter then expected: %s", m_filename.c_str());
          return false;
        }
 
-       /* convert the samples to float */
-       convertFn(raw, m_sampleCount, m_samples);
-       _aligned_free(raw);
+       m_sampleCount = chunk.chunksize / bytesPerSample;
+       m_frameCount  = m_sampleCount / m_channels.Count();
+       m_sampleCount = m_frameCount * m_channels.Count();
+       isDATA        = m_frameCount > 0;
+
+       /* convert the samples to float straight from the file data */
+       if (isDATA)
+       {
+         m_samples = (float*)_aligned_malloc(sizeof(float) * m_sampleCount, 16);
+         convertFn((uint8_t*)pos, m_sampleCount, m_samples);
+       }
+       pos += chunk.chunksize;
     }
     else
     {
       /* skip any unknown sections */
-      file.Seek(chunk.chunksize, SEEK_CUR);
+      if (end - pos < (ptrdiff_t)chunk.chunksize)
+        break;
+      pos += chunk.chunksize;
     }
+
+    /* chunks are word aligned */
+    if ((chunk.chunksize & 1) && pos < end && memcmp(chunk.chunk_id, "RIFF", 4) != 0)
+      ++pos;
   }
 
   if (!isRIFF || !isWAVE || !isFMT || !isPCM || !isDATA || m_sampleCount == 0)
   {
-    CLog::Log(LOGERROR, "CAEWAVLoader::Initialize - Invalid, or un-supported WAV file: %s", m_filename.c_str());
-    file.Close();
+    CLog::Log(LOGERROR, "CAEWAVLoader::Load - Invalid, or un-supported WAV file: %s", m_filename.c_str());
+    _aligned_free(m_samples);
+    m_samples     = NULL;
+    m_sampleCount = 0;
+    m_frameCount  = 0;
     return false;
   }
 
-  /* close the file as we have the samples now */
-  file.Close();
-
   m_outputChannels     = m_channels;
   m_outputSampleRate   = m_sampleRate;
   m_outputSamples      = m_samples;
   m_outputSampleCount  = m_sampleCount;
   m_outputFrameCount   = m_frameCount;
 
-  CLog::Log(LOGINFO, "CAEWAVLoader::Initialize - Sound Loaded: %s", m_filename.c_str());
+  CLog::Log(LOGINFO, "CAEWAVLoader::Load - Sound Loaded: %s", m_filename.c_str());
   m_valid = true;
   return true;
 }
@@ -303,6 +350,7 @@ void CAEWAVLoader::UnLoad()
 {
   DeInitialize();
 
+  m_valid = false;
   _aligned_free(m_samples);
   m_samples     = NULL;
   m_sampleCount = 0;
@@ -355,6 +403,14 @@ float* CAEWAVLoader::GetSamples()
   return m_outputSamples;
 }
 
+size_t CAEWAVLoader::GetMemoryUsage()
+{
+  size_t samples = m_sampleCount;
+  if (m_outputSamples && m_outputSamples != m_samples)
+    samples += m_outputSampleCount;
+  return samples * sizeof(float);
+}
+
 bool CAEWAVLoader::IsCompatible(const unsigned int sampleRate, const CAEChannelInfo &channelInfo)
 {
   return (
@@ -29,7 +29,7 @@ public:
   ~CAEWAVLoader();
 
   /**
-   * Load a WAV file into memory
+   * Load a WAV file into memory, local files are memory mapped rather than read
    * @param filename The filename to load
    * @return         true on success
    */
@@ -66,7 +66,16 @@ public:
   float*         GetSamples();
   bool           IsCompatible(const unsigned int sampleRate, const CAEChannelInfo &channelInfo);
 
+  /**
+   * Returns the memory used by the loaded and the converted samples
+   * @return the size in bytes
+   */
+  size_t         GetMemoryUsage();
+
 private:
+  bool Parse(const uint8_t *data, size_t size);
+
+
   std::string  m_filename;
   bool         m_valid;
 
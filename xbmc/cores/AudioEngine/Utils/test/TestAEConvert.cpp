@@ -0,0 +1,255 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Utils/AEConvert.h"
+#include "cores/AudioEngine/Utils/AEUtil.h"
+#include "utils/CPUInfo.h"
+#include "utils/TimeUtils.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+static const enum AEDataFormat formats[] =
+{
+  AE_FMT_U8,
+  AE_FMT_S8,
+  AE_FMT_S16LE,
+  AE_FMT_S16BE,
+  AE_FMT_S24LE4,
+  AE_FMT_S24BE4,
+  AE_FMT_S24NE4,
+  AE_FMT_S24LE3,
+  AE_FMT_S24BE3,
+  AE_FMT_S24NE3,
+  AE_FMT_S32LE,
+  AE_FMT_S32BE,
+  AE_FMT_DOUBLE
+};
+
+struct SIMDVariant
+{
+  const char   *name;
+  unsigned int  features;
+};
+
+static const SIMDVariant variants[] =
+{
+  { "SSE2", CPU_FEATURE_SSE2                    },
+  { "AVX2", CPU_FEATURE_SSE2 | CPU_FEATURE_AVX2 }
+};
+
+/* odd sizes and offsets exercise the unaligned heads and the scalar tails */
+static const unsigned int sizes  [] = { 1, 3, 7, 8, 15, 17, 31, 33, 67, 4099 };
+static const unsigned int offsets[] = { 0, 1, 3 };
+
+static bool HasVariant(const SIMDVariant &variant)
+{
+  return (g_cpuInfo.GetCPUFeatures() & variant.features) == variant.features;
+}
+
+static unsigned int BytesPerSample(enum AEDataFormat format)
+{
+  return CAEUtil::DataFormatToBits(format) >> 3;
+}
+
+/* the S16 output formats are dithered, they may differ by one LSB */
+static bool IsDithered(enum AEDataFormat format)
+{
+  return format == AE_FMT_S16LE || format == AE_FMT_S16BE;
+}
+
+static void FillInput(enum AEDataFormat format, uint8_t *data, unsigned int samples)
+{
+  if (format == AE_FMT_DOUBLE)
+  {
+    double *dst = (double*)data;
+    for (unsigned int i = 0; i < samples; ++i)
+      dst[i] = ((double)rand() / RAND_MAX) * 3.0 - 1.5;
+  }
+  else
+  {
+    for (unsigned int i = 0; i < samples * BytesPerSample(format); ++i)
+      data[i] = rand() & 0xFF;
+  }
+}
+
+static void FillFloat(float *data, unsigned int samples)
+{
+  /* include full scale and out of range values to test the clamping */
+  static const float special[] = { 0.0f, 1.0f, -1.0f, 1.5f, -1.5f, 0.5f, -0.5f, 1e-7f };
+  for (unsigned int i = 0; i < samples; ++i)
+  {
+    if (i < sizeof(special) / sizeof(special[0]))
+      data[i] = special[i];
+    else
+      data[i] = ((float)rand() / RAND_MAX) * 2.4f - 1.2f;
+  }
+}
+
+TEST(TestAEConvert, ToFloatBitExact)
+{
+  for (unsigned int f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f)
+  {
+    CAEConvert::AEConvertToFn ref = CAEConvert::ToFloat(formats[f], 0);
+    ASSERT_TRUE(ref != NULL);
+
+    for (unsigned int v = 0; v < sizeof(variants) / sizeof(variants[0]); ++v)
+    {
+      if (!HasVariant(variants[v]))
+        continue;
+
+      CAEConvert::AEConvertToFn fn = CAEConvert::ToFloat(formats[f], variants[v].features);
+      ASSERT_TRUE(fn != NULL);
+
+      for (unsigned int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+        for (unsigned int o = 0; o < sizeof(offsets) / sizeof(offsets[0]); ++o)
+        {
+          const unsigned int samples = sizes[s];
+          std::vector<uint8_t> in(samples * 8 + offsets[o]);
+          std::vector<float>   expected(samples), actual(samples);
+          uint8_t *data = &in[offsets[o]];
+
+          FillInput(formats[f], data, samples);
+          EXPECT_EQ(samples, ref(data, samples, &expected[0]));
+          EXPECT_EQ(samples, fn (data, samples, &actual  [0]));
+          EXPECT_EQ(0, memcmp(&expected[0], &actual[0], samples * sizeof(float)))
+            << CAEUtil::DataFormatToStr(formats[f]) << " " << variants[v].name
+            << " samples " << samples << " offset " << offsets[o];
+        }
+    }
+  }
+}
+
+TEST(TestAEConvert, FrFloatBitExact)
+{
+  for (unsigned int f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f)
+  {
+    CAEConvert::AEConvertFrFn ref = CAEConvert::FrFloat(formats[f], 0);
+    if (!ref)
+      continue; /* no conversion to this format */
+
+    for (unsigned int v = 0; v < sizeof(variants) / sizeof(variants[0]); ++v)
+    {
+      if (!HasVariant(variants[v]))
+        continue;
+
+      CAEConvert::AEConvertFrFn fn = CAEConvert::FrFloat(formats[f], variants[v].features);
+      ASSERT_TRUE(fn != NULL);
+
+      for (unsigned int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+        for (unsigned int o = 0; o < sizeof(offsets) / sizeof(offsets[0]); ++o)
+        {
+          const unsigned int samples = sizes[s];
+          const unsigned int bytes   = samples * BytesPerSample(formats[f]);
+          std::vector<float>   in(samples + offsets[o]);
+          std::vector<uint8_t> expected(bytes + offsets[o]), actual(bytes + offsets[o]);
+          float *data = &in[offsets[o]];
+
+          FillFloat(data, samples);
+          EXPECT_EQ(bytes, ref(data, samples, &expected[offsets[o]]));
+          EXPECT_EQ(bytes, fn (data, samples, &actual  [offsets[o]]));
+
+          if (IsDithered(formats[f]))
+          {
+            const bool swap = formats[f] == AE_FMT_S16BE;
+            for (unsigned int i = 0; i < samples; ++i)
+            {
+              const uint8_t *e = &expected[offsets[o] + i * 2];
+              const uint8_t *a = &actual  [offsets[o] + i * 2];
+              const int16_t es = swap ? (int16_t)((e[0] << 8) | e[1]) : (int16_t)((e[1] << 8) | e[0]);
+              const int16_t as = swap ? (int16_t)((a[0] << 8) | a[1]) : (int16_t)((a[1] << 8) | a[0]);
+              EXPECT_NEAR(es, as, 1)
+                << CAEUtil::DataFormatToStr(formats[f]) << " " << variants[v].name << " sample " << i;
+            }
+          }
+          else
+            EXPECT_EQ(0, memcmp(&expected[0], &actual[0], expected.size()))
+              << CAEUtil::DataFormatToStr(formats[f]) << " " << variants[v].name
+              << " samples " << samples << " offset " << offsets[o];
+        }
+    }
+  }
+}
+
+TEST(TestAEConvert, FrFloatClamp)
+{
+  float in[4] = { 1.0f, -1.0f, 2.0f, -2.0f };
+  int32_t s32[4];
+  EXPECT_EQ(sizeof(s32), CAEConvert::FrFloat(AE_FMT_S32NE)(in, 4, (uint8_t*)s32));
+  EXPECT_EQ(INT32_MAX, s32[0]);
+  EXPECT_EQ(INT32_MIN, s32[1]);
+  EXPECT_EQ(INT32_MAX, s32[2]);
+  EXPECT_EQ(INT32_MIN, s32[3]);
+
+  int32_t s24[4];
+  EXPECT_EQ(sizeof(s24), CAEConvert::FrFloat(AE_FMT_S24NE4)(in, 4, (uint8_t*)s24));
+  EXPECT_EQ(0x7FFFFF00, s24[0]);
+  EXPECT_EQ(0x7FFFFF00, s24[2]);
+  EXPECT_EQ((int32_t)0x80000000, s24[3]);
+}
+
+TEST(TestAEConvert, Benchmark)
+{
+  const unsigned int samples    = 8 * 1024;
+  const unsigned int iterations = 200;
+  std::vector<uint8_t> raw(samples * sizeof(double));
+  std::vector<float>   flt(samples);
+
+  for (unsigned int f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f)
+  {
+    FillInput(formats[f], &raw[0], samples);
+    FillFloat(&flt[0], samples);
+
+    for (int v = -1; v < (int)(sizeof(variants) / sizeof(variants[0])); ++v)
+    {
+      if (v >= 0 && !HasVariant(variants[v]))
+        continue;
+
+      const unsigned int features = v < 0 ? 0 : variants[v].features;
+      CAEConvert::AEConvertToFn to = CAEConvert::ToFloat(formats[f], features);
+      CAEConvert::AEConvertFrFn fr = CAEConvert::FrFloat(formats[f], features);
+
+      int64_t start = CurrentHostCounter();
+      for (unsigned int i = 0; i < iterations; ++i)
+        to(&raw[0], samples, &flt[0]);
+      const double toTime = (double)(CurrentHostCounter() - start) / CurrentHostFrequency();
+
+      double frTime = 0.0;
+      if (fr)
+      {
+        FillFloat(&flt[0], samples);
+        start = CurrentHostCounter();
+        for (unsigned int i = 0; i < iterations; ++i)
+          fr(&flt[0], samples, &raw[0]);
+        frTime = (double)(CurrentHostCounter() - start) / CurrentHostFrequency();
+      }
+
+      const double msamples = (double)samples * iterations / 1000000.0;
+      std::cout << CAEUtil::DataFormatToStr(formats[f]) << " " << (v < 0 ? "scalar" : variants[v].name)
+                << " ToFloat: " << testing::PrintToString(msamples / toTime) << " Msamples/s";
+      if (fr)
+        std::cout << " FrFloat: " << testing::PrintToString(msamples / frTime) << " Msamples/s";
+      std::cout << std::endl;
+    }
+  }
+}
@@ -0,0 +1,172 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Utils/AELoudness.h"
+
+#include "gtest/gtest.h"
+
+#include <math.h>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* appends a sine of the given peak level in dBFS to every channel */
+static void AppendSine(std::vector<float> &samples, unsigned int channels, double rate, double freq, double dBFS, double seconds, double phase = 0.0)
+{
+  const double amplitude = pow(10.0, dBFS / 20.0);
+  const unsigned int frames = (unsigned int)(rate * seconds);
+  const size_t start = samples.size() / channels;
+  for (unsigned int i = 0; i < frames; ++i)
+    for (unsigned int c = 0; c < channels; ++c)
+      samples.push_back((float)(amplitude * sin(2.0 * M_PI * freq * (start + i) / rate + phase)));
+}
+
+static bool Measure(const std::vector<float> &samples, enum AEStdChLayout layout, unsigned int rate, double &loudness, double &peak)
+{
+  CAEChannelInfo info(layout);
+  CAELoudness meter;
+  if (!meter.Initialize(info, rate))
+    return false;
+  meter.Process(&samples[0], samples.size() / info.Count());
+  peak = meter.GetTruePeak();
+  return meter.GetIntegratedLoudness(loudness);
+}
+
+TEST(TestAELoudness, Invalid)
+{
+  CAELoudness meter;
+  EXPECT_FALSE(meter.Initialize(CAEChannelInfo(), 48000));
+
+  double loudness;
+  EXPECT_FALSE(meter.GetIntegratedLoudness(loudness));
+}
+
+TEST(TestAELoudness, Sine)
+{
+  /* EBU Tech 3341 cases 1 and 2, a stereo 1kHz sine reads its peak level in LUFS */
+  static const unsigned int rates[] = { 44100, 48000 };
+  static const double levels[] = { -23.0, -33.0 };
+  for (unsigned int r = 0; r < sizeof(rates) / sizeof(rates[0]); ++r)
+    for (unsigned int l = 0; l < sizeof(levels) / sizeof(levels[0]); ++l)
+    {
+      std::vector<float> samples;
+      AppendSine(samples, 2, rates[r], 1000.0, levels[l], 20.0);
+
+      double loudness, peak;
+      ASSERT_TRUE(Measure(samples, AE_CH_LAYOUT_2_0, rates[r], loudness, peak));
+      EXPECT_NEAR(levels[l], loudness, 0.1) << rates[r] << "Hz";
+    }
+}
+
+TEST(TestAELoudness, Gating)
+{
+  /* EBU Tech 3341 case 3, the quiet parts fall below the relative gate */
+  std::vector<float> samples;
+  AppendSine(samples, 2, 48000.0, 1000.0, -36.0, 10.0);
+  AppendSine(samples, 2, 48000.0, 1000.0, -23.0, 60.0);
+  AppendSine(samples, 2, 48000.0, 1000.0, -36.0, 10.0);
+
+  double loudness, peak;
+  ASSERT_TRUE(Measure(samples, AE_CH_LAYOUT_2_0, 48000, loudness, peak));
+  EXPECT_NEAR(-23.0, loudness, 0.1);
+
+  /* EBU Tech 3341 case 5, silence falls below the absolute gate */
+  samples.clear();
+  AppendSine(samples, 2, 48000.0, 1000.0, -26.0, 20.0);
+  samples.resize(samples.size() + 48000 * 20 * 2, 0.0f);
+  AppendSine(samples, 2, 48000.0, 1000.0, -26.0, 20.1);
+  samples.resize(samples.size() + 48000 * 20 * 2, 0.0f);
+  AppendSine(samples, 2, 48000.0, 1000.0, -26.0, 20.0);
+
+  ASSERT_TRUE(Measure(samples, AE_CH_LAYOUT_2_0, 48000, loudness, peak));
+  EXPECT_NEAR(-26.0, loudness, 0.1);
+}
+
+TEST(TestAELoudness, Silence)
+{
+  std::vector<float> samples(48000 * 2 * 5, 0.0f);
+  double loudness, peak;
+  EXPECT_FALSE(Measure(samples, AE_CH_LAYOUT_2_0, 48000, loudness, peak));
+  EXPECT_EQ(0.0, peak);
+}
+
+TEST(TestAELoudness, Surround)
+{
+  /* the LFE is not measured and the surrounds weigh +1.5dB */
+  std::vector<float> samples;
+  AppendSine(samples, 6, 48000.0, 1000.0, -23.0, 20.0);
+  CAEChannelInfo info(AE_CH_LAYOUT_5_1);
+
+  double loudness, peak;
+  ASSERT_TRUE(Measure(samples, AE_CH_LAYOUT_5_1, 48000, loudness, peak));
+
+  double expected = 0.0;
+  for (unsigned int c = 0; c < info.Count(); ++c)
+  {
+    if (info[c] == AE_CH_LFE)
+      continue;
+    expected += (info[c] == AE_CH_BL || info[c] == AE_CH_BR || info[c] == AE_CH_SL || info[c] == AE_CH_SR) ? 1.41 : 1.0;
+  }
+  EXPECT_NEAR(-23.0 + 10.0 * log10(expected / 2.0), loudness, 0.1);
+}
+
+TEST(TestAELoudness, TruePeak)
+{
+  /*
+    a quarter sample rate sine at 45 degrees never has a sample on its peak,
+    the samples read 3dB low while the true peak is the full level
+  */
+  std::vector<float> samples;
+  AppendSine(samples, 2, 48000.0, 12000.0, -6.0, 1.0, M_PI / 4.0);
+
+  double loudness, peak;
+  Measure(samples, AE_CH_LAYOUT_2_0, 48000, loudness, peak);
+  EXPECT_NEAR(-6.0, 20.0 * log10(peak), 0.2);
+
+  float samplePeak = 0.0f;
+  for (unsigned int i = 0; i < samples.size(); ++i)
+    samplePeak = std::max(samplePeak, (float)fabs(samples[i]));
+  EXPECT_NEAR(-9.0, 20.0 * log10(samplePeak), 0.1);
+}
+
+TEST(TestAELoudness, Chunking)
+{
+  /* the result must not depend on how the stream is split */
+  std::vector<float> samples;
+  AppendSine(samples, 2, 44100.0, 997.0, -18.0, 3.0);
+  AppendSine(samples, 2, 44100.0, 3000.0, -30.0, 3.0);
+
+  CAEChannelInfo info(AE_CH_LAYOUT_2_0);
+  CAELoudness whole, split;
+  ASSERT_TRUE(whole.Initialize(info, 44100));
+  ASSERT_TRUE(split.Initialize(info, 44100));
+
+  whole.Process(&samples[0], samples.size() / 2);
+  for (unsigned int pos = 0; pos < samples.size() / 2; pos += 333)
+    split.Process(&samples[pos * 2], std::min(333U, (unsigned int)(samples.size() / 2 - pos)));
+
+  double a, b;
+  ASSERT_TRUE(whole.GetIntegratedLoudness(a));
+  ASSERT_TRUE(split.GetIntegratedLoudness(b));
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(whole.GetTruePeak(), split.GetTruePeak());
+}
@@ -0,0 +1,235 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Utils/AERemap.h"
+#include "settings/GUISettings.h"
+#include "utils/TimeUtils.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+/* odd frame counts exercise the single frame tails of the two frame kernels */
+static const unsigned int frameCounts[] = { 1, 2, 3, 7, 64, 4099 };
+static const float        guard         = 12345.0f;
+
+static const double k = 1.0 / sqrt(2.0);
+
+/*
+  runs the remap and compares it against the given matrix, coeffs holds one
+  row of input levels per output channel
+*/
+static void CheckRemap(const enum AEChannel *input, const enum AEChannel *output,
+                       const double *coeffs, bool finalStage = false)
+{
+  CAEChannelInfo inLayout(input), outLayout(output);
+  const unsigned int inChannels  = inLayout .Count();
+  const unsigned int outChannels = outLayout.Count();
+
+  CAERemap remap;
+  ASSERT_TRUE(remap.Initialize(inLayout, outLayout, finalStage, true));
+
+  for (unsigned int n = 0; n < sizeof(frameCounts) / sizeof(frameCounts[0]); ++n)
+  {
+    const unsigned int frames = frameCounts[n];
+    std::vector<float> in(frames * inChannels);
+    std::vector<float> out(frames * outChannels + 4, guard);
+
+    for (unsigned int i = 0; i < in.size(); ++i)
+      in[i] = ((float)rand() / RAND_MAX) * 2.0f - 1.0f;
+
+    remap.Remap(&in[0], &out[0], frames);
+
+    for (unsigned int f = 0; f < frames; ++f)
+      for (unsigned int o = 0; o < outChannels; ++o)
+      {
+        const double *row = coeffs + o * inChannels;
+        double expected = 0.0;
+        double level    = 0.0;
+        int    sources  = 0;
+        for (unsigned int i = 0; i < inChannels; ++i)
+          if (row[i] != 0.0)
+          {
+            expected += row[i] * in[f * inChannels + i];
+            level     = row[i];
+            ++sources;
+          }
+
+        const float actual = out[f * outChannels + o];
+        /* copied channels must be bit exact */
+        if (sources == 1 && level == 1.0)
+          EXPECT_EQ((float)expected, actual) << "frames " << frames << " frame " << f << " channel " << o;
+        else
+          EXPECT_NEAR(expected, actual, 1e-5) << "frames " << frames << " frame " << f << " channel " << o;
+      }
+
+    /* the kernels must not write past the last frame */
+    for (unsigned int i = frames * outChannels; i < out.size(); ++i)
+      EXPECT_EQ(guard, out[i]);
+  }
+}
+
+TEST(TestAERemap, Reorder)
+{
+  static enum AEChannel input [] = { AE_CH_FL, AE_CH_FR, AE_CH_FC, AE_CH_LFE, AE_CH_BL, AE_CH_BR, AE_CH_NULL };
+  static enum AEChannel output[] = { AE_CH_FL, AE_CH_FR, AE_CH_BL, AE_CH_BR, AE_CH_FC, AE_CH_LFE, AE_CH_NULL };
+  static const double coeffs[] =
+  {
+    1, 0, 0, 0, 0, 0,
+    0, 1, 0, 0, 0, 0,
+    0, 0, 0, 0, 1, 0,
+    0, 0, 0, 0, 0, 1,
+    0, 0, 1, 0, 0, 0,
+    0, 0, 0, 1, 0, 0
+  };
+  CheckRemap(input, output, coeffs, true);
+}
+
+TEST(TestAERemap, MonoToStereo)
+{
+  static enum AEChannel input [] = { AE_CH_FC, AE_CH_NULL };
+  static enum AEChannel output[] = { AE_CH_FL, AE_CH_FR, AE_CH_NULL };
+  /* a single source is copied so DPL survives */
+  static const double coeffs[] = { 1, 1 };
+  CheckRemap(input, output, coeffs);
+}
+
+TEST(TestAERemap, StereoTo51)
+{
+  static enum AEChannel input [] = { AE_CH_FL, AE_CH_FR, AE_CH_NULL };
+  static enum AEChannel output[] = { AE_CH_FL, AE_CH_FR, AE_CH_FC, AE_CH_LFE, AE_CH_BL, AE_CH_BR, AE_CH_NULL };
+  static const double coeffs[] =
+  {
+    1, 0,
+    0, 1,
+    0, 0,
+    0, 0,
+    0, 0,
+    0, 0
+  };
+  CheckRemap(input, output, coeffs);
+}
+
+TEST(TestAERemap, UpmixStereoTo51)
+{
+  static enum AEChannel input [] = { AE_CH_FL, AE_CH_FR, AE_CH_NULL };
+  static enum AEChannel output[] = { AE_CH_FL, AE_CH_FR, AE_CH_FC, AE_CH_LFE, AE_CH_BL, AE_CH_BR, AE_CH_NULL };
+  static const double coeffs[] =
+  {
+    1  , 0  ,
+    0  , 1  ,
+    0.5, 0.5,
+    0.5, 0.5,
+    1  , 0  ,
+    0  , 1
+  };
+
+  bool upmix = g_guiSettings.GetBool("audiooutput.stereoupmix");
+  g_guiSettings.SetBool("audiooutput.stereoupmix", true);
+  CheckRemap(input, output, coeffs);
+  g_guiSettings.SetBool("audiooutput.stereoupmix", upmix);
+}
+
+TEST(TestAERemap, Downmix51ToStereo)
+{
+  static enum AEChannel input [] = { AE_CH_FL, AE_CH_FR, AE_CH_FC, AE_CH_LFE, AE_CH_BL, AE_CH_BR, AE_CH_NULL };
+  static enum AEChannel output[] = { AE_CH_FL, AE_CH_FR, AE_CH_NULL };
+  const double s = 1.0 / (2.0 + 2.0 * k);
+  const double coeffs[] =
+  {
+    s, 0, k * s, k * s, s, 0,
+    0, s, k * s, k * s, 0, s
+  };
+  CheckRemap(input, output, coeffs);
+}
+
+TEST(TestAERemap, Downmix71To51)
+{
+  static enum AEChannel input [] = { AE_CH_FL, AE_CH_FR, AE_CH_FC, AE_CH_LFE, AE_CH_BL, AE_CH_BR, AE_CH_SL, AE_CH_SR, AE_CH_NULL };
+  static enum AEChannel output[] = { AE_CH_FL, AE_CH_FR, AE_CH_FC, AE_CH_LFE, AE_CH_BL, AE_CH_BR, AE_CH_NULL };
+  const double s = 1.0 / (1.0 + k);
+  const double coeffs[] =
+  {
+    s, 0, 0, 0, 0, 0, k * s, 0    ,
+    0, s, 0, 0, 0, 0, 0    , k * s,
+    0, 0, 1, 0, 0, 0, 0    , 0    ,
+    0, 0, 0, 1, 0, 0, 0    , 0    ,
+    0, 0, 0, 0, s, 0, k * s, 0    ,
+    0, 0, 0, 0, 0, s, 0    , k * s
+  };
+  CheckRemap(input, output, coeffs);
+}
+
+TEST(TestAERemap, Downmix71To50)
+{
+  static enum AEChannel input [] = { AE_CH_FL, AE_CH_FR, AE_CH_FC, AE_CH_LFE, AE_CH_BL, AE_CH_BR, AE_CH_SL, AE_CH_SR, AE_CH_NULL };
+  static enum AEChannel output[] = { AE_CH_FL, AE_CH_FR, AE_CH_FC, AE_CH_BL, AE_CH_BR, AE_CH_NULL };
+  const double s = 1.0 / (1.0 + 2.0 * k);
+  const double coeffs[] =
+  {
+    s, 0, 0, k * s, 0    , 0    , k * s, 0    ,
+    0, s, 0, k * s, 0    , 0    , 0    , k * s,
+    0, 0, 1, 0    , 0    , 0    , 0    , 0    ,
+    0, 0, 0, 0    , s    , 0    , k * s, 0    ,
+    0, 0, 0, 0    , 0    , s    , 0    , k * s
+  };
+  CheckRemap(input, output, coeffs);
+}
+
+TEST(TestAERemap, Benchmark)
+{
+  static enum AEChannel stereo  [] = { AE_CH_FL, AE_CH_FR, AE_CH_NULL };
+  static enum AEChannel surround[] = { AE_CH_FL, AE_CH_FR, AE_CH_FC, AE_CH_LFE, AE_CH_BL, AE_CH_BR, AE_CH_NULL };
+  static enum AEChannel full    [] = { AE_CH_FL, AE_CH_FR, AE_CH_FC, AE_CH_LFE, AE_CH_BL, AE_CH_BR, AE_CH_SL, AE_CH_SR, AE_CH_NULL };
+
+  static const struct
+  {
+    const char     *name;
+    enum AEChannel *input;
+    enum AEChannel *output;
+  } cases[] =
+  {
+    { "2.0 -> 5.1", stereo  , surround },
+    { "5.1 -> 2.0", surround, stereo   },
+    { "7.1 -> 5.1", full    , surround },
+    { "7.1 -> 2.0", full    , stereo   }
+  };
+
+  const unsigned int frames     = 4096;
+  const unsigned int iterations = 500;
+  std::vector<float> in(frames * 8, 0.5f), out(frames * 8);
+
+  for (unsigned int c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c)
+  {
+    CAERemap remap;
+    ASSERT_TRUE(remap.Initialize(CAEChannelInfo(cases[c].input), CAEChannelInfo(cases[c].output), false, true));
+
+    int64_t start = CurrentHostCounter();
+    for (unsigned int i = 0; i < iterations; ++i)
+      remap.Remap(&in[0], &out[0], frames);
+    const double time = (double)(CurrentHostCounter() - start) / CurrentHostFrequency();
+
+    std::cout << cases[c].name << ": "
+              << testing::PrintToString((double)frames * iterations / 1000000.0 / time)
+              << " Mframes/s" << std::endl;
+  }
+}
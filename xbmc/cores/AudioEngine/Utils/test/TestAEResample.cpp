@@ -0,0 +1,295 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Utils/AEResample.h"
+#include "utils/CPUInfo.h"
+#include "utils/TimeUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <samplerate.h>
+#include <math.h>
+#include <iostream>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static void MakeTones(std::vector<float> &samples, unsigned int frames, unsigned int channels, double rate, double baseFreq)
+{
+  samples.resize(frames * channels);
+  for (unsigned int i = 0; i < frames; ++i)
+    for (unsigned int c = 0; c < channels; ++c)
+      samples[i * channels + c] = 0.5f * (float)sin(2.0 * M_PI * (baseFreq + 250.0 * c) * i / rate);
+}
+
+static unsigned int ResampleAll(CAEResample &resample, const std::vector<float> &in, unsigned int channels, std::vector<float> &out, unsigned int chunk)
+{
+  const unsigned int frames = in.size() / channels;
+  out.resize((unsigned int)(frames * 4 + 1024) * channels);
+
+  unsigned int produced = 0, consumed = 0;
+  while (consumed < frames)
+  {
+    unsigned int used;
+    const unsigned int count = std::min(chunk, frames - consumed);
+    produced += resample.Resample(&in[consumed * channels], count, used, &out[produced * channels], out.size() / channels - produced);
+    consumed += used;
+  }
+  out.resize(produced * channels);
+  return produced;
+}
+
+/* the signal to noise ratio in dB of the output against the tones at the output rate */
+static double ToneSNR(const std::vector<float> &out, unsigned int channels, double rate, double baseFreq, unsigned int delay, unsigned int skip)
+{
+  double signal = 0.0, noise = 0.0;
+  const unsigned int frames = out.size() / channels;
+  for (unsigned int i = skip; i < frames - skip; ++i)
+    for (unsigned int c = 0; c < channels; ++c)
+    {
+      const double ideal = 0.5 * sin(2.0 * M_PI * (baseFreq + 250.0 * c) * ((double)i - delay) / rate);
+      const double error = out[i * channels + c] - ideal;
+      signal += ideal * ideal;
+      noise  += error * error;
+    }
+  return 10.0 * log10(signal / noise);
+}
+
+TEST(TestAEResample, Invalid)
+{
+  CAEResample resample;
+  EXPECT_FALSE(resample.Initialize(0, 1.0, CAEResample::QUALITY_MEDIUM));
+  EXPECT_FALSE(resample.Initialize(2, 0.0, CAEResample::QUALITY_MEDIUM));
+  EXPECT_FALSE(resample.SetRatio(1.0));
+
+  float in[2] = { 0.0f, 0.0f }, out[2];
+  unsigned int used;
+  EXPECT_EQ(0U, resample.Resample(in, 1, used, out, 1));
+  EXPECT_EQ(0U, used);
+}
+
+TEST(TestAEResample, SNR)
+{
+  static const CAEResample::Quality qualities[] = { CAEResample::QUALITY_FAST, CAEResample::QUALITY_MEDIUM, CAEResample::QUALITY_HIGH };
+  static const double ratios[][2] = { { 44100.0, 48000.0 }, { 48000.0, 44100.0 }, { 48000.0, 96000.0 }, { 96000.0, 48000.0 } };
+
+  for (unsigned int q = 0; q < sizeof(qualities) / sizeof(qualities[0]); ++q)
+    for (unsigned int r = 0; r < sizeof(ratios) / sizeof(ratios[0]); ++r)
+    {
+      const double inRate = ratios[r][0], outRate = ratios[r][1];
+      std::vector<float> in, out;
+      MakeTones(in, 16384, 6, inRate, 1000.0);
+
+      CAEResample resample;
+      ASSERT_TRUE(resample.Initialize(6, outRate / inRate, qualities[q]));
+      ResampleAll(resample, in, 6, out, 1000);
+
+      /* the output starts lined up with the input, the filter only adds its delay at the end */
+      const double snr = ToneSNR(out, 6, outRate, 1000.0, 0, 1024);
+      EXPECT_GT(snr, 95.0) << "quality " << qualities[q] << " " << inRate << " -> " << outRate;
+    }
+}
+
+TEST(TestAEResample, Stopband)
+{
+  /* a tone above the output nyquist frequency must not alias back */
+  std::vector<float> in, out;
+  MakeTones(in, 16384, 1, 48000.0, 23000.0);
+
+  CAEResample resample;
+  ASSERT_TRUE(resample.Initialize(1, 44100.0 / 48000.0, CAEResample::QUALITY_MEDIUM));
+  unsigned int frames = ResampleAll(resample, in, 1, out, 512);
+
+  double energy = 0.0;
+  for (unsigned int i = 1024; i < frames - 1024; ++i)
+    energy += out[i] * out[i];
+  const double level = 10.0 * log10(energy / (frames - 2048) / 0.125);
+  EXPECT_LT(level, -80.0);
+}
+
+TEST(TestAEResample, Chunking)
+{
+  /* the output must not depend on how the input is split */
+  std::vector<float> in, whole, split;
+  MakeTones(in, 8192, 8, 44100.0, 440.0);
+
+  CAEResample resample;
+  ASSERT_TRUE(resample.Initialize(8, 48000.0 / 44100.0, CAEResample::QUALITY_MEDIUM));
+  ResampleAll(resample, in, 8, whole, 8192);
+  resample.Reset();
+  ResampleAll(resample, in, 8, split, 37);
+
+  ASSERT_EQ(whole.size(), split.size());
+  for (unsigned int i = 0; i < whole.size(); ++i)
+    ASSERT_EQ(whole[i], split[i]) << "sample " << i;
+}
+
+TEST(TestAEResample, Kernels)
+{
+  std::vector<float> in, ref, out;
+  MakeTones(in, 8192, 7, 44100.0, 440.0);
+
+  CAEResample resample;
+  ASSERT_TRUE(resample.Initialize(7, 48000.0 / 44100.0, CAEResample::QUALITY_MEDIUM, 0));
+  ResampleAll(resample, in, 7, ref, 1024);
+
+  static const unsigned int features[] = { CPU_FEATURE_SSE2, CPU_FEATURE_SSE2 | CPU_FEATURE_AVX | CPU_FEATURE_AVX2 };
+  for (unsigned int f = 0; f < sizeof(features) / sizeof(features[0]); ++f)
+  {
+    if ((g_cpuInfo.GetCPUFeatures() & features[f]) != features[f])
+      continue;
+
+    ASSERT_TRUE(resample.Initialize(7, 48000.0 / 44100.0, CAEResample::QUALITY_MEDIUM, features[f]));
+    ResampleAll(resample, in, 7, out, 1024);
+    ASSERT_EQ(ref.size(), out.size());
+    for (unsigned int i = 0; i < ref.size(); ++i)
+      ASSERT_NEAR(ref[i], out[i], 1e-5f) << "features " << features[f] << " sample " << i;
+  }
+}
+
+TEST(TestAEResample, VariableRatio)
+{
+  std::vector<float> in, out;
+  MakeTones(in, 48000, 2, 48000.0, 1000.0);
+
+  CAEResample resample;
+  ASSERT_TRUE(resample.Initialize(2, 1.0, CAEResample::QUALITY_MEDIUM));
+
+  /* speed up by half a percent half way through, as the video clock sync would */
+  std::vector<float> first (in.begin(), in.begin() + in.size() / 2);
+  std::vector<float> second(in.begin() + in.size() / 2, in.end());
+  std::vector<float> out1, out2;
+  const unsigned int frames1 = ResampleAll(resample, first, 2, out1, 1024);
+  EXPECT_TRUE(resample.SetRatio(1.005));
+  EXPECT_DOUBLE_EQ(1.005, resample.GetRatio());
+  const unsigned int frames2 = ResampleAll(resample, second, 2, out2, 1024);
+
+  /* the last frames stay in the filter history */
+  EXPECT_NEAR(24000.0 + 24000.0 * 1.005 - resample.GetDelay(), frames1 + frames2, 4.0);
+
+  /* the change is ramped, the waveform must stay smooth across it */
+  out = out1;
+  out.insert(out.end(), out2.begin(), out2.end());
+  const float maxStep = 0.5f * 2.0f * (float)M_PI * 1250.0f / 48000.0f * 1.01f;
+  for (unsigned int i = 256; i < out.size() / 2; ++i)
+    for (unsigned int c = 0; c < 2; ++c)
+      ASSERT_LE(fabs(out[i * 2 + c] - out[(i - 1) * 2 + c]), maxStep) << "frame " << i;
+}
+
+TEST(TestAEResample, FilterLengthChange)
+{
+  std::vector<float> in, out;
+  MakeTones(in, 48000, 2, 48000.0, 1000.0);
+
+  CAEResample resample;
+  ASSERT_TRUE(resample.Initialize(2, 1.0, CAEResample::QUALITY_MEDIUM));
+
+  /* halving the ratio doubles the filter length, the history must carry over */
+  std::vector<float> first (in.begin(), in.begin() + in.size() / 2);
+  std::vector<float> second(in.begin() + in.size() / 2, in.end());
+  std::vector<float> out1, out2;
+  const unsigned int delay1  = resample.GetDelay();
+  const unsigned int frames1 = ResampleAll(resample, first, 2, out1, 1024);
+  EXPECT_TRUE(resample.SetRatio(0.5));
+  EXPECT_GT(resample.GetDelay(), delay1);
+  const unsigned int frames2 = ResampleAll(resample, second, 2, out2, 1024);
+
+  /* the buffered input is resampled at the new ratio, the ramp only adds frames */
+  EXPECT_EQ(24000U - delay1, frames1);
+  EXPECT_GE(frames2, (24000U + delay1 - resample.GetDelay()) / 2);
+
+  out = out1;
+  out.insert(out.end(), out2.begin(), out2.end());
+  const float maxStep = 0.5f * 2.0f * (float)M_PI * 1250.0f / 24000.0f * 1.01f;
+  for (unsigned int i = 256; i < out.size() / 2; ++i)
+    for (unsigned int c = 0; c < 2; ++c)
+      ASSERT_LE(fabs(out[i * 2 + c] - out[(i - 1) * 2 + c]), maxStep) << "frame " << i;
+}
+
+static double BenchmarkAE(CAEResample::Quality quality, const std::vector<float> &in, unsigned int channels, double ratio, std::vector<float> &out)
+{
+  CAEResample resample;
+  resample.Initialize(channels, ratio, quality);
+
+  const unsigned int frames = in.size() / channels;
+  const unsigned int period = 1024;
+  int64_t start = CurrentHostCounter();
+  for (unsigned int pos = 0; pos + period <= frames; pos += period)
+  {
+    unsigned int used;
+    resample.Resample(&in[pos * channels], period, used, &out[0], out.size() / channels);
+    /* sync to display nudges the ratio every period */
+    resample.SetRatio(ratio * (1.0 + 0.001 * ((pos / period) & 1)));
+  }
+  return (double)(CurrentHostCounter() - start) * 1e9 / CurrentHostFrequency() / frames;
+}
+
+static double BenchmarkSRC(int converter, const std::vector<float> &in, unsigned int channels, double ratio, std::vector<float> &out)
+{
+  int error;
+  SRC_STATE *state = src_new(converter, channels, &error);
+  if (!state)
+    return 0.0;
+
+  const unsigned int frames = in.size() / channels;
+  const unsigned int period = 1024;
+  SRC_DATA data;
+  data.end_of_input = 0;
+  int64_t start = CurrentHostCounter();
+  for (unsigned int pos = 0; pos + period <= frames; pos += period)
+  {
+    data.data_in       = (float*)&in[pos * channels];
+    data.input_frames  = period;
+    data.data_out      = &out[0];
+    data.output_frames = out.size() / channels;
+    data.src_ratio     = ratio * (1.0 + 0.001 * ((pos / period) & 1));
+    src_set_ratio(state, data.src_ratio);
+    src_process(state, &data);
+  }
+  double ns = (double)(CurrentHostCounter() - start) * 1e9 / CurrentHostFrequency() / frames;
+  src_delete(state);
+  return ns;
+}
+
+TEST(TestAEResample, Benchmark)
+{
+  /* 8 channels 44.1kHz to 48kHz, the costly case of a 7.1 movie track */
+  const unsigned int channels = 8;
+  const double ratio = 48000.0 / 44100.0;
+  std::vector<float> in, out(4096 * channels);
+  MakeTones(in, 44100 * 4, channels, 44100.0, 440.0);
+
+  static const struct { CAEResample::Quality quality; int converter; const char *name; } cases[] =
+  {
+    { CAEResample::QUALITY_FAST  , SRC_SINC_FASTEST       , "fast"   },
+    { CAEResample::QUALITY_MEDIUM, SRC_SINC_MEDIUM_QUALITY, "medium" },
+    { CAEResample::QUALITY_HIGH  , SRC_SINC_BEST_QUALITY  , "high"   }
+  };
+
+  for (unsigned int i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i)
+  {
+    const double ae  = BenchmarkAE (cases[i].quality  , in, channels, ratio, out);
+    const double src = BenchmarkSRC(cases[i].converter, in, channels, ratio, out);
+    std::cout << "CAEResample " << cases[i].name << ": " << testing::PrintToString(ae ) << " ns/frame" << std::endl;
+    std::cout << "libsamplerate " << cases[i].name << ": " << testing::PrintToString(src) << " ns/frame" << std::endl;
+  }
+}
@@ -0,0 +1,160 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Utils/AESPSCQueue.h"
+#include "threads/Thread.h"
+
+#include "gtest/gtest.h"
+
+#define TESTNUM 200000
+
+struct TestItem
+{
+  unsigned int sequence;
+  unsigned int check;
+};
+
+TEST(TestAESPSCQueue, Alloc)
+{
+  CAESPSCQueue<TestItem> queue;
+  EXPECT_EQ(0U, queue.Size());
+  EXPECT_TRUE(queue.GetWriteSlot() == NULL);
+  EXPECT_TRUE(queue.GetReadSlot () == NULL);
+
+  /* sizes are rounded up to a power of two */
+  queue.Alloc(5);
+  EXPECT_EQ(8U, queue.Size());
+  EXPECT_EQ(8U, queue.Free());
+  EXPECT_TRUE(queue.Empty());
+}
+
+TEST(TestAESPSCQueue, PushPop)
+{
+  CAESPSCQueue<TestItem> queue;
+  queue.Alloc(4);
+
+  for (unsigned int i = 0; i < 4; ++i)
+  {
+    TestItem *item = queue.GetWriteSlot();
+    ASSERT_TRUE(item != NULL);
+    item->sequence = i;
+    queue.Push();
+  }
+
+  /* full */
+  EXPECT_TRUE(queue.GetWriteSlot() == NULL);
+  EXPECT_EQ(4U, queue.Used());
+
+  /* reading does not free the item until it is popped */
+  TestItem *item = queue.GetReadSlot();
+  ASSERT_TRUE(item != NULL);
+  EXPECT_EQ(0U, item->sequence);
+  EXPECT_TRUE(queue.GetWriteSlot() == NULL);
+
+  queue.Pop();
+  EXPECT_TRUE(queue.GetWriteSlot() != NULL);
+
+  for (unsigned int i = 1; i < 4; ++i)
+  {
+    item = queue.GetReadSlot();
+    ASSERT_TRUE(item != NULL);
+    EXPECT_EQ(i, item->sequence);
+    queue.Pop();
+  }
+
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_TRUE(queue.GetReadSlot() == NULL);
+}
+
+TEST(TestAESPSCQueue, Drop)
+{
+  CAESPSCQueue<TestItem> queue;
+  queue.Alloc(8);
+
+  for (unsigned int i = 0; i < 6; ++i)
+  {
+    queue.GetWriteSlot()->sequence = i;
+    queue.Push();
+  }
+
+  queue.Drop(1);
+  EXPECT_EQ(1U, queue.Used());
+  EXPECT_EQ(0U, queue.GetReadSlot()->sequence);
+
+  /* keeping more than is queued changes nothing */
+  queue.Drop(4);
+  EXPECT_EQ(1U, queue.Used());
+
+  queue.Drop(0);
+  EXPECT_TRUE(queue.Empty());
+}
+
+class SPSCProducer : public IRunnable
+{
+  CAESPSCQueue<TestItem> &m_queue;
+public:
+  unsigned int stalls;
+
+  SPSCProducer(CAESPSCQueue<TestItem> &queue) : m_queue(queue), stalls(0) {}
+
+  virtual void Run()
+  {
+    for (unsigned int i = 0; i < TESTNUM; ++i)
+    {
+      TestItem *item;
+      while ((item = m_queue.GetWriteSlot()) == NULL)
+      {
+        ++stalls;
+        XbmcThreads::ThreadSleep(0);
+      }
+
+      item->sequence = i;
+      item->check    = ~i;
+      m_queue.Push();
+    }
+  }
+};
+
+TEST(TestAESPSCQueue, Threaded)
+{
+  CAESPSCQueue<TestItem> queue;
+  queue.Alloc(16);
+
+  SPSCProducer producer(queue);
+  CThread thread(&producer, "SPSCProducer");
+  thread.Create();
+
+  /* every item must arrive once, in order and complete */
+  unsigned int errors = 0;
+  for (unsigned int i = 0; i < TESTNUM; ++i)
+  {
+    TestItem *item;
+    while ((item = queue.GetReadSlot()) == NULL)
+      XbmcThreads::ThreadSleep(0);
+
+    if (item->sequence != i || item->check != ~i)
+      ++errors;
+    queue.Pop();
+  }
+
+  EXPECT_TRUE(thread.WaitForThreadExit(10000));
+  EXPECT_EQ(0U, errors);
+  EXPECT_TRUE(queue.Empty());
+}
@@ -0,0 +1,148 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Utils/AESoundCache.h"
+#include "filesystem/File.h"
+#include "test/TestUtils.h"
+#include "utils/EndianSwap.h"
+
+#include <string.h>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#define TEST_RATE   44100
+#define TEST_FRAMES 4410
+
+/* writes a 16 bit mono ramp as a WAV file, dataSize can claim more data than is written */
+static XFILE::CFile *CreateSound(uint32_t dataSize = TEST_FRAMES * 2)
+{
+  std::vector<int16_t> samples(TEST_FRAMES);
+  for (unsigned int i = 0; i < TEST_FRAMES; ++i)
+    samples[i] = Endian_SwapLE16((int16_t)(i * 4));
+
+  XFILE::CFile *file = XBMC_CREATETEMPFILE(".wav");
+  if (!file)
+    return NULL;
+  file->Close();
+  if (!file->OpenForWrite(XBMC_TEMPFILEPATH(file), true))
+    return file;
+
+  uint8_t header[44];
+  memcpy(header     , "RIFF", 4);
+  *(uint32_t*)(header +  4) = Endian_SwapLE32(36 + TEST_FRAMES * 2);
+  memcpy(header +  8, "WAVEfmt ", 8);
+  *(uint32_t*)(header + 16) = Endian_SwapLE32(16);
+  *(uint16_t*)(header + 20) = Endian_SwapLE16(1);             /* PCM */
+  *(uint16_t*)(header + 22) = Endian_SwapLE16(1);             /* channels */
+  *(uint32_t*)(header + 24) = Endian_SwapLE32(TEST_RATE);
+  *(uint32_t*)(header + 28) = Endian_SwapLE32(TEST_RATE * 2); /* byte rate */
+  *(uint16_t*)(header + 32) = Endian_SwapLE16(2);             /* block align */
+  *(uint16_t*)(header + 34) = Endian_SwapLE16(16);            /* bits per sample */
+  memcpy(header + 36, "data", 4);
+  *(uint32_t*)(header + 40) = Endian_SwapLE32(dataSize);
+
+  file->Write(header, sizeof(header));
+  file->Write(&samples[0], TEST_FRAMES * 2);
+  file->Close();
+  return file;
+}
+
+TEST(TestAESoundCache, Load)
+{
+  XFILE::CFile *file = CreateSound();
+  ASSERT_TRUE(file);
+  CAESoundCache &cache = CAESoundCache::GetInstance();
+
+  /* mono is remapped to the output layout */
+  CAEChannelInfo stereo(AE_CH_LAYOUT_2_0);
+  CAESoundBuffer *buffer = cache.Acquire(XBMC_TEMPFILEPATH(file), TEST_RATE, stereo);
+  ASSERT_TRUE(buffer);
+  EXPECT_TRUE(buffer->IsCompatible(TEST_RATE, stereo));
+  EXPECT_FALSE(buffer->IsCompatible(48000, stereo));
+  EXPECT_EQ((unsigned int)TEST_FRAMES * 2, buffer->GetSampleCount());
+
+  float *samples = buffer->GetSamples();
+  ASSERT_TRUE(samples);
+  EXPECT_FLOAT_EQ(samples[200], samples[201]);
+  EXPECT_LT(samples[200], samples[202]);
+  EXPECT_LE(TEST_FRAMES * 2 * sizeof(float), cache.GetMemoryUsage());
+
+  cache.Release(buffer);
+  cache.Clear();
+  EXPECT_EQ(0U, cache.GetCount());
+  EXPECT_EQ(0U, cache.GetMemoryUsage());
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(file));
+}
+
+TEST(TestAESoundCache, Shared)
+{
+  XFILE::CFile *file = CreateSound();
+  ASSERT_TRUE(file);
+  CAESoundCache &cache = CAESoundCache::GetInstance();
+  CAEChannelInfo stereo(AE_CH_LAYOUT_2_0);
+
+  /* sounds of the same file and format share the samples */
+  CAESoundBuffer *a = cache.Acquire(XBMC_TEMPFILEPATH(file), TEST_RATE, stereo);
+  CAESoundBuffer *b = cache.Acquire(XBMC_TEMPFILEPATH(file), TEST_RATE, stereo);
+  ASSERT_TRUE(a);
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(1U, cache.GetCount());
+
+  /* and they are kept for the next sound once released */
+  size_t size = cache.GetMemoryUsage();
+  cache.Release(a);
+  cache.Release(b);
+  EXPECT_EQ(1U, cache.GetCount());
+  EXPECT_EQ(size, cache.GetMemoryUsage());
+  EXPECT_EQ(a, cache.Acquire(XBMC_TEMPFILEPATH(file), TEST_RATE, stereo));
+
+  /* another format is converted separately */
+  CAESoundBuffer *resampled = cache.Acquire(XBMC_TEMPFILEPATH(file), 48000, stereo);
+  ASSERT_TRUE(resampled);
+  EXPECT_NE(a, resampled);
+  EXPECT_EQ(2U, cache.GetCount());
+  EXPECT_NEAR(TEST_FRAMES * 2 * 48000.0 / TEST_RATE, (double)resampled->GetSampleCount(), 16.0);
+
+  /* referenced buffers survive a clear */
+  cache.Release(resampled);
+  cache.Clear();
+  EXPECT_EQ(1U, cache.GetCount());
+
+  cache.Release(a);
+  cache.Clear();
+  EXPECT_EQ(0U, cache.GetCount());
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(file));
+}
+
+TEST(TestAESoundCache, Invalid)
+{
+  CAESoundCache &cache = CAESoundCache::GetInstance();
+  CAEChannelInfo stereo(AE_CH_LAYOUT_2_0);
+
+  EXPECT_FALSE(cache.Acquire("special://temp/does-not-exist.wav", TEST_RATE, stereo));
+
+  /* a data chunk that claims more than the file holds */
+  XFILE::CFile *file = CreateSound(TEST_FRAMES * 4);
+  ASSERT_TRUE(file);
+  EXPECT_FALSE(cache.Acquire(XBMC_TEMPFILEPATH(file), TEST_RATE, stereo));
+  EXPECT_EQ(0U, cache.GetCount());
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(file));
+}
@@ -0,0 +1,153 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "cores/AudioEngine/Utils/AEUtil.h"
+#include "utils/CPUInfo.h"
+#include "utils/TimeUtils.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+struct SIMDVariant
+{
+  const char   *name;
+  unsigned int  features;
+};
+
+static const SIMDVariant variants[] =
+{
+  { "SSE2", CPU_FEATURE_SSE2                    },
+  { "AVX2", CPU_FEATURE_SSE2 | CPU_FEATURE_AVX2 }
+};
+
+/* odd sizes exercise the scalar tails, the sources end inside and outside the vector blocks */
+static const unsigned int sizes[] = { 1, 3, 7, 8, 15, 17, 33, 4099 };
+
+static bool HasVariant(const SIMDVariant &variant)
+{
+  return (g_cpuInfo.GetCPUFeatures() & variant.features) == variant.features;
+}
+
+static void FillRandom(std::vector<float> &data, float range)
+{
+  for (unsigned int i = 0; i < data.size(); ++i)
+    data[i] = ((float)rand() / RAND_MAX) * 2.0f * range - range;
+}
+
+TEST(TestAEUtil, MixVolumeBitExact)
+{
+  CAEUtil::AEMixVolumeFn ref = CAEUtil::MixVolume(0);
+
+  for (unsigned int v = 0; v < sizeof(variants) / sizeof(variants[0]); ++v)
+  {
+    if (!HasVariant(variants[v]))
+      continue;
+
+    CAEUtil::AEMixVolumeFn fn = CAEUtil::MixVolume(variants[v].features);
+    for (unsigned int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+      const unsigned int count = sizes[s];
+      std::vector<float> in(count), sound1(count), sound2(count);
+      FillRandom(in    , 1.0f);
+      FillRandom(sound1, 0.5f);
+      FillRandom(sound2, 0.5f);
+
+      /* one sound covering the buffer and one ending part way through it */
+      AEMixSource sources[2] = {
+        { &sound1[0], 0.7f, count         },
+        { &sound2[0], 0.3f, count * 2 / 3 }
+      };
+
+      for (unsigned int n = 0; n <= 2; ++n)
+      {
+        std::vector<float> expected(in), actual(in);
+        const bool expectedClip = ref(&expected[0], count, sources, n, 0.8f);
+        const bool actualClip   = fn (&actual  [0], count, sources, n, 0.8f);
+        EXPECT_EQ(expectedClip, actualClip) << variants[v].name << " count " << count << " sources " << n;
+        EXPECT_EQ(0, memcmp(&expected[0], &actual[0], count * sizeof(float)))
+          << variants[v].name << " count " << count << " sources " << n;
+      }
+    }
+  }
+}
+
+TEST(TestAEUtil, MixVolumeClip)
+{
+  for (int v = -1; v < (int)(sizeof(variants) / sizeof(variants[0])); ++v)
+  {
+    if (v >= 0 && !HasVariant(variants[v]))
+      continue;
+
+    CAEUtil::AEMixVolumeFn fn = CAEUtil::MixVolume(v < 0 ? 0 : variants[v].features);
+    for (unsigned int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+      const unsigned int count = sizes[s];
+      std::vector<float> data(count, 0.5f);
+      EXPECT_FALSE(fn(&data[0], count, NULL, 0, 1.0f));
+
+      /* full scale is not clipping */
+      data[count - 1] = -1.0f;
+      EXPECT_FALSE(fn(&data[0], count, NULL, 0, 1.0f));
+
+      /* the last sample clips, until the volume brings it back in range */
+      data[count - 1] = 1.5f;
+      EXPECT_TRUE (fn(&data[0], count, NULL, 0, 1.0f));
+      EXPECT_FALSE(fn(&data[0], count, NULL, 0, 0.5f));
+      EXPECT_FLOAT_EQ(0.75f, data[count - 1]);
+
+      /* clipping caused by the mixed in source */
+      std::vector<float> sound(count, 0.5f);
+      AEMixSource source = { &sound[0], 1.0f, count };
+      EXPECT_TRUE(fn(&data[0], count, &source, 1, 1.0f));
+      EXPECT_FLOAT_EQ(1.25f, data[count - 1]);
+    }
+  }
+}
+
+TEST(TestAEUtil, Benchmark)
+{
+  const unsigned int count      = 8 * 1024;
+  const unsigned int iterations = 2000;
+  std::vector<float> data(count), sound(count);
+  FillRandom(sound, 0.5f);
+  AEMixSource source = { &sound[0], 0.5f, count };
+
+  for (int v = -1; v < (int)(sizeof(variants) / sizeof(variants[0])); ++v)
+  {
+    if (v >= 0 && !HasVariant(variants[v]))
+      continue;
+
+    CAEUtil::AEMixVolumeFn fn = CAEUtil::MixVolume(v < 0 ? 0 : variants[v].features);
+    FillRandom(data, 0.5f);
+
+    int64_t start = CurrentHostCounter();
+    for (unsigned int i = 0; i < iterations; ++i)
+      fn(&data[0], count, &source, 1, 0.5f);
+    const double time = (double)(CurrentHostCounter() - start) / CurrentHostFrequency();
+
+    std::cout << (v < 0 ? "scalar" : variants[v].name) << " MixVolume: "
+              << testing::PrintToString((double)count * iterations / 1000000.0 / time)
+              << " Msamples/s" << std::endl;
+  }
+}
@@ -113,6 +113,33 @@ struct SPlayerVideoStreamInfo
   }
 };
 
+struct SPlayerStagePerformance
+{
+  std::string name;
+  float    busy;        // % of a cpu the thread of the stage used, -1 if it has none of its own
+  int      queueLevel;  // % of the input queue of the stage filled, -1 if it has none
+  float    decodeP50;   // ms
+  float    decodeP90;
+  float    decodeP99;
+  float    decodeMax;
+  uint64_t frames;
+  uint64_t dropped;
+  uint64_t late;
+
+  SPlayerStagePerformance()
+  {
+    busy = -1.0f;
+    queueLevel = -1;
+    decodeP50 = decodeP90 = decodeP99 = decodeMax = 0.0f;
+    frames = dropped = late = 0;
+  }
+};
+
+struct SPlayerPerformanceInfo
+{
+  std::vector<SPlayerStagePerformance> stages;
+};
+
 class IPlayer
 {
 public:
@@ -188,6 +215,10 @@ public:
    */
   virtual int64_t GetTotalTime() { return 0; }
   virtual void GetVideoStreamInfo(SPlayerVideoStreamInfo &info){};
+  /*!
+   \brief decode times, thread load and frame counts of each stage of playback, false if the player has none
+   */
+  virtual bool GetPerformanceInfo(SPlayerPerformanceInfo &info) { return false; }
   virtual int GetSourceBitrate(){ return 0;}
   virtual int GetBitsPerSample(){ return 0;};
   virtual int GetSampleRate(){ return 0;};
@@ -0,0 +1,245 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDBenchmark.h"
+#include "settings/AdvancedSettings.h"
+#include "cores/AudioEngine/Utils/AEUtil.h"
+#include "utils/log.h"
+#include "utils/StringUtils.h"
+#include "utils/TimeUtils.h"
+
+#include "DVDClock.h"
+#include "DVDStreamInfo.h"
+#include "DVDInputStreams/DVDInputStream.h"
+#include "DVDInputStreams/DVDFactoryInputStream.h"
+#include "DVDDemuxers/DVDDemux.h"
+#include "DVDDemuxers/DVDDemuxUtils.h"
+#include "DVDDemuxers/DVDDemuxPacketPool.h"
+#include "DVDDemuxers/DVDFactoryDemuxer.h"
+#include "DVDCodecs/DVDCodecs.h"
+#include "DVDCodecs/DVDFactoryCodec.h"
+#include "DVDCodecs/Audio/DVDAudioCodec.h"
+#include "DVDCodecs/Video/DVDVideoCodec.h"
+
+#include <memory>
+#include <string.h>
+
+static double ElapsedSeconds(int64_t start)
+{
+  return (double)(CurrentHostCounter() - start) / CurrentHostFrequency();
+}
+
+std::vector<CDVDBenchmark::Variant> CDVDBenchmark::GetDefaultVariants()
+{
+  static const Variant variants[] =
+  {
+    { "default",  -1, 0, 0,           true, true },
+    { "slice",     2, 0, 0,           true, true },
+    { "frame",     1, 0, 0,           true, true },
+    { "read32k",  -1, 0, 32 * 1024,   true, true },
+    { "read1m",   -1, 0, 1024 * 1024, true, true },
+  };
+  return std::vector<Variant>(variants, variants + sizeof(variants) / sizeof(variants[0]));
+}
+
+bool CDVDBenchmark::Run(const std::string& path, const Variant& variant, Result& result)
+{
+  result.variant      = variant.name;
+  result.openTime     = 0.0;
+  result.demuxTime    = 0.0;
+  result.videoTime    = 0.0;
+  result.audioTime    = 0.0;
+  result.totalTime    = 0.0;
+  result.packets      = 0;
+  result.bytes        = 0;
+  result.bytesCopied  = 0;
+  result.videoFrames  = 0;
+  result.audioSamples = 0;
+  result.errors       = 0;
+
+  // the codecs and the demuxer pick these up when they are opened
+  std::vector<VideoCodecThreading> threading = g_advancedSettings.m_videoCodecThreading;
+  int demuxBufferSize = g_advancedSettings.m_videoDemuxBufferSize;
+
+  if (variant.threadType >= 0)
+  {
+    VideoCodecThreading policy;
+    policy.codec   = "*";
+    policy.type    = variant.threadType;
+    policy.threads = variant.threads;
+    policy.latency = 0.0f;
+    g_advancedSettings.m_videoCodecThreading.clear();
+    g_advancedSettings.m_videoCodecThreading.push_back(policy);
+  }
+  if (variant.ioBufferSize > 0)
+    g_advancedSettings.m_videoDemuxBufferSize = variant.ioBufferSize;
+
+  CDVDDemuxPacketPool::Stats before, after;
+  CDVDDemuxPacketPool::GetInstance().GetStats(before);
+
+  int64_t start = CurrentHostCounter();
+  bool ok = Decode(path, variant, result);
+  result.totalTime = ElapsedSeconds(start);
+
+  CDVDDemuxPacketPool::GetInstance().GetStats(after);
+  result.bytesCopied = after.bytesCopied - before.bytesCopied;
+
+  g_advancedSettings.m_videoCodecThreading  = threading;
+  g_advancedSettings.m_videoDemuxBufferSize = demuxBufferSize;
+  return ok;
+}
+
+bool CDVDBenchmark::Decode(const std::string& path, const Variant& variant, Result& result)
+{
+  int64_t start = CurrentHostCounter();
+
+  std::auto_ptr<CDVDInputStream> input(CDVDFactoryInputStream::CreateInputStream(NULL, path, ""));
+  if (!input.get() || !input->Open(path.c_str(), ""))
+  {
+    CLog::Log(LOGERROR, "CDVDBenchmark::Decode - unable to open %s", path.c_str());
+    return false;
+  }
+
+  std::auto_ptr<CDVDDemux> demux(CDVDFactoryDemuxer::CreateDemuxer(input.get()));
+  if (!demux.get())
+  {
+    CLog::Log(LOGERROR, "CDVDBenchmark::Decode - unable to demux %s", path.c_str());
+    return false;
+  }
+
+  int streams = demux->GetNrOfStreams();
+  std::vector<CDVDVideoCodec*> videoCodecs(streams, (CDVDVideoCodec*)NULL);
+  std::vector<CDVDAudioCodec*> audioCodecs(streams, (CDVDAudioCodec*)NULL);
+  bool decoding = false;
+
+  for (int i = 0; i < streams; i++)
+  {
+    CDemuxStream* pStream = demux->GetStream(i);
+    if (!pStream)
+      continue;
+
+    CDVDStreamInfo hint(*pStream, true);
+    if (pStream->type == STREAM_VIDEO && variant.video)
+      videoCodecs[i] = CDVDFactoryCodec::CreateVideoCodec(hint);
+    else if (pStream->type == STREAM_AUDIO && variant.audio)
+      audioCodecs[i] = CDVDFactoryCodec::CreateAudioCodec(hint, false);
+
+    if (videoCodecs[i] || audioCodecs[i])
+      decoding = true;
+    else
+      pStream->SetDiscard(AVDISCARD_ALL);
+  }
+  result.openTime = ElapsedSeconds(start);
+
+  if (!decoding)
+    CLog::Log(LOGWARNING, "CDVDBenchmark::Decode - nothing to decode in %s", path.c_str());
+
+  DVDVideoPicture picture;
+  while (decoding)
+  {
+    start = CurrentHostCounter();
+    DemuxPacket* pPacket = demux->Read();
+    result.demuxTime += ElapsedSeconds(start);
+
+    if (!pPacket)
+      break;
+
+    result.packets++;
+    result.bytes += pPacket->iSize;
+
+    int id = pPacket->iStreamId;
+    if (id >= 0 && id < streams && videoCodecs[id])
+    {
+      CDVDVideoCodec* pCodec = videoCodecs[id];
+      start = CurrentHostCounter();
+
+      int iDecoderState = pCodec->Decode(pPacket->pData, pPacket->iSize, pPacket->dts, pPacket->pts);
+      while (!(iDecoderState & VC_ERROR) && (iDecoderState & VC_PICTURE))
+      {
+        memset(&picture, 0, sizeof(picture));
+        if (pCodec->GetPicture(&picture) && !(picture.iFlags & DVP_FLAG_DROPPED))
+          result.videoFrames++;
+        pCodec->ClearPicture(&picture);
+
+        // the decoder wants the next packet before it has more
+        if (iDecoderState & VC_BUFFER)
+          break;
+        iDecoderState = pCodec->Decode(NULL, 0, DVD_NOPTS_VALUE, DVD_NOPTS_VALUE);
+      }
+      if (iDecoderState & VC_ERROR)
+        result.errors++;
+
+      result.videoTime += ElapsedSeconds(start);
+    }
+    else if (id >= 0 && id < streams && audioCodecs[id])
+    {
+      CDVDAudioCodec* pCodec = audioCodecs[id];
+      start = CurrentHostCounter();
+
+      BYTE* pData = pPacket->pData;
+      int   iSize = pPacket->iSize;
+      while (iSize > 0)
+      {
+        int len = pCodec->Decode(pData, iSize);
+        if (len < 0 || len > iSize)
+        {
+          result.errors++;
+          break;
+        }
+        pData += len;
+        iSize -= len;
+
+        BYTE* pOut;
+        int   iOut  = pCodec->GetData(&pOut);
+        int   frame = pCodec->GetChannels() * (CAEUtil::DataFormatToBits(pCodec->GetDataFormat()) >> 3);
+        if (iOut > 0 && frame > 0)
+          result.audioSamples += iOut / frame;
+        if (len == 0)
+          break;
+      }
+
+      result.audioTime += ElapsedSeconds(start);
+    }
+
+    CDVDDemuxUtils::FreeDemuxPacket(pPacket);
+  }
+
+  for (int i = 0; i < streams; i++)
+  {
+    delete videoCodecs[i];
+    delete audioCodecs[i];
+  }
+  return decoding;
+}
+
+std::string CDVDBenchmark::Format(const Result& result)
+{
+  double time = result.totalTime > 0.0 ? result.totalTime : 1.0;
+  return StringUtils::Format("%s: %.1f fps, %.0f packets/s, %.0f samples/s, %.1f MB demuxed, %.1f MB copied, "
+                             "open %.3fs, demux %.3fs, video %.3fs, audio %.3fs, total %.3fs, %u errors",
+                             result.variant.c_str(),
+                             result.videoFrames / time,
+                             result.packets / time,
+                             result.audioSamples / time,
+                             result.bytes / (1024.0 * 1024.0),
+                             result.bytesCopied / (1024.0 * 1024.0),
+                             result.openTime, result.demuxTime, result.videoTime, result.audioTime,
+                             result.totalTime, result.errors);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * Demuxes a file and decodes all of its audio and video as fast as it can,
+ * without a clock or a renderer, to measure how much the player could do.
+ * Each run can change the decoder threading and the demuxer buffer size.
+ */
+class CDVDBenchmark
+{
+public:
+  typedef struct
+  {
+    std::string name;
+    int         threadType;    // as VideoCodecThreading::type, -1 keeps the settings
+    int         threads;       // 0 for one per cpu
+    int         ioBufferSize;  // bytes the demuxer reads at once, 0 keeps the settings
+    bool        audio;
+    bool        video;
+  } Variant;
+
+  typedef struct
+  {
+    std::string variant;
+    double      openTime;      // seconds opening the input and demuxer, and the codecs
+    double      demuxTime;     // seconds in CDVDDemux::Read
+    double      videoTime;     // seconds decoding video
+    double      audioTime;     // seconds decoding audio
+    double      totalTime;
+    uint64_t    packets;
+    uint64_t    bytes;         // demuxed
+    uint64_t    bytesCopied;   // into demux packets
+    uint64_t    videoFrames;
+    uint64_t    audioSamples;
+    unsigned    errors;
+  } Result;
+
+  /**
+   * The runs worth comparing, the settings as they are, slice and frame
+   * threading, and small and large demuxer reads
+   */
+  static std::vector<Variant> GetDefaultVariants();
+
+  static bool        Run(const std::string& path, const Variant& variant, Result& result);
+  static std::string Format(const Result& result);
+
+private:
+  static bool Decode(const std::string& path, const Variant& variant, Result& result);
+};
@@ -243,4 +243,13 @@ public:
   {
     return 0;
   }
+
+  /*
+   * How many packets the codec holds on to before it returns
+   * their picture, both reordering and frame threading add to it
+   */
+  virtual unsigned GetDelayFrames()
+  {
+    return 0;
+  }
 };
@@ -149,6 +149,8 @@ CDVDVideoCodecFFmpeg::CDVDVideoCodecFFmpeg() : CDVDVideoCodec()
   m_iLastKeyframe = 0;
   m_dts = DVD_NOPTS_VALUE;
   m_started = false;
+  m_iPacketsIn = 0;
+  m_iDelayFrames = -1;
 }
 
 CDVDVideoCodecFFmpeg::~CDVDVideoCodecFFmpeg()
@@ -262,6 +264,9 @@ bool CDVDVideoCodecFFmpeg::Open(CDVDStreamInfo &hints, CDVDCodecOptions &options
    *
    * When we detect Hi10p and user did not disable hi10pmultithreading
    * via advancedsettings.xml we keep the ffmpeg default thread type.
+   *
+   * A <threading> policy for the codec in advancedsettings.xml
+   * overrides both, see SetThreading.
    * */
   if(m_isHi10p && !g_advancedSettings.m_videoDisableHi10pMultithreading)
   {
@@ -309,11 +314,7 @@ bool CDVDVideoCodecFFmpeg::Open(CDVDStreamInfo &hints, CDVDCodecOptions &options
       m_dllAvUtil.av_opt_set(m_pCodecContext, it->m_name.c_str(), it->m_value.c_str(), 0);
   }
 
-  int num_threads = std::min(8 /*MAX_THREADS*/, g_cpuInfo.getCPUCount());
-  if( num_threads > 1 && !hints.software && m_pHardware == NULL // thumbnail extraction fails when run threaded
-  && ( pCodec->id == CODEC_ID_H264
-    || pCodec->id == CODEC_ID_MPEG4 ))
-    m_pCodecContext->thread_count = num_threads;
+  SetThreading(hints, pCodec);
 
   if (m_dllAvCodec.avcodec_open2(m_pCodecContext, pCodec, NULL) < 0)
   {
@@ -328,6 +329,89 @@ bool CDVDVideoCodecFFmpeg::Open(CDVDStreamInfo &hints, CDVDCodecOptions &options
   return true;
 }
 
+void CDVDVideoCodecFFmpeg::SetThreading(const CDVDStreamInfo &hints, AVCodec* pCodec)
+{
+  // thumbnail extraction fails when run threaded
+  if (hints.software || m_pHardware)
+    return;
+
+  const VideoCodecThreading* policy = g_advancedSettings.GetVideoCodecThreading(pCodec->name);
+  if (!policy)
+  {
+    int num_threads = std::min(8 /*MAX_THREADS*/, g_cpuInfo.getCPUCount());
+    if( num_threads > 1
+    && ( pCodec->id == CODEC_ID_H264
+      || pCodec->id == CODEC_ID_MPEG4 ))
+      m_pCodecContext->thread_count = num_threads;
+    return;
+  }
+
+  int num_threads = policy->threads > 0 ? policy->threads : g_cpuInfo.getCPUCount();
+  if (policy->type)
+    m_pCodecContext->thread_type = policy->type;
+
+  if (m_pCodecContext->thread_type & FF_THREAD_FRAME)
+  {
+    // every frame thread after the first delays the pictures by a frame
+    if (policy->latency > 0.0f)
+    {
+      double frametime = 1000.0 / 25.0;
+      if (hints.fpsrate > 0 && hints.fpsscale > 0)
+        frametime = 1000.0 * hints.fpsscale / hints.fpsrate;
+
+      int max_threads = 1 + (int)(policy->latency / frametime);
+      if (max_threads < 2)
+      {
+        CLog::Log(LOGDEBUG, "CDVDVideoCodecFFmpeg::SetThreading - %.0fms does not allow frame threading, using slices", policy->latency);
+        m_pCodecContext->thread_type = FF_THREAD_SLICE;
+      }
+      else if (num_threads > max_threads)
+        num_threads = max_threads;
+    }
+
+    // frame threading crashes with hardware acceleration
+    if (m_pCodecContext->thread_type & FF_THREAD_FRAME)
+      m_bSoftware = true;
+  }
+
+  if (num_threads > 1)
+    m_pCodecContext->thread_count = num_threads;
+
+  CLog::Log(LOGNOTICE, "CDVDVideoCodecFFmpeg::SetThreading - %s: type %d, %d threads", pCodec->name, m_pCodecContext->thread_type, num_threads);
+}
+
+void CDVDVideoCodecFFmpeg::UpdateDelay(double pts)
+{
+  if (pts == DVD_NOPTS_VALUE)
+    return;
+
+  // find the packet the picture came from, the newest match is the closest
+  for (int i = 1; i <= FFMPEG_DELAY_HISTORY && i <= m_iPacketsIn; i++)
+  {
+    if (m_delayPts[(m_iPacketsIn - i) % FFMPEG_DELAY_HISTORY] == pts)
+    {
+      if (i - 1 > m_iDelayFrames)
+        m_iDelayFrames = i - 1;
+      return;
+    }
+  }
+}
+
+unsigned CDVDVideoCodecFFmpeg::GetDelayFrames()
+{
+  if (m_iDelayFrames >= 0)
+    return m_iDelayFrames;
+
+  // nothing measured yet, go by what the decoder was set up for
+  if (!m_pCodecContext)
+    return 0;
+
+  int frames = m_pCodecContext->has_b_frames;
+  if (m_pCodecContext->active_thread_type & FF_THREAD_FRAME)
+    frames += m_pCodecContext->thread_count - 1;
+  return std::max(frames, 0);
+}
+
 void CDVDVideoCodecFFmpeg::Dispose()
 {
   if (m_pFrame) m_dllAvUtil.av_free(m_pFrame);
@@ -479,6 +563,12 @@ int CDVDVideoCodecFFmpeg::Decode(BYTE* pData, int iSize, double dts, double pts)
   m_dts = dts;
   m_pCodecContext->reordered_opaque = pts_dtoi(pts);
 
+  if(pData)
+  {
+    m_delayPts[m_iPacketsIn % FFMPEG_DELAY_HISTORY] = pts;
+    m_iPacketsIn++;
+  }
+
   AVPacket avpkt;
   m_dllAvCodec.av_init_packet(&avpkt);
   avpkt.data = pData;
@@ -500,6 +590,8 @@ int CDVDVideoCodecFFmpeg::Decode(BYTE* pData, int iSize, double dts, double pts)
   if (!iGotPicture)
     return VC_BUFFER;
 
+  UpdateDelay(pts_itod(m_pFrame->reordered_opaque));
+
   if(m_pFrame->key_frame)
   {
     m_started = true;
@@ -562,6 +654,8 @@ void CDVDVideoCodecFFmpeg::Reset()
   m_started = false;
   m_iLastKeyframe = m_pCodecContext->has_b_frames;
   m_dllAvCodec.avcodec_flush_buffers(m_pCodecContext);
+  m_iPacketsIn = 0;
+  m_iDelayFrames = -1;
 
   if (m_pHardware)
     m_pHardware->Reset();
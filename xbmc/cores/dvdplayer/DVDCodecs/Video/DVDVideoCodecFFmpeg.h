@@ -29,6 +29,9 @@
 #include "DllAvFilter.h"
 #include "DllPostProc.h"
 
+// how many packets back the decoder delay is measured
+#define FFMPEG_DELAY_HISTORY 32
+
 class CVDPAU;
 class CCriticalSection;
 
@@ -61,6 +64,7 @@ public:
   virtual unsigned int SetFilters(unsigned int filters);
   virtual const char* GetName() { return m_name.c_str(); }; // m_name is never changed after open
   virtual unsigned GetConvergeCount();
+  virtual unsigned GetDelayFrames();
 
   bool               IsHardwareAllowed()                     { return !m_bSoftware; }
   IHardwareDecoder * GetHardware()                           { return m_pHardware; };
@@ -78,6 +82,9 @@ protected:
   void FilterClose();
   int  FilterProcess(AVFrame* frame);
 
+  void SetThreading(const CDVDStreamInfo &hints, AVCodec* pCodec);
+  void UpdateDelay(double pts);
+
   void UpdateName()
   {
     if(m_pCodecContext->codec->name)
@@ -122,4 +129,9 @@ protected:
   double m_dts;
   bool   m_started;
   std::vector<PixelFormat> m_formats;
+
+  // pts of the last packets fed, to measure how many the decoder holds
+  double m_delayPts[FFMPEG_DELAY_HISTORY];
+  int    m_iPacketsIn;
+  int    m_iDelayFrames; // -1 until measured
 };
@@ -37,6 +37,9 @@
 #include "DVDInputStreams/DVDInputStreamPVRManager.h"
 #include "DVDInputStreams/DVDInputStreamFFmpeg.h"
 #include "DVDDemuxUtils.h"
+#include "DVDDemuxPacketPool.h"
+#include "DVDStreamProbeCache.h"
+#include "DVDKeyframeIndex.h"
 #include "DVDClock.h" // for DVD_TIME_BASE
 #include "commons/Exception.h"
 #include "settings/AdvancedSettings.h"
@@ -47,6 +50,8 @@
 #include "threads/Thread.h"
 #include "threads/SystemClock.h"
 #include "utils/TimeUtils.h"
+#include "utils/URIUtils.h"
+#include "URL.h"
 
 void CDemuxStreamAudioFFmpeg::GetStreamInfo(std::string& strInfo)
 {
@@ -178,8 +183,16 @@ static int dvd_file_read(void *h, uint8_t* buf, int size)
   if(interrupt_cb(h))
     return AVERROR_EXIT;
 
-  CDVDInputStream* pInputStream = static_cast<CDVDDemuxFFmpeg*>(h)->m_pInput;
-  return pInputStream->Read(buf, size);
+  CDVDDemuxFFmpeg* demuxer = static_cast<CDVDDemuxFFmpeg*>(h);
+  int ret = demuxer->m_pInput->Read(buf, size);
+
+  demuxer->m_ioStats.reads++;
+  if (ret > 0)
+  {
+    demuxer->m_ioStats.bytes       += ret;
+    demuxer->m_ioStats.windowBytes += ret;
+  }
+  return ret;
 }
 /*
 static int dvd_file_write(URLContext *h, BYTE* buf, int size)
@@ -207,12 +220,20 @@ CDVDDemuxFFmpeg::CDVDDemuxFFmpeg() : CDVDDemux()
   m_pFormatContext = NULL;
   m_pInput = NULL;
   m_ioContext = NULL;
+  m_ioClass = "";
+  m_ioMinSize = FFMPEG_FILE_BUFFER_SIZE;
+  m_ioMaxSize = FFMPEG_FILE_BUFFER_SIZE;
+  memset(&m_ioStats, 0, sizeof(m_ioStats));
   for (int i = 0; i < MAX_STREAMS; i++) m_streams[i] = NULL;
   m_iCurrentPts = DVD_NOPTS_VALUE;
   m_bMatroska = false;
   m_bAVI = false;
   m_speed = DVD_PLAYSPEED_NORMAL;
   m_program = UINT_MAX;
+  m_keyframes = NULL;
+  m_probeCached = false;
+  m_keyframeIndexer = NULL;
+  m_keyframeTarget = NULL;
 }
 
 CDVDDemuxFFmpeg::~CDVDDemuxFFmpeg()
@@ -241,6 +262,9 @@ bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput)
   m_speed = DVD_PLAYSPEED_NORMAL;
   m_program = UINT_MAX;
   const AVIOInterruptCB int_cb = { interrupt_cb, this };
+  CDVDStreamProbeEntry probeEntry;
+  bool probeCacheable = false;
+  bool probeCached = false;
 
   if (!pInput) return false;
 
@@ -305,15 +329,75 @@ bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput)
   }
   else
   {
-    unsigned char* buffer = (unsigned char*)m_dllAvUtil.av_malloc(FFMPEG_FILE_BUFFER_SIZE);
-    m_ioContext = m_dllAvFormat.avio_alloc_context(buffer, FFMPEG_FILE_BUFFER_SIZE, 0, this, dvd_file_read, NULL, dvd_file_seek);
+    // size the buffer by the kind of input. small reads are what costs on
+    // network shares, while live streams should not wait for a large read
+    if (m_pInput->GetBlockSize())
+    {
+      m_ioClass = "disc";
+      m_ioMinSize = m_ioMaxSize = FFMPEG_FILE_BUFFER_SIZE;
+    }
+    else if (m_pInput->IsStreamType(DVDSTREAM_TYPE_PVRMANAGER)
+         ||  m_pInput->IsStreamType(DVDSTREAM_TYPE_HTSP)
+         ||  m_pInput->IsStreamType(DVDSTREAM_TYPE_TV)
+         ||  URIUtils::IsLiveTV(strFile))
+    {
+      m_ioClass = "live";
+      m_ioMinSize = 32 * 1024;
+      m_ioMaxSize = 128 * 1024;
+    }
+    else if (URIUtils::IsInternetStream(CURL(strFile)))
+    {
+      m_ioClass = "internet";
+      m_ioMinSize = 64 * 1024;
+      m_ioMaxSize = 1024 * 1024;
+    }
+    else if (URIUtils::IsSmb(strFile) || URIUtils::IsNfs(strFile) || URIUtils::IsAfp(strFile))
+    {
+      m_ioClass = "share";
+      m_ioMinSize = 256 * 1024;
+      m_ioMaxSize = 1024 * 1024;
+    }
+    else
+    {
+      m_ioClass = "local";
+      m_ioMinSize = 32 * 1024;
+      m_ioMaxSize = 256 * 1024;
+    }
+
+    // a fixed size from advancedsettings.xml
+    if (g_advancedSettings.m_videoDemuxBufferSize > 0 && !m_pInput->GetBlockSize())
+      m_ioMinSize = m_ioMaxSize = g_advancedSettings.m_videoDemuxBufferSize;
+
+    unsigned char* buffer = (unsigned char*)m_dllAvUtil.av_malloc(m_ioMinSize);
+    m_ioContext = m_dllAvFormat.avio_alloc_context(buffer, m_ioMinSize, 0, this, dvd_file_read, NULL, dvd_file_seek);
     m_ioContext->max_packet_size = m_pInput->GetBlockSize();
     if(m_ioContext->max_packet_size)
       m_ioContext->max_packet_size *= FFMPEG_FILE_BUFFER_SIZE / m_ioContext->max_packet_size;
+    else
+      m_ioContext->max_packet_size = m_ioMinSize;
+
+    memset(&m_ioStats, 0, sizeof(m_ioStats));
+    m_ioStats.start = m_ioStats.windowStart = XbmcThreads::SystemClockMillis();
+    CLog::Log(LOGDEBUG, "%s - %s input, reading %d bytes at a time", __FUNCTION__, m_ioClass, m_ioContext->max_packet_size);
 
     if(m_pInput->Seek(0, SEEK_POSSIBLE) == 0)
       m_ioContext->seekable = 0;
 
+    // files that were opened before need not be probed and analyzed again
+    probeCacheable = m_pInput->IsStreamType(DVDSTREAM_TYPE_FILE)
+                  && m_pInput->GetContent().empty()
+                  && m_ioContext->seekable
+                  && (strcmp(m_ioClass, "local") == 0 || strcmp(m_ioClass, "share") == 0);
+    if (iformat == NULL && probeCacheable && CDVDStreamProbeCache::GetInstance().Lookup(strFile, probeEntry))
+    {
+      iformat = m_dllAvFormat.av_find_input_format(probeEntry.format.c_str());
+      if (iformat)
+      {
+        CLog::Log(LOGDEBUG, "%s - using cached format [%s]", __FUNCTION__, iformat->name);
+        probeCached = true;
+      }
+    }
+
     if( iformat == NULL )
     {
       // let ffmpeg decide which demuxer we have to open
@@ -338,7 +422,7 @@ bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput)
         pd.filename = strFile.c_str();
 
         // read data using avformat's buffers
-        pd.buf_size = m_dllAvFormat.avio_read(m_ioContext, pd.buf, m_ioContext->max_packet_size ? m_ioContext->max_packet_size : m_ioContext->buffer_size);
+        pd.buf_size = m_dllAvFormat.avio_read(m_ioContext, pd.buf, std::min(FFMPEG_FILE_BUFFER_SIZE, m_ioContext->max_packet_size ? m_ioContext->max_packet_size : m_ioContext->buffer_size));
         if (pd.buf_size <= 0)
         {
           CLog::Log(LOGERROR, "%s - error reading from input stream, %s", __FUNCTION__, strFile.c_str());
@@ -439,7 +523,12 @@ bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput)
   m_bMatroska = strncmp(m_pFormatContext->iformat->name, "matroska", 8) == 0;	// for "matroska.webm"
   m_bAVI = strcmp(m_pFormatContext->iformat->name, "avi") == 0;
 
-  if (streaminfo)
+  if (streaminfo && probeCached && ApplyProbeCache(probeEntry))
+  {
+    m_probeCached = true;
+    CLog::Log(LOGDEBUG, "%s - using cached stream info", __FUNCTION__);
+  }
+  else if (streaminfo)
   {
     /* too speed up dvd switches, only analyse very short */
     if(m_pInput->IsStreamType(DVDSTREAM_TYPE_DVD))
@@ -451,6 +540,8 @@ bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput)
     if (iErr < 0)
     {
       CLog::Log(LOGWARNING,"could not find codec parameters for %s", strFile.c_str());
+      if (probeCached)
+        CDVDStreamProbeCache::GetInstance().Remove(strFile);
       if (m_pInput->IsStreamType(DVDSTREAM_TYPE_DVD)
       ||  m_pInput->IsStreamType(DVDSTREAM_TYPE_BLURAY)
       || (m_pFormatContext->nb_streams == 1 && m_pFormatContext->streams[0]->codec->codec_id == CODEC_ID_AC3))
@@ -463,6 +554,8 @@ bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput)
         return false;
       }
     }
+    else if (probeCacheable)
+      StoreProbeCache(strFile);
     CLog::Log(LOGDEBUG, "%s - av_find_stream_info finished", __FUNCTION__);
   }
   // reset any timeout
@@ -502,11 +595,49 @@ bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput)
       AddStream(i);
   }
 
+  // ffmpeg can only bisect files without a seek index, build one instead
+  if (probeCacheable && !m_keyframeTarget && g_advancedSettings.m_videoKeyframeIndex
+  && !m_pFormatContext->iformat->read_seek && !m_pFormatContext->iformat->read_seek2)
+    OpenKeyframeIndex(strFile);
+
   return true;
 }
 
+void CDVDDemuxFFmpeg::OpenKeyframeIndex(const std::string& path)
+{
+  bool video = false;
+  for (unsigned int i = 0; i < m_pFormatContext->nb_streams; i++)
+  {
+    if (m_pFormatContext->streams[i]->codec->codec_type == AVMEDIA_TYPE_VIDEO)
+      video = true;
+  }
+  if (!video)
+    return;
+
+  m_keyframes = new CDVDKeyframeIndex(path);
+  if (m_keyframes->Load() && m_keyframes->IsComplete())
+  {
+    CLog::Log(LOGDEBUG, "%s - using keyframe index of %s", __FUNCTION__, path.c_str());
+    return;
+  }
+
+  CLog::Log(LOGDEBUG, "%s - indexing keyframes of %s", __FUNCTION__, path.c_str());
+  m_keyframeIndexer = new CDVDKeyframeIndexer(path, m_keyframes);
+  m_keyframeIndexer->Create();
+}
+
 void CDVDDemuxFFmpeg::Dispose()
 {
+  // the indexer saves what it got when it is stopped
+  delete m_keyframeIndexer;
+  m_keyframeIndexer = NULL;
+  delete m_keyframes;
+  m_keyframes = NULL;
+  m_probeCached = false;
+
+  // what this file added to or removed from the probe cache is written once it closes
+  CDVDStreamProbeCache::GetInstance().Flush();
+
   if (m_pFormatContext)
   {
     if (m_ioContext && m_pFormatContext->pb && m_pFormatContext->pb != m_ioContext)
@@ -519,6 +650,12 @@ void CDVDDemuxFFmpeg::Dispose()
 
   if(m_ioContext)
   {
+    unsigned int elapsed = XbmcThreads::SystemClockMillis() - m_ioStats.start;
+    if (m_ioStats.reads && elapsed)
+      CLog::Log(LOGDEBUG, "CDVDDemuxFFmpeg::Dispose - %s input, %u reads of %u bytes on average, %.1f reads/s, last read size %d",
+                m_ioClass, m_ioStats.reads, (unsigned int)(m_ioStats.bytes / m_ioStats.reads),
+                m_ioStats.reads * 1000.0 / elapsed, m_ioContext->max_packet_size);
+
     m_dllAvUtil.av_free(m_ioContext->buffer);
     m_dllAvUtil.av_free(m_ioContext);
   }
@@ -551,6 +688,17 @@ void CDVDDemuxFFmpeg::Reset()
   Open(pInputStream);
 }
 
+bool CDVDDemuxFFmpeg::ReprobeStreams()
+{
+  if (!m_probeCached || !m_pInput)
+    return false;
+
+  CLog::Log(LOGDEBUG, "%s - cached stream info of %s failed, analyzing it again", __FUNCTION__, m_pInput->GetFileName().c_str());
+  CDVDStreamProbeCache::GetInstance().Remove(m_pInput->GetFileName());
+  Reset();
+  return m_pFormatContext != NULL;
+}
+
 void CDVDDemuxFFmpeg::Flush()
 {
   // naughty usage of an internal ffmpeg function
@@ -625,6 +773,224 @@ double CDVDDemuxFFmpeg::ConvertTimestamp(int64_t pts, int den, int num)
   return timestamp*DVD_TIME_BASE;
 }
 
+static void ReleaseAVPacket(void* opaque)
+{
+  AVPacket *pkt = (AVPacket*)opaque;
+  if (pkt->destruct)
+    pkt->destruct(pkt);
+}
+
+DemuxPacket* CDVDDemuxFFmpeg::AllocatePacket(AVPacket& pkt)
+{
+  DemuxPacket* pPacket = NULL;
+
+  // take over the buffer of the packet instead of copying it. once duplicated
+  // the data is ffmpeg's own allocation, freed by its destruct callback, and
+  // valid until then. the padding after it is zero unless the data was cut
+  // from a larger packet, those are still copied
+  if (pkt.data && pkt.size > 0 && m_dllAvCodec.av_dup_packet(&pkt) == 0 && pkt.destruct)
+  {
+    bool padded = true;
+    for (int i = 0; i < FF_INPUT_BUFFER_PADDING_SIZE && padded; i++)
+      padded = pkt.data[pkt.size + i] == 0;
+
+    if (padded)
+      pPacket = CDVDDemuxPacketPool::GetInstance().AllocateExternal(sizeof(AVPacket), ReleaseAVPacket);
+    if (pPacket)
+    {
+      // the side data stays with pkt and is freed with it
+      AVPacket *owned = (AVPacket*)CDVDDemuxPacketPool::GetOpaque(pPacket);
+      *owned = pkt;
+      owned->side_data       = NULL;
+      owned->side_data_elems = 0;
+      pkt.destruct = NULL;
+
+      pPacket->pData = pkt.data;
+      pPacket->iSize = pkt.size;
+      return pPacket;
+    }
+  }
+
+  // copy contents into our own packet
+  pPacket = CDVDDemuxUtils::AllocateDemuxPacket(pkt.size);
+  if (pPacket)
+  {
+    pPacket->iSize = pkt.size;
+    if (pkt.data)
+      memcpy(pPacket->pData, pkt.data, pPacket->iSize);
+  }
+  return pPacket;
+}
+
+bool CDVDDemuxFFmpeg::ApplyProbeCache(const CDVDStreamProbeEntry& entry)
+{
+  // streams that only show up while reading packets, or different ones, need the full analysis
+  if (m_pFormatContext->nb_streams != entry.streams.size())
+    return false;
+  for (unsigned int i = 0; i < m_pFormatContext->nb_streams; i++)
+  {
+    AVCodecContext* codec = m_pFormatContext->streams[i]->codec;
+    if (codec->codec_type != entry.streams[i].codecType
+    ||  codec->codec_id   != entry.streams[i].codecId)
+      return false;
+  }
+
+  // fill in what the demuxer did not read from the header
+  for (unsigned int i = 0; i < m_pFormatContext->nb_streams; i++)
+  {
+    const CDVDStreamProbeStream& cached = entry.streams[i];
+    AVStream*       stream = m_pFormatContext->streams[i];
+    AVCodecContext* codec  = stream->codec;
+
+    if (!codec->width)                        codec->width = cached.width;
+    if (!codec->height)                       codec->height = cached.height;
+    if (codec->pix_fmt == PIX_FMT_NONE)       codec->pix_fmt = (PixelFormat)cached.pixFmt;
+    if (!codec->sample_rate)                  codec->sample_rate = cached.sampleRate;
+    if (!codec->channels)                     codec->channels = cached.channels;
+    if (!codec->channel_layout)               codec->channel_layout = cached.channelLayout;
+    if (codec->sample_fmt == AV_SAMPLE_FMT_NONE) codec->sample_fmt = (AVSampleFormat)cached.sampleFmt;
+    if (!codec->bits_per_coded_sample)        codec->bits_per_coded_sample = cached.bitsPerCodedSample;
+    if (!codec->block_align)                  codec->block_align = cached.blockAlign;
+    if (!codec->bit_rate)                     codec->bit_rate = cached.bitRate;
+    if (codec->profile == FF_PROFILE_UNKNOWN) codec->profile = cached.profile;
+    if (codec->level == FF_LEVEL_UNKNOWN)     codec->level = cached.level;
+
+    if (!stream->r_frame_rate.num)
+    {
+      stream->r_frame_rate.num = cached.rFrameRateNum;
+      stream->r_frame_rate.den = cached.rFrameRateDen;
+    }
+    if (!stream->avg_frame_rate.num)
+    {
+      stream->avg_frame_rate.num = cached.avgFrameRateNum;
+      stream->avg_frame_rate.den = cached.avgFrameRateDen;
+    }
+    if (stream->start_time == (int64_t)AV_NOPTS_VALUE) stream->start_time = cached.startTime;
+    if (stream->duration == (int64_t)AV_NOPTS_VALUE)   stream->duration = cached.duration;
+    if (!stream->nb_frames)                            stream->nb_frames = cached.frames;
+
+    if (!codec->extradata && !cached.extradata.empty())
+    {
+      codec->extradata = (uint8_t*)m_dllAvUtil.av_mallocz(cached.extradata.size() + FF_INPUT_BUFFER_PADDING_SIZE);
+      if (codec->extradata)
+      {
+        memcpy(codec->extradata, cached.extradata.data(), cached.extradata.size());
+        codec->extradata_size = cached.extradata.size();
+      }
+    }
+  }
+
+  if (m_pFormatContext->start_time == (int64_t)AV_NOPTS_VALUE) m_pFormatContext->start_time = entry.startTime;
+  if (m_pFormatContext->duration == (int64_t)AV_NOPTS_VALUE)   m_pFormatContext->duration = entry.duration;
+  if (!m_pFormatContext->bit_rate)                             m_pFormatContext->bit_rate = entry.bitRate;
+  return true;
+}
+
+void CDVDDemuxFFmpeg::StoreProbeCache(const std::string& path)
+{
+  // wav is probed again for dts and ac3 it may carry
+  const char* format = m_pFormatContext->iformat->name;
+  if (!format || strcmp(format, "wav") == 0 || strcmp(format, "spdif") == 0 || m_pFormatContext->nb_streams == 0)
+    return;
+
+  CDVDStreamProbeEntry entry;
+  entry.format    = format;
+  entry.startTime = m_pFormatContext->start_time;
+  entry.duration  = m_pFormatContext->duration;
+  entry.bitRate   = m_pFormatContext->bit_rate;
+  entry.streams.resize(m_pFormatContext->nb_streams);
+
+  for (unsigned int i = 0; i < m_pFormatContext->nb_streams; i++)
+  {
+    CDVDStreamProbeStream& cached = entry.streams[i];
+    AVStream*       stream = m_pFormatContext->streams[i];
+    AVCodecContext* codec  = stream->codec;
+
+    cached.codecType          = codec->codec_type;
+    cached.codecId            = codec->codec_id;
+    cached.width              = codec->width;
+    cached.height             = codec->height;
+    cached.pixFmt             = codec->pix_fmt;
+    cached.sampleRate         = codec->sample_rate;
+    cached.channels           = codec->channels;
+    cached.channelLayout      = codec->channel_layout;
+    cached.sampleFmt          = codec->sample_fmt;
+    cached.bitsPerCodedSample = codec->bits_per_coded_sample;
+    cached.blockAlign         = codec->block_align;
+    cached.bitRate            = codec->bit_rate;
+    cached.profile            = codec->profile;
+    cached.level              = codec->level;
+    cached.rFrameRateNum      = stream->r_frame_rate.num;
+    cached.rFrameRateDen      = stream->r_frame_rate.den;
+    cached.avgFrameRateNum    = stream->avg_frame_rate.num;
+    cached.avgFrameRateDen    = stream->avg_frame_rate.den;
+    cached.startTime          = stream->start_time;
+    cached.duration           = stream->duration;
+    cached.frames             = stream->nb_frames;
+    if (codec->extradata && codec->extradata_size > 0)
+      cached.extradata.assign((const char*)codec->extradata, codec->extradata_size);
+  }
+
+  CDVDStreamProbeCache::GetInstance().Store(path, entry);
+}
+
+int CDVDDemuxFFmpeg::GetIOSize(int64_t bytesPerSecond)
+{
+  int64_t wanted = bytesPerSecond * FFMPEG_IO_READ_PERIOD / 1000;
+
+  int size = m_ioMinSize;
+  while (size < m_ioMaxSize && size < wanted)
+    size *= 2;
+  return std::min(size, m_ioMaxSize);
+}
+
+void CDVDDemuxFFmpeg::UpdateIOSize()
+{
+  if (!m_ioContext || m_pFormatContext->pb != m_ioContext || m_ioMinSize == m_ioMaxSize)
+    return;
+
+  unsigned int now     = XbmcThreads::SystemClockMillis();
+  unsigned int elapsed = now - m_ioStats.windowStart;
+  if (elapsed < FFMPEG_IO_WINDOW)
+    return;
+
+  int64_t bytes = m_ioStats.windowBytes;
+  m_ioStats.windowStart = now;
+  m_ioStats.windowBytes = 0;
+
+  // nothing was demuxed for a while, paused or the queues were full
+  if (elapsed > 2 * FFMPEG_IO_WINDOW)
+    return;
+
+  int size = GetIOSize(bytes * 1000 / elapsed);
+  if (size == m_ioContext->max_packet_size)
+    return;
+
+  // avio shrinks the buffer to max_packet_size on the next fill, but
+  // never grows it, so move what is still buffered to a larger one here
+  if (size > m_ioContext->buffer_size)
+  {
+    unsigned char* buffer = (unsigned char*)m_dllAvUtil.av_malloc(size);
+    if (!buffer)
+      return;
+
+    int left = std::max(0, (int)(m_ioContext->buf_end - m_ioContext->buf_ptr));
+    if (left)
+      memcpy(buffer, m_ioContext->buf_ptr, left);
+    m_dllAvUtil.av_free(m_ioContext->buffer);
+
+    m_ioContext->buffer       = buffer;
+    m_ioContext->buffer_size  = size;
+    m_ioContext->buf_ptr      = buffer;
+    m_ioContext->buf_end      = buffer + left;
+    m_ioContext->checksum_ptr = buffer;
+  }
+
+  CLog::Log(LOGDEBUG, "%s - %s input at %d kB/s, reading %d bytes at a time", __FUNCTION__,
+            m_ioClass, (int)(bytes * 1000 / elapsed / 1024), size);
+  m_ioContext->max_packet_size = size;
+}
+
 DemuxPacket* CDVDDemuxFFmpeg::Read()
 {
   AVPacket pkt;
@@ -635,6 +1001,8 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
   { CSingleLock lock(m_critSection); // open lock scope
   if (m_pFormatContext)
   {
+    UpdateIOSize();
+
     // assume we are not eof
     if(m_pFormatContext->pb)
       m_pFormatContext->pb->eof_reached = 0;
@@ -683,7 +1051,7 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
         {
           if(pkt.stream_index == (int)m_pFormatContext->programs[m_program]->stream_index[i])
           {
-            pPacket = CDVDDemuxUtils::AllocateDemuxPacket(pkt.size);
+            pPacket = AllocatePacket(pkt);
             break;
           }
         }
@@ -692,7 +1060,7 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
           bReturnEmpty = true;
       }
       else
-        pPacket = CDVDDemuxUtils::AllocateDemuxPacket(pkt.size);
+        pPacket = AllocatePacket(pkt);
 
       if (pPacket)
       {
@@ -728,17 +1096,18 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
           pkt.pts = AV_NOPTS_VALUE;
         }
 
-        // copy contents into our own packet
-        pPacket->iSize = pkt.size;
-
-        // maybe we can avoid a memcpy here by detecting where pkt.destruct is pointing too?
-        if (pkt.data)
-          memcpy(pPacket->pData, pkt.data, pPacket->iSize);
-
         pPacket->pts = ConvertTimestamp(pkt.pts, stream->time_base.den, stream->time_base.num);
         pPacket->dts = ConvertTimestamp(pkt.dts, stream->time_base.den, stream->time_base.num);
         pPacket->duration =  DVD_SEC_TO_TIME((double)pkt.duration * stream->time_base.num / stream->time_base.den);
 
+        if (m_keyframeTarget && (pkt.flags & AV_PKT_FLAG_KEY) && pkt.pos >= 0
+        &&  stream->codec && stream->codec->codec_type == AVMEDIA_TYPE_VIDEO)
+        {
+          double ts = pPacket->pts != DVD_NOPTS_VALUE ? pPacket->pts : pPacket->dts;
+          if (ts != DVD_NOPTS_VALUE)
+            m_keyframeTarget->Add(DVD_TIME_TO_MSEC(ts), pkt.pos);
+        }
+
         // used to guess streamlength
         if (pPacket->dts != DVD_NOPTS_VALUE && (pPacket->dts > m_iCurrentPts || m_iCurrentPts == DVD_NOPTS_VALUE))
           m_iCurrentPts = pPacket->dts;
@@ -835,6 +1204,16 @@ bool CDVDDemuxFFmpeg::SeekTime(int time, bool backwords, double *startpts)
     return false;
   }
 
+  // straight to the keyframe before time, the player skips up to time from there
+  int64_t pos;
+  if (m_keyframes && m_keyframes->Find(time, pos) && SeekByte(pos))
+  {
+    CLog::Log(LOGDEBUG, "%s - seek to time %d by keyframe index at byte %"PRId64, __FUNCTION__, time, pos);
+    if(startpts)
+      *startpts = DVD_MSEC_TO_TIME(time);
+    return true;
+  }
+
   int64_t seek_pts = (int64_t)time * (AV_TIME_BASE / 1000);
   if (m_pFormatContext->start_time != (int64_t)AV_NOPTS_VALUE)
     seek_pts += m_pFormatContext->start_time;
@@ -29,6 +29,9 @@
 #include "threads/SystemClock.h"
 
 class CDVDDemuxFFmpeg;
+class CDVDStreamProbeEntry;
+class CDVDKeyframeIndex;
+class CDVDKeyframeIndexer;
 
 class CDemuxStreamVideoFFmpeg
   : public CDemuxStreamVideo
@@ -80,6 +83,20 @@ public:
 #define FFMPEG_FILE_BUFFER_SIZE   32768 // default reading size for ffmpeg
 #define FFMPEG_DVDNAV_BUFFER_SIZE 2048  // for dvd's
 
+// the avio buffer is resized to a read per FFMPEG_IO_READ_PERIOD of the bitrate
+// measured over each FFMPEG_IO_WINDOW, within the limits of the input class
+#define FFMPEG_IO_WINDOW          2000  // ms
+#define FFMPEG_IO_READ_PERIOD     125   // ms
+
+struct FFmpegIOStats
+{
+  unsigned int reads;        // reads from the input stream
+  int64_t      bytes;
+  unsigned int start;        // ms, when the input was opened
+  unsigned int windowStart;  // ms
+  int64_t      windowBytes;
+};
+
 class CDVDDemuxFFmpeg : public CDVDDemux
 {
 public:
@@ -110,8 +127,21 @@ public:
 
   bool Aborted();
 
+  /**
+   * Record the video keyframes Read passes in index, set before Open
+   */
+  void IndexKeyframes(CDVDKeyframeIndex* index) { m_keyframeTarget = index; }
+
+  /**
+   * Drop the cached stream info the streams were opened with and analyze the
+   * file in full, false if they did not come from the probe cache.
+   * The streams are recreated, pointers to the old ones are invalid.
+   */
+  bool ReprobeStreams();
+
   AVFormatContext* m_pFormatContext;
   CDVDInputStream* m_pInput;
+  FFmpegIOStats    m_ioStats;
 
 protected:
   friend class CDemuxStreamAudioFFmpeg;
@@ -123,12 +153,21 @@ protected:
 
   double ConvertTimestamp(int64_t pts, int den, int num);
   void UpdateCurrentPTS();
+  DemuxPacket* AllocatePacket(AVPacket& pkt);
+  int  GetIOSize(int64_t bytesPerSecond);
+  void UpdateIOSize();
+  bool ApplyProbeCache(const CDVDStreamProbeEntry& entry);
+  void StoreProbeCache(const std::string& path);
+  void OpenKeyframeIndex(const std::string& path);
 
   CCriticalSection m_critSection;
   #define MAX_STREAMS 100
   CDemuxStream* m_streams[MAX_STREAMS]; // maximum number of streams that ffmpeg can handle
 
   AVIOContext* m_ioContext;
+  const char*  m_ioClass;   // what kind of input the buffer is sized for
+  int          m_ioMinSize;
+  int          m_ioMaxSize;
 
   DllAvFormat m_dllAvFormat;
   DllAvCodec  m_dllAvCodec;
@@ -141,5 +180,10 @@ protected:
   unsigned m_program;
   XbmcThreads::EndTime  m_timeout;
 
+  CDVDKeyframeIndex*   m_keyframes;       // seeked by, for files without an index
+  bool                 m_probeCached;     // the stream info came from the probe cache
+  CDVDKeyframeIndexer* m_keyframeIndexer;
+  CDVDKeyframeIndex*   m_keyframeTarget;  // filled by Read
+
 };
 
@@ -0,0 +1,238 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#if (defined HAVE_CONFIG_H) && (!defined WIN32)
+  #include "config.h"
+#endif
+#include "DVDDemuxPacketPool.h"
+#include "DVDClock.h"
+#include "threads/SingleLock.h"
+#include "utils/log.h"
+extern "C" {
+#if (defined USE_EXTERNAL_FFMPEG)
+  #if (defined HAVE_LIBAVCODEC_AVCODEC_H)
+    #include <libavcodec/avcodec.h>
+  #else
+    #include <ffmpeg/avcodec.h>
+  #endif
+#else
+  #include "libavcodec/avcodec.h"
+#endif
+}
+
+#include <algorithm>
+#include <string.h>
+
+// the packet is at the start of its block, the data follows 16 byte aligned
+typedef struct
+{
+  DemuxPacket packet;
+  int         sizeClass;  // -1 if the block is too large to be pooled
+  size_t      blockSize;
+  void      (*release)(void* opaque);
+} PacketBlock;
+
+#define DEMUX_POOL_HEADER_SIZE ((sizeof(PacketBlock) + 15) & ~(size_t)15)
+
+CDVDDemuxPacketPool::CDVDDemuxPacketPool(size_t maxFree) :
+  m_maxFree(maxFree)
+{
+  m_stats.bytesInPool  = 0;
+  m_stats.bytesInUse   = 0;
+  m_stats.packetsInUse = 0;
+  ResetStats();
+}
+
+CDVDDemuxPacketPool::~CDVDDemuxPacketPool()
+{
+  Trim();
+}
+
+CDVDDemuxPacketPool& CDVDDemuxPacketPool::GetInstance()
+{
+  static CDVDDemuxPacketPool sPool;
+  return sPool;
+}
+
+int CDVDDemuxPacketPool::GetClass(size_t size)
+{
+  int sizeClass = DEMUX_POOL_MIN_CLASS;
+  while (((size_t)1 << sizeClass) < size)
+  {
+    if (++sizeClass > DEMUX_POOL_MAX_CLASS)
+      return -1;
+  }
+  return sizeClass - DEMUX_POOL_MIN_CLASS;
+}
+
+void* CDVDDemuxPacketPool::AllocateBlock(size_t needed, int iDataSize)
+{
+  int    sizeClass = GetClass(needed);
+  size_t blockSize = sizeClass < 0 ? needed : (size_t)1 << (sizeClass + DEMUX_POOL_MIN_CLASS);
+
+  void *block = NULL;
+  {
+    CSingleLock lock(m_section);
+    if (sizeClass >= 0 && !m_free[sizeClass].empty())
+    {
+      block = m_free[sizeClass].back();
+      m_free[sizeClass].pop_back();
+      m_stats.bytesInPool -= blockSize;
+      m_stats.hits++;
+    }
+    else
+      m_stats.misses++;
+
+    m_stats.bytesInUse += blockSize;
+    m_stats.bytesCopied += iDataSize;
+    m_stats.packetsInUse++;
+    if (m_stats.bytesInUse > m_stats.highWater)
+      m_stats.highWater = m_stats.bytesInUse;
+  }
+
+  if (!block)
+  {
+    block = _aligned_malloc(blockSize, 16);
+    if (!block)
+    {
+      CLog::Log(LOGERROR, "%s - Failed to allocate %u bytes", __FUNCTION__, (unsigned int)blockSize);
+      CSingleLock lock(m_section);
+      m_stats.bytesInUse -= blockSize;
+      m_stats.bytesCopied -= iDataSize;
+      m_stats.packetsInUse--;
+      return NULL;
+    }
+  }
+
+  PacketBlock *header = (PacketBlock*)block;
+  memset(header, 0, sizeof(PacketBlock));
+  header->sizeClass = sizeClass;
+  header->blockSize = blockSize;
+
+  // setup defaults
+  header->packet.dts       = DVD_NOPTS_VALUE;
+  header->packet.pts       = DVD_NOPTS_VALUE;
+  header->packet.iStreamId = -1;
+  return block;
+}
+
+DemuxPacket* CDVDDemuxPacketPool::Allocate(int iDataSize)
+{
+  if (iDataSize < 0)
+    iDataSize = 0;
+
+  // need to allocate a few bytes more, see FF_INPUT_BUFFER_PADDING_SIZE in avcodec.h
+  size_t needed = DEMUX_POOL_HEADER_SIZE;
+  if (iDataSize > 0)
+    needed += iDataSize + FF_INPUT_BUFFER_PADDING_SIZE;
+
+  void *block = AllocateBlock(needed, iDataSize);
+  if (!block)
+    return NULL;
+
+  DemuxPacket *pPacket = &((PacketBlock*)block)->packet;
+  if (iDataSize > 0)
+  {
+    pPacket->pData = (BYTE*)block + DEMUX_POOL_HEADER_SIZE;
+    // the bitstream readers may read past the end, the padding has to be zero
+    memset(pPacket->pData + iDataSize, 0, FF_INPUT_BUFFER_PADDING_SIZE);
+  }
+  return pPacket;
+}
+
+DemuxPacket* CDVDDemuxPacketPool::AllocateExternal(int iOpaqueSize, void (*release)(void* opaque))
+{
+  void *block = AllocateBlock(DEMUX_POOL_HEADER_SIZE + std::max(iOpaqueSize, 0), 0);
+  if (!block)
+    return NULL;
+
+  ((PacketBlock*)block)->release = release;
+  {
+    CSingleLock lock(m_section);
+    m_stats.external++;
+  }
+  return &((PacketBlock*)block)->packet;
+}
+
+void* CDVDDemuxPacketPool::GetOpaque(DemuxPacket* pPacket)
+{
+  return (BYTE*)pPacket + DEMUX_POOL_HEADER_SIZE;
+}
+
+void CDVDDemuxPacketPool::Free(DemuxPacket* pPacket)
+{
+  if (!pPacket)
+    return;
+
+  PacketBlock *header = (PacketBlock*)pPacket;
+  const int    sizeClass = header->sizeClass;
+  const size_t blockSize = header->blockSize;
+
+  if (header->release)
+    header->release(GetOpaque(pPacket));
+
+  {
+    CSingleLock lock(m_section);
+    m_stats.bytesInUse -= blockSize;
+    m_stats.packetsInUse--;
+
+    if (sizeClass >= 0 && m_stats.bytesInPool + blockSize <= m_maxFree)
+    {
+      m_free[sizeClass].push_back(header);
+      m_stats.bytesInPool += blockSize;
+      return;
+    }
+  }
+
+  _aligned_free(header);
+}
+
+void CDVDDemuxPacketPool::Trim()
+{
+  std::vector<void*> blocks;
+  {
+    CSingleLock lock(m_section);
+    for (int i = 0; i < DEMUX_POOL_CLASSES; ++i)
+    {
+      blocks.insert(blocks.end(), m_free[i].begin(), m_free[i].end());
+      m_free[i].clear();
+    }
+    m_stats.bytesInPool = 0;
+  }
+
+  for (std::vector<void*>::iterator it = blocks.begin(); it != blocks.end(); ++it)
+    _aligned_free(*it);
+}
+
+void CDVDDemuxPacketPool::GetStats(Stats& stats)
+{
+  CSingleLock lock(m_section);
+  stats = m_stats;
+}
+
+void CDVDDemuxPacketPool::ResetStats()
+{
+  CSingleLock lock(m_section);
+  m_stats.hits        = 0;
+  m_stats.misses      = 0;
+  m_stats.external    = 0;
+  m_stats.bytesCopied = 0;
+  m_stats.highWater   = m_stats.bytesInUse;
+}
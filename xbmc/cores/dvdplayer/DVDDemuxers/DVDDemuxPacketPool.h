@@ -0,0 +1,100 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "DVDDemuxPacket.h"
+#include "threads/CriticalSection.h"
+
+// smallest and largest pooled block, larger packets are allocated on their own
+#define DEMUX_POOL_MIN_CLASS  9   // 512 bytes
+#define DEMUX_POOL_MAX_CLASS  22  // 4 MB
+#define DEMUX_POOL_CLASSES    (DEMUX_POOL_MAX_CLASS - DEMUX_POOL_MIN_CLASS + 1)
+
+// the most memory kept in free blocks
+#define DEMUX_POOL_MAX_FREE   (32 * 1024 * 1024)
+
+/**
+ * Allocates a DemuxPacket together with its data in a single block, and keeps
+ * freed blocks in power of two size classes for the next packets. The demuxer
+ * thread allocates and the decoder threads free, so the pool is locked, but
+ * in the steady state a packet costs a lock and a pop instead of two mallocs.
+ */
+class CDVDDemuxPacketPool
+{
+public:
+  typedef struct
+  {
+    uint64_t     hits;         // allocations served from a free block
+    uint64_t     misses;       // allocations that had to go to the heap
+    uint64_t     external;     // packets carrying a buffer owned by someone else
+    uint64_t     bytesCopied;  // data allocated for, the demuxer copies it in
+    size_t       bytesInPool;  // held in free blocks
+    size_t       bytesInUse;   // held by live packets
+    size_t       highWater;    // the most bytesInUse has been
+    unsigned int packetsInUse;
+  } Stats;
+
+  CDVDDemuxPacketPool(size_t maxFree = DEMUX_POOL_MAX_FREE);
+  ~CDVDDemuxPacketPool();
+
+  static CDVDDemuxPacketPool& GetInstance();
+
+  /**
+   * Allocate a packet with room for iDataSize bytes, followed by
+   * FF_INPUT_BUFFER_PADDING_SIZE zeroed bytes of padding
+   */
+  DemuxPacket* Allocate(int iDataSize);
+  void         Free(DemuxPacket* pPacket);
+
+  /**
+   * Allocate a packet without data of its own, for the caller to point pData
+   * at a buffer it hands over. The packet has iOpaqueSize bytes of 16 byte
+   * aligned storage for whatever owns that buffer, see GetOpaque, and release
+   * is called with it when the packet is freed. The buffer must be padded
+   * like the ones Allocate returns.
+   */
+  DemuxPacket* AllocateExternal(int iOpaqueSize, void (*release)(void* opaque));
+  static void* GetOpaque(DemuxPacket* pPacket);
+
+  /**
+   * Release every free block back to the heap
+   */
+  void Trim();
+
+  void GetStats(Stats& stats);
+  void ResetStats();
+
+private:
+  CDVDDemuxPacketPool(const CDVDDemuxPacketPool&);
+  CDVDDemuxPacketPool& operator=(const CDVDDemuxPacketPool&);
+
+  static int GetClass(size_t size);
+  void*      AllocateBlock(size_t needed, int iDataSize);
+
+  CCriticalSection   m_section;
+  std::vector<void*> m_free[DEMUX_POOL_CLASSES];
+  size_t             m_maxFree;
+  Stats              m_stats;
+};
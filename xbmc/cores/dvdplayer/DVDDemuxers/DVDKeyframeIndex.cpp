@@ -0,0 +1,329 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDKeyframeIndex.h"
+#include "DVDDemuxFFmpeg.h"
+#include "DVDDemuxUtils.h"
+#include "DVDInputStreams/DVDInputStream.h"
+#include "DVDInputStreams/DVDFactoryInputStream.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "FileItem.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/Archive.h"
+#include "utils/Crc32.h"
+#include "utils/log.h"
+#include "utils/StdString.h"
+#include "utils/URIUtils.h"
+
+#include <algorithm>
+#include <memory>
+
+using namespace XFILE;
+
+// bump when the layout of the index file changes
+#define KEYFRAME_INDEX_VERSION 1
+
+// remote files are read at this rate, leaving the rest of the link to playback
+#define KEYFRAME_INDEX_REMOTE_RATE (4 * 1024 * 1024) // bytes per second
+
+CDVDKeyframeIndex::CDVDKeyframeIndex(const std::string& path) :
+  m_path(path),
+  m_complete(false),
+  m_changed(false)
+{
+}
+
+std::string CDVDKeyframeIndex::GetCacheFile() const
+{
+  Crc32 crc;
+  crc.ComputeFromLowerCase(m_path);
+
+  CStdString file;
+  file.Format(KEYFRAME_INDEX_PATH "%08x.kfi", (unsigned __int32)crc);
+  return file;
+}
+
+void CDVDKeyframeIndex::Prune(const std::string& keep)
+{
+  CFileItemList items;
+  CDirectory::GetDirectory(KEYFRAME_INDEX_PATH, items, ".kfi", DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_BYPASS_CACHE);
+  if (items.Size() <= KEYFRAME_INDEX_MAX_FILES)
+    return;
+
+  items.Sort(SORT_METHOD_DATE, SortOrderAscending);
+  int remove = items.Size() - KEYFRAME_INDEX_MAX_FILES;
+  for (int i = 0; i < items.Size() && remove > 0; i++)
+  {
+    if (URIUtils::GetFileName(items[i]->GetPath()) == URIUtils::GetFileName(keep))
+      continue;
+    CFile::Delete(items[i]->GetPath());
+    remove--;
+  }
+}
+
+bool CDVDKeyframeIndex::Stat(int64_t& size, int64_t& mtime) const
+{
+  struct __stat64 st;
+  if (CFile::Stat(m_path, &st) != 0)
+    return false;
+
+  size  = st.st_size;
+  mtime = st.st_mtime;
+  return true;
+}
+
+bool CDVDKeyframeIndex::Load()
+{
+  int64_t size, mtime;
+  if (!Stat(size, mtime))
+    return false;
+
+  CSingleLock lock(m_section);
+  m_entries.clear();
+  m_complete = false;
+  m_changed  = false;
+
+  CFile file;
+  if (!file.Open(GetCacheFile()))
+    return false;
+
+  CArchive ar(&file, CArchive::load);
+  int version = 0, count = 0;
+  int64_t storedSize = -1, storedMtime = -1;
+  bool complete = false;
+  ar >> version;
+  if (version != KEYFRAME_INDEX_VERSION)
+  {
+    CLog::Log(LOGDEBUG, "CDVDKeyframeIndex::Load - ignoring index of version %d", version);
+    return false;
+  }
+
+  ar >> storedSize >> storedMtime;
+  if (storedSize != size || storedMtime != mtime)
+  {
+    CLog::Log(LOGDEBUG, "CDVDKeyframeIndex::Load - %s changed, indexing again", m_path.c_str());
+    return false;
+  }
+
+  // the entries have a fixed size, a file cut short or padded does not match their count
+  ar >> complete >> count;
+  const int64_t entrySize = sizeof(int) + sizeof(int64_t);
+  if (count < 0 || file.GetPosition() + count * entrySize != file.GetLength())
+  {
+    CLog::Log(LOGWARNING, "CDVDKeyframeIndex::Load - ignoring damaged index of %s", m_path.c_str());
+    return false;
+  }
+
+  std::vector<Entry> entries(count);
+  for (unsigned int i = 0; i < entries.size(); i++)
+  {
+    ar >> entries[i].time >> entries[i].pos;
+    if (entries[i].pos < 0 ||
+        (i > 0 && (entries[i].time <= entries[i - 1].time || entries[i].pos <= entries[i - 1].pos)))
+    {
+      CLog::Log(LOGWARNING, "CDVDKeyframeIndex::Load - ignoring unsorted index of %s", m_path.c_str());
+      return false;
+    }
+  }
+
+  m_entries.swap(entries);
+  m_complete = complete;
+  return !m_entries.empty();
+}
+
+void CDVDKeyframeIndex::Save()
+{
+  int64_t size, mtime;
+  if (!Stat(size, mtime))
+    return;
+
+  CSingleLock lock(m_section);
+  if (!m_changed)
+    return;
+
+  // the index is written next to the old one and renamed over it once complete
+  std::string cacheFile = GetCacheFile();
+  std::string tempFile  = cacheFile + ".tmp";
+  CDirectory::Create(KEYFRAME_INDEX_PATH);
+  CFile file;
+  if (!file.OpenForWrite(tempFile, true))
+  {
+    CLog::Log(LOGWARNING, "CDVDKeyframeIndex::Save - unable to write index of %s", m_path.c_str());
+    return;
+  }
+
+  CArchive ar(&file, CArchive::store);
+  ar << (int)KEYFRAME_INDEX_VERSION;
+  ar << size << mtime;
+  ar << m_complete;
+  ar << (int)m_entries.size();
+  for (unsigned int i = 0; i < m_entries.size(); i++)
+    ar << m_entries[i].time << m_entries[i].pos;
+  ar.Close();
+  file.Close();
+
+  if (!CFile::Rename(tempFile, cacheFile) &&
+      !(CFile::Delete(cacheFile) && CFile::Rename(tempFile, cacheFile)))
+  {
+    CLog::Log(LOGWARNING, "CDVDKeyframeIndex::Save - unable to replace index of %s", m_path.c_str());
+    CFile::Delete(tempFile);
+    return;
+  }
+
+  m_changed = false;
+  Prune(cacheFile);
+}
+
+void CDVDKeyframeIndex::Add(int time, int64_t pos)
+{
+  CSingleLock lock(m_section);
+  if (!m_entries.empty())
+  {
+    const Entry& last = m_entries.back();
+    if (time < last.time + KEYFRAME_INDEX_INTERVAL || pos <= last.pos)
+      return;
+  }
+
+  Entry entry;
+  entry.time = time;
+  entry.pos  = pos;
+  m_entries.push_back(entry);
+  m_changed = true;
+}
+
+bool CDVDKeyframeIndex::CompareTime(int time, const Entry& entry)
+{
+  return time < entry.time;
+}
+
+bool CDVDKeyframeIndex::Find(int time, int64_t& pos)
+{
+  CSingleLock lock(m_section);
+
+  // the first keyframe after time has to be known too, unless all are
+  std::vector<Entry>::const_iterator it = std::upper_bound(m_entries.begin(), m_entries.end(), time, CompareTime);
+  if (it == m_entries.begin() || (it == m_entries.end() && !m_complete))
+    return false;
+
+  pos = (it - 1)->pos;
+  return true;
+}
+
+bool CDVDKeyframeIndex::GetLast(int64_t& pos)
+{
+  CSingleLock lock(m_section);
+  if (m_entries.empty())
+    return false;
+
+  pos = m_entries.back().pos;
+  return true;
+}
+
+void CDVDKeyframeIndex::SetComplete()
+{
+  CSingleLock lock(m_section);
+  m_complete = true;
+  m_changed  = true;
+}
+
+bool CDVDKeyframeIndex::IsComplete()
+{
+  CSingleLock lock(m_section);
+  return m_complete;
+}
+
+CDVDKeyframeIndexer::CDVDKeyframeIndexer(const std::string& path, CDVDKeyframeIndex* index) :
+  CThread("DVDKeyframeIndexer"),
+  m_path(path),
+  m_index(index)
+{
+}
+
+CDVDKeyframeIndexer::~CDVDKeyframeIndexer()
+{
+  StopThread();
+}
+
+void CDVDKeyframeIndexer::Process()
+{
+  // playback comes first
+  SetPriority(GetMinPriority());
+
+  std::auto_ptr<CDVDInputStream> input(CDVDFactoryInputStream::CreateInputStream(NULL, m_path, ""));
+  if (!input.get() || !input->Open(m_path.c_str(), ""))
+  {
+    CLog::Log(LOGERROR, "CDVDKeyframeIndexer::Process - unable to open %s", m_path.c_str());
+    return;
+  }
+
+  CDVDDemuxFFmpeg demux;
+  demux.IndexKeyframes(m_index);
+  if (!demux.Open(input.get()))
+  {
+    CLog::Log(LOGERROR, "CDVDKeyframeIndexer::Process - unable to demux %s", m_path.c_str());
+    return;
+  }
+
+  for (int i = 0; i < demux.GetNrOfStreams(); i++)
+  {
+    CDemuxStream* pStream = demux.GetStream(i);
+    if (pStream && pStream->type != STREAM_VIDEO)
+      pStream->SetDiscard(AVDISCARD_ALL);
+  }
+
+  // carry on where the index left off
+  int64_t pos;
+  if (m_index->GetLast(pos))
+    demux.SeekByte(pos);
+
+  bool paced = URIUtils::IsRemote(m_path);
+  int64_t startPos = input->Seek(0, SEEK_CUR);
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  while (!m_bStop)
+  {
+    if (paced && startPos >= 0)
+    {
+      unsigned int due     = (unsigned int)((input->Seek(0, SEEK_CUR) - startPos) * 1000 / KEYFRAME_INDEX_REMOTE_RATE);
+      unsigned int elapsed = XbmcThreads::SystemClockMillis() - start;
+      if (due > elapsed)
+      {
+        Sleep(std::min(due - elapsed, 100U));
+        continue;
+      }
+    }
+
+    DemuxPacket* pPacket = demux.Read();
+    if (!pPacket)
+    {
+      if (input->IsEOF())
+      {
+        m_index->SetComplete();
+        CLog::Log(LOGDEBUG, "CDVDKeyframeIndexer::Process - indexed %s in %u ms", m_path.c_str(), XbmcThreads::SystemClockMillis() - start);
+      }
+      break;
+    }
+    CDVDDemuxUtils::FreeDemuxPacket(pPacket);
+  }
+
+  demux.Dispose();
+  m_index->Save();
+}
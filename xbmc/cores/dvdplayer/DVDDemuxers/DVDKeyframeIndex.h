@@ -0,0 +1,111 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "threads/CriticalSection.h"
+#include "threads/Thread.h"
+
+// keyframes closer than this to the one indexed before are skipped
+#define KEYFRAME_INDEX_INTERVAL 1000 // ms
+
+// the indexes written last are kept, the others are deleted
+#define KEYFRAME_INDEX_PATH      "special://temp/keyframes/"
+#define KEYFRAME_INDEX_MAX_FILES 200
+
+/**
+ * Byte offsets of the video keyframes of a file by time, for containers
+ * without a seek index of their own, where ffmpeg would have to bisect.
+ * Entries are added in file order from the start, so the index covers the
+ * file up to its last entry. It is kept in special://temp while the file
+ * is unchanged, along with the indexes of the other files saved last.
+ */
+class CDVDKeyframeIndex
+{
+public:
+  CDVDKeyframeIndex(const std::string& path);
+
+  /**
+   * Read what was indexed of the file before, false if nothing was or the
+   * file changed since
+   */
+  bool Load();
+  void Save();
+
+  /**
+   * Add the keyframe at time (ms from the start of the file) starting at
+   * byte pos, ignored unless it is past the last one added
+   */
+  void Add(int time, int64_t pos);
+
+  /**
+   * Byte offset of the last keyframe at or before time, false if the index
+   * does not reach that far
+   */
+  bool Find(int time, int64_t& pos);
+
+  /**
+   * Byte offset to continue indexing from, false if nothing is indexed yet
+   */
+  bool GetLast(int64_t& pos);
+
+  void SetComplete();
+  bool IsComplete();
+
+private:
+  typedef struct
+  {
+    int     time;  // ms
+    int64_t pos;
+  } Entry;
+
+  static bool CompareTime(int time, const Entry& entry);
+  std::string GetCacheFile() const;
+  static void Prune(const std::string& keep);
+  bool Stat(int64_t& size, int64_t& mtime) const;
+
+  CCriticalSection   m_section;
+  std::string        m_path;
+  std::vector<Entry> m_entries;
+  bool               m_complete;
+  bool               m_changed;
+};
+
+/**
+ * Demuxes a file with its own input stream in the background, to fill a
+ * keyframe index while the file is played. Remote files are read at a
+ * bounded rate.
+ */
+class CDVDKeyframeIndexer : public CThread
+{
+public:
+  CDVDKeyframeIndexer(const std::string& path, CDVDKeyframeIndex* index);
+  virtual ~CDVDKeyframeIndexer();
+
+protected:
+  virtual void Process();
+
+  std::string        m_path;
+  CDVDKeyframeIndex* m_index;
+};
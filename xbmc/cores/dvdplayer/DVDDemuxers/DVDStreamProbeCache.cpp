@@ -0,0 +1,309 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDStreamProbeCache.h"
+#include "filesystem/File.h"
+#include "threads/SingleLock.h"
+#include "utils/log.h"
+
+#include <algorithm>
+#include <time.h>
+
+using namespace XFILE;
+
+// bump when the layout of the cache file changes
+#define STREAMPROBE_CACHE_VERSION 2
+
+CDVDStreamProbeStream::CDVDStreamProbeStream()
+{
+  codecType          = -1;
+  codecId            = 0;
+  width              = 0;
+  height             = 0;
+  pixFmt             = -1;
+  sampleRate         = 0;
+  channels           = 0;
+  channelLayout      = 0;
+  sampleFmt          = -1;
+  bitsPerCodedSample = 0;
+  blockAlign         = 0;
+  bitRate            = 0;
+  profile            = -99;
+  level              = -99;
+  rFrameRateNum      = 0;
+  rFrameRateDen      = 0;
+  avgFrameRateNum    = 0;
+  avgFrameRateDen    = 0;
+  startTime          = 0;
+  duration           = 0;
+  frames             = 0;
+}
+
+void CDVDStreamProbeStream::Archive(CArchive& ar)
+{
+  if (ar.IsStoring())
+  {
+    ar << codecType << codecId << width << height << pixFmt;
+    ar << sampleRate << channels << channelLayout << sampleFmt;
+    ar << bitsPerCodedSample << blockAlign << bitRate << profile << level;
+    ar << rFrameRateNum << rFrameRateDen << avgFrameRateNum << avgFrameRateDen;
+    ar << startTime << duration << frames << extradata;
+  }
+  else
+  {
+    ar >> codecType >> codecId >> width >> height >> pixFmt;
+    ar >> sampleRate >> channels >> channelLayout >> sampleFmt;
+    ar >> bitsPerCodedSample >> blockAlign >> bitRate >> profile >> level;
+    ar >> rFrameRateNum >> rFrameRateDen >> avgFrameRateNum >> avgFrameRateDen;
+    ar >> startTime >> duration >> frames >> extradata;
+  }
+}
+
+CDVDStreamProbeEntry::CDVDStreamProbeEntry()
+{
+  startTime = 0;
+  duration  = 0;
+  bitRate   = 0;
+  size      = 0;
+  mtime     = 0;
+  lastUsed  = 0;
+}
+
+void CDVDStreamProbeEntry::Archive(CArchive& ar)
+{
+  if (ar.IsStoring())
+  {
+    ar << format << startTime << duration << bitRate;
+    ar << size << mtime << lastUsed;
+    ar << (int)streams.size();
+    for (unsigned int i = 0; i < streams.size(); i++)
+      ar << streams[i];
+  }
+  else
+  {
+    int count = 0;
+    ar >> format >> startTime >> duration >> bitRate;
+    ar >> size >> mtime >> lastUsed;
+    ar >> count;
+
+    // an empty format marks the entry damaged
+    if (count < 0 || count > STREAMPROBE_CACHE_MAX_STREAMS)
+    {
+      format.clear();
+      streams.clear();
+      return;
+    }
+    streams.resize(count);
+    for (unsigned int i = 0; i < streams.size(); i++)
+      ar >> streams[i];
+  }
+}
+
+CDVDStreamProbeCache::CDVDStreamProbeCache(const std::string& cacheFile) :
+  m_cacheFile(cacheFile),
+  m_loaded(false),
+  m_dirty(false)
+{
+}
+
+CDVDStreamProbeCache& CDVDStreamProbeCache::GetInstance()
+{
+  static CDVDStreamProbeCache sCache("special://temp/streamprobe.cache");
+  return sCache;
+}
+
+bool CDVDStreamProbeCache::Stat(const std::string& path, int64_t& size, int64_t& mtime)
+{
+  struct __stat64 st;
+  if (CFile::Stat(path, &st) != 0)
+    return false;
+
+  size  = st.st_size;
+  mtime = st.st_mtime;
+  return true;
+}
+
+bool CDVDStreamProbeCache::Lookup(const std::string& path, CDVDStreamProbeEntry& entry)
+{
+  int64_t size, mtime;
+  if (!Stat(path, size, mtime))
+    return false;
+
+  CSingleLock lock(m_section);
+  Load();
+
+  EntryMap::iterator it = m_entries.find(path);
+  if (it == m_entries.end())
+    return false;
+
+  if (it->second.size != size || it->second.mtime != mtime)
+  {
+    CLog::Log(LOGDEBUG, "CDVDStreamProbeCache::Lookup - %s changed, probing again", path.c_str());
+    m_entries.erase(it);
+    m_dirty = true;
+    return false;
+  }
+
+  it->second.lastUsed = time(NULL);
+  m_dirty = true;
+  entry = it->second;
+  return true;
+}
+
+void CDVDStreamProbeCache::Store(const std::string& path, const CDVDStreamProbeEntry& entry)
+{
+  int64_t size, mtime;
+  if (!Stat(path, size, mtime))
+    return;
+
+  CSingleLock lock(m_section);
+  Load();
+
+  CDVDStreamProbeEntry& stored = m_entries[path];
+  stored          = entry;
+  stored.size     = size;
+  stored.mtime    = mtime;
+  stored.lastUsed = time(NULL);
+
+  while (m_entries.size() > STREAMPROBE_CACHE_MAX_ENTRIES)
+  {
+    EntryMap::iterator oldest = m_entries.begin();
+    for (EntryMap::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+    {
+      if (it->second.lastUsed < oldest->second.lastUsed)
+        oldest = it;
+    }
+    m_entries.erase(oldest);
+  }
+
+  m_dirty = true;
+}
+
+void CDVDStreamProbeCache::Remove(const std::string& path)
+{
+  CSingleLock lock(m_section);
+  Load();
+
+  if (m_entries.erase(path))
+    m_dirty = true;
+}
+
+void CDVDStreamProbeCache::Clear()
+{
+  CSingleLock lock(m_section);
+  m_entries.clear();
+  m_loaded = true;
+  m_dirty  = false;
+  CFile::Delete(m_cacheFile);
+}
+
+void CDVDStreamProbeCache::Flush()
+{
+  CSingleLock lock(m_section);
+  if (m_dirty)
+    Save();
+}
+
+void CDVDStreamProbeCache::Load()
+{
+  if (m_loaded)
+    return;
+  m_loaded = true;
+
+  CFile file;
+  if (!file.Open(m_cacheFile))
+    return;
+
+  // the file ends with the length of what precedes it, one that was cut short is ignored
+  int64_t length = file.GetLength() - (int64_t)sizeof(int64_t);
+  int64_t stored = -1;
+  if (length >= (int64_t)(2 * sizeof(int)) && file.Seek(length, SEEK_SET) == length)
+    file.Read(&stored, sizeof(stored));
+  if (stored != length || file.Seek(0, SEEK_SET) != 0)
+  {
+    CLog::Log(LOGWARNING, "CDVDStreamProbeCache::Load - ignoring damaged %s", m_cacheFile.c_str());
+    return;
+  }
+
+  CArchive ar(&file, CArchive::load);
+  int version = 0, count = 0;
+  ar >> version;
+  if (version != STREAMPROBE_CACHE_VERSION)
+  {
+    CLog::Log(LOGDEBUG, "CDVDStreamProbeCache::Load - ignoring cache of version %d", version);
+    return;
+  }
+
+  EntryMap entries;
+  ar >> count;
+  bool valid = count >= 0 && count <= STREAMPROBE_CACHE_MAX_ENTRIES;
+  for (int i = 0; valid && i < count; i++)
+  {
+    std::string path;
+    CDVDStreamProbeEntry entry;
+    ar >> path;
+    ar >> entry;
+    valid = !path.empty() && !entry.format.empty() && file.GetPosition() <= length;
+    if (valid)
+      entries[path] = entry;
+  }
+
+  if (!valid || file.GetPosition() != length)
+  {
+    CLog::Log(LOGWARNING, "CDVDStreamProbeCache::Load - ignoring damaged %s", m_cacheFile.c_str());
+    return;
+  }
+  m_entries.swap(entries);
+}
+
+void CDVDStreamProbeCache::Save()
+{
+  // write a new file and move it over the old one, so a crash never leaves a partial cache behind
+  std::string tempFile = m_cacheFile + ".tmp";
+  CFile file;
+  if (!file.OpenForWrite(tempFile, true))
+  {
+    CLog::Log(LOGWARNING, "CDVDStreamProbeCache::Save - unable to write %s", tempFile.c_str());
+    return;
+  }
+
+  CArchive ar(&file, CArchive::store);
+  ar << (int)STREAMPROBE_CACHE_VERSION;
+  ar << (int)m_entries.size();
+  for (EntryMap::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+  {
+    ar << it->first;
+    ar << it->second;
+  }
+  ar.Close();
+  int64_t length = file.GetPosition();
+  bool written = file.Write(&length, sizeof(length)) == sizeof(length);
+  file.Close();
+
+  // renaming over an existing file fails on windows
+  if (!written || (!CFile::Rename(tempFile, m_cacheFile) &&
+                   !(CFile::Delete(m_cacheFile) && CFile::Rename(tempFile, m_cacheFile))))
+  {
+    CLog::Log(LOGWARNING, "CDVDStreamProbeCache::Save - unable to replace %s", m_cacheFile.c_str());
+    CFile::Delete(tempFile);
+    return;
+  }
+  m_dirty = false;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "threads/CriticalSection.h"
+#include "utils/Archive.h"
+
+// the most files remembered, the least recently opened are dropped first
+#define STREAMPROBE_CACHE_MAX_ENTRIES 200
+// the most streams of a file, more than any container holds
+#define STREAMPROBE_CACHE_MAX_STREAMS 256
+
+/**
+ * Codec parameters of one stream as avformat_find_stream_info left them
+ */
+class CDVDStreamProbeStream : public IArchivable
+{
+public:
+  CDVDStreamProbeStream();
+  virtual void Archive(CArchive& ar);
+
+  int         codecType;
+  int         codecId;
+  int         width;
+  int         height;
+  int         pixFmt;
+  int         sampleRate;
+  int         channels;
+  uint64_t    channelLayout;
+  int         sampleFmt;
+  int         bitsPerCodedSample;
+  int         blockAlign;
+  int         bitRate;
+  int         profile;
+  int         level;
+  int         rFrameRateNum;
+  int         rFrameRateDen;
+  int         avgFrameRateNum;
+  int         avgFrameRateDen;
+  int64_t     startTime;
+  int64_t     duration;
+  int64_t     frames;
+  std::string extradata;
+};
+
+/**
+ * What probing found for a file, valid as long as its size and mtime match
+ */
+class CDVDStreamProbeEntry : public IArchivable
+{
+public:
+  CDVDStreamProbeEntry();
+  virtual void Archive(CArchive& ar);
+
+  std::string format;     // AVInputFormat name
+  int64_t     startTime;  // AV_TIME_BASE
+  int64_t     duration;   // AV_TIME_BASE
+  int         bitRate;
+  std::vector<CDVDStreamProbeStream> streams;
+
+  int64_t     size;
+  int64_t     mtime;
+  int64_t     lastUsed;
+};
+
+/**
+ * Remembers the probe and stream info results of files, so reopening a file
+ * does not have to read and analyze its start again. Entries are kept in a
+ * file in special://temp and are only used while the file is unchanged.
+ * Changes are written out by Flush, which the demuxer calls when it closes.
+ */
+class CDVDStreamProbeCache
+{
+public:
+  CDVDStreamProbeCache(const std::string& cacheFile);
+
+  static CDVDStreamProbeCache& GetInstance();
+
+  /**
+   * Fill entry with what is known about path, false if nothing is or the
+   * file changed since it was stored
+   */
+  bool Lookup(const std::string& path, CDVDStreamProbeEntry& entry);
+  void Store(const std::string& path, const CDVDStreamProbeEntry& entry);
+
+  /**
+   * Forget path, the next open probes it in full again
+   */
+  void Remove(const std::string& path);
+  void Clear();
+
+  /**
+   * Write the changes since the last flush to the cache file
+   */
+  void Flush();
+
+private:
+  typedef std::map<std::string, CDVDStreamProbeEntry> EntryMap;
+
+  static bool Stat(const std::string& path, int64_t& size, int64_t& mtime);
+  void Load();
+  void Save();
+
+  CCriticalSection m_section;
+  std::string      m_cacheFile;
+  bool             m_loaded;
+  bool             m_dirty;
+  EntryMap         m_entries;
+};
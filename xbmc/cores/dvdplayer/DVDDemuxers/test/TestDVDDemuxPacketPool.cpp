@@ -0,0 +1,235 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/dvdplayer/DVDDemuxers/DVDDemuxPacketPool.h"
+#include "cores/dvdplayer/DVDClock.h"
+#include "threads/Thread.h"
+
+#include <string.h>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(TestDVDDemuxPacketPool, Allocate)
+{
+  CDVDDemuxPacketPool pool;
+
+  DemuxPacket *pPacket = pool.Allocate(1000);
+  ASSERT_TRUE(pPacket);
+  ASSERT_TRUE(pPacket->pData);
+  EXPECT_EQ(0U, (uintptr_t)pPacket->pData & 15);
+  EXPECT_EQ(0, pPacket->iSize);
+  EXPECT_EQ(-1, pPacket->iStreamId);
+  EXPECT_EQ(DVD_NOPTS_VALUE, pPacket->pts);
+  EXPECT_EQ(DVD_NOPTS_VALUE, pPacket->dts);
+
+  /* dirty the padding, a reused block must have it cleared again */
+  memset(pPacket->pData, 0xFF, 1000 + 64);
+  pool.Free(pPacket);
+
+  pPacket = pool.Allocate(1000);
+  ASSERT_TRUE(pPacket);
+  for (unsigned int i = 1000; i < 1000 + 16; ++i)
+    EXPECT_EQ(0, pPacket->pData[i]);
+  pool.Free(pPacket);
+
+  /* packets without data have none */
+  pPacket = pool.Allocate(0);
+  ASSERT_TRUE(pPacket);
+  EXPECT_FALSE(pPacket->pData);
+  pool.Free(pPacket);
+}
+
+TEST(TestDVDDemuxPacketPool, Reuse)
+{
+  CDVDDemuxPacketPool pool;
+  CDVDDemuxPacketPool::Stats stats;
+
+  DemuxPacket *a = pool.Allocate(3000);
+  DemuxPacket *b = pool.Allocate(3000);
+  pool.GetStats(stats);
+  EXPECT_EQ(0U, stats.hits);
+  EXPECT_EQ(2U, stats.misses);
+  EXPECT_EQ(2U, stats.packetsInUse);
+  EXPECT_EQ(stats.bytesInUse, stats.highWater);
+  EXPECT_EQ(6000U, stats.bytesCopied);
+  size_t peak = stats.highWater;
+
+  pool.Free(a);
+  pool.Free(b);
+  pool.GetStats(stats);
+  EXPECT_EQ(0U, stats.bytesInUse);
+  EXPECT_EQ(0U, stats.packetsInUse);
+  EXPECT_EQ(peak, stats.bytesInPool);
+  EXPECT_EQ(peak, stats.highWater);
+
+  /* any size in the same class is served from the freed blocks */
+  DemuxPacket *c = pool.Allocate(2500);
+  pool.GetStats(stats);
+  EXPECT_EQ(1U, stats.hits);
+  EXPECT_TRUE(c == a || c == b);
+  pool.Free(c);
+
+  /* a smaller class is not */
+  c = pool.Allocate(100);
+  pool.GetStats(stats);
+  EXPECT_EQ(3U, stats.misses);
+  pool.Free(c);
+
+  pool.Trim();
+  pool.GetStats(stats);
+  EXPECT_EQ(0U, stats.bytesInPool);
+
+  pool.ResetStats();
+  pool.GetStats(stats);
+  EXPECT_EQ(0U, stats.hits);
+  EXPECT_EQ(0U, stats.misses);
+  EXPECT_EQ(0U, stats.highWater);
+  EXPECT_EQ(0U, stats.bytesCopied);
+}
+
+TEST(TestDVDDemuxPacketPool, Limits)
+{
+  CDVDDemuxPacketPool pool(64 * 1024);
+  CDVDDemuxPacketPool::Stats stats;
+
+  /* larger than the largest class, allocated and freed on its own */
+  DemuxPacket *pPacket = pool.Allocate(8 * 1024 * 1024);
+  ASSERT_TRUE(pPacket);
+  pPacket->pData[8 * 1024 * 1024 - 1] = 1;
+  pool.Free(pPacket);
+  pool.GetStats(stats);
+  EXPECT_EQ(0U, stats.bytesInPool);
+
+  /* no more than the limit is kept */
+  std::vector<DemuxPacket*> packets;
+  for (unsigned int i = 0; i < 64; ++i)
+    packets.push_back(pool.Allocate(4000));
+  for (unsigned int i = 0; i < packets.size(); ++i)
+    pool.Free(packets[i]);
+  pool.GetStats(stats);
+  EXPECT_GE(64U * 1024, stats.bytesInPool);
+  EXPECT_LT(0U, stats.bytesInPool);
+}
+
+static void ReleaseBuffer(void *opaque)
+{
+  int *count = *(int**)opaque;
+  (*count)++;
+}
+
+TEST(TestDVDDemuxPacketPool, External)
+{
+  CDVDDemuxPacketPool pool;
+  CDVDDemuxPacketPool::Stats stats;
+  unsigned char buffer[64] = {0};
+  int released = 0;
+
+  DemuxPacket *pPacket = pool.AllocateExternal(sizeof(int*), ReleaseBuffer);
+  ASSERT_TRUE(pPacket);
+  EXPECT_FALSE(pPacket->pData);
+  EXPECT_EQ(DVD_NOPTS_VALUE, pPacket->pts);
+  EXPECT_EQ(0U, (uintptr_t)CDVDDemuxPacketPool::GetOpaque(pPacket) & 15);
+  *(int**)CDVDDemuxPacketPool::GetOpaque(pPacket) = &released;
+  pPacket->pData = buffer;
+  pPacket->iSize = 48;
+
+  pool.Free(pPacket);
+  EXPECT_EQ(1, released);
+  pool.GetStats(stats);
+  EXPECT_EQ(1U, stats.external);
+  EXPECT_EQ(0U, stats.bytesCopied);
+  EXPECT_EQ(0U, stats.packetsInUse);
+
+  /* the block is reused without the release of the last owner */
+  pPacket = pool.Allocate(16);
+  ASSERT_TRUE(pPacket);
+  pool.Free(pPacket);
+  EXPECT_EQ(1, released);
+}
+
+class CPacketFreeThread : public CThread
+{
+public:
+  CPacketFreeThread(CDVDDemuxPacketPool &pool) : CThread("PacketFree"), m_pool(pool) {}
+
+  CCriticalSection          m_section;
+  std::vector<DemuxPacket*> m_packets;
+  bool                      m_done;
+
+protected:
+  virtual void Process()
+  {
+    while (true)
+    {
+      std::vector<DemuxPacket*> packets;
+      bool done;
+      {
+        CSingleLock lock(m_section);
+        done = m_done;
+        packets.swap(m_packets);
+      }
+      for (unsigned int i = 0; i < packets.size(); ++i)
+      {
+        /* every packet still holds the pattern it was written with */
+        EXPECT_EQ((unsigned char)packets[i]->iSize, packets[i]->pData[packets[i]->iSize - 1]);
+        m_pool.Free(packets[i]);
+      }
+      if (done)
+        break;
+    }
+  }
+
+private:
+  CDVDDemuxPacketPool &m_pool;
+};
+
+TEST(TestDVDDemuxPacketPool, Threads)
+{
+  /* allocate on this thread and free on another, as the demuxer and the players do */
+  CDVDDemuxPacketPool pool;
+  CPacketFreeThread   thread(pool);
+  thread.m_done = false;
+  thread.Create();
+
+  for (int i = 1; i <= 20000; ++i)
+  {
+    int size = 1 + (i * 7919) % 100000;
+    DemuxPacket *pPacket = pool.Allocate(size);
+    ASSERT_TRUE(pPacket);
+    pPacket->iSize = size;
+    memset(pPacket->pData, (unsigned char)size, size);
+
+    CSingleLock lock(thread.m_section);
+    thread.m_packets.push_back(pPacket);
+  }
+  {
+    CSingleLock lock(thread.m_section);
+    thread.m_done = true;
+  }
+  thread.StopThread();
+
+  CDVDDemuxPacketPool::Stats stats;
+  pool.GetStats(stats);
+  EXPECT_EQ(0U, stats.packetsInUse);
+  EXPECT_EQ(0U, stats.bytesInUse);
+  EXPECT_EQ(20000U, stats.hits + stats.misses);
+  EXPECT_LT(0U, stats.hits);
+}
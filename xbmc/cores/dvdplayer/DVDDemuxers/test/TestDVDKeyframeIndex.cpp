@@ -0,0 +1,177 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/dvdplayer/DVDDemuxers/DVDKeyframeIndex.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "FileItem.h"
+#include "test/TestUtils.h"
+#include "utils/Crc32.h"
+
+#include "gtest/gtest.h"
+
+static CStdString IndexFile(const CStdString &path)
+{
+  Crc32 crc;
+  crc.ComputeFromLowerCase(path);
+
+  CStdString file;
+  file.Format(KEYFRAME_INDEX_PATH "%08x.kfi", (unsigned __int32)crc);
+  return file;
+}
+
+TEST(TestDVDKeyframeIndex, Find)
+{
+  CDVDKeyframeIndex index("special://temp/notthere.ts");
+  int64_t pos;
+  EXPECT_FALSE(index.Find(0, pos));
+  EXPECT_FALSE(index.GetLast(pos));
+
+  index.Add(0, 0);
+  index.Add(500, 100000);    /* too close to the one before */
+  index.Add(2000, 400000);
+  index.Add(1500, 500000);   /* not past the last */
+  index.Add(4000, 800000);
+
+  ASSERT_TRUE(index.Find(0, pos));
+  EXPECT_EQ(0, pos);
+  ASSERT_TRUE(index.Find(1999, pos));
+  EXPECT_EQ(0, pos);
+  ASSERT_TRUE(index.Find(2000, pos));
+  EXPECT_EQ(400000, pos);
+  ASSERT_TRUE(index.Find(3999, pos));
+  EXPECT_EQ(400000, pos);
+
+  /* a later keyframe may come before 5000 */
+  EXPECT_FALSE(index.Find(5000, pos));
+  index.SetComplete();
+  ASSERT_TRUE(index.Find(5000, pos));
+  EXPECT_EQ(800000, pos);
+
+  ASSERT_TRUE(index.GetLast(pos));
+  EXPECT_EQ(800000, pos);
+}
+
+TEST(TestDVDKeyframeIndex, SaveLoad)
+{
+  XFILE::CFile *media = XBMC_CREATETEMPFILE(".ts");
+  ASSERT_TRUE(media);
+  CStdString path = XBMC_TEMPFILEPATH(media);
+
+  {
+    CDVDKeyframeIndex index(path);
+    EXPECT_FALSE(index.Load());
+    index.Add(0, 0);
+    index.Add(1000, 188000);
+    index.SetComplete();
+    index.Save();
+  }
+
+  CDVDKeyframeIndex index(path);
+  ASSERT_TRUE(index.Load());
+  EXPECT_TRUE(index.IsComplete());
+  int64_t pos;
+  ASSERT_TRUE(index.Find(1500, pos));
+  EXPECT_EQ(188000, pos);
+
+  EXPECT_TRUE(XFILE::CFile::Delete(IndexFile(path)));
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(media));
+}
+
+TEST(TestDVDKeyframeIndex, Damaged)
+{
+  XFILE::CFile *media = XBMC_CREATETEMPFILE(".ts");
+  ASSERT_TRUE(media);
+  CStdString path = XBMC_TEMPFILEPATH(media);
+
+  {
+    CDVDKeyframeIndex index(path);
+    index.Add(0, 0);
+    index.Add(1000, 188000);
+    index.Add(2000, 376000);
+    index.Save();
+  }
+
+  XFILE::CFile file;
+  ASSERT_TRUE(file.Open(IndexFile(path)));
+  std::string data((size_t)file.GetLength(), '\0');
+  ASSERT_EQ((unsigned int)data.size(), file.Read(&data[0], data.size()));
+  file.Close();
+
+  /* every shorter piece of the index, and one with the last two entries swapped */
+  std::vector<std::string> damaged;
+  for (size_t length = 0; length < data.size(); length += 5)
+    damaged.push_back(data.substr(0, length));
+  const size_t entrySize = sizeof(int) + sizeof(int64_t);
+  std::string swapped(data, 0, data.size() - 2 * entrySize);
+  swapped += data.substr(data.size() - entrySize);
+  swapped += data.substr(data.size() - 2 * entrySize, entrySize);
+  damaged.push_back(swapped);
+
+  for (size_t i = 0; i < damaged.size(); i++)
+  {
+    ASSERT_TRUE(file.OpenForWrite(IndexFile(path), true));
+    file.Write(damaged[i].data(), damaged[i].size());
+    file.Close();
+
+    CDVDKeyframeIndex index(path);
+    EXPECT_FALSE(index.Load()) << "damaged index " << i;
+    int64_t pos;
+    EXPECT_FALSE(index.GetLast(pos));
+  }
+
+  EXPECT_TRUE(XFILE::CFile::Delete(IndexFile(path)));
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(media));
+}
+
+TEST(TestDVDKeyframeIndex, Prune)
+{
+  XFILE::CFile *media = XBMC_CREATETEMPFILE(".ts");
+  ASSERT_TRUE(media);
+  CStdString path = XBMC_TEMPFILEPATH(media);
+
+  /* more indexes of files played before than are kept */
+  ASSERT_TRUE(XFILE::CDirectory::Create(KEYFRAME_INDEX_PATH));
+  for (int i = 0; i < KEYFRAME_INDEX_MAX_FILES + 10; i++)
+  {
+    CStdString other;
+    other.Format(KEYFRAME_INDEX_PATH "testprune%05i.kfi", i);
+    XFILE::CFile file;
+    ASSERT_TRUE(file.OpenForWrite(other, true));
+    file.Write("x", 1);
+    file.Close();
+  }
+
+  {
+    CDVDKeyframeIndex index(path);
+    index.Add(0, 0);
+    index.Save();
+  }
+
+  /* the one written last stays */
+  CFileItemList items;
+  XFILE::CDirectory::GetDirectory(KEYFRAME_INDEX_PATH, items, ".kfi", XFILE::DIR_FLAG_NO_FILE_DIRS | XFILE::DIR_FLAG_BYPASS_CACHE);
+  EXPECT_EQ(KEYFRAME_INDEX_MAX_FILES, items.Size());
+  EXPECT_TRUE(XFILE::CFile::Exists(IndexFile(path)));
+
+  for (int i = 0; i < items.Size(); i++)
+    XFILE::CFile::Delete(items[i]->GetPath());
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(media));
+}
@@ -0,0 +1,158 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/dvdplayer/DVDDemuxers/DVDStreamProbeCache.h"
+#include "filesystem/File.h"
+#include "test/TestUtils.h"
+
+#include "gtest/gtest.h"
+
+static CDVDStreamProbeEntry CreateEntry()
+{
+  CDVDStreamProbeEntry entry;
+  entry.format   = "matroska,webm";
+  entry.duration = 5400000000LL;
+  entry.bitRate  = 8000000;
+  entry.streams.resize(2);
+  entry.streams[0].codecType     = 0;
+  entry.streams[0].codecId       = 28;
+  entry.streams[0].width         = 1920;
+  entry.streams[0].height        = 1080;
+  entry.streams[0].rFrameRateNum = 24000;
+  entry.streams[0].rFrameRateDen = 1001;
+  entry.streams[0].extradata.assign("\x01\x64\x00\x29\x00", 5);
+  entry.streams[1].codecType     = 1;
+  entry.streams[1].codecId       = 86019;
+  entry.streams[1].sampleRate    = 48000;
+  entry.streams[1].channels      = 6;
+  entry.streams[1].channelLayout = 0x60F;
+  return entry;
+}
+
+TEST(TestDVDStreamProbeCache, StoreLookup)
+{
+  XFILE::CFile *media = XBMC_CREATETEMPFILE(".mkv");
+  XFILE::CFile *cacheFile = XBMC_CREATETEMPFILE(".cache");
+  ASSERT_TRUE(media);
+  ASSERT_TRUE(cacheFile);
+  CStdString path = XBMC_TEMPFILEPATH(media);
+
+  {
+    CDVDStreamProbeCache cache(XBMC_TEMPFILEPATH(cacheFile));
+    CDVDStreamProbeEntry entry;
+    EXPECT_FALSE(cache.Lookup(path, entry));
+    cache.Store(path, CreateEntry());
+    EXPECT_TRUE(cache.Lookup(path, entry));
+    cache.Flush();
+  }
+
+  /* a new instance reads it back from the cache file */
+  CDVDStreamProbeCache cache(XBMC_TEMPFILEPATH(cacheFile));
+  CDVDStreamProbeEntry entry;
+  ASSERT_TRUE(cache.Lookup(path, entry));
+  EXPECT_EQ("matroska,webm", entry.format);
+  EXPECT_EQ(5400000000LL, entry.duration);
+  ASSERT_EQ(2U, entry.streams.size());
+  EXPECT_EQ(1920, entry.streams[0].width);
+  EXPECT_EQ(1001, entry.streams[0].rFrameRateDen);
+  EXPECT_EQ(std::string("\x01\x64\x00\x29\x00", 5), entry.streams[0].extradata);
+  EXPECT_EQ(6, entry.streams[1].channels);
+  EXPECT_EQ(0x60FU, entry.streams[1].channelLayout);
+
+  cache.Remove(path);
+  EXPECT_FALSE(cache.Lookup(path, entry));
+
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(media));
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(cacheFile));
+}
+
+TEST(TestDVDStreamProbeCache, Changed)
+{
+  XFILE::CFile *media = XBMC_CREATETEMPFILE(".ts");
+  XFILE::CFile *cacheFile = XBMC_CREATETEMPFILE(".cache");
+  ASSERT_TRUE(media);
+  ASSERT_TRUE(cacheFile);
+  CStdString path = XBMC_TEMPFILEPATH(media);
+
+  CDVDStreamProbeCache cache(XBMC_TEMPFILEPATH(cacheFile));
+  CDVDStreamProbeEntry entry;
+  cache.Store(path, CreateEntry());
+  ASSERT_TRUE(cache.Lookup(path, entry));
+
+  /* a file of another size is probed again */
+  media->Close();
+  ASSERT_TRUE(media->OpenForWrite(path, true));
+  EXPECT_EQ(16, media->Write("grown since then", 16));
+  media->Close();
+  EXPECT_FALSE(cache.Lookup(path, entry));
+
+  /* as is one that no longer exists */
+  cache.Store(path, CreateEntry());
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(media));
+  EXPECT_FALSE(cache.Lookup(path, entry));
+
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(cacheFile));
+}
+
+TEST(TestDVDStreamProbeCache, Damaged)
+{
+  XFILE::CFile *media = XBMC_CREATETEMPFILE(".mkv");
+  XFILE::CFile *cacheFile = XBMC_CREATETEMPFILE(".cache");
+  ASSERT_TRUE(media);
+  ASSERT_TRUE(cacheFile);
+  CStdString path = XBMC_TEMPFILEPATH(media);
+  CStdString cachePath = XBMC_TEMPFILEPATH(cacheFile);
+  cacheFile->Close();
+
+  {
+    CDVDStreamProbeCache cache(cachePath);
+    cache.Store(path, CreateEntry());
+    cache.Flush();
+  }
+
+  /* read the good file, then write back every shorter piece of it and garbage */
+  XFILE::CFile file;
+  ASSERT_TRUE(file.Open(cachePath));
+  std::string data((size_t)file.GetLength(), '\0');
+  ASSERT_EQ((unsigned int)data.size(), file.Read(&data[0], data.size()));
+  file.Close();
+
+  std::vector<std::string> damaged;
+  for (size_t length = 0; length < data.size(); length += 7)
+    damaged.push_back(data.substr(0, length));
+  std::string garbage(data);
+  for (size_t i = 8; i < garbage.size(); i += 5)
+    garbage[i] = (char)0xFF;
+  damaged.push_back(garbage);
+
+  for (size_t i = 0; i < damaged.size(); i++)
+  {
+    ASSERT_TRUE(file.OpenForWrite(cachePath, true));
+    file.Write(damaged[i].data(), damaged[i].size());
+    file.Close();
+
+    CDVDStreamProbeCache cache(cachePath);
+    CDVDStreamProbeEntry entry;
+    EXPECT_FALSE(cache.Lookup(path, entry)) << "damaged file " << i;
+  }
+
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(media));
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(cacheFile));
+}
@@ -24,6 +24,10 @@
 #include "threads/SingleLock.h"
 #include "DVDClock.h"
 #include "utils/MathUtils.h"
+#include "utils/TimeUtils.h"
+
+#include <stdio.h>
+#include <string.h>
 
 using namespace std;
 
@@ -39,6 +43,12 @@ CDVDMessageQueue::CDVDMessageQueue(const string &owner) : m_hEvent(true), m_owne
   m_TimeFront     = DVD_NOPTS_VALUE;
   m_TimeSize      = 1.0 / 4.0; /* 4 seconds */
   m_iMaxDataSize  = 0;
+
+  m_ring.resize(MSGQ_RING_SIZE);
+  m_ringRead      = 0;
+  m_ringCount     = 0;
+  m_iWaiting      = 0;
+  ResetLatency();
 }
 
 CDVDMessageQueue::~CDVDMessageQueue()
@@ -55,20 +65,37 @@ void CDVDMessageQueue::Init()
   m_bInitialized  = true;
   m_TimeBack      = DVD_NOPTS_VALUE;
   m_TimeFront     = DVD_NOPTS_VALUE;
+  ResetLatency();
 }
 
 void CDVDMessageQueue::Flush(CDVDMsg::Message type)
 {
   CSingleLock lock(m_section);
 
-  for(SList::iterator it = m_list.begin(); it != m_list.end();)
+  for(SList::iterator it = m_prio.begin(); it != m_prio.end();)
   {
     if (it->message->IsType(type) ||  type == CDVDMsg::NONE)
-      it = m_list.erase(it);
+    {
+      it->message->Release();
+      it = m_prio.erase(it);
+    }
     else
       ++it;
   }
 
+  // compact the ring in place, keeping the order of what remains
+  const unsigned int size = m_ring.size();
+  unsigned int count = 0;
+  for(unsigned int i = 0; i < m_ringCount; ++i)
+  {
+    SlotItem& item = m_ring[(m_ringRead + i) % size];
+    if (item.message->IsType(type) ||  type == CDVDMsg::NONE)
+      item.message->Release();
+    else
+      m_ring[(m_ringRead + count++) % size] = item;
+  }
+  m_ringCount = count;
+
   if (type == CDVDMsg::DEMUXER_PACKET ||  type == CDVDMsg::NONE)
   {
     m_iDataSize = 0;
@@ -92,6 +119,7 @@ void CDVDMessageQueue::End()
   CSingleLock lock(m_section);
 
   Flush();
+  LogLatency();
 
   m_bInitialized  = false;
   m_iDataSize     = 0;
@@ -115,14 +143,24 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority)
     return MSGQ_INVALID_MSG;
   }
 
-  SList::iterator it = m_list.begin();
-  while(it != m_list.end())
+  SlotItem item;
+  item.message  = pMsg;
+  item.priority = priority;
+  item.queued   = CurrentHostCounter();
+
+  if (priority == 0)
+    PushRing(item);
+  else
   {
-    if(priority <= it->priority)
-      break;
-    ++it;
+    SList::iterator it = m_prio.begin();
+    while(it != m_prio.end())
+    {
+      if(priority <= it->priority)
+        break;
+      ++it;
+    }
+    m_prio.insert(it, item);
   }
-  m_list.insert(it, DVDMessageListItem(pMsg, priority));
 
   if (pMsg->IsType(CDVDMsg::DEMUXER_PACKET) && priority == 0)
   {
@@ -139,9 +177,10 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority)
     }
   }
 
-  pMsg->Release();
+  // the queue holds the reference now
 
-  m_hEvent.Set(); // inform waiter for new packet
+  if (m_iWaiting > 0)
+    m_hEvent.Set(); // inform waiter for new packet
 
   return MSGQ_OK;
 }
@@ -160,7 +199,7 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
     return MSGQ_NOT_INITIALIZED;
   }
 
-  if(m_list.empty() && m_bEmptied == false && priority == 0 && m_owner != "teletext")
+  if(m_ringCount == 0 && m_prio.empty() && m_bEmptied == false && priority == 0 && m_owner != "teletext")
   {
 #if !defined(TARGET_RASPBERRY_PI)
     CLog::Log(LOGWARNING, "CDVDMessageQueue(%s)::Get - asked for new data packet, with nothing available", m_owner.c_str());
@@ -170,9 +209,22 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
 
   while (!m_bAbortRequest)
   {
-    if(!m_list.empty() && m_list.back().priority >= priority && !m_bCaching)
+    // messages with a positive priority go first, then the ring, then the negative ones
+    SlotItem* next = NULL;
+    bool fromRing = false;
+    if (!m_prio.empty() && m_prio.back().priority > 0)
+      next = &m_prio.back();
+    else if (m_ringCount > 0)
+    {
+      next = &m_ring[m_ringRead];
+      fromRing = true;
+    }
+    else if (!m_prio.empty())
+      next = &m_prio.back();
+
+    if(next && next->priority >= priority && !m_bCaching)
     {
-      DVDMessageListItem& item(m_list.back());
+      SlotItem& item(*next);
       priority = item.priority;
 
       if (item.message->IsType(CDVDMsg::DEMUXER_PACKET) && item.priority == 0)
@@ -191,8 +243,16 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
           m_bEmptied = false;
       }
 
-      *pMsg = item.message->Acquire();
-      m_list.pop_back();
+      AddLatency(item.queued);
+
+      *pMsg = item.message;
+      if (fromRing)
+      {
+        m_ringRead = (m_ringRead + 1) % m_ring.size();
+        m_ringCount--;
+      }
+      else
+        m_prio.pop_back();
 
       ret = MSGQ_OK;
       break;
@@ -205,13 +265,16 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
     else
     {
       m_hEvent.Reset();
+      m_iWaiting++;
       lock.Leave();
 
       // wait for a new message
-      if (!m_hEvent.WaitMSec(iTimeoutInMilliSeconds))
-        return MSGQ_TIMEOUT;
+      bool signaled = m_hEvent.WaitMSec(iTimeoutInMilliSeconds);
 
       lock.Enter();
+      m_iWaiting--;
+      if (!signaled)
+        return MSGQ_TIMEOUT;
     }
   }
 
@@ -229,11 +292,16 @@ unsigned CDVDMessageQueue::GetPacketCount(CDVDMsg::Message type)
     return 0;
 
   unsigned count = 0;
-  for(SList::iterator it = m_list.begin(); it != m_list.end();++it)
+  for(SList::iterator it = m_prio.begin(); it != m_prio.end();++it)
   {
     if(it->message->IsType(type))
       count++;
   }
+  for(unsigned int i = 0; i < m_ringCount; ++i)
+  {
+    if(m_ring[(m_ringRead + i) % m_ring.size()].message->IsType(type))
+      count++;
+  }
 
   return count;
 }
@@ -274,3 +342,67 @@ bool CDVDMessageQueue::IsDataBased() const
           m_TimeFront == DVD_NOPTS_VALUE ||
           m_TimeFront <= m_TimeBack);
 }
+
+void CDVDMessageQueue::PushRing(const SlotItem& item)
+{
+  if (m_ringCount == m_ring.size())
+  {
+    // full, unroll into a ring twice the size
+    std::vector<SlotItem> ring(m_ring.size() * 2);
+    for(unsigned int i = 0; i < m_ringCount; ++i)
+      ring[i] = m_ring[(m_ringRead + i) % m_ring.size()];
+    m_ring.swap(ring);
+    m_ringRead = 0;
+  }
+
+  m_ring[(m_ringRead + m_ringCount) % m_ring.size()] = item;
+  m_ringCount++;
+}
+
+void CDVDMessageQueue::AddLatency(int64_t queued)
+{
+  double ms = (double)(CurrentHostCounter() - queued) * 1000.0 / CurrentHostFrequency();
+
+  int bucket = 0;
+  while (bucket < MSGQ_LATENCY_BUCKETS - 1 && ms >= (double)(1 << bucket))
+    bucket++;
+
+  m_latency.buckets[bucket]++;
+  m_latency.count++;
+  m_latency.total += ms;
+  if (ms > m_latency.max)
+    m_latency.max = ms;
+}
+
+void CDVDMessageQueue::GetLatency(MsgQueueLatency& latency) const
+{
+  CSingleLock lock(m_section);
+  latency = m_latency;
+}
+
+void CDVDMessageQueue::ResetLatency()
+{
+  CSingleLock lock(m_section);
+  memset(&m_latency, 0, sizeof(m_latency));
+}
+
+void CDVDMessageQueue::LogLatency()
+{
+  if (m_latency.count == 0)
+    return;
+
+  std::string buckets;
+  for(int i = 0; i < MSGQ_LATENCY_BUCKETS; ++i)
+  {
+    char bucket[32];
+    if (i < MSGQ_LATENCY_BUCKETS - 1)
+      sprintf(bucket, " <%dms:%u", 1 << i, m_latency.buckets[i]);
+    else
+      sprintf(bucket, " more:%u", m_latency.buckets[i]);
+    buckets += bucket;
+  }
+
+  CLog::Log(LOGDEBUG, "CDVDMessageQueue(%s)::LogLatency - %u messages, average %.2f ms, max %.2f ms,%s",
+            m_owner.c_str(), m_latency.count, m_latency.total / m_latency.count, m_latency.max, buckets.c_str());
+  memset(&m_latency, 0, sizeof(m_latency));
+}
@@ -23,6 +23,8 @@
 #include "DVDMessage.h"
 #include <string>
 #include <list>
+#include <vector>
+#include <stdint.h>
 #include "threads/CriticalSection.h"
 #include "threads/Event.h"
 
@@ -80,6 +82,20 @@ enum MsgQueueReturnCode
 
 #define MSGQ_IS_ERROR(c)    (c < 0)
 
+// slots the message ring starts with, it grows if a queue ever holds more
+#define MSGQ_RING_SIZE        256
+
+// bucket 0 counts waits below 1 ms, bucket n waits below 2^n ms, the last one the rest
+#define MSGQ_LATENCY_BUCKETS  12
+
+struct MsgQueueLatency
+{
+  unsigned int count;
+  double       total;    // ms
+  double       max;      // ms
+  unsigned int buckets[MSGQ_LATENCY_BUCKETS];
+};
+
 class CDVDMessageQueue
 {
 public:
@@ -122,7 +138,23 @@ public:
   bool IsInited() const                 { return m_bInitialized; }
   bool IsDataBased() const;
 
+  /**
+   * Time messages spent in the queue between Put and Get
+   */
+  void GetLatency(MsgQueueLatency& latency) const;
+  void ResetLatency();
+
 private:
+  struct SlotItem
+  {
+    CDVDMsg* message;
+    int      priority;
+    int64_t  queued;
+  };
+
+  void PushRing(const SlotItem& item);
+  void AddLatency(int64_t queued);
+  void LogLatency();
 
   CEvent m_hEvent;
   mutable CCriticalSection m_section;
@@ -140,7 +172,17 @@ private:
   bool m_bEmptied;
   std::string m_owner;
 
-  typedef std::list<DVDMessageListItem> SList;
-  SList m_list;
+  // priority 0 messages in arrival order, in a ring that is reused between messages
+  std::vector<SlotItem> m_ring;
+  unsigned int m_ringRead;
+  unsigned int m_ringCount;
+
+  // the few messages with another priority, ordered by ascending priority
+  // and newest first within a priority, taken from the back
+  typedef std::list<SlotItem> SList;
+  SList m_prio;
+
+  int m_iWaiting;
+  MsgQueueLatency m_latency;
 };
 
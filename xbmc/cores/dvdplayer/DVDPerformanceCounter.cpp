@@ -20,8 +20,11 @@
 
 #include "DVDPerformanceCounter.h"
 #include "DVDMessageQueue.h"
+#include "cores/IPlayer.h"
 #include "utils/TimeUtils.h"
 
+#include <algorithm>
+
 #include "dvd_config.h"
 
 #ifdef DVDDEBUG_WITH_PERFORMANCE_COUNTER
@@ -121,6 +124,7 @@ CDVDPerformanceCounter::CDVDPerformanceCounter()
   memset(&m_videoDecodePerformance, 0, sizeof(m_videoDecodePerformance)); // video decoding
   memset(&m_audioDecodePerformance, 0, sizeof(m_audioDecodePerformance)); // audio decoding + output to audio device
   memset(&m_mainPerformance,        0, sizeof(m_mainPerformance));        // reading files, demuxing, decoding of subtitles + menu overlays
+  memset(m_stages, 0, sizeof(m_stages));
 
   Initialize();
 }
@@ -152,3 +156,90 @@ void CDVDPerformanceCounter::DeInitialize()
 
 }
 
+CThread* CDVDPerformanceCounter::GetThread(EDVDPerformanceStage stage)
+{
+  switch (stage)
+  {
+    case DVDPERF_DEMUX: return m_mainPerformance.thread;
+    case DVDPERF_AUDIO: return m_audioDecodePerformance.thread;
+    case DVDPERF_VIDEO: return m_videoDecodePerformance.thread;
+    default:            return NULL; // subtitles are decoded on the main thread
+  }
+}
+
+void CDVDPerformanceCounter::AddDecodeTime(EDVDPerformanceStage stage, int64_t ticks)
+{
+  float ms = (float)((double)ticks * 1000.0 / CurrentHostFrequency());
+
+  CSingleLock lock(m_critSection);
+  StagePerformance& perf = m_stages[stage];
+  perf.decode[perf.decodeCount % DVD_PERF_DECODE_SAMPLES] = ms;
+  perf.decodeCount++;
+}
+
+void CDVDPerformanceCounter::ResetStages()
+{
+  CSingleLock lock(m_critSection);
+  memset(m_stages, 0, sizeof(m_stages));
+}
+
+static int GetQueueLevel(CDVDMessageQueue* pQueue)
+{
+  if (!pQueue || pQueue->GetMaxDataSize() <= 0)
+    return -1;
+
+  return std::min(100, pQueue->GetDataSize() * 100 / pQueue->GetMaxDataSize());
+}
+
+void CDVDPerformanceCounter::GetPerformance(SPlayerPerformanceInfo &info)
+{
+  static const char* names[DVDPERF_STAGES] = { "demux", "audio", "video", "subtitle" };
+
+  CSingleLock lock(m_critSection);
+  int64_t now = CurrentHostCounter();
+
+  info.stages.clear();
+  for (int i = 0; i < DVDPERF_STAGES; i++)
+  {
+    StagePerformance& perf = m_stages[i];
+    SPlayerStagePerformance stage;
+    stage.name    = names[i];
+    stage.frames  = perf.frames;
+    stage.dropped = perf.dropped;
+    stage.late    = perf.late;
+
+    if (i == DVDPERF_AUDIO)
+      stage.queueLevel = GetQueueLevel(m_pAudioQueue);
+    else if (i == DVDPERF_VIDEO)
+      stage.queueLevel = GetQueueLevel(m_pVideoQueue);
+
+    // cpu time is in 100ns units
+    CThread* thread = GetThread((EDVDPerformanceStage)i);
+    if (thread)
+    {
+      int64_t usage = thread->GetAbsoluteUsage();
+      if (perf.time > 0 && now > perf.time && usage >= perf.usage)
+      {
+        double elapsed = (double)(now - perf.time) * 10000000.0 / CurrentHostFrequency();
+        stage.busy = (float)((usage - perf.usage) * 100.0 / elapsed);
+      }
+      else
+        stage.busy = 0.0f;
+      perf.usage = usage;
+      perf.time  = now;
+    }
+
+    unsigned count = std::min(perf.decodeCount, (unsigned)DVD_PERF_DECODE_SAMPLES);
+    if (count)
+    {
+      std::vector<float> times(perf.decode, perf.decode + count);
+      std::sort(times.begin(), times.end());
+      stage.decodeP50 = times[count * 50 / 100];
+      stage.decodeP90 = times[count * 90 / 100];
+      stage.decodeP99 = times[count * 99 / 100];
+      stage.decodeMax = times[count - 1];
+    }
+
+    info.stages.push_back(stage);
+  }
+}
@@ -27,6 +27,19 @@
 #include "threads/SingleLock.h"
 
 class CDVDMessageQueue;
+struct SPlayerPerformanceInfo;
+
+// decode times kept per stage for the percentiles
+#define DVD_PERF_DECODE_SAMPLES 256
+
+enum EDVDPerformanceStage
+{
+  DVDPERF_DEMUX = 0,
+  DVDPERF_AUDIO,
+  DVDPERF_VIDEO,
+  DVDPERF_SUBTITLE,
+  DVDPERF_STAGES
+};
 
 typedef struct stProcessPerformance
 {
@@ -35,6 +48,17 @@ typedef struct stProcessPerformance
   CThread*        thread;
 } ProcessPerformance;
 
+typedef struct stStagePerformance
+{
+  float     decode[DVD_PERF_DECODE_SAMPLES]; // ms, the last decode times
+  unsigned  decodeCount;
+  uint64_t  frames;
+  uint64_t  dropped;
+  uint64_t  late;
+  int64_t   usage;  // cpu time of the stage thread at the last query, 100ns
+  int64_t   time;   // CurrentHostCounter at the last query
+} StagePerformance;
+
 class CDVDPerformanceCounter
 {
 public:
@@ -59,6 +83,25 @@ public:
   void EnableMainPerformance(CThread *thread)         { CSingleLock lock(m_critSection); m_mainPerformance.thread = thread;  }
   void DisableMainPerformance()                       { CSingleLock lock(m_critSection); m_mainPerformance.thread = NULL;  }
 
+  /**
+   * Record ticks of CurrentHostCounter spent decoding, or reading for the
+   * demux stage, and what became of the frames
+   */
+  void AddDecodeTime(EDVDPerformanceStage stage, int64_t ticks);
+  void AddFrame(EDVDPerformanceStage stage)    { CSingleLock lock(m_critSection); m_stages[stage].frames++;  }
+  void AddDropped(EDVDPerformanceStage stage)  { CSingleLock lock(m_critSection); m_stages[stage].dropped++; }
+  void AddLate(EDVDPerformanceStage stage)     { CSingleLock lock(m_critSection); m_stages[stage].late++;    }
+
+  /**
+   * Forget the counts and decode times of all stages, for a new file
+   */
+  void ResetStages();
+
+  /**
+   * Busy time is measured since the last call
+   */
+  void GetPerformance(SPlayerPerformanceInfo &info);
+
   CDVDMessageQueue*         m_pAudioQueue;
   CDVDMessageQueue*         m_pVideoQueue;
 
@@ -67,7 +110,10 @@ public:
   ProcessPerformance        m_mainPerformance;
 
 private:
+  CThread* GetThread(EDVDPerformanceStage stage);
+
   CCriticalSection m_critSection;
+  StagePerformance m_stages[DVDPERF_STAGES];
 };
 
 extern CDVDPerformanceCounter g_dvdPerformanceCounter;
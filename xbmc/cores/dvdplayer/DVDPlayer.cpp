@@ -31,6 +31,7 @@
 
 #include "DVDDemuxers/DVDDemux.h"
 #include "DVDDemuxers/DVDDemuxUtils.h"
+#include "DVDDemuxers/DVDDemuxPacketPool.h"
 #include "DVDDemuxers/DVDDemuxVobsub.h"
 #include "DVDDemuxers/DVDFactoryDemuxer.h"
 #include "DVDDemuxers/DVDDemuxFFmpeg.h"
@@ -558,6 +559,7 @@ void CDVDPlayer::OnStartup()
 
   m_messenger.Init();
 
+  g_dvdPerformanceCounter.ResetStages();
   g_dvdPerformanceCounter.EnableMainPerformance(this);
   CUtil::ClearTempFonts();
 }
@@ -799,7 +801,13 @@ bool CDVDPlayer::ReadPacket(DemuxPacket*& packet, CDemuxStream*& stream)
 
   // read a data frame from stream.
   if(m_pDemuxer)
+  {
+    int64_t readStart = CurrentHostCounter();
     packet = m_pDemuxer->Read();
+    g_dvdPerformanceCounter.AddDecodeTime(DVDPERF_DEMUX, CurrentHostCounter() - readStart);
+    if(packet)
+      g_dvdPerformanceCounter.AddFrame(DVDPERF_DEMUX);
+  }
 
   if(packet)
   {
@@ -1988,6 +1996,14 @@ void CDVDPlayer::OnExit()
     }
     m_pSubtitleDemuxer = NULL;
 
+    // the packets went with the demuxers and the players, give the pooled ones back
+    CDVDDemuxPacketPool::Stats poolStats;
+    CDVDDemuxPacketPool::GetInstance().GetStats(poolStats);
+    CLog::Log(LOGDEBUG, "CDVDPlayer::OnExit() packet pool: %"PRIu64" hits, %"PRIu64" misses, %"PRIu64" without copy, peak %u KB in use, %u KB pooled",
+              poolStats.hits, poolStats.misses, poolStats.external, (unsigned int)(poolStats.highWater / 1024), (unsigned int)(poolStats.bytesInPool / 1024));
+    CDVDDemuxPacketPool::GetInstance().Trim();
+    CDVDDemuxPacketPool::GetInstance().ResetStats();
+
     // destroy the inputstream
     if (m_pInputStream)
     {
@@ -2822,6 +2838,19 @@ void CDVDPlayer::ToFFRW(int iSpeed)
   SetPlaySpeed(iSpeed * DVD_PLAYSPEED_NORMAL);
 }
 
+bool CDVDPlayer::ReprobeDemuxer()
+{
+  CDVDDemuxFFmpeg* demuxer = dynamic_cast<CDVDDemuxFFmpeg*>(m_pDemuxer);
+  if (!demuxer || !demuxer->ReprobeStreams())
+    return false;
+
+  // the demuxer streams were recreated, as on DEMUXER_RESET
+  m_CurrentAudio.stream = NULL;
+  m_CurrentVideo.stream = NULL;
+  m_CurrentSubtitle.stream = NULL;
+  return true;
+}
+
 bool CDVDPlayer::OpenAudioStream(int iStream, int source, bool reset)
 {
   CLog::Log(LOGNOTICE, "Opening audio stream: %i source: %i", iStream, source);
@@ -2854,6 +2883,10 @@ bool CDVDPlayer::OpenAudioStream(int iStream, int source, bool reset)
   {
     if (!m_dvdPlayerAudio.OpenStream( hint ))
     {
+      // the stream info may have come from the probe cache, analyze the file in full and try again
+      if (ReprobeDemuxer())
+        return OpenAudioStream(iStream, source, reset);
+
       /* mark stream as disabled, to disallaw further attempts*/
       CLog::Log(LOGWARNING, "%s - Unsupported stream %d. Stream disabled.", __FUNCTION__, iStream);
       pStream->disabled = true;
@@ -2927,6 +2960,10 @@ bool CDVDPlayer::OpenVideoStream(int iStream, int source, bool reset)
   {
     if (!m_dvdPlayerVideo.OpenStream(hint))
     {
+      // the stream info may have come from the probe cache, analyze the file in full and try again
+      if (ReprobeDemuxer())
+        return OpenVideoStream(iStream, source, reset);
+
       /* mark stream as disabled, to disallaw further attempts */
       CLog::Log(LOGWARNING, "%s - Unsupported stream %d. Stream disabled.", __FUNCTION__, iStream);
       pStream->disabled = true;
@@ -3825,6 +3862,12 @@ void CDVDPlayer::GetVideoStreamInfo(SPlayerVideoStreamInfo &info)
   m_dvdPlayerVideo.GetVideoRect(info.SrcRect, info.DestRect);
 }
 
+bool CDVDPlayer::GetPerformanceInfo(SPlayerPerformanceInfo &info)
+{
+  g_dvdPerformanceCounter.GetPerformance(info);
+  return true;
+}
+
 int CDVDPlayer::GetSourceBitrate()
 {
   if (m_pInputStream)
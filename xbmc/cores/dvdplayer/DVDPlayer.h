@@ -231,6 +231,7 @@ public:
 
   virtual int GetSourceBitrate();
   virtual void GetVideoStreamInfo(SPlayerVideoStreamInfo &info);
+  virtual bool GetPerformanceInfo(SPlayerPerformanceInfo &info);
   virtual int GetPictureWidth();
   virtual int GetPictureHeight();
   virtual bool GetStreamDetails(CStreamDetails &details);
@@ -281,6 +282,12 @@ protected:
   bool CloseSubtitleStream(bool bKeepOverlays);
   bool CloseTeletextStream(bool bWaitForBuffers);
 
+  /**
+   * Analyze the file in full when its streams were opened from the probe cache
+   * \return true if the demuxer was reopened and opening the stream is worth another try
+   */
+  bool ReprobeDemuxer();
+
   void ProcessPacket(CDemuxStream* pStream, DemuxPacket* pPacket);
   void ProcessAudioData(CDemuxStream* pStream, DemuxPacket* pPacket);
   void ProcessVideoData(CDemuxStream* pStream, DemuxPacket* pPacket);
@@ -267,7 +267,9 @@ int CDVDPlayerAudio::DecodeFrame(DVDAudioFrame &audioframe, bool bDropPacket)
       if (dts != DVD_NOPTS_VALUE)
         m_audioClock = dts;
 
+      int64_t decodeStart = CurrentHostCounter();
       int len = m_pAudioCodec->Decode(m_decode.data, m_decode.size);
+      g_dvdPerformanceCounter.AddDecodeTime(DVDPERF_AUDIO, CurrentHostCounter() - decodeStart);
       m_audioStats.AddSampleBytes(m_decode.size);
       if (len < 0)
       {
@@ -578,6 +580,8 @@ void CDVDPlayerAudio::Process()
 
     if( result & DECODE_FLAG_DROP )
     {
+      g_dvdPerformanceCounter.AddDropped(DVDPERF_AUDIO);
+
       //frame should be dropped. Don't let audio move ahead of the current time thou
       //we need to be able to start playing at any time
       //when playing backwords, we try to keep as small buffers as possible
@@ -598,6 +602,7 @@ void CDVDPlayerAudio::Process()
 
       // add any packets play
       packetadded = OutputPacket(audioframe);
+      g_dvdPerformanceCounter.AddFrame(DVDPERF_AUDIO);
 
       // we are not running until something is cached in output device
       if(m_stalled && m_dvdAudio.GetCacheTime() > 0.0)
@@ -766,6 +771,8 @@ bool CDVDPlayerAudio::OutputPacket(DVDAudioFrame &audioframe)
         m_dvdAudio.AddPackets(audioframe);
         m_skipdupcount++;
       }
+      else // skipped to catch up with the clock
+        g_dvdPerformanceCounter.AddLate(DVDPERF_AUDIO);
     }
     else if (m_skipdupcount > 0)
     {
@@ -23,19 +23,10 @@
 #include "utils/log.h"
 #include "utils/MathUtils.h"
 
-#ifdef _WIN32
-#pragma comment(lib, "libsamplerate-0.lib")
-#endif
-
 CDVDPlayerResampler::CDVDPlayerResampler()
 {
   m_nrchannels = -1;
-  m_converter = NULL;
-  
-  memset(&m_converterdata, 0, sizeof(m_converterdata));
-  m_converterdata.src_ratio = 1.0;
-  
-  m_quality = SRC_LINEAR;
+  m_quality = CAEResample::QUALITY_LOW;
   m_ratio = 1.0;
 
   m_buffer = NULL;
@@ -60,34 +51,35 @@ void CDVDPlayerResampler::Add(DVDAudioFrame &audioframe, double pts)
 
   //resize sample buffer if necessary
   //we want the buffer to be large enough to hold the current frames in it,
-  //the number of frames needed for libsamplerate's input
-  //and the maximum number of frames libsamplerate might generate, times 2 for safety
+  //the number of frames needed for the resampler's input
+  //and the maximum number of frames the resampler might generate, times 2 for safety
   ResizeSampleBuffer(m_bufferfill + nrframes + nrframes * MathUtils::round_int(m_ratio + 0.5) * 2);
 
   //assign samplebuffers
-  m_converterdata.input_frames = nrframes;
-  m_converterdata.output_frames = m_buffersize - m_bufferfill - m_converterdata.input_frames;
+  int outputframes = m_buffersize - m_bufferfill - nrframes;
   //output buffer starts at the place where the buffer doesn't hold samples
-  m_converterdata.data_out = m_buffer + m_bufferfill * m_nrchannels;
+  float* dataout = m_buffer + m_bufferfill * m_nrchannels;
   //intput buffer is a block of data at the end of the buffer
-  m_converterdata.data_in = m_converterdata.data_out + m_converterdata.output_frames * m_nrchannels;
+  float* datain  = dataout + outputframes * m_nrchannels;
 
   //add samples to the resample input buffer
   int16_t* inputptr  = (int16_t*)audioframe.data;
-  float*   outputptr = m_converterdata.data_in;
+  float*   outputptr = datain;
 
   for (int i = 0; i < nrframes * m_nrchannels; i++)
     *outputptr++ = (float)*inputptr++ / scale;
 
-  //resample
-  m_converterdata.src_ratio = m_ratio;
-  src_set_ratio(m_converter, m_ratio);
-  src_process(m_converter, &m_converterdata);
+  //resample, a changed ratio is ramped in by the resampler
+  if (m_ratio != m_resampler.GetRatio())
+    m_resampler.SetRatio(m_ratio);
+
+  unsigned int used;
+  int generated = m_resampler.Resample(datain, nrframes, used, dataout, outputframes);
 
   //calculate a pts for each sample
-  for (int i = 0; i < m_converterdata.output_frames_gen; i++)
+  for (int i = 0; i < generated; i++)
   {
-    m_ptsbuffer[m_bufferfill] = pts + i * (audioframe.duration / (double)m_converterdata.output_frames_gen);
+    m_ptsbuffer[m_bufferfill] = pts + i * (audioframe.duration / (double)generated);
     m_bufferfill++;
   }
 }
@@ -128,13 +120,12 @@ bool CDVDPlayerResampler::Retrieve(DVDAudioFrame &audioframe, double &pts)
 
 void CDVDPlayerResampler::CheckResampleBuffers(int channels)
 {
-  int error;
   if (channels != m_nrchannels)
   {
     Clean();
 
     m_nrchannels = channels;
-    m_converter = src_new(m_quality, m_nrchannels, &error);
+    m_resampler.Initialize(m_nrchannels, m_ratio, m_quality);
   }
 }
 
@@ -175,19 +166,19 @@ void CDVDPlayerResampler::SetRatio(double ratio)
 void CDVDPlayerResampler::Flush()
 {
   m_bufferfill = 0;
+  m_resampler.Reset();
 }
 
 void CDVDPlayerResampler::SetQuality(int quality)
 {
-  int qualitylookup[] = {SRC_LINEAR, SRC_SINC_FASTEST, SRC_SINC_MEDIUM_QUALITY, SRC_SINC_BEST_QUALITY};
+  CAEResample::Quality qualitylookup[] = {CAEResample::QUALITY_LOW, CAEResample::QUALITY_FAST, CAEResample::QUALITY_MEDIUM, CAEResample::QUALITY_HIGH};
   m_quality = qualitylookup[Clamp(quality, 0, 3)];
   Clean();
 }
 
 void CDVDPlayerResampler::Clean()
 {
-  if (m_converter) src_delete(m_converter);
-  m_converter = NULL;
+  m_resampler.Deinitialize();
 
   free(m_buffer);
   m_buffer = NULL;
@@ -198,7 +189,5 @@ void CDVDPlayerResampler::Clean()
   m_buffersize = 0;
 
   m_nrchannels = -1;
-  m_converterdata.end_of_input = 0;
-  m_converterdata.src_ratio = 1.0;
   m_ratio = 1.0;
 }
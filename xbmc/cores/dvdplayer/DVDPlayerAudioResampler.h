@@ -19,7 +19,7 @@
  */
 #pragma once
 
-#include <samplerate.h>
+#include "cores/AudioEngine/Utils/AEResample.h"
 
 #define MAXRATIO 30
 
@@ -48,9 +48,8 @@ class CDVDPlayerResampler
   private:
 
     int        m_nrchannels;
-    int        m_quality;
-    SRC_STATE* m_converter;
-    SRC_DATA   m_converterdata;
+    CAEResample::Quality m_quality;
+    CAEResample m_resampler;
     double     m_ratio;
 
     float*     m_buffer;     //buffer for the audioframes
@@ -32,6 +32,8 @@
 #include "DVDCodecs/DVDCodecs.h"
 #include "DVDCodecs/DVDFactoryCodec.h"
 #include "DVDDemuxers/DVDDemuxUtils.h"
+#include "DVDPerformanceCounter.h"
+#include "utils/TimeUtils.h"
 #include "utils/log.h"
 #include "threads/SingleLock.h"
 #ifdef _LINUX
@@ -72,7 +74,9 @@ void CDVDPlayerSubtitle::SendMessage(CDVDMsg* pMsg)
 
     if (m_pOverlayCodec)
     {
+      int64_t decodeStart = CurrentHostCounter();
       int result = m_pOverlayCodec->Decode(pPacket);
+      g_dvdPerformanceCounter.AddDecodeTime(DVDPERF_SUBTITLE, CurrentHostCounter() - decodeStart);
 
       if(result == OC_OVERLAY)
       {
@@ -83,6 +87,7 @@ void CDVDPlayerSubtitle::SendMessage(CDVDMsg* pMsg)
           overlay->iGroupId = pPacket->iGroupId;
           m_pOverlayContainer->Add(overlay);
           overlay->Release();
+          g_dvdPerformanceCounter.AddFrame(DVDPERF_SUBTITLE);
         }
       }
     }
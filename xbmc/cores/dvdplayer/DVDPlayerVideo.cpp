@@ -37,6 +37,7 @@
 #include "DVDDemuxers/DVDDemuxUtils.h"
 #include "DVDOverlayRenderer.h"
 #include "DVDPerformanceCounter.h"
+#include "utils/TimeUtils.h"
 #include "DVDCodecs/DVDCodecs.h"
 #include "DVDCodecs/Overlay/DVDOverlayCodecCC.h"
 #include "DVDCodecs/Overlay/DVDOverlaySSA.h"
@@ -142,6 +143,7 @@ CDVDPlayerVideo::CDVDPlayerVideo( CDVDClock* pClock
   m_FlipTimeStamp = 0.0;
   m_iLateFrames = 0;
   m_iDroppedRequest = 0;
+  m_iDecoderDelay = 0;
   m_fForcedAspectRatio = 0;
   m_iNrOfPicturesNotToSkip = 0;
   m_messageQueue.SetMaxDataSize(40 * 1024 * 1024);
@@ -174,7 +176,8 @@ CDVDPlayerVideo::~CDVDPlayerVideo()
 
 double CDVDPlayerVideo::GetOutputDelay()
 {
-    double time = m_messageQueue.GetPacketCount(CDVDMsg::DEMUXER_PACKET);
+    // packets wait in the queue, and then in the decoder for as many packets
+    double time = m_messageQueue.GetPacketCount(CDVDMsg::DEMUXER_PACKET) + m_iDecoderDelay;
     if( m_fFrameRate )
       time = (time * DVD_TIME_BASE) / m_fFrameRate;
     else
@@ -240,6 +243,7 @@ void CDVDPlayerVideo::OpenStream(CDVDStreamInfo &hint, CDVDVideoCodec* codec)
 
   m_iDroppedRequest = 0;
   m_iLateFrames = 0;
+  m_iDecoderDelay = 0;
   m_autosync = 1;
 
   if( m_fFrameRate > 100 || m_fFrameRate < 5 )
@@ -557,7 +561,10 @@ void CDVDPlayerVideo::Process()
 
       mFilters = m_pVideoCodec->SetFilters(mFilters);
 
+      int64_t decodeStart = CurrentHostCounter();
       int iDecoderState = m_pVideoCodec->Decode(pPacket->pData, pPacket->iSize, pPacket->dts, pPacket->pts);
+      g_dvdPerformanceCounter.AddDecodeTime(DVDPERF_VIDEO, CurrentHostCounter() - decodeStart);
+      m_iDecoderDelay   = m_pVideoCodec->GetDelayFrames();
 
       // buffer packets so we can recover should decoder flush for some reason
       if(m_pVideoCodec->GetConvergeCount() > 0)
@@ -577,6 +584,7 @@ void CDVDPlayerVideo::Process()
       {
         m_iDroppedFrames++;
         iDropped++;
+        g_dvdPerformanceCounter.AddDropped(DVDPERF_VIDEO);
       }
 
       // loop while no error
@@ -734,10 +742,14 @@ void CDVDPlayerVideo::Process()
             {
               m_iDroppedFrames++;
               iDropped++;
+              g_dvdPerformanceCounter.AddDropped(DVDPERF_VIDEO);
             }
             else
               iDropped = 0;
 
+            if( !(iResult & EOS_DROPPED) )
+              g_dvdPerformanceCounter.AddFrame(DVDPERF_VIDEO);
+
             bRequestDrop = (iResult & EOS_VERYLATE) == EOS_VERYLATE;
           }
           else
@@ -1253,7 +1265,10 @@ int CDVDPlayerVideo::OutputPicture(const DVDVideoPicture* src, double pts)
   m_FlipTimeStamp += iFrameDuration;
 
   if (iSleepTime <= 0 && m_speed)
+  {
     m_iLateFrames++;
+    g_dvdPerformanceCounter.AddLate(DVDPERF_VIDEO);
+  }
   else
     m_iLateFrames = 0;
 
@@ -1272,7 +1287,8 @@ int CDVDPlayerVideo::OutputPicture(const DVDVideoPicture* src, double pts)
 
       //if we requested 5 drops in a row and we're still late, drop on output
       //this keeps a/v sync if the decoder can't drop, or we're still calculating the framerate
-      if (m_iDroppedRequest > 5)
+      //the decoder only drops once the pictures it holds are out, so allow for those too
+      if (m_iDroppedRequest > 5 + m_iDecoderDelay)
       {
         m_iDroppedRequest--; //decrease so we only drop half the frames
         return result | EOS_DROPPED;
@@ -1540,6 +1556,8 @@ std::string CDVDPlayerVideo::GetPlayerInfo()
   s << ", dc:"   << m_codecname;
   s << ", Mb/s:" << fixed << setprecision(2) << (double)GetVideoBitrate() / (1024.0*1024.0);
   s << ", drop:" << m_iDroppedFrames;
+  if (m_iDecoderDelay > 0)
+    s << ", dd:" << m_iDecoderDelay;
 
   int pc = m_pullupCorrection.GetPatternLength();
   if (pc > 0)
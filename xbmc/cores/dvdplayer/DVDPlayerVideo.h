@@ -132,6 +132,7 @@ protected:
   int m_iLateFrames;
   int m_iDroppedFrames;
   int m_iDroppedRequest;
+  int m_iDecoderDelay; // packets the codec holds before it returns their picture
 
   void   ResetFrameRateCalc();
   void   CalcFrameRate();
@@ -18,17 +18,19 @@
  *
  */
 
+
 #include "DVDSubtitleLineCollection.h"
 #include "DVDClock.h"
 
+#include <algorithm>
+
+// overlays starting further ahead than this are not handed out yet
+#define SUBTITLE_LOOKAHEAD DVD_SEC_TO_TIME(10)
 
 CDVDSubtitleLineCollection::CDVDSubtitleLineCollection()
 {
-  m_pHead = NULL;
-  m_pCurrent = NULL;
-  m_pTail = NULL;
-
-  m_iSize = 0;
+  m_current = 0;
+  m_sorted = true;
 }
 
 CDVDSubtitleLineCollection::~CDVDSubtitleLineCollection()
@@ -38,85 +40,68 @@ CDVDSubtitleLineCollection::~CDVDSubtitleLineCollection()
 
 void CDVDSubtitleLineCollection::Add(CDVDOverlay* pOverlay)
 {
-  ListElement* pElement = new ListElement;
-  pElement->pOverlay = pOverlay;
-  pElement->pNext = NULL;
-
-  if (!m_pHead)
-  {
-    m_pHead = m_pTail = pElement;
-    m_pCurrent = m_pHead;
-  }
-  else
-  {
-    m_pTail->pNext = pElement;
-    m_pTail = pElement;
-  }
+  m_overlays.push_back(pOverlay);
+  m_sorted = false;
+}
 
-  m_iSize++;
+bool CDVDSubtitleLineCollection::CompareStart(const CDVDOverlay* p1, const CDVDOverlay* p2)
+{
+  return p1->iPTSStartTime < p2->iPTSStartTime;
 }
 
 void CDVDSubtitleLineCollection::Sort()
 {
-  if (!m_pHead || !m_pHead->pNext)
-    return;
-  
-  for (ListElement* p1 = m_pHead; p1->pNext->pNext != NULL; p1 = p1->pNext)
+  std::stable_sort(m_overlays.begin(), m_overlays.end(), CompareStart);
+
+  m_maxStop.resize(m_overlays.size());
+  for (unsigned int i = 0; i < m_overlays.size(); i++)
   {
-    for (ListElement* p2 = p1->pNext; p2->pNext != NULL; p2 = p2->pNext)
-    {
-      if (p1->pOverlay->iPTSStartTime > p2->pOverlay->iPTSStartTime)
-      {
-        CDVDOverlay* temp = p1->pOverlay;
-        p1->pOverlay = p2->pOverlay;
-        p2->pOverlay = temp;
-      }
-    }
+    m_maxStop[i] = m_overlays[i]->iPTSStopTime;
+    if (i > 0 && m_maxStop[i - 1] > m_maxStop[i])
+      m_maxStop[i] = m_maxStop[i - 1];
   }
+
+  m_current = 0;
+  m_sorted = true;
 }
 
 CDVDOverlay* CDVDSubtitleLineCollection::Get(double iPts)
 {
-  CDVDOverlay* pOverlay = NULL;
+  // parsers may still set the stop time of an overlay after adding it,
+  // so the index is built on the first lookup
+  if (!m_sorted)
+    Sort();
 
-  if (m_pCurrent)
-  {
-    while (m_pCurrent && m_pCurrent->pOverlay->iPTSStopTime < iPts)
-    {
-      m_pCurrent = m_pCurrent->pNext;
-    }
-
-    if (m_pCurrent)
-    {
-      pOverlay = m_pCurrent->pOverlay;
-
-      // advance to the next overlay
-      m_pCurrent = m_pCurrent->pNext;
-    }
-  }
-  return pOverlay;
+  // all overlays before the first with a max stop time past iPts have ended
+  unsigned int first = std::lower_bound(m_maxStop.begin(), m_maxStop.end(), iPts) - m_maxStop.begin();
+  if (m_current < first)
+    m_current = first;
+
+  while (m_current < m_overlays.size() && m_overlays[m_current]->iPTSStopTime < iPts)
+    m_current++;
+
+  if (m_current >= m_overlays.size())
+    return NULL;
+
+  if (m_overlays[m_current]->iPTSStartTime > iPts + SUBTITLE_LOOKAHEAD)
+    return NULL;
+
+  // advance to the next overlay
+  return m_overlays[m_current++];
 }
 
 void CDVDSubtitleLineCollection::Reset()
 {
-  m_pCurrent = m_pHead;
+  m_current = 0;
 }
 
 void CDVDSubtitleLineCollection::Clear()
 {
-  ListElement* pElement = NULL;
-
-  while (m_pHead)
-  {
-    pElement = m_pHead;
-    m_pHead = pElement->pNext;
-
-    pElement->pOverlay->Release();
-    delete pElement;
-  }
+  for (unsigned int i = 0; i < m_overlays.size(); i++)
+    m_overlays[i]->Release();
 
-  m_pTail    = NULL;
-  m_pHead    = NULL;
-  m_pCurrent = NULL;
-  m_iSize    = 0;
+  m_overlays.clear();
+  m_maxStop.clear();
+  m_current = 0;
+  m_sorted  = true;
 }
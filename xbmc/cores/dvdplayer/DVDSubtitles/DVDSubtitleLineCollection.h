@@ -22,39 +22,41 @@
 
 #include "../DVDCodecs/Overlay/DVDOverlay.h"
 
-typedef struct stListElement
-{
-  CDVDOverlay* pOverlay;
-  struct stListElement* pNext;
-
-} ListElement;
+#include <vector>
 
+/**
+ * The overlays of a subtitle file, ordered by start time. Overlays may
+ * overlap, the highest stop time up to each overlay is kept alongside so
+ * the first one still showing at a pts is found by binary search.
+ */
 class CDVDSubtitleLineCollection
 {
 public:
   CDVDSubtitleLineCollection();
   virtual ~CDVDSubtitleLineCollection();
 
-  //void Lock()   { EnterCriticalSection(&m_critSection); }
-  //void Unlock() { LeaveCriticalSection(&m_critSection); }
-
   void Add(CDVDOverlay* pSubtitle);
+
+  /**
+   * Order and index what was added, done by Get if it was not
+   */
   void Sort();
 
-  CDVDOverlay* Get(double iPts = 0LL); // get the first overlay in this fifo
+  /**
+   * The next overlay that is still showing at iPts, or starts shortly after
+   */
+  CDVDOverlay* Get(double iPts = 0LL);
 
   void Reset();
 
-  void Remove();
   void Clear();
-  int GetSize() { return m_iSize; }
+  int GetSize() { return (int)m_overlays.size(); }
 
 private:
-  ListElement* m_pHead;
-  ListElement* m_pCurrent;
-  ListElement* m_pTail;
+  static bool CompareStart(const CDVDOverlay* p1, const CDVDOverlay* p2);
 
-  int m_iSize;
-  //CRITICAL_SECTION m_critSection;
+  std::vector<CDVDOverlay*> m_overlays;
+  std::vector<double>       m_maxStop;  // highest stop time of m_overlays[0..i]
+  unsigned int              m_current;
+  bool                      m_sorted;
 };
-
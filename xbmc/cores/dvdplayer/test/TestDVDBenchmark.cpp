@@ -0,0 +1,49 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/dvdplayer/DVDBenchmark.h"
+#include "test/TestUtils.h"
+
+#include <iostream>
+
+#include "gtest/gtest.h"
+
+/* Run with the files to measure, for example
+ *   xbmc-test --gtest_filter=TestDVDBenchmark.* --add-dvdbenchmark-file /media/sample.mkv
+ */
+TEST(TestDVDBenchmark, Variants)
+{
+  std::vector<CStdString> files = CXBMCTestUtils::Instance().getDVDBenchmarkFiles();
+  std::vector<CDVDBenchmark::Variant> variants = CDVDBenchmark::GetDefaultVariants();
+
+  std::vector<CStdString>::iterator it;
+  for (it = files.begin(); it < files.end(); it++)
+  {
+    std::cout << "Benchmarking: " << *it << std::endl;
+    for (unsigned int i = 0; i < variants.size(); i++)
+    {
+      CDVDBenchmark::Result result;
+      EXPECT_TRUE(CDVDBenchmark::Run(*it, variants[i], result)) << variants[i].name;
+      EXPECT_EQ(0U, result.errors) << variants[i].name;
+      EXPECT_LT(0U, result.packets) << variants[i].name;
+      std::cout << CDVDBenchmark::Format(result) << std::endl;
+    }
+  }
+}
@@ -0,0 +1,219 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/dvdplayer/DVDMessageQueue.h"
+#include "cores/dvdplayer/DVDDemuxers/DVDDemuxUtils.h"
+#include "cores/dvdplayer/DVDClock.h"
+#include "threads/SystemClock.h"
+#include "threads/Thread.h"
+
+#include "gtest/gtest.h"
+
+static CDVDMsg* CreatePacket(int size, double pts)
+{
+  DemuxPacket *packet = CDVDDemuxUtils::AllocateDemuxPacket(size);
+  packet->iSize = size;
+  packet->pts   = pts;
+  return new CDVDMsgDemuxerPacket(packet);
+}
+
+static double GetPts(CDVDMsg *msg)
+{
+  return ((CDVDMsgDemuxerPacket*)msg)->GetPacket()->pts;
+}
+
+TEST(TestDVDMessageQueue, Order)
+{
+  CDVDMessageQueue queue("test");
+  queue.Init();
+
+  CDVDMsg *msg;
+  int priority;
+
+  queue.Put(CreatePacket(100, 1 * DVD_TIME_BASE));
+  queue.Put(CreatePacket(100, 2 * DVD_TIME_BASE));
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_RESYNC), -1);
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_FLUSH), 1);
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_EOF), 2);
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_RESET), 1);
+  EXPECT_EQ(200, queue.GetDataSize());
+  EXPECT_EQ(2U, queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+
+  /* higher priority first, in order within a priority */
+  priority = 0;
+  ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0, priority));
+  EXPECT_TRUE(msg->IsType(CDVDMsg::GENERAL_EOF));
+  EXPECT_EQ(2, priority);
+  msg->Release();
+
+  /* asking for priority only skips the packets */
+  priority = 1;
+  ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0, priority));
+  EXPECT_TRUE(msg->IsType(CDVDMsg::GENERAL_FLUSH));
+  msg->Release();
+  ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0, priority));
+  EXPECT_TRUE(msg->IsType(CDVDMsg::GENERAL_RESET));
+  msg->Release();
+  EXPECT_EQ(MSGQ_TIMEOUT, queue.Get(&msg, 0, priority));
+
+  ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0));
+  EXPECT_EQ(1 * DVD_TIME_BASE, GetPts(msg));
+  msg->Release();
+  ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0));
+  EXPECT_EQ(2 * DVD_TIME_BASE, GetPts(msg));
+  msg->Release();
+  EXPECT_EQ(0, queue.GetDataSize());
+
+  /* negative priorities wait for a request that allows them */
+  EXPECT_EQ(MSGQ_TIMEOUT, queue.Get(&msg, 0));
+  priority = -1;
+  ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0, priority));
+  EXPECT_TRUE(msg->IsType(CDVDMsg::GENERAL_RESYNC));
+  msg->Release();
+
+  queue.End();
+}
+
+TEST(TestDVDMessageQueue, Grow)
+{
+  CDVDMessageQueue queue("test");
+  queue.Init();
+  queue.SetMaxDataSize(100000000);
+
+  /* wrap the ring before it has to grow */
+  CDVDMsg *msg;
+  for (int i = 0; i < MSGQ_RING_SIZE / 2; ++i)
+  {
+    queue.Put(CreatePacket(10, i));
+    ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0));
+    msg->Release();
+  }
+
+  const int count = MSGQ_RING_SIZE * 3 + 7;
+  for (int i = 0; i < count; ++i)
+    queue.Put(CreatePacket(10, i));
+  EXPECT_EQ(count * 10, queue.GetDataSize());
+  EXPECT_EQ((unsigned)count, queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+
+  for (int i = 0; i < count; ++i)
+  {
+    ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0));
+    EXPECT_EQ(i, GetPts(msg));
+    msg->Release();
+  }
+  queue.End();
+}
+
+TEST(TestDVDMessageQueue, Flush)
+{
+  CDVDMessageQueue queue("test");
+  queue.Init();
+
+  for (int i = 0; i < 10; ++i)
+  {
+    queue.Put(CreatePacket(10, i));
+    if (i % 3 == 0)
+      queue.Put(new CDVDMsg(CDVDMsg::GENERAL_RESYNC));
+  }
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_FLUSH), 1);
+
+  /* only the packets go, the rest keeps its order */
+  queue.Flush();
+  EXPECT_EQ(0, queue.GetDataSize());
+  EXPECT_EQ(0U, queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+  EXPECT_EQ(4U, queue.GetPacketCount(CDVDMsg::GENERAL_RESYNC));
+  EXPECT_EQ(1U, queue.GetPacketCount(CDVDMsg::GENERAL_FLUSH));
+
+  queue.Flush(CDVDMsg::NONE);
+  EXPECT_EQ(0U, queue.GetPacketCount(CDVDMsg::GENERAL_RESYNC));
+  EXPECT_EQ(0U, queue.GetPacketCount(CDVDMsg::GENERAL_FLUSH));
+
+  /* the ring still works after being compacted */
+  CDVDMsg *msg;
+  queue.Put(CreatePacket(10, 42));
+  ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0));
+  EXPECT_EQ(42, GetPts(msg));
+  msg->Release();
+  queue.End();
+}
+
+TEST(TestDVDMessageQueue, Latency)
+{
+  CDVDMessageQueue queue("test");
+  queue.Init();
+
+  CDVDMsg *msg;
+  for (int i = 0; i < 5; ++i)
+  {
+    queue.Put(CreatePacket(10, i));
+    ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0));
+    msg->Release();
+  }
+  EXPECT_EQ(MSGQ_TIMEOUT, queue.Get(&msg, 10));
+
+  MsgQueueLatency latency;
+  queue.GetLatency(latency);
+  EXPECT_EQ(5U, latency.count);
+  unsigned int total = 0;
+  for (int i = 0; i < MSGQ_LATENCY_BUCKETS; ++i)
+    total += latency.buckets[i];
+  EXPECT_EQ(5U, total);
+  EXPECT_LE(0.0, latency.max);
+
+  queue.ResetLatency();
+  queue.GetLatency(latency);
+  EXPECT_EQ(0U, latency.count);
+  queue.End();
+}
+
+class CDelayedPutThread : public CThread
+{
+public:
+  CDelayedPutThread(CDVDMessageQueue &queue) : CThread("DelayedPut"), m_queue(queue) {}
+
+protected:
+  virtual void Process()
+  {
+    Sleep(50);
+    m_queue.Put(CreatePacket(10, 7));
+  }
+
+private:
+  CDVDMessageQueue &m_queue;
+};
+
+TEST(TestDVDMessageQueue, Wait)
+{
+  /* a waiting Get is woken by the Put */
+  CDVDMessageQueue  queue("test");
+  CDelayedPutThread thread(queue);
+  queue.Init();
+  thread.Create();
+
+  CDVDMsg *msg;
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 5000));
+  EXPECT_GT(2000U, XbmcThreads::SystemClockMillis() - start);
+  EXPECT_EQ(7, GetPts(msg));
+  msg->Release();
+
+  thread.StopThread();
+  queue.End();
+}
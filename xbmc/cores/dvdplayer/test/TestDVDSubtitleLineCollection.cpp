@@ -0,0 +1,91 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/dvdplayer/DVDSubtitles/DVDSubtitleLineCollection.h"
+#include "cores/dvdplayer/DVDClock.h"
+
+#include "gtest/gtest.h"
+
+static CDVDOverlay* CreateOverlay(int start, int stop)
+{
+  CDVDOverlay* pOverlay = new CDVDOverlay(DVDOVERLAY_TYPE_TEXT);
+  pOverlay->iPTSStartTime = DVD_MSEC_TO_TIME(start);
+  pOverlay->iPTSStopTime  = DVD_MSEC_TO_TIME(stop);
+  return pOverlay;
+}
+
+TEST(TestDVDSubtitleLineCollection, Get)
+{
+  CDVDSubtitleLineCollection collection;
+  /* added out of order, the second overlaps the two after it */
+  collection.Add(CreateOverlay(1000, 2000));
+  collection.Add(CreateOverlay(7000, 8000));
+  collection.Add(CreateOverlay(3000, 9000));
+  collection.Add(CreateOverlay(4000, 5000));
+  collection.Add(CreateOverlay(5000, 6000));
+  EXPECT_EQ(5, collection.GetSize());
+
+  /* 1000-2000 has ended, 3000-9000 is showing */
+  CDVDOverlay* pOverlay = collection.Get(DVD_MSEC_TO_TIME(3500));
+  ASSERT_TRUE(pOverlay);
+  EXPECT_EQ(DVD_MSEC_TO_TIME(3000), pOverlay->iPTSStartTime);
+
+  pOverlay = collection.Get(DVD_MSEC_TO_TIME(3500));
+  ASSERT_TRUE(pOverlay);
+  EXPECT_EQ(DVD_MSEC_TO_TIME(4000), pOverlay->iPTSStartTime);
+
+  /* the long one is not handed out again */
+  pOverlay = collection.Get(DVD_MSEC_TO_TIME(5500));
+  ASSERT_TRUE(pOverlay);
+  EXPECT_EQ(DVD_MSEC_TO_TIME(5000), pOverlay->iPTSStartTime);
+
+  pOverlay = collection.Get(DVD_MSEC_TO_TIME(5500));
+  ASSERT_TRUE(pOverlay);
+  EXPECT_EQ(DVD_MSEC_TO_TIME(7000), pOverlay->iPTSStartTime);
+
+  EXPECT_FALSE(collection.Get(DVD_MSEC_TO_TIME(5500)));
+
+  /* after a seek back everything still showing is handed out again */
+  collection.Reset();
+  pOverlay = collection.Get(DVD_MSEC_TO_TIME(8500));
+  ASSERT_TRUE(pOverlay);
+  EXPECT_EQ(DVD_MSEC_TO_TIME(3000), pOverlay->iPTSStartTime);
+  EXPECT_FALSE(collection.Get(DVD_MSEC_TO_TIME(8500)));
+
+  collection.Clear();
+  EXPECT_EQ(0, collection.GetSize());
+  EXPECT_FALSE(collection.Get(0));
+}
+
+TEST(TestDVDSubtitleLineCollection, Lookahead)
+{
+  CDVDSubtitleLineCollection collection;
+  collection.Add(CreateOverlay(1000, 2000));
+  collection.Add(CreateOverlay(60000, 61000));
+  collection.Sort();
+
+  ASSERT_TRUE(collection.Get(0));
+  /* too far ahead to hand out yet */
+  EXPECT_FALSE(collection.Get(0));
+
+  CDVDOverlay* pOverlay = collection.Get(DVD_MSEC_TO_TIME(59000));
+  ASSERT_TRUE(pOverlay);
+  EXPECT_EQ(DVD_MSEC_TO_TIME(60000), pOverlay->iPTSStartTime);
+}
@@ -64,7 +64,7 @@ void CAudioDecoder::Destroy()
   m_canPlay = false;
 }
 
-bool CAudioDecoder::Create(const CFileItem &file, int64_t seekOffset)
+bool CAudioDecoder::Create(const CFileItem &file, int64_t seekOffset, unsigned int bufferSeconds)
 {
   Destroy();
 
@@ -100,13 +100,26 @@ bool CAudioDecoder::Create(const CFileItem &file, int64_t seekOffset)
     return false;
   }
 
-  /* allocate the pcmBuffer for 2 seconds of audio */
-  m_pcmBuffer.Create(2 * blockSize * m_codec->m_SampleRate);
+  /* allocate the pcmBuffer for bufferSeconds of audio, but no less than the default */
+  unsigned int bufferSize = std::max(bufferSeconds, (unsigned int)PCM_BUFFER_SECONDS) * blockSize * m_codec->m_SampleRate;
+  bufferSize = std::min(bufferSize, std::max((unsigned int)PCM_BUFFER_MAX, PCM_BUFFER_SECONDS * blockSize * m_codec->m_SampleRate));
+  m_pcmBuffer.Create(bufferSize);
 
   // set total time from the given tag
   if (file.HasMusicInfoTag() && file.GetMusicInfoTag()->GetDuration())
     m_codec->SetTotalTime(file.GetMusicInfoTag()->GetDuration());
 
+  // without ReplayGain tags use the gain from the loudness measured into the library
+  if (file.HasMusicInfoTag() && !(m_codec->m_tag.HasReplayGainInfo() & REPLAY_GAIN_HAS_TRACK_INFO))
+  {
+    const MUSIC_INFO::CMusicInfoTag &tag = *file.GetMusicInfoTag();
+    if (tag.HasReplayGainInfo() & REPLAY_GAIN_HAS_TRACK_INFO)
+    {
+      m_codec->m_tag.SetReplayGainTrackGain(tag.GetReplayGainTrackGain());
+      m_codec->m_tag.SetReplayGainTrackPeak(tag.GetReplayGainTrackPeak());
+    }
+  }
+
   if (seekOffset)
     m_codec->Seek(seekOffset);
 
@@ -153,6 +166,22 @@ unsigned int CAudioDecoder::GetDataSize()
   return std::min(m_pcmBuffer.getMaxReadSize() / (m_codec->m_BitsPerSample >> 3), (unsigned int)OUTPUT_SAMPLES);
 }
 
+unsigned int CAudioDecoder::GetBufferedMS()
+{
+  CSingleLock lock(m_critSection);
+  if (!m_codec)
+    return 0;
+  unsigned int bytesPerSecond = (m_codec->m_BitsPerSample >> 3) * m_codec->GetChannelInfo().Count() * m_codec->m_SampleRate;
+  if (bytesPerSecond == 0)
+    return 0;
+  return (unsigned int)((uint64_t)m_pcmBuffer.getMaxReadSize() * 1000 / bytesPerSecond);
+}
+
+bool CAudioDecoder::IsBufferFull()
+{
+  return m_pcmBuffer.getMaxWriteSize() < PACKET_SIZE;
+}
+
 void *CAudioDecoder::GetData(unsigned int samples)
 {
   unsigned int size  = samples * (m_codec->m_BitsPerSample >> 3);
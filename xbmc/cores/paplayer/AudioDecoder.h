@@ -38,6 +38,9 @@ class CFileItem;
 #define OUTPUT_SAMPLES PACKET_SIZE      // max number of output samples
 #define INPUT_SAMPLES  PACKET_SIZE      // number of input samples (distributed over channels)
 
+#define PCM_BUFFER_SECONDS 2            // default length of the decoded pcm buffer
+#define PCM_BUFFER_MAX (32 * 1024 * 1024) // upper limit of the pcm buffer size, for decode ahead of hi-res files
+
 #define STATUS_NO_FILE  0
 #define STATUS_QUEUING  1
 #define STATUS_QUEUED   2
@@ -68,7 +71,7 @@ public:
 
   static ReplayGainSettings& GetReplayGainSettings() { return m_replayGainSettings; }
 
-  bool Create(const CFileItem &file, int64_t seekOffset);
+  bool Create(const CFileItem &file, int64_t seekOffset, unsigned int bufferSeconds = PCM_BUFFER_SECONDS);
   void Destroy();
 
   int ReadSamples(int numsamples);
@@ -84,6 +87,9 @@ public:
   unsigned int GetChannels() { if (m_codec) return m_codec->GetChannelInfo().Count(); else return 0; };
   // Data management
   unsigned int GetDataSize();
+  // the decoded data waiting in the pcm buffer in ms, and whether the buffer has room for another packet
+  unsigned int GetBufferedMS();
+  bool IsBufferFull();
   void *GetData(unsigned int samples);
   ICodec *GetCodec() const { return m_codec; }
   float GetReplayGain();
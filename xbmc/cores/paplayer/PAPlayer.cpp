@@ -28,6 +28,7 @@
 #include "utils/TimeUtils.h"
 #include "utils/log.h"
 #include "utils/MathUtils.h"
+#include "utils/JobManager.h"
 
 #include "threads/SingleLock.h"
 #include "cores/AudioEngine/AEFactory.h"
@@ -59,7 +60,13 @@ PAPlayer::PAPlayer(IPlayerCallback& callback) :
   m_upcomingCrossfadeMS(0),
   m_currentStream      (NULL ),
   m_audioCallback      (NULL ),
-  m_FileItem           (new CFileItem())
+  m_FileItem           (new CFileItem()),
+  m_decodeAheadJob     (0    ),
+  m_decodeAheadStream  (NULL ),
+  m_decodeAheadFile    (NULL ),
+  m_decodeAheadFailed  (false),
+  m_decodeAheadReady   (0    ),
+  m_decodeAheadLate    (0    )
 {
   memset(&m_playerGUIData, 0, sizeof(m_playerGUIData));
 }
@@ -224,6 +231,9 @@ void PAPlayer::CloseAllStreams(bool fade/* = true */)
 
 bool PAPlayer::OpenFile(const CFileItem& file, const CPlayerOptions &options)
 {
+  /* the file being decoded ahead is not the one we have been asked to play */
+  CancelDecodeAhead();
+
   m_defaultCrossfadeMS = g_guiSettings.GetInt("musicplayer.crossfade") * 1000;
 
   if (m_streams.size() > 1 || !m_defaultCrossfadeMS || m_isPaused)
@@ -282,23 +292,43 @@ void PAPlayer::UpdateCrossfadeTime(const CFileItem& file)
 
 bool PAPlayer::QueueNextFile(const CFileItem &file)
 {
-  return QueueNextFileEx(file);
+  /* without decode ahead, or if nothing is playing, open the file right away */
+  if (!g_advancedSettings.m_audioDecodeAheadSeconds || !IsRunning())
+    return QueueNextFileEx(file);
+
+  CancelDecodeAhead();
+
+  CSingleLock lock(m_decodeAheadSection);
+  m_decodeAheadJob = CJobManager::GetInstance().AddJob(new CDecodeAheadJob(file, g_advancedSettings.m_audioDecodeAheadSeconds), this, CJob::PRIORITY_NORMAL);
+  CLog::Log(LOGDEBUG, "PAPlayer::QueueNextFile - Decoding %s ahead", file.GetPath().c_str());
+  return true;
 }
 
 bool PAPlayer::QueueNextFileEx(const CFileItem &file, bool fadeIn/* = true */)
+{
+  StreamInfo *si = CreateStreamInfo(file, PCM_BUFFER_SECONDS, NULL);
+  if (!si)
+  {
+    m_callback.OnQueueNextItem();
+    return false;
+  }
+
+  return AddStream(si, file, fadeIn);
+}
+
+PAPlayer::StreamInfo* PAPlayer::CreateStreamInfo(const CFileItem &file, unsigned int bufferSeconds, const CJob *job)
 {
   StreamInfo *si = new StreamInfo();
 
-  if (!si->m_decoder.Create(file, (file.m_lStartOffset * 1000) / 75))
+  if (!si->m_decoder.Create(file, (file.m_lStartOffset * 1000) / 75, bufferSeconds))
   {
-    CLog::Log(LOGWARNING, "PAPlayer::QueueNextFileEx - Failed to create the decoder");
+    CLog::Log(LOGWARNING, "PAPlayer::CreateStreamInfo - Failed to create the decoder");
 
     delete si;
-    m_callback.OnQueueNextItem();
-    return false;
+    return NULL;
   }
 
-  /* decode until there is data-available */
+  /* decode until there is data-available, that is until the pcm buffer is nearly full */
   si->m_decoder.Start();
   while(si->m_decoder.GetDataSize() == 0)
   {
@@ -307,18 +337,61 @@ bool PAPlayer::QueueNextFileEx(const CFileItem &file, bool fadeIn/* = true */)
         status == STATUS_NO_FILE ||
         si->m_decoder.ReadSamples(PACKET_SIZE) == RET_ERROR)
     {
-      CLog::Log(LOGINFO, "PAPlayer::QueueNextFileEx - Error reading samples");
+      CLog::Log(LOGINFO, "PAPlayer::CreateStreamInfo - Error reading samples");
 
       si->m_decoder.Destroy();
       delete si;
-      m_callback.OnQueueNextItem();
-      return false;
+      return NULL;
     }
 
-    /* yield our time so that the main PAP thread doesnt stall */
-    CThread::Sleep(1);
+    if (job)
+    {
+      /* the player has moved on to another file */
+      if (job->ShouldCancel(0, 0))
+      {
+        si->m_decoder.Destroy();
+        delete si;
+        return NULL;
+      }
+    }
+    else
+    {
+      /* yield our time so that the main PAP thread doesnt stall */
+      XbmcThreads::ThreadSleep(1);
+    }
   }
 
+  /* decode ahead keeps going until the buffer holds the requested seconds, is full or the file ends */
+  if (job)
+  {
+    while (si->m_decoder.GetBufferedMS() < bufferSeconds * 1000 && !si->m_decoder.IsBufferFull())
+    {
+      int status = si->m_decoder.GetStatus();
+      if (status == STATUS_ENDING || status == STATUS_ENDED)
+        break;
+
+      /* a later error is left for the player thread to hit, what was decoded is still played */
+      int ret = si->m_decoder.ReadSamples(PACKET_SIZE);
+      if (ret == RET_ERROR)
+        break;
+
+      if (job->ShouldCancel(0, 0))
+      {
+        si->m_decoder.Destroy();
+        delete si;
+        return NULL;
+      }
+
+      if (ret == RET_SLEEP)
+        XbmcThreads::ThreadSleep(1);
+    }
+  }
+
+  return si;
+}
+
+bool PAPlayer::AddStream(StreamInfo *si, const CFileItem &file, bool fadeIn)
+{
   UpdateCrossfadeTime(file);
 
   /* init the streaminfo struct */
@@ -341,9 +414,12 @@ bool PAPlayer::QueueNextFileEx(const CFileItem &file, bool fadeIn/* = true */)
   if (si->m_endOffset)
     streamTotalTime = si->m_endOffset - si->m_startOffset;
   
+  /* the decode ahead needs the next file early enough to open it and fill its buffer */
+  const int64_t cacheTime = TIME_TO_CACHE_NEXT_FILE + g_advancedSettings.m_audioDecodeAheadSeconds * 1000;
+
   si->m_prepareNextAtFrame = 0;
-  if (streamTotalTime >= TIME_TO_CACHE_NEXT_FILE + m_defaultCrossfadeMS)
-    si->m_prepareNextAtFrame = (int)((streamTotalTime - TIME_TO_CACHE_NEXT_FILE - m_defaultCrossfadeMS) * si->m_sampleRate / 1000.0f);
+  if (streamTotalTime >= cacheTime + m_defaultCrossfadeMS)
+    si->m_prepareNextAtFrame = (int)((streamTotalTime - cacheTime - m_defaultCrossfadeMS) * si->m_sampleRate / 1000.0f);
 
   si->m_prepareTriggered = false;
 
@@ -352,7 +428,7 @@ bool PAPlayer::QueueNextFileEx(const CFileItem &file, bool fadeIn/* = true */)
 
   if (!PrepareStream(si))
   {
-    CLog::Log(LOGINFO, "PAPlayer::QueueNextFileEx - Error preparing stream");
+    CLog::Log(LOGINFO, "PAPlayer::AddStream - Error preparing stream");
     
     si->m_decoder.Destroy();
     delete si;
@@ -449,9 +525,113 @@ bool PAPlayer::CloseFile()
 
   /* wait for the thread to terminate */
   StopThread(true);//true - wait for end of thread
+
+  CancelDecodeAhead();
   return true;
 }
 
+PAPlayer::CDecodeAheadJob::CDecodeAheadJob(const CFileItem &file, unsigned int seconds) :
+  m_file   (new CFileItem(file)),
+  m_si     (NULL   ),
+  m_seconds(seconds)
+{
+}
+
+PAPlayer::CDecodeAheadJob::~CDecodeAheadJob()
+{
+  /* the result was not taken, the job was cancelled */
+  if (m_si)
+  {
+    m_si->m_decoder.Destroy();
+    delete m_si;
+  }
+  delete m_file;
+}
+
+bool PAPlayer::CDecodeAheadJob::DoWork()
+{
+  m_si = CreateStreamInfo(*m_file, m_seconds, this);
+  return m_si != NULL;
+}
+
+void PAPlayer::OnJobComplete(unsigned int jobID, bool success, CJob *job)
+{
+  CSingleLock lock(m_decodeAheadSection);
+  if (jobID != m_decodeAheadJob)
+    return;
+
+  /* take the result, it is added to the streams on the player thread */
+  CDecodeAheadJob *decodeJob = (CDecodeAheadJob*)job;
+  m_decodeAheadStream = decodeJob->m_si;
+  m_decodeAheadFile   = decodeJob->m_file;
+  m_decodeAheadFailed = !success;
+  decodeJob->m_si     = NULL;
+  decodeJob->m_file   = NULL;
+  m_decodeAheadJob    = 0;
+}
+
+void PAPlayer::CancelDecodeAhead()
+{
+  CSingleLock lock(m_decodeAheadSection);
+  if (m_decodeAheadJob)
+  {
+    CJobManager::GetInstance().CancelJob(m_decodeAheadJob);
+    m_decodeAheadJob = 0;
+  }
+
+  if (m_decodeAheadStream)
+  {
+    m_decodeAheadStream->m_decoder.Destroy();
+    delete m_decodeAheadStream;
+    m_decodeAheadStream = NULL;
+  }
+
+  delete m_decodeAheadFile;
+  m_decodeAheadFile   = NULL;
+  m_decodeAheadFailed = false;
+}
+
+bool PAPlayer::ProcessDecodeAhead()
+{
+  CSingleLock lock(m_decodeAheadSection);
+  if (!m_decodeAheadFile)
+    return m_decodeAheadJob != 0;
+
+  StreamInfo *si   = m_decodeAheadStream;
+  CFileItem  *file = m_decodeAheadFile;
+  bool      failed = m_decodeAheadFailed;
+  m_decodeAheadStream = NULL;
+  m_decodeAheadFile   = NULL;
+  m_decodeAheadFailed = false;
+  lock.Leave();
+
+  if (failed)
+  {
+    CLog::Log(LOGWARNING, "PAPlayer::ProcessDecodeAhead - Failed to decode %s ahead", file->GetPath().c_str());
+    delete file;
+    m_callback.OnQueueNextItem();
+    return false;
+  }
+
+  /* in time if the current stream has not yet reached the point to start the next one */
+  bool inTime;
+  {
+    CSharedLock streamsLock(m_streamsLock);
+    inTime = m_currentStream && !m_currentStream->m_playNextTriggered;
+  }
+
+  if (inTime)
+    ++m_decodeAheadReady;
+  else
+    ++m_decodeAheadLate;
+  CLog::Log(LOGDEBUG, "PAPlayer::ProcessDecodeAhead - %s was decoded %s, %u of %u in time",
+    file->GetPath().c_str(), inTime ? "in time" : "late", m_decodeAheadReady, m_decodeAheadReady + m_decodeAheadLate);
+
+  AddStream(si, *file, true);
+  delete file;
+  return false;
+}
+
 void PAPlayer::Process()
 {
   if (!m_startEvent.WaitMSec(100))
@@ -470,6 +650,9 @@ void PAPlayer::Process()
       m_signalSpeedChange = false;
     }
 
+    /* add the next file once it has been decoded ahead */
+    bool decodingAhead = ProcessDecodeAhead();
+
     double delay  = 100.0;
     double buffer = 100.0;
     ProcessStreams(delay, buffer);
@@ -488,6 +671,8 @@ void PAPlayer::Process()
     if ((delay < buffer) && delay > watermark)
 #endif
       CThread::Sleep(MathUtils::round_int((delay - watermark) * 1000.0));
+    else if (decodingAhead && !m_currentStream)
+      CThread::Sleep(10); /* nothing to play until the decode ahead completes */
 
     GetTimeInternal(); //update for GUI
   }
@@ -910,6 +1095,11 @@ bool PAPlayer::SkipNext()
   return false;
 }
 
+void PAPlayer::GetGeneralInfo(CStdString& strGeneralInfo)
+{
+  strGeneralInfo.Format("decode ahead: %u/%u in time", m_decodeAheadReady, m_decodeAheadReady + m_decodeAheadLate);
+}
+
 void PAPlayer::UpdateGUIData(StreamInfo *si)
 {
   /* Store data need by external threads in member
@@ -26,6 +26,7 @@
 #include "threads/Thread.h"
 #include "AudioDecoder.h"
 #include "threads/SharedSection.h"
+#include "utils/Job.h"
 
 #include "cores/IAudioCallback.h"
 #include "cores/AudioEngine/Utils/AEChannelInfo.h"
@@ -33,7 +34,7 @@
 class IAEStream;
 
 class CFileItem;
-class PAPlayer : public IPlayer, public CThread
+class PAPlayer : public IPlayer, public CThread, public IJobCallback
 {
 public:
   PAPlayer(IPlayerCallback& callback);
@@ -58,7 +59,7 @@ public:
   virtual void SetDynamicRangeCompression(long drc);
   virtual void GetAudioInfo( CStdString& strAudioInfo) {}
   virtual void GetVideoInfo( CStdString& strVideoInfo) {}
-  virtual void GetGeneralInfo( CStdString& strVideoInfo) {}
+  virtual void GetGeneralInfo( CStdString& strVideoInfo);
   virtual void Update(bool bPauseDrawing = false) {}
   virtual void ToFFRW(int iSpeed = 0);
   virtual int GetCacheLevel() const;
@@ -72,6 +73,8 @@ public:
 
   static bool HandlesType(const CStdString &type);
 
+  virtual void OnJobComplete(unsigned int jobID, bool success, CJob *job);
+
   struct
   {
     char         m_codec[21];
@@ -121,6 +124,20 @@ private:
 
   typedef std::list<StreamInfo*> StreamList;
 
+  /* opens the next file and decodes its first seconds away from the player thread */
+  class CDecodeAheadJob : public CJob
+  {
+  public:
+    CDecodeAheadJob(const CFileItem &file, unsigned int seconds);
+    virtual ~CDecodeAheadJob();
+    virtual const char *GetType() const { return "paplayerdecodeahead"; }
+    virtual bool DoWork();
+
+    CFileItem   *m_file;
+    StreamInfo  *m_si;       /* the decoded stream, owned by the job until it completes */
+    unsigned int m_seconds;
+  };
+
   bool                m_signalSpeedChange;   /* true if OnPlaybackSpeedChange needs to be called */
   int                 m_playbackSpeed;       /* the playback speed (1 = normal) */
   bool                m_isPlaying;
@@ -138,7 +155,20 @@ private:
   StreamList          m_streams;             /* playing streams */  
   StreamList          m_finishing;           /* finishing streams */
 
+  /* decode ahead of the queued file, the job completes on a job worker and the result is added by Process */
+  CCriticalSection    m_decodeAheadSection;
+  unsigned int        m_decodeAheadJob;      /* the id of the running job, 0 for none */
+  StreamInfo*         m_decodeAheadStream;   /* the decoded stream waiting to be added */
+  CFileItem*          m_decodeAheadFile;     /* and its file */
+  bool                m_decodeAheadFailed;   /* the job failed to open or decode the file */
+  unsigned int        m_decodeAheadReady;    /* transitions that found the next file decoded in time */
+  unsigned int        m_decodeAheadLate;     /* transitions that had to wait for the decode ahead */
+
   bool QueueNextFileEx(const CFileItem &file, bool fadeIn = true);
+  static StreamInfo* CreateStreamInfo(const CFileItem &file, unsigned int bufferSeconds, const CJob *job);
+  bool AddStream(StreamInfo *si, const CFileItem &file, bool fadeIn);
+  bool ProcessDecodeAhead();
+  void CancelDecodeAhead();
   void SoftStart(bool wait = false);
   void SoftStop(bool wait = false, bool close = true);
   void CloseAllStreams(bool fade = true);
@@ -57,6 +57,25 @@ void CCacheStrategy::ClearEndOfInput()
   m_bEndOfInput = false;
 }
 
+void CCacheStrategy::SetSource(const CStdString& strPath, int64_t iLength, int64_t iModified)
+{
+}
+
+bool CCacheStrategy::IsStored(int64_t iSourcePosition)
+{
+  return false;
+}
+
+int CCacheStrategy::ReadFromStore(int64_t iSourcePosition, char *pBuffer, size_t iMaxSize)
+{
+  return 0;
+}
+
+int64_t CCacheStrategy::GetSourcePosition(int64_t iFilePosition)
+{
+  return iFilePosition;
+}
+
 CSimpleFileCache::CSimpleFileCache()
   : m_hCacheFileRead(NULL)
   , m_hCacheFileWrite(NULL)
@@ -30,6 +30,7 @@
 #endif
 #include "threads/CriticalSection.h"
 #include "threads/Event.h"
+#include "utils/StdString.h"
 
 namespace XFILE {
 
@@ -57,6 +58,23 @@ public:
   virtual bool IsEndOfInput();
   virtual void ClearEndOfInput();
 
+  /**
+   * The file being cached, for strategies that keep data across opens
+   */
+  virtual void SetSource(const CStdString& strPath, int64_t iLength, int64_t iModified);
+
+  /**
+   * Data of the source at iSourcePosition kept from an earlier open, to be
+   * read instead of the source, ReadFromStore returns 0 if none is kept
+   */
+  virtual bool IsStored(int64_t iSourcePosition);
+  virtual int ReadFromStore(int64_t iSourcePosition, char *pBuffer, size_t iMaxSize);
+
+  /**
+   * Where the source should be read from to get to iFilePosition
+   */
+  virtual int64_t GetSourcePosition(int64_t iFilePosition);
+
   CEvent m_space;
 protected:
   bool  m_bEndOfInput;
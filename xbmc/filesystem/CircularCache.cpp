@@ -35,6 +35,8 @@ CCircularCache::CCircularCache(size_t front, size_t back)
  , m_buf(NULL)
  , m_size(front + back)
  , m_size_back(back)
+ , m_readerWaiting(false)
+ , m_writerWaiting(false)
 #ifdef _WIN32
  , m_handle(INVALID_HANDLE_VALUE)
 #endif
@@ -61,6 +63,8 @@ int CCircularCache::Open()
   m_beg = 0;
   m_end = 0;
   m_cur = 0;
+  m_readerWaiting = false;
+  m_writerWaiting = false;
   return CACHE_RC_OK;
 }
 
@@ -116,7 +120,10 @@ int CCircularCache::WriteToCache(const char *buf, size_t len)
     len = wrap;
 
   if(len == 0)
+  {
+    m_writerWaiting = true;
     return 0;
+  }
 
   // write the data
   memcpy(m_buf + pos, buf, len);
@@ -126,7 +133,12 @@ int CCircularCache::WriteToCache(const char *buf, size_t len)
   if(m_end - m_beg > (int64_t)m_size)
     m_beg = m_end - m_size;
 
-  m_written.Set();
+  // only wake the reader when it is waiting for us
+  if(m_readerWaiting)
+  {
+    m_readerWaiting = false;
+    m_written.Set();
+  }
 
   return len;
 }
@@ -161,7 +173,12 @@ int CCircularCache::ReadFromCache(char *buf, size_t len)
   memcpy(buf, m_buf + pos, len);
   m_cur += len;
 
-  m_space.Set();
+  // only wake the writer when it found the buffer full
+  if(m_writerWaiting)
+  {
+    m_writerWaiting = false;
+    m_space.Set();
+  }
 
   return len;
 }
@@ -180,6 +197,7 @@ int64_t CCircularCache::WaitForData(unsigned int minumum, unsigned int millis)
   XbmcThreads::EndTime endtime(millis);
   while (!IsEndOfInput() && avail < minumum && !endtime.IsTimePast() )
   {
+    m_readerWaiting = true;
     lock.Leave();
     m_written.WaitMSec(50); // may miss the deadline. shouldn't be a problem.
     lock.Enter();
@@ -50,6 +50,8 @@ protected:
     uint8_t          *m_buf;       /**< buffer holding data */
     size_t            m_size;      /**< size of data buffer used (m_buf) */
     size_t            m_size_back; /**< guaranteed size of back buffer (actual size can be smaller, or larger if front buffer doesn't need it) */
+    bool              m_readerWaiting; /**< m_written is only set when someone waits for it */
+    bool              m_writerWaiting; /**< m_space is only set after a write found no room */
     CCriticalSection  m_sync;
     CEvent            m_written;
 #ifdef _WIN32
@@ -41,6 +41,7 @@
 #include "ShoutcastFile.h"
 #include "SpecialProtocol.h"
 #include "utils/CharsetConverter.h"
+#include "utils/Crc32.h"
 #include "utils/log.h"
 
 using namespace XFILE;
@@ -51,6 +52,9 @@ using namespace XCURL;
 
 #define dllselect select
 
+// bytes fetched by each connection of a segmented read
+#define CURL_SEGMENT_SIZE (1024 * 1024)
+
 
 curl_proxytype proxyType2CUrlProxyType[] = {
   CURLPROXY_HTTP,
@@ -362,6 +366,263 @@ void CCurlFile::CReadState::Disconnect()
   m_readBuffer = 0;
 }
 
+CCurlFile::CSegmentedState::CSegmentedState(CCurlFile* file, int64_t fileSize, unsigned int connections)
+{
+  m_file         = file;
+  m_filePos      = 0;
+  m_fileSize     = fileSize;
+  m_connections  = connections;
+  m_rangeIgnored = false;
+  m_failed       = false;
+  m_multiHandle  = g_curlInterface.multi_init();
+}
+
+CCurlFile::CSegmentedState::~CSegmentedState()
+{
+  Clear();
+  if (m_multiHandle)
+    g_curlInterface.multi_cleanup(m_multiHandle);
+}
+
+void CCurlFile::CSegmentedState::Clear()
+{
+  while (!m_segments.empty())
+  {
+    Stop(m_segments.front());
+    m_segments.pop_front();
+  }
+}
+
+void CCurlFile::CSegmentedState::Stop(Segment& segment)
+{
+  if (segment.running)
+    g_curlInterface.multi_remove_handle(m_multiHandle, segment.state->m_easyHandle);
+  segment.running = false;
+
+  // hands the connection back to the pool
+  delete segment.state;
+  segment.state = NULL;
+}
+
+int64_t CCurlFile::CSegmentedState::Received(const Segment& segment) const
+{
+  return segment.state->m_filePos + segment.state->m_buffer.getMaxReadSize() + segment.state->m_overflowSize;
+}
+
+void CCurlFile::CSegmentedState::Fill()
+{
+  int64_t start = m_segments.empty() ? m_filePos : m_segments.back().end;
+  CURL url(m_file->m_url);
+
+  while (m_segments.size() < m_connections && start < m_fileSize)
+  {
+    Segment segment;
+    segment.state   = new CReadState();
+    segment.end     = XMIN(start + CURL_SEGMENT_SIZE, m_fileSize);
+    segment.retries = 0;
+    segment.running = false;
+    segment.checked = false;
+
+    g_curlInterface.easy_aquire(url.GetProtocol(), url.GetHostName(), &segment.state->m_easyHandle, &segment.state->m_multiHandle);
+    m_file->SetCommonOptions(segment.state);
+    g_curlInterface.easy_setopt(segment.state->m_easyHandle, CURLOPT_URL, m_file->m_url.c_str());
+
+    // the header list is shared by all ranges still running, so it is not rebuilt
+    if (m_file->m_curlHeaderList)
+      g_curlInterface.easy_setopt(segment.state->m_easyHandle, CURLOPT_HTTPHEADER, m_file->m_curlHeaderList);
+
+    // the buffer holds the whole range so the transfer never has to wait for the reader
+    segment.state->m_filePos    = start;
+    segment.state->m_fileSize   = m_fileSize;
+    segment.state->m_bufferSize = (unsigned int)(segment.end - start);
+    segment.state->m_buffer.Create(segment.state->m_bufferSize);
+
+    Request(segment, start);
+    m_segments.push_back(segment);
+    start = segment.end;
+  }
+}
+
+void CCurlFile::CSegmentedState::Request(Segment& segment, int64_t from)
+{
+  CStdString range;
+  range.Format("%"PRId64"-%"PRId64, from, segment.end - 1);
+  g_curlInterface.easy_setopt(segment.state->m_easyHandle, CURLOPT_RANGE, range.c_str());
+
+  segment.from    = from;
+  segment.checked = false;
+  segment.state->m_headerdone = false;
+  segment.state->m_httpheader.Clear();
+
+  g_curlInterface.multi_add_handle(m_multiHandle, segment.state->m_easyHandle);
+  segment.running = true;
+}
+
+void CCurlFile::CSegmentedState::Finish(Segment& segment, int result)
+{
+  g_curlInterface.multi_remove_handle(m_multiHandle, segment.state->m_easyHandle);
+  segment.running = false;
+
+  int64_t received = Received(segment);
+  if (result == CURLE_OK && received >= segment.end)
+    return;
+
+  // refused rather than cut off, e.g. by a server allowing a single connection
+  long response = 0;
+  g_curlInterface.easy_getinfo(segment.state->m_easyHandle, CURLINFO_RESPONSE_CODE, &response);
+  if (response != 0 && response != 206)
+  {
+    CLog::Log(LOGWARNING, "CCurlFile::CSegmentedState::Finish - Range request for %s answered with %ld", m_file->m_url.c_str(), response);
+    m_rangeIgnored = true;
+    return;
+  }
+
+  if (++segment.retries > g_advancedSettings.m_curlretries)
+  {
+    CLog::Log(LOGERROR, "CCurlFile::CSegmentedState::Finish - Failed to fetch %s at %"PRId64" (%d)", m_file->m_url.c_str(), received, result);
+    m_failed = true;
+    return;
+  }
+
+  // ask again for what is missing of the range
+  CLog::Log(LOGNOTICE, "CCurlFile::CSegmentedState::Finish - Retrying %s at %"PRId64" (%d)", m_file->m_url.c_str(), received, result);
+  Request(segment, received);
+}
+
+bool CCurlFile::CSegmentedState::Perform()
+{
+  // the buffers hold all of their ranges, so there is no reason not to take all there is
+  int running;
+  CURLMcode result;
+  do
+    result = g_curlInterface.multi_perform(m_multiHandle, &running);
+  while (result == CURLM_CALL_MULTI_PERFORM);
+
+  if (result != CURLM_OK)
+  {
+    CLog::Log(LOGERROR, "CCurlFile::CSegmentedState::Perform - Multi perform failed with code %d", result);
+    m_failed = true;
+    return false;
+  }
+
+  int msgs;
+  CURLMsg* msg;
+  while ((msg = g_curlInterface.multi_info_read(m_multiHandle, &msgs)))
+  {
+    if (msg->msg != CURLMSG_DONE)
+      continue;
+
+    for (std::deque<Segment>::iterator it = m_segments.begin(); it != m_segments.end(); ++it)
+    {
+      if (it->running && it->state->m_easyHandle == msg->easy_handle)
+      {
+        Finish(*it, msg->data.result);
+        break;
+      }
+    }
+  }
+
+  // a server that does not know about ranges sends the whole file instead,
+  // which is found out before anything of it is read
+  for (std::deque<Segment>::iterator it = m_segments.begin(); it != m_segments.end(); ++it)
+  {
+    if (it->checked || Received(*it) == it->from)
+      continue;
+
+    long response = 0;
+    g_curlInterface.easy_getinfo(it->state->m_easyHandle, CURLINFO_RESPONSE_CODE, &response);
+    if (response != 206)
+    {
+      CLog::Log(LOGWARNING, "CCurlFile::CSegmentedState::Perform - Range request for %s answered with %ld", m_file->m_url.c_str(), response);
+      m_rangeIgnored = true;
+      return false;
+    }
+    it->checked = true;
+  }
+
+  if (m_failed || m_rangeIgnored)
+    return false;
+
+  // wait for any of the connections to have something
+  fd_set fdread;
+  fd_set fdwrite;
+  fd_set fdexcep;
+  int maxfd = -1;
+  FD_ZERO(&fdread);
+  FD_ZERO(&fdwrite);
+  FD_ZERO(&fdexcep);
+  g_curlInterface.multi_fdset(m_multiHandle, &fdread, &fdwrite, &fdexcep, &maxfd);
+
+  long timeout = 0;
+  if (CURLM_OK != g_curlInterface.multi_timeout(m_multiHandle, &timeout) || timeout == -1)
+    timeout = 200;
+
+  struct timeval t = { timeout / 1000, (timeout % 1000) * 1000 };
+  if (SOCKET_ERROR == dllselect(maxfd + 1, &fdread, &fdwrite, &fdexcep, &t))
+  {
+    CLog::Log(LOGERROR, "CCurlFile::CSegmentedState::Perform - Failed with socket error");
+    m_failed = true;
+    return false;
+  }
+  return true;
+}
+
+void CCurlFile::CSegmentedState::Seek(int64_t pos)
+{
+  // skip ahead within what the first range already has, anything else starts over
+  while (!m_segments.empty() && m_segments.front().end <= pos && pos < m_segments.back().end)
+  {
+    Stop(m_segments.front());
+    m_segments.pop_front();
+  }
+
+  if (!m_segments.empty())
+  {
+    Segment& segment = m_segments.front();
+    int64_t skip = pos - segment.state->m_filePos;
+    if (skip >= 0 && skip <= (int64_t)segment.state->m_buffer.getMaxReadSize() && segment.checked)
+    {
+      segment.state->m_buffer.SkipBytes((int)skip);
+      segment.state->m_filePos = pos;
+    }
+    else
+      Clear();
+  }
+
+  m_filePos = pos;
+}
+
+unsigned int CCurlFile::CSegmentedState::Read(void* lpBuf, int64_t uiBufSize)
+{
+  if (m_filePos >= m_fileSize || m_rangeIgnored || m_failed)
+    return 0;
+
+  Fill();
+
+  Segment* segment = &m_segments.front();
+  while (!segment->checked || segment->state->m_buffer.getMaxReadSize() == 0)
+  {
+    if (m_file->m_state->m_cancelled || !Perform())
+      return 0;
+  }
+
+  unsigned int want = (unsigned int)XMIN((int64_t)segment->state->m_buffer.getMaxReadSize(), uiBufSize);
+  if (!segment->state->m_buffer.ReadData((char*)lpBuf, want))
+    return 0;
+
+  segment->state->m_filePos += want;
+  m_filePos += want;
+
+  // the range is done with, the connection moves on past the last one
+  if (segment->state->m_filePos >= segment->end)
+  {
+    Stop(*segment);
+    m_segments.pop_front();
+    Fill();
+  }
+  return want;
+}
+
 
 CCurlFile::~CCurlFile()
 {
@@ -395,8 +656,10 @@ CCurlFile::CCurlFile()
   m_httpauth = "";
   m_proxytype = PROXY_HTTP;
   m_state = new CReadState();
+  m_segments = NULL;
   m_skipshout = false;
   m_httpresponse = -1;
+  m_modified = -1;
 }
 
 //Has to be called before Open()
@@ -410,7 +673,10 @@ void CCurlFile::Close()
   if (m_opened && m_forWrite && !m_inError)
       Write(NULL, 0);
 
+  delete m_segments;
+  m_segments = NULL;
   m_state->Disconnect();
+  m_modified = -1;
 
   m_url.Empty();
   m_referer.Empty();
@@ -898,6 +1164,8 @@ bool CCurlFile::Open(const CURL& url)
   // setup common curl options
   SetCommonOptions(m_state);
   SetRequestHeaders(m_state);
+  if(url2.GetProtocol().Equals("http") || url2.GetProtocol().Equals("https"))
+    g_curlInterface.easy_setopt(m_state->m_easyHandle, CURLOPT_FILETIME, 1);
 
   m_httpresponse = m_state->Connect(m_bufferSize);
   if( m_httpresponse < 0 || m_httpresponse >= 400)
@@ -905,6 +1173,18 @@ bool CCurlFile::Open(const CURL& url)
 
   SetCorrectHeaders(m_state);
 
+  // tells a later open whether the file changed, an etag is only compared
+  m_modified = -1;
+  long filetime = -1;
+  if (g_curlInterface.easy_getinfo(m_state->m_easyHandle, CURLINFO_FILETIME, &filetime) == CURLE_OK && filetime != -1)
+    m_modified = filetime;
+  else if (!m_state->m_httpheader.GetValue("ETag").IsEmpty())
+  {
+    Crc32 crc;
+    crc.Compute(m_state->m_httpheader.GetValue("ETag"));
+    m_modified = (uint32_t)crc;
+  }
+
   // since we can't know the stream size up front if we're gzipped/deflated
   // flag the stream with an unknown file size rather than the compressed
   // file size.
@@ -952,6 +1232,19 @@ bool CCurlFile::Open(const CURL& url)
   if (CURLE_OK == g_curlInterface.easy_getinfo(m_state->m_easyHandle, CURLINFO_EFFECTIVE_URL,&efurl) && efurl)
     m_url = efurl;
 
+  // large files from servers that take ranges are read over several connections
+  if (m_seekable && m_multisession && g_advancedSettings.m_curlConnections > 1
+  && m_contentencoding.IsEmpty()
+  && m_state->m_httpheader.GetValue("Accept-Ranges").Equals("bytes")
+  && m_state->m_fileSize > CURL_SEGMENT_SIZE)
+  {
+    CLog::Log(LOGDEBUG, "CCurlFile::Open - Reading %s over %d connections", m_url.c_str(), g_advancedSettings.m_curlConnections);
+    int64_t fileSize = m_state->m_fileSize;
+    m_state->Disconnect();
+    m_state->m_fileSize = fileSize;
+    m_segments = new CSegmentedState(this, fileSize, g_advancedSettings.m_curlConnections);
+  }
+
   return true;
 }
 
@@ -1117,7 +1410,7 @@ bool CCurlFile::Exists(const CURL& url)
 
 int64_t CCurlFile::Seek(int64_t iFilePosition, int iWhence)
 {
-  int64_t nextPos = m_state->m_filePos;
+  int64_t nextPos = m_segments ? m_segments->m_filePos : m_state->m_filePos;
   switch(iWhence)
   {
     case SEEK_SET:
@@ -1139,9 +1432,20 @@ int64_t CCurlFile::Seek(int64_t iFilePosition, int iWhence)
   // We can't seek beyond EOF
   if (m_state->m_fileSize && nextPos > m_state->m_fileSize) return -1;
 
+  if (m_segments)
+  {
+    m_segments->Seek(nextPos);
+    return nextPos;
+  }
+
   if(m_state->Seek(nextPos))
     return nextPos;
 
+  return Reconnect(nextPos);
+}
+
+int64_t CCurlFile::Reconnect(int64_t nextPos)
+{
   if(!m_seekable)
     return -1;
 
@@ -1194,9 +1498,46 @@ int64_t CCurlFile::GetLength()
 int64_t CCurlFile::GetPosition()
 {
   if (!m_opened) return 0;
+  if (m_segments) return m_segments->m_filePos;
   return m_state->m_filePos;
 }
 
+unsigned int CCurlFile::Read(void* lpBuf, int64_t uiBufSize)
+{
+  if (m_segments)
+  {
+    unsigned int read = m_segments->Read(lpBuf, uiBufSize);
+    if (!m_segments->IsRangeIgnored())
+      return read;
+
+    // nothing was read from the ranges yet, carry on over a single connection
+    int64_t pos = m_segments->m_filePos;
+    delete m_segments;
+    m_segments = NULL;
+
+    // the single connection was dropped when the ranges were started, so
+    // m_state has nothing buffered and its position means nothing
+    if (Reconnect(pos) != pos)
+      return 0;
+  }
+  return m_state->Read(lpBuf, uiBufSize);
+}
+
+bool CCurlFile::ReadString(char *szLine, int iLineLength)
+{
+  if (!m_segments)
+    return m_state->ReadString(szLine, iLineLength);
+
+  int pos = 0;
+  while (pos < iLineLength - 1 && Read(szLine + pos, 1) == 1)
+  {
+    if (szLine[pos++] == '\n')
+      break;
+  }
+  szLine[pos] = 0;
+  return pos > 0;
+}
+
 int CCurlFile::Stat(const CURL& url, struct __stat64* buffer)
 {
   // if file is already running, get info from it
@@ -1327,6 +1668,22 @@ int CCurlFile::Stat(const CURL& url, struct __stat64* buffer)
   return 0;
 }
 
+int CCurlFile::Stat(struct __stat64* buffer)
+{
+  // without a length and a validator it can't be told whether the file changed
+  if (!m_opened || m_modified < 0 || GetLength() <= 0)
+  {
+    errno = ENOENT;
+    return -1;
+  }
+
+  memset(buffer, 0, sizeof(struct __stat64));
+  buffer->st_size  = GetLength();
+  buffer->st_mtime = m_modified;
+  buffer->st_mode  = _S_IFREG;
+  return 0;
+}
+
 unsigned int CCurlFile::CReadState::Read(void* lpBuf, int64_t uiBufSize)
 {
   /* only request 1 byte, for truncated reads (only if not eof) */
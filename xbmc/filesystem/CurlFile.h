@@ -22,6 +22,7 @@
 #include "IFile.h"
 #include "utils/RingBuffer.h"
 #include <map>
+#include <deque>
 #include "utils/HttpHeader.h"
 
 namespace XCURL
@@ -56,9 +57,10 @@ namespace XFILE
       virtual int64_t GetPosition();
       virtual int64_t  GetLength();
       virtual int  Stat(const CURL& url, struct __stat64* buffer);
+      virtual int  Stat(struct __stat64* buffer);
       virtual void Close();
-      virtual bool ReadString(char *szLine, int iLineLength)     { return m_state->ReadString(szLine, iLineLength); }
-      virtual unsigned int Read(void* lpBuf, int64_t uiBufSize)  { return m_state->Read(lpBuf, uiBufSize); }
+      virtual bool ReadString(char *szLine, int iLineLength);
+      virtual unsigned int Read(void* lpBuf, int64_t uiBufSize);
       virtual int Write(const void* lpBuf, int64_t uiBufSize);
       virtual CStdString GetMimeType()                           { return m_state->m_httpheader.GetMimeType(); }
       virtual int IoControl(EIoControl request, void* param);
@@ -136,15 +138,62 @@ namespace XFILE
           void         Disconnect();
       };
 
+      /**
+       * Reads a file over several connections at once, each fetching a
+       * range of it, consecutive and ahead of the read position, which are
+       * handed out in order as they are read
+       */
+      class CSegmentedState
+      {
+      public:
+          CSegmentedState(CCurlFile* file, int64_t fileSize, unsigned int connections);
+          ~CSegmentedState();
+
+          int64_t         m_filePos;
+          int64_t         m_fileSize;
+
+          void         Seek(int64_t pos);
+          unsigned int Read(void* lpBuf, int64_t uiBufSize);
+          bool         IsRangeIgnored() const { return m_rangeIgnored; }
+
+      private:
+          typedef struct
+          {
+            CReadState* state;     // buffers the range, its m_filePos is the next byte to read
+            int64_t     from;      // where the last request started
+            int64_t     end;       // one past the last byte of the range
+            int         retries;
+            bool        running;
+            bool        checked;   // the server answered with the range asked for
+          } Segment;
+
+          void    Fill();
+          void    Request(Segment& segment, int64_t from);
+          void    Finish(Segment& segment, int result);
+          void    Stop(Segment& segment);
+          void    Clear();
+          bool    Perform();
+          int64_t Received(const Segment& segment) const;
+
+          CCurlFile*          m_file;
+          XCURL::CURLM*       m_multiHandle;
+          std::deque<Segment> m_segments;  // the first one holds m_filePos
+          unsigned int        m_connections;
+          bool                m_rangeIgnored;
+          bool                m_failed;
+      };
+
     protected:
       void ParseAndCorrectUrl(CURL &url);
       void SetCommonOptions(CReadState* state);
       void SetRequestHeaders(CReadState* state);
       void SetCorrectHeaders(CReadState* state);
+      int64_t Reconnect(int64_t nextPos);
       bool Service(const CStdString& strURL, CStdString& strHTML);
 
     protected:
       CReadState*     m_state;
+      CSegmentedState* m_segments;
       unsigned int    m_bufferSize;
       int64_t         m_writeOffset;
 
@@ -189,5 +238,6 @@ namespace XFILE
       MAPHTTPHEADERS m_requestheaders;
 
       long            m_httpresponse;
+      int64_t         m_modified;      // from Last-Modified or ETag of the open file, -1 if neither
   };
 }
@@ -20,17 +20,115 @@
 
 #include "DirectoryCache.h"
 #include "FileItem.h"
+#include "File.h"
+#include "settings/AdvancedSettings.h"
 #include "threads/SingleLock.h"
+#include "utils/Archive.h"
+#include "utils/Crc32.h"
 #include "utils/log.h"
 #include "utils/URIUtils.h"
+#include "URL.h"
 #include "climits"
 
+#include <algorithm>
+
 using namespace std;
 using namespace XFILE;
 
+#define PERSISTENT_PATH  "special://temp/dircache/"
+#define PERSISTENT_INDEX PERSISTENT_PATH "index.dat"
+#define PERSISTENT_TEMP  ".tmp"
+#define PERSISTENT_MAX   1000
+
+// the files end with the length and crc of what precedes them, anything
+// cut short or damaged is dropped before a single item is parsed
+#define PERSISTENT_TRAILER (sizeof(int64_t) + sizeof(uint32_t))
+
+static bool ComputeCrc(CFile& file, int64_t length, uint32_t& crc)
+{
+  if (file.Seek(0, SEEK_SET) != 0)
+    return false;
+
+  Crc32 sum;
+  char buffer[16384];
+  while (length > 0)
+  {
+    unsigned int read = file.Read(buffer, (unsigned int)min(length, (int64_t)sizeof(buffer)));
+    if (read == 0)
+      return false;
+    sum.Compute(buffer, read);
+    length -= read;
+  }
+  crc = sum;
+  return true;
+}
+
+static bool OpenPersistentFile(CFile& file, const CStdString& path)
+{
+  if (!file.Open(path))
+    return false;
+
+  int64_t length = file.GetLength() - (int64_t)PERSISTENT_TRAILER;
+  int64_t storedLength = -1;
+  uint32_t storedCrc = 0, crc = 0;
+  if (length < 0 || file.Seek(length, SEEK_SET) != length ||
+      file.Read(&storedLength, sizeof(storedLength)) != sizeof(storedLength) ||
+      file.Read(&storedCrc, sizeof(storedCrc)) != sizeof(storedCrc) ||
+      storedLength != length || !ComputeCrc(file, length, crc) || crc != storedCrc ||
+      file.Seek(0, SEEK_SET) != 0)
+  {
+    CLog::Log(LOGWARNING, "%s - ignoring damaged %s", __FUNCTION__, path.c_str());
+    file.Close();
+    return false;
+  }
+  return true;
+}
+
+// appends the trailer to a file written to path + PERSISTENT_TEMP and moves it over path
+static bool ClosePersistentFile(CFile& file, const CStdString& path)
+{
+  int64_t length = file.GetPosition();
+  uint32_t crc = 0;
+  bool written = length >= 0 && ComputeCrc(file, length, crc) && file.Seek(length, SEEK_SET) == length &&
+                 file.Write(&length, sizeof(length)) == sizeof(length) &&
+                 file.Write(&crc, sizeof(crc)) == sizeof(crc);
+  file.Close();
+
+  // renaming over an existing file fails on windows
+  CStdString tempPath = path + PERSISTENT_TEMP;
+  if (written && (CFile::Rename(tempPath, path) || (CFile::Delete(path) && CFile::Rename(tempPath, path))))
+    return true;
+
+  CLog::Log(LOGWARNING, "%s - unable to write %s", __FUNCTION__, path.c_str());
+  CFile::Delete(tempPath);
+  return false;
+}
+
+// only listings of archives are kept on disk, the archive tells whether they are still valid
+static bool GetArchive(const CStdString& storedPath, CStdString& archive)
+{
+  CURL url(storedPath);
+  if (!url.GetProtocol().Equals("zip") && !url.GetProtocol().Equals("rar") && !url.GetProtocol().Equals("apk"))
+    return false;
+  archive = url.GetHostName();
+  return !archive.IsEmpty();
+}
+
+static bool StatArchive(const CStdString& storedPath, int64_t& size, int64_t& mtime)
+{
+  CStdString archive;
+  struct __stat64 st;
+  if (!GetArchive(storedPath, archive) || CFile::Stat(archive, &st) != 0)
+    return false;
+  size  = st.st_size;
+  mtime = st.st_mtime;
+  return true;
+}
+
 CDirectoryCache::CDir::CDir(DIR_CACHE_TYPE cacheType)
 {
   m_cacheType = cacheType;
+  m_size = 0;
   m_lastAccess = 0;
   m_Items = new CFileItemList;
   m_Items->SetFastLookup(true);
@@ -49,10 +147,14 @@ void CDirectoryCache::CDir::SetLastAccess(unsigned int &accessCounter)
 CDirectoryCache::CDirectoryCache(void)
 {
   m_accessCounter = 0;
-#ifdef _DEBUG
+  m_size = 0;
+  m_persistCounter = 0;
+  m_persistMax = PERSISTENT_MAX;
+  m_indexLoaded = false;
   m_cacheHits = 0;
   m_cacheMisses = 0;
-#endif
+  m_diskHits = 0;
+  m_evictions = 0;
 }
 
 CDirectoryCache::~CDirectoryCache(void)
@@ -61,26 +163,20 @@ CDirectoryCache::~CDirectoryCache(void)
 
 bool CDirectoryCache::GetDirectory(const CStdString& strPath, CFileItemList &items, bool retrieveAll)
 {
-  CSingleLock lock (m_cs);
-
   CStdString storedPath = strPath;
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  ciCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
+  CSingleLock lock (m_cs);
+  CDir* dir = Find(storedPath, lock);
+  if (dir && (dir->m_cacheType == XFILE::DIR_CACHE_ALWAYS ||
+             (dir->m_cacheType == XFILE::DIR_CACHE_ONCE && retrieveAll)))
   {
-    CDir* dir = i->second;
-    if (dir->m_cacheType == XFILE::DIR_CACHE_ALWAYS ||
-       (dir->m_cacheType == XFILE::DIR_CACHE_ONCE && retrieveAll))
-    {
-      items.Copy(*dir->m_Items);
-      dir->SetLastAccess(m_accessCounter);
-#ifdef _DEBUG
-      m_cacheHits+=items.Size();
-#endif
-      return true;
-    }
+    items.Copy(*dir->m_Items);
+    dir->SetLastAccess(m_accessCounter);
+    m_cacheHits++;
+    return true;
   }
+  m_cacheMisses++;
   return false;
 }
 
@@ -100,19 +196,25 @@ void CDirectoryCache::SetDirectory(const CStdString& strPath, const CFileItemLis
   // IDEALLY, any further processing on the item would actually create a new item
   // instead of altering it, but we can't really enforce that in an easy way, so
   // this is the best solution for now.
-  CSingleLock lock (m_cs);
-
   CStdString storedPath = strPath;
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  ClearDirectory(storedPath);
+  {
+    CSingleLock lock (m_cs);
 
-  CheckIfFull();
+    iCache i = m_cache.find(storedPath);
+    if (i != m_cache.end())
+      Delete(i);
 
-  CDir* dir = new CDir(cacheType);
-  dir->m_Items->Copy(items);
-  dir->SetLastAccess(m_accessCounter);
-  m_cache.insert(pair<CStdString, CDir*>(storedPath, dir));
+    CDir* dir = new CDir(cacheType);
+    dir->m_Items->Copy(items);
+    Insert(storedPath, dir);
+  }
+
+  if (cacheType == DIR_CACHE_ALWAYS)
+    SavePersistent(storedPath, items);
+  else
+    RemovePersistent(storedPath);
 }
 
 void CDirectoryCache::ClearFile(const CStdString& strFile)
@@ -124,55 +226,70 @@ void CDirectoryCache::ClearFile(const CStdString& strFile)
 
 void CDirectoryCache::ClearDirectory(const CStdString& strPath)
 {
-  CSingleLock lock (m_cs);
-
   CStdString storedPath = strPath;
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  iCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
-    Delete(i);
+  {
+    CSingleLock lock (m_cs);
+
+    iCache i = m_cache.find(storedPath);
+    if (i != m_cache.end())
+      Delete(i);
+  }
+
+  RemovePersistent(storedPath);
 }
 
 void CDirectoryCache::ClearSubPaths(const CStdString& strPath)
 {
-  CSingleLock lock (m_cs);
-
   CStdString storedPath = strPath;
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  iCache i = m_cache.begin();
-  while (i != m_cache.end())
   {
-    CStdString path = i->first;
-    if (strncmp(path.c_str(), storedPath.c_str(), storedPath.GetLength()) == 0)
-      Delete(i++);
-    else
-      i++;
+    CSingleLock lock (m_cs);
+
+    iCache i = m_cache.begin();
+    while (i != m_cache.end())
+    {
+      CStdString path = i->first;
+      if (strncmp(path.c_str(), storedPath.c_str(), storedPath.GetLength()) == 0)
+        Delete(i++);
+      else
+        i++;
+    }
   }
+
+  // those only on disk as well
+  RemovePersistent(storedPath, true);
 }
 
 void CDirectoryCache::AddFile(const CStdString& strFile)
 {
-  CSingleLock lock (m_cs);
-
   CStdString strPath;
   URIUtils::GetDirectory(strFile, strPath);
   URIUtils::RemoveSlashAtEnd(strPath);
 
-  ciCache i = m_cache.find(strPath);
-  if (i != m_cache.end())
   {
+    CSingleLock lock (m_cs);
+
+    ciCache i = m_cache.find(strPath);
+    if (i == m_cache.end())
+      return;
+
     CDir *dir = i->second;
     CFileItemPtr item(new CFileItem(strFile, false));
     dir->m_Items->Add(item);
+    dir->m_size += EstimateSize(*item);
+    m_size += EstimateSize(*item);
     dir->SetLastAccess(m_accessCounter);
   }
+
+  // the copy on disk is out of date, the folder stays in memory until it's listed again
+  RemovePersistent(strPath);
 }
 
 bool CDirectoryCache::FileExists(const CStdString& strFile, bool& bInCache)
 {
-  CSingleLock lock (m_cs);
   bInCache = false;
 
   CStdString strPath(strFile);
@@ -181,26 +298,22 @@ bool CDirectoryCache::FileExists(const CStdString& strFile, bool& bInCache)
   URIUtils::GetDirectory(strPath, storedPath);
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  ciCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
+  CSingleLock lock (m_cs);
+  CDir *dir = Find(storedPath, lock);
+  if (dir)
   {
     bInCache = true;
-    CDir *dir = i->second;
     dir->SetLastAccess(m_accessCounter);
-#ifdef _DEBUG
     m_cacheHits++;
-#endif
     return dir->m_Items->Contains(strFile);
   }
-#ifdef _DEBUG
   m_cacheMisses++;
-#endif
   return false;
 }
 
 void CDirectoryCache::Clear()
 {
-  // this routine clears everything
+  // this routine clears everything in memory, the persistent cache stays
   CSingleLock lock (m_cs);
 
   iCache i = m_cache.begin();
@@ -232,40 +345,311 @@ void CDirectoryCache::ClearCache(set<CStdString>& dirs)
   }
 }
 
-void CDirectoryCache::CheckIfFull()
+void CDirectoryCache::CheckIfFull(size_t size)
 {
   CSingleLock lock (m_cs);
-  static const unsigned int max_cached_dirs = 10;
 
-  // find the last accessed folder, and remove if the number of cached folders is too many
-  iCache lastAccessed = m_cache.end();
-  unsigned int numCached = 0;
-  for (iCache i = m_cache.begin(); i != m_cache.end(); i++)
+  // remove the least recently accessed folders until the new one fits.  folders
+  // that are always cached only go if they can be read back from disk
+  while (m_size + size > g_advancedSettings.m_dirCacheSize)
   {
-    // ensure dirs that are always cached aren't cleared
-    if (i->second->m_cacheType != DIR_CACHE_ALWAYS)
+    iCache lastAccessed = m_cache.end();
+    for (iCache i = m_cache.begin(); i != m_cache.end(); i++)
     {
-      if (lastAccessed == m_cache.end() || i->second->GetLastAccess() < lastAccessed->second->GetLastAccess())
-        lastAccessed = i;
-      numCached++;
+      if (i->second->m_cacheType != DIR_CACHE_ALWAYS || m_persisted.find(i->first) != m_persisted.end())
+      {
+        if (lastAccessed == m_cache.end() || i->second->GetLastAccess() < lastAccessed->second->GetLastAccess())
+          lastAccessed = i;
+      }
     }
-  }
-  if (lastAccessed != m_cache.end() && numCached >= max_cached_dirs)
+    if (lastAccessed == m_cache.end())
+      break;
+
     Delete(lastAccessed);
+    m_evictions++;
+  }
 }
 
 void CDirectoryCache::Delete(iCache it)
 {
   CDir* dir = it->second;
+  m_size -= dir->m_size;
   delete dir;
   m_cache.erase(it);
 }
 
-#ifdef _DEBUG
+CDirectoryCache::CDir* CDirectoryCache::Insert(const CStdString& storedPath, CDir* dir)
+{
+  dir->m_size = 0;
+  for (int i = 0; i < dir->m_Items->Size(); i++)
+    dir->m_size += EstimateSize(*dir->m_Items->Get(i));
+
+  CheckIfFull(dir->m_size);
+
+  dir->SetLastAccess(m_accessCounter);
+  m_cache.insert(pair<CStdString, CDir*>(storedPath, dir));
+  m_size += dir->m_size;
+  return dir;
+}
+
+size_t CDirectoryCache::EstimateSize(const CFileItem& item)
+{
+  // the strings make the difference between items, the tags are left out
+  return sizeof(CFileItem) + item.GetPath().size() + item.GetLabel().size() + item.GetLabel2().size();
+}
+
+CStdString CDirectoryCache::GetPersistentFile(const CStdString& storedPath) const
+{
+  Crc32 crc;
+  crc.ComputeFromLowerCase(storedPath);
+
+  CStdString file;
+  file.Format(PERSISTENT_PATH "%08x.fi", (unsigned __int32)crc);
+  return file;
+}
+
+bool CDirectoryCache::CanPersist(const CStdString& storedPath)
+{
+  CStdString archive;
+  return g_advancedSettings.m_dirCachePersistent && GetArchive(storedPath, archive);
+}
+
+CDirectoryCache::CDir* CDirectoryCache::Find(const CStdString& storedPath, CSingleLock& lock)
+{
+  CDir* dir = NULL;
+  ciCache i = m_cache.find(storedPath);
+  if (i != m_cache.end())
+    dir = i->second;
+  else if (CanPersist(storedPath))
+  {
+    // the disk is read without holding up the folders in memory
+    CDir* loaded = new CDir(DIR_CACHE_ALWAYS);
+    lock.Leave();
+    bool found = LoadPersistent(storedPath, *loaded->m_Items);
+    lock.Enter();
+
+    // someone may have listed it meanwhile
+    i = m_cache.find(storedPath);
+    if (i != m_cache.end())
+      dir = i->second;
+    else if (found)
+    {
+      dir = Insert(storedPath, loaded);
+      loaded = NULL;
+      m_diskHits++;
+    }
+    delete loaded;
+  }
+
+  // the copy on disk of a folder in use is the last to go
+  map<CStdString, unsigned int>::iterator it = m_persisted.find(storedPath);
+  if (dir && it != m_persisted.end())
+    it->second = m_persistCounter++;
+  return dir;
+}
+
+bool CDirectoryCache::LoadPersistent(const CStdString& storedPath, CFileItemList& items)
+{
+  CSingleLock lock(m_diskSection);
+
+  LoadIndex();
+  {
+    CSingleLock cacheLock(m_cs);
+    if (m_persisted.find(storedPath) == m_persisted.end())
+      return false;
+  }
+
+  CFile file;
+  if (!OpenPersistentFile(file, GetPersistentFile(storedPath)))
+  {
+    RemovePersistent(storedPath);
+    return false;
+  }
+
+  // files whose names clash hold another folder
+  CStdString path;
+  int64_t size = -1, mtime = -1, archiveSize, archiveMtime;
+  CArchive ar(&file, CArchive::load);
+  ar >> path;
+  if (path != storedPath)
+    return false;
+
+  // the archive changed since its listing was stored
+  ar >> size >> mtime;
+  if (!StatArchive(storedPath, archiveSize, archiveMtime) || size != archiveSize || mtime != archiveMtime)
+  {
+    CLog::Log(LOGDEBUG, "%s - %s changed, dropping its listing", __FUNCTION__, storedPath.c_str());
+    ar.Close();
+    file.Close();
+    RemovePersistent(storedPath);
+    return false;
+  }
+
+  ar >> items;
+  ar.Close();
+  file.Close();
+
+  CLog::Log(LOGDEBUG, "%s - %i items of %s read from disk", __FUNCTION__, items.Size(), storedPath.c_str());
+  return true;
+}
+
+void CDirectoryCache::SavePersistent(const CStdString& storedPath, const CFileItemList& items)
+{
+  int64_t size, mtime;
+  if (!CanPersist(storedPath) || !StatArchive(storedPath, size, mtime))
+    return;
+
+  CSingleLock lock(m_diskSection);
+  LoadIndex();
+
+  CStdString path = GetPersistentFile(storedPath);
+  CFile file;
+  if (!file.OpenForWrite(path + PERSISTENT_TEMP, true))
+    return;
+
+  CArchive ar(&file, CArchive::store);
+  ar << storedPath;
+  ar << size << mtime;
+  ar << const_cast<CFileItemList&>(items);
+  ar.Close();
+  if (!ClosePersistentFile(file, path))
+    return;
+
+  // the least recently used folders make room
+  vector<CStdString> evicted;
+  {
+    CSingleLock cacheLock(m_cs);
+    m_persisted[storedPath] = m_persistCounter++;
+    while (m_persisted.size() > m_persistMax)
+    {
+      map<CStdString, unsigned int>::iterator lastUsed = m_persisted.begin();
+      for (map<CStdString, unsigned int>::iterator it = m_persisted.begin(); it != m_persisted.end(); ++it)
+      {
+        if (it->second < lastUsed->second)
+          lastUsed = it;
+      }
+      evicted.push_back(lastUsed->first);
+      m_persisted.erase(lastUsed);
+    }
+  }
+
+  for (vector<CStdString>::const_iterator it = evicted.begin(); it != evicted.end(); ++it)
+    CFile::Delete(GetPersistentFile(*it));
+  SaveIndex();
+}
+
+void CDirectoryCache::RemovePersistent(const CStdString& storedPath, bool subPaths)
+{
+  if (!g_advancedSettings.m_dirCachePersistent)
+    return;
+
+  CSingleLock lock(m_diskSection);
+  LoadIndex();
+
+  vector<CStdString> removed;
+  {
+    CSingleLock cacheLock(m_cs);
+    if (!subPaths)
+    {
+      if (m_persisted.erase(storedPath) > 0)
+        removed.push_back(storedPath);
+    }
+    else
+    {
+      map<CStdString, unsigned int>::iterator it = m_persisted.begin();
+      while (it != m_persisted.end())
+      {
+        if (strncmp(it->first.c_str(), storedPath.c_str(), storedPath.GetLength()) == 0)
+        {
+          removed.push_back(it->first);
+          m_persisted.erase(it++);
+        }
+        else
+          it++;
+      }
+    }
+  }
+  if (removed.empty())
+    return;
+
+  for (vector<CStdString>::const_iterator it = removed.begin(); it != removed.end(); ++it)
+    CFile::Delete(GetPersistentFile(*it));
+  SaveIndex();
+}
+
+void CDirectoryCache::LoadIndex()
+{
+  if (m_indexLoaded)
+    return;
+  m_indexLoaded = true;
+
+  CDirectory::Create(PERSISTENT_PATH);
+
+  CFile file;
+  if (!OpenPersistentFile(file, PERSISTENT_INDEX))
+    return;
+
+  // every path takes at least its length
+  CArchive ar(&file, CArchive::load);
+  int count = 0;
+  ar >> count;
+  if (count < 0 || count > file.GetLength() / (int64_t)sizeof(int))
+    return;
+
+  // the paths are stored from the least recently used on
+  vector<CStdString> paths;
+  for (int i = 0; i < count; i++)
+  {
+    CStdString path;
+    ar >> path;
+    if (!path.IsEmpty())
+      paths.push_back(path);
+  }
+  ar.Close();
+  file.Close();
+
+  CSingleLock cacheLock(m_cs);
+  for (vector<CStdString>::const_iterator it = paths.begin(); it != paths.end(); ++it)
+    m_persisted[*it] = m_persistCounter++;
+}
+
+void CDirectoryCache::SaveIndex()
+{
+  vector< pair<unsigned int, CStdString> > paths;
+  {
+    CSingleLock cacheLock(m_cs);
+    for (map<CStdString, unsigned int>::const_iterator it = m_persisted.begin(); it != m_persisted.end(); ++it)
+      paths.push_back(make_pair(it->second, it->first));
+  }
+  sort(paths.begin(), paths.end());
+
+  CFile file;
+  if (!file.OpenForWrite(PERSISTENT_INDEX PERSISTENT_TEMP, true))
+    return;
+
+  CArchive ar(&file, CArchive::store);
+  ar << (int)paths.size();
+  for (vector< pair<unsigned int, CStdString> >::const_iterator it = paths.begin(); it != paths.end(); ++it)
+    ar << it->second;
+  ar.Close();
+  ClosePersistentFile(file, PERSISTENT_INDEX);
+}
+
+void CDirectoryCache::GetStats(Stats& stats) const
+{
+  CSingleLock lock (m_cs);
+  stats.hits      = m_cacheHits;
+  stats.misses    = m_cacheMisses;
+  stats.diskHits  = m_diskHits;
+  stats.evictions = m_evictions;
+  stats.dirs      = m_cache.size();
+  stats.size      = m_size;
+}
+
 void CDirectoryCache::PrintStats() const
 {
   CSingleLock lock (m_cs);
-  CLog::Log(LOGDEBUG, "%s - total of %u cache hits, and %u cache misses", __FUNCTION__, m_cacheHits, m_cacheMisses);
+  CLog::Log(LOGDEBUG, "%s - total of %u cache hits, %u from disk, %u cache misses and %u evictions", __FUNCTION__, m_cacheHits, m_diskHits, m_cacheMisses, m_evictions);
   // run through and find the oldest and the number of items cached
   unsigned int oldest = UINT_MAX;
   unsigned int numItems = 0;
@@ -277,6 +661,5 @@ void CDirectoryCache::PrintStats() const
     numItems += dir->m_Items->Size();
     numDirs++;
   }
-  CLog::Log(LOGDEBUG, "%s - %u folders cached, with %u items total.  Oldest is %u, current is %u", __FUNCTION__, numDirs, numItems, oldest, m_accessCounter);
+  CLog::Log(LOGDEBUG, "%s - %u folders cached, with %u items total taking about %u kB.  Oldest is %u, current is %u", __FUNCTION__, numDirs, numItems, (unsigned int)(m_size / 1024), oldest, m_accessCounter);
 }
-#endif
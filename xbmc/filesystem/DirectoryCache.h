@@ -22,6 +22,7 @@
 #include "IDirectory.h"
 #include "Directory.h"
 #include "threads/CriticalSection.h"
+#include "threads/SingleLock.h"
 
 #include <map>
 #include <set>
@@ -43,10 +44,21 @@ namespace XFILE
 
       CFileItemList* m_Items;
       DIR_CACHE_TYPE m_cacheType;
+      size_t         m_size;      ///< estimated memory taken by the items
     private:
       unsigned int m_lastAccess;
     };
   public:
+    typedef struct
+    {
+      unsigned int hits;
+      unsigned int misses;
+      unsigned int diskHits;      ///< misses found in the persistent cache
+      unsigned int evictions;
+      unsigned int dirs;
+      size_t       size;          ///< estimated memory of all cached folders
+    } Stats;
+
     CDirectoryCache(void);
     virtual ~CDirectoryCache(void);
     bool GetDirectory(const CStdString& strPath, CFileItemList &items, bool retrieveAll = false);
@@ -57,27 +69,55 @@ namespace XFILE
     void Clear();
     void AddFile(const CStdString& strFile);
     bool FileExists(const CStdString& strPath, bool& bInCache);
-#ifdef _DEBUG
+    void GetStats(Stats& stats) const;
     void PrintStats() const;
-#endif
   protected:
     void InitCache(std::set<CStdString>& dirs);
     void ClearCache(std::set<CStdString>& dirs);
-    void CheckIfFull();
+    void CheckIfFull(size_t size);
 
     std::map<CStdString, CDir*> m_cache;
     typedef std::map<CStdString, CDir*>::iterator iCache;
     typedef std::map<CStdString, CDir*>::const_iterator ciCache;
     void Delete(iCache i);
+    CDir* Insert(const CStdString& storedPath, CDir* dir);
+    static size_t EstimateSize(const CFileItem& item);
+
+    /*! \brief Looks the folder up in memory, then on disk. lock holds m_cs
+     and is let go while the disk is read.
+     */
+    CDir* Find(const CStdString& storedPath, CSingleLock& lock);
+
+    /*! \brief Folders that are always cached are also kept on disk when
+     dircachepersistent is set, so they survive a restart and an eviction.
+     Only archive listings are kept, with the size and mtime of the archive
+     so they are dropped once it changes. The least recently used ones go
+     once there are too many. The disk is only touched with m_diskSection
+     held and never with m_cs held.
+     */
+    static bool CanPersist(const CStdString& storedPath);
+    bool LoadPersistent(const CStdString& storedPath, CFileItemList& items);
+    void SavePersistent(const CStdString& storedPath, const CFileItemList& items);
+    void RemovePersistent(const CStdString& storedPath, bool subPaths = false);
+    CStdString GetPersistentFile(const CStdString& storedPath) const;
+    void LoadIndex();
+    void SaveIndex();
+
+    std::map<CStdString, unsigned int> m_persisted;  ///< folders stored on disk, with when they were last used
+    unsigned int m_persistCounter;
+    unsigned int m_persistMax;     ///< folders kept on disk at most
+    bool m_indexLoaded;
 
     CCriticalSection m_cs;
+    CCriticalSection m_diskSection;
 
     unsigned int m_accessCounter;
+    size_t m_size;
 
-#ifdef _DEBUG
     unsigned int m_cacheHits;
     unsigned int m_cacheMisses;
-#endif
+    unsigned int m_diskHits;
+    unsigned int m_evictions;
   };
 }
 extern XFILE::CDirectoryCache g_directoryCache;
@@ -25,6 +25,7 @@
 #include "DirectoryCache.h"
 #include "Directory.h"
 #include "FileCache.h"
+#include "settings/AdvancedSettings.h"
 #include "utils/log.h"
 #include "utils/URIUtils.h"
 #include "utils/BitstreamStats.h"
@@ -230,6 +231,11 @@ bool CFile::Open(const CStdString& strFileName, unsigned int flags)
     if ( (flags & READ_NO_CACHE) == 0 && URIUtils::IsInternetStream(url, true) && !CUtil::IsPicture(strFileName) )
       m_flags |= READ_CACHED;
 
+    // shares are read through the cache too once it keeps blocks on disk
+    if ( (flags & READ_NO_CACHE) == 0 && g_advancedSettings.m_cacheDiskSize > 0
+      && (URIUtils::IsSmb(url.Get()) || URIUtils::IsNfs(url.Get())) && !CUtil::IsPicture(strFileName) )
+      m_flags |= READ_CACHED;
+
     if (m_flags & READ_CACHED)
     {
       m_pFile = new CFileCache();
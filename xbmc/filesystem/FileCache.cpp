@@ -26,6 +26,7 @@
 #include "URL.h"
 
 #include "CircularCache.h"
+#include "PersistentCache.h"
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "utils/TimeUtils.h"
@@ -90,6 +91,8 @@ CFileCache::CFileCache() : CThread("FileCache")
    else
      m_pCache = new CCircularCache(g_advancedSettings.m_cacheMemBufferSize
                                  , std::max<unsigned int>( g_advancedSettings.m_cacheMemBufferSize / 4, 1024 * 1024));
+   if (g_advancedSettings.m_cacheDiskSize > 0)
+     m_pCache = new CPersistentCache(m_pCache);
    m_seekPossible = 0;
    m_cacheFull = false;
 }
@@ -163,6 +166,11 @@ bool CFileCache::Open(const CURL& url)
 
   m_source.IoControl(IOCTRL_SET_CACHE,this);
 
+  // an unchanged file can be read from what was kept of it before
+  struct __stat64 st;
+  if (m_source.Stat(&st) == 0)
+    m_pCache->SetSource(m_sourcePath, st.st_size, st.st_mtime);
+
   // check if source can seek
   m_seekPossible = m_source.IoControl(IOCTRL_SEEK_POSSIBLE, NULL);
   m_chunkSize = CFile::GetChunkSize(m_source.GetChunkSize(), READ_CACHE_CHUNK_SIZE);
@@ -198,6 +206,7 @@ void CFileCache::Process()
 
   CWriteRate limiter;
   CWriteRate average;
+  int64_t    sourcePos = 0;
 
   while (!m_bStop)
   {
@@ -206,7 +215,12 @@ void CFileCache::Process()
     {
       m_seekEvent.Reset();
       CLog::Log(LOGDEBUG,"%s, request seek on source to %"PRId64, __FUNCTION__, m_seekPos);
-      m_nSeekResult = m_source.Seek(m_seekPos, SEEK_SET);
+      // the source is only moved once it has to be read
+      if (m_pCache->IsStored(m_seekPos))
+        m_nSeekResult = m_seekPos;
+      else if ((m_nSeekResult = m_source.Seek(m_seekPos, SEEK_SET)) == m_seekPos)
+        sourcePos = m_seekPos;
+
       if (m_nSeekResult != m_seekPos)
       {
         CLog::Log(LOGERROR,"%s, error %d seeking. seek returned %"PRId64, __FUNCTION__, (int)GetLastError(), m_nSeekResult);
@@ -243,7 +257,23 @@ void CFileCache::Process()
       }
     }
 
-    int iRead = m_source.Read(buffer.get(), m_chunkSize);
+    int iRead = m_pCache->ReadFromStore(m_writePos, buffer.get(), m_chunkSize);
+    if (iRead <= 0)
+    {
+      if (sourcePos != m_writePos)
+      {
+        if (m_source.Seek(m_writePos, SEEK_SET) != m_writePos)
+        {
+          CLog::Log(LOGERROR, "%s, error %d seeking source to %"PRId64, __FUNCTION__, (int)GetLastError(), m_writePos);
+          break;
+        }
+        sourcePos = m_writePos;
+      }
+      iRead = m_source.Read(buffer.get(), m_chunkSize);
+      if (iRead > 0)
+        sourcePos += iRead;
+    }
+
     if (iRead == 0)
     {
       CLog::Log(LOGINFO, "CFileCache::Process - Hit eof.");
@@ -325,6 +355,11 @@ int CFileCache::Stat(const CURL& url, struct __stat64* buffer)
   return CFile::Stat(url.Get(), buffer);
 }
 
+int CFileCache::Stat(struct __stat64* buffer)
+{
+  return m_source.Stat(buffer);
+}
+
 unsigned int CFileCache::Read(void* lpBuf, int64_t uiBufSize)
 {
   CSingleLock lock(m_sync);
@@ -395,6 +430,7 @@ int64_t CFileCache::Seek(int64_t iFilePosition, int iWhence)
 
     /* never request closer to end than 2k, speeds up tag reading */
     m_seekPos = std::min(iTarget, std::max((int64_t)0, m_source.GetLength() - m_chunkSize));
+    m_seekPos = m_pCache->GetSourcePosition(m_seekPos);
 
     m_seekEvent.Set();
     if (!m_seekEnded.Wait())
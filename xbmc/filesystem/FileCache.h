@@ -47,6 +47,7 @@ namespace XFILE
     virtual void          Close();
     virtual bool          Exists(const CURL& url);
     virtual int           Stat(const CURL& url, struct __stat64* buffer);
+    virtual int           Stat(struct __stat64* buffer);
 
     virtual unsigned int  Read(void* lpBuf, int64_t uiBufSize);
 
@@ -31,12 +31,17 @@
 #include "utils/URIUtils.h"
 #include "network/DNSNameCache.h"
 #include "threads/SystemClock.h"
+#include "settings/AdvancedSettings.h"
 
 #include <nfsc/libnfs-raw-mount.h>
+#include <climits>
 
 #ifdef TARGET_WINDOWS
 #include <fcntl.h>
 #include <sys\stat.h>
+#define poll WSAPoll
+#else
+#include <poll.h>
 #endif
 
 //KEEP_ALIVE_TIMEOUT is decremented every half a second
@@ -48,6 +53,9 @@
 //6 mins (360s) cached context timeout
 #define CONTEXT_TIMEOUT 360000
 
+//30s to wait for a read sent ahead before giving up on it
+#define READ_AHEAD_TIMEOUT 30000
+
 //return codes for getContextForExport
 #define CONTEXT_INVALID  0    //getcontext failed
 #define CONTEXT_NEW      1    //new context created
@@ -136,6 +144,7 @@ void CNfsConnection::destroyOpenContexts()
   for(tOpenContextMap::iterator it = m_openContextMap.begin();it!=m_openContextMap.end();it++)
   {
     m_pLibNfs->nfs_destroy_context(it->second.pContext);
+    XFILE::CNFSFile::CancelReadAhead(it->second.pContext);
   }
   m_openContextMap.clear();
 }
@@ -166,6 +175,7 @@ struct nfs_context *CNfsConnection::getContextFromMap(const CStdString &exportna
       //destroy it and return NULL
       CLog::Log(LOGDEBUG, "NFS: Old context timed out - destroying it");
       m_pLibNfs->nfs_destroy_context(it->second.pContext);
+      XFILE::CNFSFile::CancelReadAhead(it->second.pContext);
     }
   }
   return pRet;
@@ -460,10 +470,14 @@ void CNfsConnection::AddIdleConnection()
 
 CNfsConnection gNfsConnection;
 
+std::set<CNFSFile::ReadRequest *> CNFSFile::m_readsOnWire;
+CCriticalSection CNFSFile::m_readsOnWireLock;
+
 CNFSFile::CNFSFile()
 : m_fileSize(0)
 , m_pFileHandle(NULL)
 , m_pNfsContext(NULL)
+, m_pLib(gNfsConnection.GetImpl())
 {
   gNfsConnection.AddActiveConnection();
 }
@@ -482,11 +496,11 @@ int64_t CNFSFile::GetPosition()
   
   if (gNfsConnection.GetNfsContext() == NULL || m_pFileHandle == NULL) return 0;
   
-  ret = (int)gNfsConnection.GetImpl()->nfs_lseek(gNfsConnection.GetNfsContext(), m_pFileHandle, 0, SEEK_CUR, &offset);
+  ret = (int)m_pLib->nfs_lseek(gNfsConnection.GetNfsContext(), m_pFileHandle, 0, SEEK_CUR, &offset);
   
   if (ret < 0) 
   {
-    CLog::Log(LOGERROR, "NFS: Failed to lseek(%s)",gNfsConnection.GetImpl()->nfs_get_error(gNfsConnection.GetNfsContext()));
+    CLog::Log(LOGERROR, "NFS: Failed to lseek(%s)",m_pLib->nfs_get_error(gNfsConnection.GetNfsContext()));
   }
   return offset;
 }
@@ -519,11 +533,11 @@ bool CNFSFile::Open(const CURL& url)
   m_pNfsContext = gNfsConnection.GetNfsContext(); 
   m_exportPath = gNfsConnection.GetContextMapId();
   
-  ret = gNfsConnection.GetImpl()->nfs_open(m_pNfsContext, filename.c_str(), O_RDONLY, &m_pFileHandle);
+  ret = m_pLib->nfs_open(m_pNfsContext, filename.c_str(), O_RDONLY, &m_pFileHandle);
   
   if (ret != 0) 
   {
-    CLog::Log(LOGINFO, "CNFSFile::Open: Unable to open file : '%s'  error : '%s'", url.GetFileName().c_str(), gNfsConnection.GetImpl()->nfs_get_error(m_pNfsContext));
+    CLog::Log(LOGINFO, "CNFSFile::Open: Unable to open file : '%s'  error : '%s'", url.GetFileName().c_str(), m_pLib->nfs_get_error(m_pNfsContext));
     m_pNfsContext = NULL;
     m_exportPath.clear();
     return false;
@@ -570,12 +584,12 @@ int CNFSFile::Stat(const CURL& url, struct __stat64* buffer)
 
   struct stat tmpBuffer = {0};
 
-  ret = gNfsConnection.GetImpl()->nfs_stat(gNfsConnection.GetNfsContext(), filename.c_str(), &tmpBuffer);
+  ret = m_pLib->nfs_stat(gNfsConnection.GetNfsContext(), filename.c_str(), &tmpBuffer);
   
   //if buffer == NULL we where called from Exists - in that case don't spam the log with errors
   if (ret != 0 && buffer != NULL) 
   {
-    CLog::Log(LOGERROR, "NFS: Failed to stat(%s) %s\n", url.GetFileName().c_str(), gNfsConnection.GetImpl()->nfs_get_error(gNfsConnection.GetNfsContext()));
+    CLog::Log(LOGERROR, "NFS: Failed to stat(%s) %s\n", url.GetFileName().c_str(), m_pLib->nfs_get_error(gNfsConnection.GetNfsContext()));
     ret = -1;
   }
   else
@@ -599,14 +613,189 @@ int CNFSFile::Stat(const CURL& url, struct __stat64* buffer)
   return ret;
 }
 
+void CNFSFile::ReadAheadCallback(int err, struct nfs_context *nfs, void *data, void *private_data)
+{
+  ReadRequest *request = (ReadRequest *)private_data;
+
+  CSingleLock lock(m_readsOnWireLock);
+  m_readsOnWire.erase(request);
+
+  //the file moved on or was closed in the meantime
+  if (request->file == NULL)
+  {
+    delete request;
+    return;
+  }
+
+  request->result = err;
+  if (err > 0)
+    request->data.assign((char *)data, err);
+  request->done = true;
+}
+
+void CNFSFile::CancelReadAhead(struct nfs_context *pContext)
+{
+  CSingleLock lock(m_readsOnWireLock);
+  std::set<ReadRequest *>::iterator it = m_readsOnWire.begin();
+  while (it != m_readsOnWire.end())
+  {
+    ReadRequest *request = *it;
+    if (request->context != pContext)
+    {
+      ++it;
+      continue;
+    }
+
+    m_readsOnWire.erase(it++);
+    if (request->file == NULL)
+      delete request;
+    else
+    {
+      request->result = -EINTR;
+      request->done   = true;
+    }
+  }
+}
+
+void CNFSFile::ReleaseReadRequest(ReadRequest *request)
+{
+  //the ones still on the wire are deleted by their callback
+  CSingleLock lock(m_readsOnWireLock);
+  if (request->done)
+    delete request;
+  else
+    request->file = NULL;
+}
+
+void CNFSFile::DropReadAhead()
+{
+  for (std::deque<ReadRequest *>::iterator it = m_readAhead.begin(); it != m_readAhead.end(); ++it)
+    ReleaseReadRequest(*it);
+  m_readAhead.clear();
+}
+
+void CNFSFile::FillReadAhead(uint64_t pos)
+{
+  uint64_t chunkSize = gNfsConnection.GetMaxReadChunkSize() ? gNfsConnection.GetMaxReadChunkSize() : 32768;
+  uint64_t offset = m_readAhead.empty() ? pos : m_readAhead.back()->offset + m_readAhead.back()->count;
+
+  while (m_readAhead.size() < (size_t)g_advancedSettings.m_nfsReadAhead && offset < (uint64_t)m_fileSize)
+  {
+    ReadRequest *request = new ReadRequest;
+    request->file    = this;
+    request->context = m_pNfsContext;
+    request->offset  = offset;
+    request->count   = std::min(chunkSize, (uint64_t)m_fileSize - offset);
+    request->result  = 0;
+    request->done    = false;
+
+    //the callback may run before the call returns
+    CSingleLock lock(m_readsOnWireLock);
+    m_readsOnWire.insert(request);
+    if (m_pLib->nfs_pread_async(m_pNfsContext, m_pFileHandle, offset, request->count, ReadAheadCallback, request) != 0)
+    {
+      CLog::Log(LOGERROR, "%s - Error( %s )", __FUNCTION__, m_pLib->nfs_get_error(m_pNfsContext));
+      m_readsOnWire.erase(request);
+      delete request;
+      break;
+    }
+    m_readAhead.push_back(request);
+    offset += request->count;
+  }
+}
+
+bool CNFSFile::WaitForReadAhead(ReadRequest *request)
+{
+  XbmcThreads::EndTime timeout(READ_AHEAD_TIMEOUT);
+
+  //replies for the other requests and other files on this context are handled on the way
+  while (!request->done)
+  {
+    struct pollfd pfd;
+    pfd.fd      = m_pLib->nfs_get_fd(m_pNfsContext);
+    pfd.events  = m_pLib->nfs_which_events(m_pNfsContext);
+    pfd.revents = 0;
+
+    if (timeout.IsTimePast() || poll(&pfd, 1, 100) < 0)
+      return false;
+
+    if (m_pLib->nfs_service(m_pNfsContext, pfd.revents) < 0)
+      return false;
+  }
+  return true;
+}
+
+int CNFSFile::ReadAhead(uint64_t pos, char *buf, unsigned int size)
+{
+  //requests before the position are done with, if it isn't in the
+  //first one left this was a seek and none of them are of use
+  while (!m_readAhead.empty() && m_readAhead.front()->offset + m_readAhead.front()->count <= pos)
+  {
+    ReleaseReadRequest(m_readAhead.front());
+    m_readAhead.pop_front();
+  }
+  if (!m_readAhead.empty() && m_readAhead.front()->offset > pos)
+    DropReadAhead();
+
+  FillReadAhead(pos);
+  if (m_readAhead.empty())
+    return 0;
+
+  ReadRequest *request = m_readAhead.front();
+  if (!WaitForReadAhead(request))
+  {
+    CLog::Log(LOGERROR, "%s - Error( %s )", __FUNCTION__, m_pLib->nfs_get_error(m_pNfsContext));
+    DropReadAhead();
+    return -1;
+  }
+
+  if (request->result < 0)
+  {
+    int result = request->result;
+    DropReadAhead();
+    return result;
+  }
+
+  //a short read ends where the server stopped
+  uint64_t skip = pos - request->offset;
+  if (skip >= request->data.size())
+  {
+    DropReadAhead();
+    return 0;
+  }
+
+  unsigned int len = (unsigned int)std::min((uint64_t)size, request->data.size() - skip);
+  memcpy(buf, request->data.data() + skip, len);
+
+  if (skip + len >= request->data.size())
+  {
+    m_readAhead.pop_front();
+    delete request;
+    FillReadAhead(pos + len);
+  }
+  return len;
+}
+
 unsigned int CNFSFile::Read(void *lpBuf, int64_t uiBufSize)
 {
   int numberOfBytesRead = 0;
+  uint64_t pos = 0;
   CSingleLock lock(gNfsConnection);
   
   if (m_pFileHandle == NULL || m_pNfsContext == NULL ) return 0;
 
-  numberOfBytesRead = gNfsConnection.GetImpl()->nfs_read(m_pNfsContext, m_pFileHandle, uiBufSize, (char *)lpBuf);  
+  //keep several reads in flight so a read doesn't wait a round trip for each chunk,
+  //past the size known at open (growing files) it reads one at a time again
+  if (g_advancedSettings.m_nfsReadAhead > 0
+  &&  m_pLib->nfs_lseek(m_pNfsContext, m_pFileHandle, 0, SEEK_CUR, &pos) == 0
+  &&  pos < (uint64_t)m_fileSize)
+  {
+    numberOfBytesRead = ReadAhead(pos, (char *)lpBuf, (unsigned int)std::min(uiBufSize, (int64_t)INT_MAX));
+    if (numberOfBytesRead > 0)
+      m_pLib->nfs_lseek(m_pNfsContext, m_pFileHandle, pos + numberOfBytesRead, SEEK_SET, &pos);
+  }
+  else
+    numberOfBytesRead = m_pLib->nfs_read(m_pNfsContext, m_pFileHandle, uiBufSize, (char *)lpBuf);  
 
   lock.Leave();//no need to keep the connection lock after that
   
@@ -615,7 +804,7 @@ unsigned int CNFSFile::Read(void *lpBuf, int64_t uiBufSize)
   //something went wrong ...
   if (numberOfBytesRead < 0) 
   {
-    CLog::Log(LOGERROR, "%s - Error( %d, %s )", __FUNCTION__, numberOfBytesRead, gNfsConnection.GetImpl()->nfs_get_error(m_pNfsContext));
+    CLog::Log(LOGERROR, "%s - Error( %d, %s )", __FUNCTION__, numberOfBytesRead, m_pLib->nfs_get_error(m_pNfsContext));
     return 0;
   }
   return (unsigned int)numberOfBytesRead;
@@ -630,10 +819,10 @@ int64_t CNFSFile::Seek(int64_t iFilePosition, int iWhence)
   if (m_pFileHandle == NULL || m_pNfsContext == NULL) return -1;
   
  
-  ret = (int)gNfsConnection.GetImpl()->nfs_lseek(m_pNfsContext, m_pFileHandle, iFilePosition, iWhence, &offset);
+  ret = (int)m_pLib->nfs_lseek(m_pNfsContext, m_pFileHandle, iFilePosition, iWhence, &offset);
   if (ret < 0) 
   {
-    CLog::Log(LOGERROR, "%s - Error( seekpos: %"PRId64", whence: %i, fsize: %"PRId64", %s)", __FUNCTION__, iFilePosition, iWhence, m_fileSize, gNfsConnection.GetImpl()->nfs_get_error(m_pNfsContext));
+    CLog::Log(LOGERROR, "%s - Error( seekpos: %"PRId64", whence: %i, fsize: %"PRId64", %s)", __FUNCTION__, iFilePosition, iWhence, m_fileSize, m_pLib->nfs_get_error(m_pNfsContext));
     return -1;
   }
   return (int64_t)offset;
@@ -647,10 +836,10 @@ int CNFSFile::Truncate(int64_t iSize)
   if (m_pFileHandle == NULL || m_pNfsContext == NULL) return -1;
   
   
-  ret = (int)gNfsConnection.GetImpl()->nfs_ftruncate(m_pNfsContext, m_pFileHandle, iSize);
+  ret = (int)m_pLib->nfs_ftruncate(m_pNfsContext, m_pFileHandle, iSize);
   if (ret < 0) 
   {
-    CLog::Log(LOGERROR, "%s - Error( ftruncate: %"PRId64", fsize: %"PRId64", %s)", __FUNCTION__, iSize, m_fileSize, gNfsConnection.GetImpl()->nfs_get_error(m_pNfsContext));
+    CLog::Log(LOGERROR, "%s - Error( ftruncate: %"PRId64", fsize: %"PRId64", %s)", __FUNCTION__, iSize, m_fileSize, m_pLib->nfs_get_error(m_pNfsContext));
     return -1;
   }
   return ret;
@@ -667,11 +856,13 @@ void CNFSFile::Close()
     // remove it from keep alive list before closing
     // so keep alive code doens't process it anymore
     gNfsConnection.removeFromKeepAliveList(m_pFileHandle);
-    ret = gNfsConnection.GetImpl()->nfs_close(m_pNfsContext, m_pFileHandle);
+    // the replies still on the way come in before the one to the close
+    DropReadAhead();
+    ret = m_pLib->nfs_close(m_pNfsContext, m_pFileHandle);
         
 	  if (ret < 0) 
     {
-      CLog::Log(LOGERROR, "Failed to close(%s) - %s\n", m_url.GetFileName().c_str(), gNfsConnection.GetImpl()->nfs_get_error(m_pNfsContext));
+      CLog::Log(LOGERROR, "Failed to close(%s) - %s\n", m_url.GetFileName().c_str(), m_pLib->nfs_get_error(m_pNfsContext));
     }
     m_pFileHandle = NULL;
     m_pNfsContext = NULL;    
@@ -704,7 +895,7 @@ int CNFSFile::Write(const void* lpBuf, int64_t uiBufSize)
       chunkSize = leftBytes;//write last chunk with correct size
     }
     //write chunk
-    writtenBytes = gNfsConnection.GetImpl()->nfs_write(m_pNfsContext,
+    writtenBytes = m_pLib->nfs_write(m_pNfsContext,
                                   m_pFileHandle, 
                                   chunkSize, 
                                   (char *)lpBuf + numberOfBytesWritten);
@@ -716,7 +907,7 @@ int CNFSFile::Write(const void* lpBuf, int64_t uiBufSize)
     //danger - something went wrong
     if (writtenBytes < 0) 
     {
-      CLog::Log(LOGERROR, "Failed to pwrite(%s) %s\n", m_url.GetFileName().c_str(), gNfsConnection.GetImpl()->nfs_get_error(m_pNfsContext));        
+      CLog::Log(LOGERROR, "Failed to pwrite(%s) %s\n", m_url.GetFileName().c_str(), m_pLib->nfs_get_error(m_pNfsContext));        
       break;
     }     
   }
@@ -734,11 +925,11 @@ bool CNFSFile::Delete(const CURL& url)
     return false;
   
   
-  ret = gNfsConnection.GetImpl()->nfs_unlink(gNfsConnection.GetNfsContext(), filename.c_str());
+  ret = m_pLib->nfs_unlink(gNfsConnection.GetNfsContext(), filename.c_str());
   
   if(ret != 0)
   {
-    CLog::Log(LOGERROR, "%s - Error( %s )", __FUNCTION__, gNfsConnection.GetImpl()->nfs_get_error(gNfsConnection.GetNfsContext()));
+    CLog::Log(LOGERROR, "%s - Error( %s )", __FUNCTION__, m_pLib->nfs_get_error(gNfsConnection.GetNfsContext()));
   }
   return (ret == 0);
 }
@@ -756,11 +947,11 @@ bool CNFSFile::Rename(const CURL& url, const CURL& urlnew)
   CStdString strDummy;
   gNfsConnection.splitUrlIntoExportAndPath(urlnew, strDummy, strFileNew);
   
-  ret = gNfsConnection.GetImpl()->nfs_rename(gNfsConnection.GetNfsContext() , strFile.c_str(), strFileNew.c_str());
+  ret = m_pLib->nfs_rename(gNfsConnection.GetNfsContext() , strFile.c_str(), strFileNew.c_str());
   
   if(ret != 0)
   {
-    CLog::Log(LOGERROR, "%s - Error( %s )", __FUNCTION__, gNfsConnection.GetImpl()->nfs_get_error(gNfsConnection.GetNfsContext()));
+    CLog::Log(LOGERROR, "%s - Error( %s )", __FUNCTION__, m_pLib->nfs_get_error(gNfsConnection.GetNfsContext()));
   } 
   return (ret == 0);
 }
@@ -786,21 +977,21 @@ bool CNFSFile::OpenForWrite(const CURL& url, bool bOverWrite)
   {
     CLog::Log(LOGWARNING, "FileNFS::OpenForWrite() called with overwriting enabled! - %s", filename.c_str());
     //create file with proper permissions
-    ret = gNfsConnection.GetImpl()->nfs_creat(m_pNfsContext, filename.c_str(), S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH, &m_pFileHandle);    
+    ret = m_pLib->nfs_creat(m_pNfsContext, filename.c_str(), S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH, &m_pFileHandle);    
     //if file was created the file handle isn't valid ... so close it and open later
     if(ret == 0)
     {
-      gNfsConnection.GetImpl()->nfs_close(m_pNfsContext,m_pFileHandle);
+      m_pLib->nfs_close(m_pNfsContext,m_pFileHandle);
       m_pFileHandle = NULL;          
     }
   }
 
-  ret = gNfsConnection.GetImpl()->nfs_open(m_pNfsContext, filename.c_str(), O_RDWR, &m_pFileHandle);
+  ret = m_pLib->nfs_open(m_pNfsContext, filename.c_str(), O_RDWR, &m_pFileHandle);
   
   if (ret || m_pFileHandle == NULL)
   {
     // write error to logfile
-    CLog::Log(LOGERROR, "CNFSFile::Open: Unable to open file : '%s' error : '%s'", filename.c_str(), gNfsConnection.GetImpl()->nfs_get_error(gNfsConnection.GetNfsContext()));
+    CLog::Log(LOGERROR, "CNFSFile::Open: Unable to open file : '%s' error : '%s'", filename.c_str(), m_pLib->nfs_get_error(gNfsConnection.GetNfsContext()));
     m_pNfsContext = NULL;
     m_exportPath.clear();
     return false;
@@ -26,6 +26,8 @@
 #include "URL.h"
 #include "threads/CriticalSection.h"
 #include <list>
+#include <deque>
+#include <set>
 #include "SectionLoader.h"
 #include <map>
 
@@ -46,6 +48,7 @@
 #endif
 
 class DllLibNfs;
+class DllLibNfsInterface;
 
 class CNfsConnection : public CCriticalSection
 {     
@@ -150,6 +153,10 @@ namespace XFILE
     virtual bool OpenForWrite(const CURL& url, bool bOverWrite = false);
     virtual bool Delete(const CURL& url);
     virtual bool Rename(const CURL& url, const CURL& urlnew);    
+
+    //ends the reads sent ahead on a context that was destroyed,
+    //whatever libnfs did with their callbacks
+    static void CancelReadAhead(struct nfs_context *pContext);
   protected:
     CURL m_url;
     bool IsValidFile(const CStdString& strFileName);
@@ -157,6 +164,31 @@ namespace XFILE
     struct nfsfh  *m_pFileHandle;
     struct nfs_context *m_pNfsContext;//current nfs context
     std::string m_exportPath;
+    DllLibNfsInterface *m_pLib;//the lib of gNfsConnection, the tests give a fake one
+
+    //a read sent ahead of the position, deleted by the callback
+    //once the file doesn't wait for it anymore
+    struct ReadRequest
+    {
+      CNFSFile   *file;//NULL if nobody waits for it
+      struct nfs_context *context;
+      uint64_t    offset;
+      uint64_t    count;
+      std::string data;
+      int         result;//bytes read or negative error
+      bool        done;
+    };
+    std::deque<ReadRequest *> m_readAhead;//consecutive, the first one holds the position
+    static std::set<ReadRequest *> m_readsOnWire;//of all files, until their callback ran
+    static CCriticalSection m_readsOnWireLock;
+
+    static void ReadAheadCallback(int err, struct nfs_context *nfs, void *data, void *private_data);
+    static void ReleaseReadRequest(ReadRequest *request);
+    //reads at pos from the requests in flight, all called with the connection lock held
+    int  ReadAhead(uint64_t pos, char *buf, unsigned int size);
+    void FillReadAhead(uint64_t pos);
+    void DropReadAhead();
+    bool WaitForReadAhead(ReadRequest *request);
   };
 }
 #endif // FILENFS_H_
@@ -0,0 +1,367 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "PersistentCache.h"
+#include "Directory.h"
+#include "File.h"
+#include "FileItem.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SingleLock.h"
+#include "utils/log.h"
+#include "utils/md5.h"
+#include "utils/URIUtils.h"
+
+#include <algorithm>
+#include <string.h>
+
+using namespace XFILE;
+
+CPersistentCacheStore::CPersistentCacheStore(const CStdString& path, int64_t maxSize) :
+  m_path(path),
+  m_maxSize(maxSize),
+  m_size(0),
+  m_clock(0),
+  m_loaded(false)
+{
+}
+
+CPersistentCacheStore& CPersistentCacheStore::GetInstance()
+{
+  static CPersistentCacheStore sStore("special://temp/blockcache/", g_advancedSettings.m_cacheDiskSize);
+  return sStore;
+}
+
+CStdString CPersistentCacheStore::GetName(const CStdString& key, unsigned int block) const
+{
+  CStdString name;
+  name.Format("%s-%u.blk", key.c_str(), block);
+  return name;
+}
+
+bool CPersistentCacheStore::Has(const CStdString& key, unsigned int block)
+{
+  CSingleLock lock(m_section);
+  Load();
+  return m_entries.find(GetName(key, block)) != m_entries.end();
+}
+
+bool CPersistentCacheStore::Read(const CStdString& key, unsigned int block, std::string& data)
+{
+  CStdString name = GetName(key, block);
+  {
+    CSingleLock lock(m_section);
+    Load();
+
+    EntryMap::iterator it = m_entries.find(name);
+    if (it == m_entries.end())
+      return false;
+    it->second.used = ++m_clock;
+  }
+
+  // the block may be evicted meanwhile, then the read fails
+  CFile file;
+  if (!file.Open(m_path + name))
+    return false;
+
+  data.resize((size_t)file.GetLength());
+  bool ok = data.empty() || file.Read(&data[0], data.size()) == data.size();
+  file.Close();
+  return ok;
+}
+
+void CPersistentCacheStore::Write(const CStdString& key, unsigned int block, const std::string& data)
+{
+  if (m_maxSize <= 0)
+    return;
+
+  CStdString name = GetName(key, block);
+  {
+    CSingleLock lock(m_section);
+    Load();
+  }
+
+  CFile file;
+  if (!file.OpenForWrite(m_path + name, true))
+  {
+    CLog::Log(LOGWARNING, "CPersistentCacheStore::Write - unable to write %s", name.c_str());
+    return;
+  }
+  bool ok = file.Write(data.data(), data.size()) == (int)data.size();
+  file.Close();
+  if (!ok)
+  {
+    CFile::Delete(m_path + name);
+    return;
+  }
+
+  CSingleLock lock(m_section);
+  Entry& entry = m_entries[name];
+  m_size    += (int64_t)data.size() - entry.size;
+  entry.size = data.size();
+  entry.used = ++m_clock;
+  Evict();
+}
+
+void CPersistentCacheStore::SetMaxSize(int64_t maxSize)
+{
+  CSingleLock lock(m_section);
+  m_maxSize = maxSize;
+  if (m_loaded)
+    Evict();
+}
+
+void CPersistentCacheStore::Clear()
+{
+  CSingleLock lock(m_section);
+  Load();
+  for (EntryMap::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+    CFile::Delete(m_path + it->first);
+  m_entries.clear();
+  m_size = 0;
+}
+
+void CPersistentCacheStore::Load()
+{
+  if (m_loaded)
+    return;
+  m_loaded = true;
+
+  if (!CDirectory::Exists(m_path))
+  {
+    CDirectory::Create(m_path);
+    return;
+  }
+
+  // what was used last before is the oldest file
+  CFileItemList items;
+  CDirectory::GetDirectory(m_path, items, ".blk", DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_BYPASS_CACHE);
+  items.Sort(SORT_METHOD_DATE, SortOrderAscending);
+  for (int i = 0; i < items.Size(); i++)
+  {
+    Entry& entry = m_entries[URIUtils::GetFileName(items[i]->GetPath())];
+    entry.size = items[i]->m_dwSize;
+    entry.used = ++m_clock;
+    m_size += entry.size;
+  }
+  Evict();
+}
+
+void CPersistentCacheStore::Evict()
+{
+  while (m_size > m_maxSize && !m_entries.empty())
+  {
+    EntryMap::iterator oldest = m_entries.begin();
+    for (EntryMap::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+    {
+      if (it->second.used < oldest->second.used)
+        oldest = it;
+    }
+    CFile::Delete(m_path + oldest->first);
+    m_size -= oldest->second.size;
+    m_entries.erase(oldest);
+  }
+}
+
+CPersistentCache::CPersistentCache(CCacheStrategy *pCache) :
+  m_pCache(pCache),
+  m_length(0),
+  m_writePos(0),
+  m_blockStart(0),
+  m_blocksWritten(0),
+  m_readStart(-1)
+{
+}
+
+CPersistentCache::~CPersistentCache()
+{
+  delete m_pCache;
+}
+
+int CPersistentCache::Open()
+{
+  m_key.clear();
+  m_length        = 0;
+  m_writePos      = 0;
+  m_blocksWritten = 0;
+  m_block.clear();
+  m_readStart     = -1;
+  m_read.clear();
+  return m_pCache->Open();
+}
+
+void CPersistentCache::Close()
+{
+  m_pCache->Close();
+  m_key.clear();
+  m_block.clear();
+  m_read.clear();
+  m_readStart = -1;
+}
+
+void CPersistentCache::SetSource(const CStdString& strPath, int64_t iLength, int64_t iModified)
+{
+  // without a size and time there is no telling whether the file changed
+  if (iLength <= 0 || iModified == 0 || CPersistentCacheStore::GetInstance().GetMaxSize() <= 0)
+    return;
+
+  CStdString key;
+  key.Format("%s|%"PRId64"|%"PRId64, strPath.c_str(), iLength, iModified);
+  m_key    = XBMC::XBMC_MD5::GetMD5(key);
+  m_length = iLength;
+}
+
+int CPersistentCache::WriteToCache(const char *pBuffer, size_t iSize)
+{
+  int iWritten = m_pCache->WriteToCache(pBuffer, iSize);
+  if (iWritten <= 0)
+    return iWritten;
+
+  const char* data = pBuffer;
+  size_t      left = iWritten;
+  int64_t     pos  = m_writePos;
+  while (!m_key.empty() && left > 0 && m_blocksWritten < PERSISTENT_CACHE_BLOCKS_PER_SEEK)
+  {
+    // blocks start at a multiple of the block size
+    if (m_block.empty())
+    {
+      size_t skip = (size_t)((PERSISTENT_CACHE_BLOCK_SIZE - pos % PERSISTENT_CACHE_BLOCK_SIZE) % PERSISTENT_CACHE_BLOCK_SIZE);
+      if (skip >= left)
+        break;
+      data += skip;
+      left -= skip;
+      pos  += skip;
+      m_blockStart = pos;
+    }
+
+    size_t len = std::min(left, PERSISTENT_CACHE_BLOCK_SIZE - m_block.size());
+    m_block.append(data, len);
+    data += len;
+    left -= len;
+    pos  += len;
+
+    if (m_block.size() == (size_t)PERSISTENT_CACHE_BLOCK_SIZE)
+      StoreBlock();
+  }
+
+  m_writePos += iWritten;
+  return iWritten;
+}
+
+void CPersistentCache::StoreBlock()
+{
+  unsigned int block = (unsigned int)(m_blockStart / PERSISTENT_CACHE_BLOCK_SIZE);
+  CPersistentCacheStore& store = CPersistentCacheStore::GetInstance();
+  if (!store.Has(m_key, block))
+    store.Write(m_key, block, m_block);
+
+  m_block.clear();
+  m_blocksWritten++;
+}
+
+int CPersistentCache::ReadFromCache(char *pBuffer, size_t iMaxSize)
+{
+  int iRead = m_pCache->ReadFromCache(pBuffer, iMaxSize);
+
+  // CFileCache waits on our event, not the one of the wrapped cache
+  if (iRead > 0)
+    m_space.Set();
+  return iRead;
+}
+
+int64_t CPersistentCache::WaitForData(unsigned int iMinAvail, unsigned int iMillis)
+{
+  return m_pCache->WaitForData(iMinAvail, iMillis);
+}
+
+int64_t CPersistentCache::Seek(int64_t iFilePosition)
+{
+  return m_pCache->Seek(iFilePosition);
+}
+
+void CPersistentCache::Reset(int64_t iSourcePosition)
+{
+  m_pCache->Reset(iSourcePosition);
+  m_writePos      = iSourcePosition;
+  m_blocksWritten = 0;
+  m_block.clear();
+}
+
+void CPersistentCache::EndOfInput()
+{
+  // the last block of a file is shorter
+  if (!m_key.empty() && !m_block.empty() && m_writePos == m_length)
+    StoreBlock();
+
+  m_pCache->EndOfInput();
+}
+
+bool CPersistentCache::IsEndOfInput()
+{
+  return m_pCache->IsEndOfInput();
+}
+
+void CPersistentCache::ClearEndOfInput()
+{
+  m_pCache->ClearEndOfInput();
+}
+
+bool CPersistentCache::IsStored(int64_t iSourcePosition)
+{
+  if (m_key.empty() || iSourcePosition >= m_length)
+    return false;
+
+  return CPersistentCacheStore::GetInstance().Has(m_key, (unsigned int)(iSourcePosition / PERSISTENT_CACHE_BLOCK_SIZE));
+}
+
+int CPersistentCache::ReadFromStore(int64_t iSourcePosition, char *pBuffer, size_t iMaxSize)
+{
+  if (m_key.empty() || iSourcePosition >= m_length)
+    return 0;
+
+  int64_t start = iSourcePosition - iSourcePosition % PERSISTENT_CACHE_BLOCK_SIZE;
+  if (start != m_readStart)
+  {
+    m_readStart = -1;
+    if (!CPersistentCacheStore::GetInstance().Read(m_key, (unsigned int)(start / PERSISTENT_CACHE_BLOCK_SIZE), m_read))
+      return 0;
+
+    // only the last block of the file may be short
+    if (m_read.size() != (size_t)PERSISTENT_CACHE_BLOCK_SIZE && start + (int64_t)m_read.size() != m_length)
+    {
+      CLog::Log(LOGWARNING, "CPersistentCache::ReadFromStore - ignoring block of %u bytes at %"PRId64, (unsigned int)m_read.size(), start);
+      return 0;
+    }
+    m_readStart = start;
+  }
+
+  size_t offset = (size_t)(iSourcePosition - start);
+  size_t len    = std::min(iMaxSize, m_read.size() - offset);
+  memcpy(pBuffer, m_read.data() + offset, len);
+  return (int)len;
+}
+
+int64_t CPersistentCache::GetSourcePosition(int64_t iFilePosition)
+{
+  // from the start of the block, so it is kept whole
+  if (m_key.empty())
+    return iFilePosition;
+  return iFilePosition - iFilePosition % PERSISTENT_CACHE_BLOCK_SIZE;
+}
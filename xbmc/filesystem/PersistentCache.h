@@ -0,0 +1,128 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef CACHEPERSISTENT_H
+#define CACHEPERSISTENT_H
+
+#include "CacheStrategy.h"
+#include "threads/CriticalSection.h"
+#include "utils/StdString.h"
+
+#include <map>
+#include <string>
+
+namespace XFILE {
+
+#define PERSISTENT_CACHE_BLOCK_SIZE      (128 * 1024)
+// blocks kept after each open or seek, playing on past them keeps nothing
+#define PERSISTENT_CACHE_BLOCKS_PER_SEEK 8
+
+/**
+ * Blocks of files kept on disk, up to a total size after which the least
+ * recently used are removed
+ */
+class CPersistentCacheStore
+{
+public:
+  CPersistentCacheStore(const CStdString& path, int64_t maxSize);
+
+  static CPersistentCacheStore& GetInstance();
+
+  bool Has(const CStdString& key, unsigned int block);
+
+  /**
+   * Read a block into data, false if it is not kept
+   */
+  bool Read(const CStdString& key, unsigned int block, std::string& data);
+  void Write(const CStdString& key, unsigned int block, const std::string& data);
+  void Clear();
+
+  int64_t GetMaxSize() const { return m_maxSize; }
+  void SetMaxSize(int64_t maxSize);
+
+private:
+  typedef struct
+  {
+    int64_t  size;
+    uint64_t used;
+  } Entry;
+  typedef std::map<CStdString, Entry> EntryMap;
+
+  CStdString GetName(const CStdString& key, unsigned int block) const;
+  void Load();
+  void Evict();
+
+  CCriticalSection m_section;
+  CStdString       m_path;
+  int64_t          m_maxSize;
+  int64_t          m_size;
+  uint64_t         m_clock;
+  bool             m_loaded;
+  EntryMap         m_entries;  // by file name
+};
+
+/**
+ * Keeps the blocks read after opening and seeking a file in the
+ * CPersistentCacheStore, so opening it again reads them from local disk.
+ * The data is buffered by the wrapped strategy.
+ */
+class CPersistentCache : public CCacheStrategy
+{
+public:
+  CPersistentCache(CCacheStrategy *pCache);
+  virtual ~CPersistentCache();
+
+  virtual int Open();
+  virtual void Close();
+
+  virtual int WriteToCache(const char *pBuffer, size_t iSize);
+  virtual int ReadFromCache(char *pBuffer, size_t iMaxSize);
+  virtual int64_t WaitForData(unsigned int iMinAvail, unsigned int iMillis);
+
+  virtual int64_t Seek(int64_t iFilePosition);
+  virtual void Reset(int64_t iSourcePosition);
+
+  virtual void EndOfInput();
+  virtual bool IsEndOfInput();
+  virtual void ClearEndOfInput();
+
+  virtual void SetSource(const CStdString& strPath, int64_t iLength, int64_t iModified);
+  virtual bool IsStored(int64_t iSourcePosition);
+  virtual int ReadFromStore(int64_t iSourcePosition, char *pBuffer, size_t iMaxSize);
+  virtual int64_t GetSourcePosition(int64_t iFilePosition);
+
+protected:
+  void StoreBlock();
+
+  CCacheStrategy *m_pCache;
+  CStdString      m_key;           // empty if the source is not kept
+  int64_t         m_length;
+  int64_t         m_writePos;      // in the source, of the next byte written
+  int64_t         m_blockStart;    // in the source, of m_block
+  std::string     m_block;         // being written
+  unsigned int    m_blocksWritten; // since the last reset
+  int64_t         m_readStart;     // in the source, of m_read, -1 if none
+  std::string     m_read;          // last block read from the store
+};
+
+}
+
+#endif
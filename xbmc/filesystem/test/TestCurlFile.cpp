@@ -0,0 +1,370 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/CurlFile.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SingleLock.h"
+#include "threads/Thread.h"
+#include "URL.h"
+
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <algorithm>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define TEST_FILE_SIZE (3 * 1024 * 1024)
+
+static char FileByte(int pos)
+{
+  return (char)(pos % 251);
+}
+
+class CTestHttpServer;
+
+/* answers a single request on one connection */
+class CFileConnection : public CThread
+{
+public:
+  CFileConnection(CTestHttpServer& server, int socket)
+    : CThread("FileConnection"), m_server(server), m_socket(socket) {}
+  virtual ~CFileConnection() { close(m_socket); }
+
+  /* wakes up a send to a client that stopped reading */
+  void Drop() { shutdown(m_socket, SHUT_RDWR); }
+
+protected:
+  virtual void Process();
+
+  CTestHttpServer& m_server;
+  int              m_socket;
+};
+
+/* an http server for a file of TEST_FILE_SIZE bytes. It says it takes ranges,
+ * but only honours them when asked to, and can cut responses to them short */
+class CTestHttpServer : public CThread
+{
+public:
+  CTestHttpServer(bool ranges, int cutOffs = 0)
+    : CThread("TestHttpServer"), m_ranges(ranges), m_cutOffs(cutOffs), m_socket(-1), m_port(0) {}
+  virtual ~CTestHttpServer() { Stop(); }
+
+  bool Start()
+  {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    m_socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (m_socket < 0 || bind(m_socket, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(m_socket, 8) != 0 || getsockname(m_socket, (struct sockaddr*)&addr, &len) != 0)
+      return false;
+
+    m_port = ntohs(addr.sin_port);
+    Create();
+    return true;
+  }
+
+  void Stop()
+  {
+    StopThread();
+    for (std::vector<CFileConnection*>::iterator it = m_connections.begin(); it != m_connections.end(); ++it)
+    {
+      (*it)->Drop();
+      (*it)->StopThread();
+      delete *it;
+    }
+    m_connections.clear();
+
+    if (m_socket >= 0)
+      close(m_socket);
+    m_socket = -1;
+  }
+
+  CStdString GetURL() const
+  {
+    CStdString url;
+    url.Format("http://127.0.0.1:%d/file.ts", m_port);
+    return url;
+  }
+
+  bool HonoursRanges() const { return m_ranges; }
+
+  /* notes a request for a closed range, and says whether to cut it short */
+  bool RangeRequested(int start)
+  {
+    CSingleLock lock(m_section);
+    m_starts.push_back(start);
+    if (m_cutOffs <= 0)
+      return false;
+    m_cutOffs--;
+    return true;
+  }
+
+  /* the starts of the closed ranges asked for so far */
+  std::vector<int> GetStarts()
+  {
+    CSingleLock lock(m_section);
+    return m_starts;
+  }
+
+protected:
+  virtual void Process()
+  {
+    while (!m_bStop)
+    {
+      fd_set fds;
+      FD_ZERO(&fds);
+      FD_SET(m_socket, &fds);
+      struct timeval t = { 0, 100000 };
+      if (select(m_socket + 1, &fds, NULL, NULL, &t) <= 0)
+        continue;
+
+      int client = accept(m_socket, NULL, NULL);
+      if (client < 0)
+        continue;
+      CFileConnection* connection = new CFileConnection(*this, client);
+      m_connections.push_back(connection);
+      connection->Create();
+    }
+  }
+
+  bool                           m_ranges;
+  int                            m_cutOffs;
+  int                            m_socket;
+  int                            m_port;
+  std::vector<CFileConnection*> m_connections;
+  std::vector<int>               m_starts;
+  CCriticalSection               m_section;
+};
+
+void CFileConnection::Process()
+{
+  std::string request;
+  char buf[1024];
+  while (!m_bStop && request.find("\r\n\r\n") == std::string::npos)
+  {
+    ssize_t len = recv(m_socket, buf, sizeof(buf), 0);
+    if (len <= 0)
+      return;
+    request.append(buf, len);
+  }
+
+  int start = 0;
+  int end   = TEST_FILE_SIZE - 1;
+  bool partial = false;
+  bool cutOff  = false;
+  size_t range = request.find("Range: bytes=");
+  if (m_server.HonoursRanges() && range != std::string::npos)
+  {
+    const char* spec = request.c_str() + range + strlen("Range: bytes=");
+    char* next;
+    start = (int)strtol(spec, &next, 10);
+    if (*next == '-' && isdigit(next[1]))
+    {
+      end    = std::min((int)strtol(next + 1, NULL, 10), TEST_FILE_SIZE - 1);
+      cutOff = m_server.RangeRequested(start);
+    }
+    partial = true;
+  }
+
+  CStdString header;
+  if (partial)
+    header.Format("HTTP/1.1 206 Partial Content\r\n"
+                  "Content-Range: bytes %d-%d/%d\r\n", start, end, TEST_FILE_SIZE);
+  else
+    header = "HTTP/1.1 200 OK\r\n";
+  header.AppendFormat("Content-Length: %d\r\n"
+                      "Content-Type: application/octet-stream\r\n"
+                      "Accept-Ranges: bytes\r\n"
+                      "Connection: close\r\n\r\n", end + 1 - start);
+  if (send(m_socket, header.c_str(), header.size(), MSG_NOSIGNAL) != (ssize_t)header.size())
+    return;
+
+  /* a cut off response stops half way, a dropped connection fails the send */
+  int stop = cutOff ? start + (end + 1 - start) / 2 : end + 1;
+  int pos = start;
+  while (!m_bStop && pos < stop)
+  {
+    int len = std::min((int)sizeof(buf), stop - pos);
+    for (int i = 0; i < len; i++)
+      buf[i] = FileByte(pos + i);
+    if (send(m_socket, buf, len, MSG_NOSIGNAL) != len)
+      return;
+    pos += len;
+  }
+  shutdown(m_socket, SHUT_RDWR);
+}
+
+class TestCurlFile : public testing::Test
+{
+protected:
+  TestCurlFile()
+  {
+    m_connections = g_advancedSettings.m_curlConnections;
+    g_advancedSettings.m_curlConnections = 2;
+  }
+  ~TestCurlFile()
+  {
+    g_advancedSettings.m_curlConnections = m_connections;
+  }
+
+  /* reads from the current position of the file to its end, and returns
+   * how many bytes there were that did not match */
+  static int ReadToEnd(XFILE::CCurlFile& file, int64_t& pos)
+  {
+    char buf[65536];
+    int wrong = 0;
+    unsigned int read;
+    while ((read = file.Read(buf, sizeof(buf))) > 0)
+    {
+      for (unsigned int i = 0; i < read; i++)
+      {
+        if (buf[i] != FileByte((int)pos + i))
+          wrong++;
+      }
+      pos += read;
+    }
+    return wrong;
+  }
+
+  int m_connections;
+};
+
+TEST_F(TestCurlFile, RangeIgnored)
+{
+  CTestHttpServer server(false);
+  ASSERT_TRUE(server.Start());
+
+  XFILE::CCurlFile file;
+  ASSERT_TRUE(file.Open(CURL(server.GetURL())));
+  EXPECT_EQ(TEST_FILE_SIZE, file.GetLength());
+
+  /* the ranges are given up on and the file is read from the start over one connection */
+  int64_t pos = 0;
+  EXPECT_EQ(0, ReadToEnd(file, pos));
+  EXPECT_EQ(TEST_FILE_SIZE, pos);
+  file.Close();
+}
+
+TEST_F(TestCurlFile, Ranges)
+{
+  CTestHttpServer server(true);
+  ASSERT_TRUE(server.Start());
+
+  XFILE::CCurlFile file;
+  ASSERT_TRUE(file.Open(CURL(server.GetURL())));
+  EXPECT_EQ(TEST_FILE_SIZE, file.GetLength());
+
+  /* the ranges are put back together in order */
+  int64_t pos = 0;
+  EXPECT_EQ(0, ReadToEnd(file, pos));
+  EXPECT_EQ(TEST_FILE_SIZE, pos);
+  file.Close();
+
+  std::vector<int> starts = server.GetStarts();
+  ASSERT_EQ(3U, starts.size());
+  for (size_t i = 0; i < starts.size(); i++)
+    EXPECT_EQ((int)i * 1024 * 1024, starts[i]);
+}
+
+TEST_F(TestCurlFile, SeekInsideWindow)
+{
+  CTestHttpServer server(true);
+  ASSERT_TRUE(server.Start());
+
+  XFILE::CCurlFile file;
+  ASSERT_TRUE(file.Open(CURL(server.GetURL())));
+
+  char buf[1000];
+  ASSERT_EQ(sizeof(buf), file.Read(buf, sizeof(buf)));
+  EXPECT_EQ(FileByte(999), buf[999]);
+
+  /* the range that was asked for already has this */
+  int64_t pos = 1100;
+  EXPECT_EQ(pos, file.Seek(100, SEEK_CUR));
+  EXPECT_EQ(0, ReadToEnd(file, pos));
+  EXPECT_EQ(TEST_FILE_SIZE, pos);
+  file.Close();
+
+  std::vector<int> starts = server.GetStarts();
+  EXPECT_TRUE(std::find(starts.begin(), starts.end(), 1100) == starts.end());
+}
+
+TEST_F(TestCurlFile, SeekOutsideWindow)
+{
+  CTestHttpServer server(true);
+  ASSERT_TRUE(server.Start());
+
+  XFILE::CCurlFile file;
+  ASSERT_TRUE(file.Open(CURL(server.GetURL())));
+
+  char buf[1000];
+  ASSERT_EQ(sizeof(buf), file.Read(buf, sizeof(buf)));
+
+  /* past the ranges asked for, the window starts over from there */
+  int64_t pos = 2 * 1024 * 1024 + 1000;
+  EXPECT_EQ(pos, file.Seek(pos, SEEK_SET));
+  EXPECT_EQ(0, ReadToEnd(file, pos));
+  EXPECT_EQ(TEST_FILE_SIZE, pos);
+
+  /* and so it does going back */
+  pos = 1000;
+  EXPECT_EQ(pos, file.Seek(pos, SEEK_SET));
+  EXPECT_EQ(0, ReadToEnd(file, pos));
+  EXPECT_EQ(TEST_FILE_SIZE, pos);
+  file.Close();
+
+  std::vector<int> starts = server.GetStarts();
+  EXPECT_TRUE(std::find(starts.begin(), starts.end(), 2 * 1024 * 1024 + 1000) != starts.end());
+  EXPECT_TRUE(std::find(starts.begin(), starts.end(), 1000) != starts.end());
+}
+
+TEST_F(TestCurlFile, RangeCutOff)
+{
+  CTestHttpServer server(true, 2);
+  ASSERT_TRUE(server.Start());
+
+  XFILE::CCurlFile file;
+  ASSERT_TRUE(file.Open(CURL(server.GetURL())));
+
+  /* what is missing of the ranges cut off is asked for again */
+  int64_t pos = 0;
+  EXPECT_EQ(0, ReadToEnd(file, pos));
+  EXPECT_EQ(TEST_FILE_SIZE, pos);
+  file.Close();
+
+  std::vector<int> starts = server.GetStarts();
+  EXPECT_TRUE(std::find(starts.begin(), starts.end(), 512 * 1024) != starts.end());
+}
@@ -0,0 +1,236 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/DirectoryCache.h"
+#include "filesystem/File.h"
+#include "FileItem.h"
+#include "settings/AdvancedSettings.h"
+#include "test/TestUtils.h"
+#include "utils/URIUtils.h"
+
+#include "gtest/gtest.h"
+
+static void FillItems(CFileItemList& items, const CStdString& path, int count)
+{
+  items.Clear();
+  items.SetPath(path);
+  for (int i = 0; i < count; i++)
+  {
+    CStdString file;
+    file.Format("%s/file%05i.mkv", path.c_str(), i);
+    items.Add(CFileItemPtr(new CFileItem(file, false)));
+  }
+}
+
+/* keeps no more than two folders on disk */
+class CSmallDirectoryCache : public XFILE::CDirectoryCache
+{
+public:
+  CSmallDirectoryCache() { m_persistMax = 2; }
+  using XFILE::CDirectoryCache::GetPersistentFile;
+};
+
+TEST(TestDirectoryCache, EvictBySize)
+{
+  unsigned int size = g_advancedSettings.m_dirCacheSize;
+  g_advancedSettings.m_dirCacheSize = 1000 * (sizeof(CFileItem) + 100);
+
+  XFILE::CDirectoryCache cache;
+  CFileItemList items;
+  FillItems(items, "smb://server/share/small", 10);
+  cache.SetDirectory("smb://server/share/small", items, XFILE::DIR_CACHE_ONCE);
+  FillItems(items, "smb://server/share/large", 800);
+  cache.SetDirectory("smb://server/share/large", items, XFILE::DIR_CACHE_ONCE);
+
+  /* the least recently used folder makes room */
+  EXPECT_TRUE(cache.GetDirectory("smb://server/share/small", items, true));
+  FillItems(items, "smb://server/share/other", 500);
+  cache.SetDirectory("smb://server/share/other", items, XFILE::DIR_CACHE_ONCE);
+  EXPECT_FALSE(cache.GetDirectory("smb://server/share/large", items, true));
+  EXPECT_TRUE(cache.GetDirectory("smb://server/share/small", items, true));
+  EXPECT_EQ(10, items.Size());
+
+  XFILE::CDirectoryCache::Stats stats;
+  cache.GetStats(stats);
+  EXPECT_EQ(2U, stats.hits);
+  EXPECT_EQ(1U, stats.misses);
+  EXPECT_EQ(1U, stats.evictions);
+  EXPECT_EQ(2U, stats.dirs);
+  EXPECT_GE((size_t)g_advancedSettings.m_dirCacheSize, stats.size);
+
+  g_advancedSettings.m_dirCacheSize = size;
+}
+
+TEST(TestDirectoryCache, Persistent)
+{
+  bool persistent = g_advancedSettings.m_dirCachePersistent;
+  g_advancedSettings.m_dirCachePersistent = true;
+
+  XFILE::CFile *archive = XBMC_CREATETEMPFILE(".zip");
+  ASSERT_TRUE(archive);
+  CStdString path;
+  URIUtils::CreateArchivePath(path, "zip", XBMC_TEMPFILEPATH(archive), "");
+
+  CFileItemList items;
+  FillItems(items, path, 100);
+  {
+    XFILE::CDirectoryCache cache;
+    cache.SetDirectory(path, items, XFILE::DIR_CACHE_ALWAYS);
+
+    /* folders with no archive behind them stay in memory */
+    cache.SetDirectory("tuxbox://box/", items, XFILE::DIR_CACHE_ALWAYS);
+  }
+
+  /* a new cache, as after a restart, reads it back */
+  XFILE::CDirectoryCache cache;
+  items.Clear();
+  EXPECT_TRUE(cache.GetDirectory(path, items));
+  EXPECT_EQ(100, items.Size());
+  EXPECT_FALSE(cache.GetDirectory("tuxbox://box/", items));
+
+  XFILE::CDirectoryCache::Stats stats;
+  cache.GetStats(stats);
+  EXPECT_EQ(1U, stats.diskHits);
+
+  /* clearing it also clears it on disk */
+  cache.ClearSubPaths(path);
+  XFILE::CDirectoryCache other;
+  EXPECT_FALSE(other.GetDirectory(path, items));
+
+  EXPECT_TRUE(XFILE::CFile::Delete("special://temp/dircache/index.dat"));
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(archive));
+  g_advancedSettings.m_dirCachePersistent = persistent;
+}
+
+TEST(TestDirectoryCache, PersistentArchiveChanged)
+{
+  bool persistent = g_advancedSettings.m_dirCachePersistent;
+  g_advancedSettings.m_dirCachePersistent = true;
+
+  XFILE::CFile *archive = XBMC_CREATETEMPFILE(".zip");
+  ASSERT_TRUE(archive);
+  CStdString path;
+  URIUtils::CreateArchivePath(path, "zip", XBMC_TEMPFILEPATH(archive), "");
+
+  CFileItemList items;
+  FillItems(items, path, 10);
+  {
+    XFILE::CDirectoryCache cache;
+    cache.SetDirectory(path, items, XFILE::DIR_CACHE_ALWAYS);
+  }
+
+  /* the listing on disk no longer matches the archive */
+  XFILE::CFile file;
+  ASSERT_TRUE(file.OpenForWrite(XBMC_TEMPFILEPATH(archive), true));
+  file.Write("PK", 2);
+  file.Close();
+
+  XFILE::CDirectoryCache cache;
+  EXPECT_FALSE(cache.GetDirectory(path, items));
+
+  EXPECT_TRUE(XFILE::CFile::Delete("special://temp/dircache/index.dat"));
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(archive));
+  g_advancedSettings.m_dirCachePersistent = persistent;
+}
+
+TEST(TestDirectoryCache, PersistentDamaged)
+{
+  bool persistent = g_advancedSettings.m_dirCachePersistent;
+  g_advancedSettings.m_dirCachePersistent = true;
+
+  XFILE::CFile *archive = XBMC_CREATETEMPFILE(".zip");
+  ASSERT_TRUE(archive);
+  CStdString path;
+  URIUtils::CreateArchivePath(path, "zip", XBMC_TEMPFILEPATH(archive), "");
+
+  CFileItemList items;
+  FillItems(items, path, 10);
+  {
+    XFILE::CDirectoryCache cache;
+    cache.SetDirectory(path, items, XFILE::DIR_CACHE_ALWAYS);
+  }
+
+  /* an index cut short, as by a crash while it was written */
+  XFILE::CFile file;
+  ASSERT_TRUE(file.Open("special://temp/dircache/index.dat"));
+  std::string data((size_t)file.GetLength(), '\0');
+  ASSERT_EQ((unsigned int)data.size(), file.Read(&data[0], data.size()));
+  file.Close();
+  for (size_t length = 0; length < data.size(); length += 7)
+  {
+    ASSERT_TRUE(file.OpenForWrite("special://temp/dircache/index.dat", true));
+    file.Write(data.data(), length);
+    file.Close();
+
+    XFILE::CDirectoryCache cache;
+    EXPECT_FALSE(cache.GetDirectory(path, items)) << "damaged index " << length;
+  }
+
+  /* put it back so the listing it points to is removed */
+  ASSERT_TRUE(file.OpenForWrite("special://temp/dircache/index.dat", true));
+  file.Write(data.data(), data.size());
+  file.Close();
+  XFILE::CDirectoryCache cache;
+  EXPECT_TRUE(cache.GetDirectory(path, items));
+  cache.ClearDirectory(path);
+  EXPECT_TRUE(XFILE::CFile::Delete("special://temp/dircache/index.dat"));
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(archive));
+  g_advancedSettings.m_dirCachePersistent = persistent;
+}
+
+TEST(TestDirectoryCache, PersistentEvict)
+{
+  bool persistent = g_advancedSettings.m_dirCachePersistent;
+  g_advancedSettings.m_dirCachePersistent = true;
+
+  XFILE::CFile *archives[3];
+  CStdString paths[3];
+  CFileItemList items;
+  CSmallDirectoryCache cache;
+  for (int i = 0; i < 3; i++)
+  {
+    archives[i] = XBMC_CREATETEMPFILE(".zip");
+    ASSERT_TRUE(archives[i]);
+    URIUtils::CreateArchivePath(paths[i], "zip", XBMC_TEMPFILEPATH(archives[i]), "");
+    FillItems(items, paths[i], 10);
+    cache.SetDirectory(paths[i], items, XFILE::DIR_CACHE_ALWAYS);
+
+    /* the first folder is in use, so the second is the one to go */
+    if (i == 1)
+      EXPECT_TRUE(cache.GetDirectory(paths[0], items));
+  }
+  EXPECT_TRUE(XFILE::CFile::Exists(cache.GetPersistentFile(paths[0])));
+  EXPECT_FALSE(XFILE::CFile::Exists(cache.GetPersistentFile(paths[1])));
+  EXPECT_TRUE(XFILE::CFile::Exists(cache.GetPersistentFile(paths[2])));
+
+  /* a new cache, as after a restart, only has those left */
+  XFILE::CDirectoryCache other;
+  EXPECT_TRUE(other.GetDirectory(paths[0], items));
+  EXPECT_FALSE(other.GetDirectory(paths[1], items));
+  EXPECT_TRUE(other.GetDirectory(paths[2], items));
+
+  for (int i = 0; i < 3; i++)
+  {
+    other.ClearDirectory(paths[i]);
+    EXPECT_TRUE(XBMC_DELETETEMPFILE(archives[i]));
+  }
+  EXPECT_TRUE(XFILE::CFile::Delete("special://temp/dircache/index.dat"));
+  g_advancedSettings.m_dirCachePersistent = persistent;
+}
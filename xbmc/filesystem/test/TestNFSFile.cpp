@@ -0,0 +1,308 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+
+#ifdef HAS_FILESYSTEM_NFS
+#include "filesystem/DllLibNfs.h"
+#include "filesystem/NFSFile.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SingleLock.h"
+
+#include <poll.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#define CHUNK_SIZE 32768
+#define TEST_FILE_SIZE (10 * CHUNK_SIZE + 100)
+
+static char FileByte(uint64_t pos)
+{
+  return (char)(pos % 251);
+}
+
+/* a server that answers the reads sent ahead newest first, one each time
+ * it is serviced */
+class CFakeNfsLib : public DllLibNfsInterface
+{
+public:
+  CFakeNfsLib() : m_pos(0)
+  {
+    /* always readable, so the wait for a reply never sleeps */
+    m_pipe[0] = m_pipe[1] = -1;
+    m_ready = pipe(m_pipe) == 0 && write(m_pipe[1], "x", 1) == 1;
+  }
+  virtual ~CFakeNfsLib()
+  {
+    if (m_pipe[0] >= 0)
+      close(m_pipe[0]);
+    if (m_pipe[1] >= 0)
+      close(m_pipe[1]);
+  }
+
+  bool IsReady() const { return m_ready; }
+
+  void Complete(size_t i)
+  {
+    Pending pending = m_pending[i];
+    m_pending.erase(m_pending.begin() + i);
+    std::string data((size_t)pending.count, 0);
+    for (uint64_t pos = 0; pos < pending.count; pos++)
+      data[(size_t)pos] = FileByte(pending.offset + pos);
+    pending.cb((int)pending.count, NULL, &data[0], pending.private_data);
+  }
+  void CompleteAll()
+  {
+    while (!m_pending.empty())
+      Complete(m_pending.size() - 1);
+  }
+  size_t Pendings() const { return m_pending.size(); }
+
+  virtual int nfs_pread_async(struct nfs_context *nfs, struct nfsfh *nfsfh, uint64_t offset, uint64_t count, nfs_cb cb, void *private_data)
+  {
+    Pending pending = { offset, count, cb, private_data };
+    m_pending.push_back(pending);
+    return 0;
+  }
+  virtual int nfs_service(struct nfs_context *nfs, int revents)
+  {
+    if (!m_pending.empty())
+      Complete(m_pending.size() - 1);
+    return 0;
+  }
+  virtual int nfs_which_events(struct nfs_context *nfs) { return POLLIN; }
+  virtual int nfs_get_fd(struct nfs_context *nfs) { return m_pipe[0]; }
+  virtual int nfs_lseek(struct nfs_context *nfs, struct nfsfh *nfsfh, uint64_t offset, int whence, uint64_t *current_offset)
+  {
+    if (whence == SEEK_SET)
+      m_pos = offset;
+    else if (whence == SEEK_CUR)
+      m_pos += (int64_t)offset;
+    else
+      return -1;
+    *current_offset = m_pos;
+    return 0;
+  }
+  virtual int nfs_close(struct nfs_context *nfs, struct nfsfh *nfsfh) { return 0; }
+  virtual char *nfs_get_error(struct nfs_context *nfs) { return (char *)"fake"; }
+  /* like older libnfs, the callbacks of the reads on the wire never run */
+  virtual void nfs_destroy_context(struct nfs_context *nfs) { m_pending.clear(); }
+
+  virtual void mount_free_export_list(struct exportnode *exports) {}
+  virtual struct exportnode *mount_getexports(const char *server) { return NULL; }
+  virtual struct nfs_server_list *nfs_find_local_servers(void) { return NULL; }
+  virtual void free_nfs_srvr_list(struct nfs_server_list *srv) {}
+  virtual struct nfs_context *nfs_init_context(void) { return NULL; }
+  virtual uint64_t nfs_get_readmax(struct nfs_context *nfs) { return CHUNK_SIZE; }
+  virtual uint64_t nfs_get_writemax(struct nfs_context *nfs) { return CHUNK_SIZE; }
+  virtual int nfs_fsync(struct nfs_context *nfs, struct nfsfh *nfsfh) { return -1; }
+  virtual int nfs_mkdir(struct nfs_context *nfs, const char *path) { return -1; }
+  virtual int nfs_rmdir(struct nfs_context *nfs, const char *path) { return -1; }
+  virtual int nfs_unlink(struct nfs_context *nfs, const char *path) { return -1; }
+  virtual void nfs_closedir(struct nfs_context *nfs, struct nfsdir *nfsdir) {}
+  virtual struct nfsdirent *nfs_readdir(struct nfs_context *nfs, struct nfsdir *nfsdir) { return NULL; }
+  virtual int nfs_mount(struct nfs_context *nfs, const char *server, const char *exportname) { return -1; }
+  virtual int nfs_stat(struct nfs_context *nfs, const char *path, struct stat *st) { return -1; }
+  virtual int nfs_fstat(struct nfs_context *nfs, struct nfsfh *nfsfh, struct stat *st) { return -1; }
+  virtual int nfs_truncate(struct nfs_context *nfs, const char *path, uint64_t length) { return -1; }
+  virtual int nfs_ftruncate(struct nfs_context *nfs, struct nfsfh *nfsfh, uint64_t length) { return -1; }
+  virtual int nfs_opendir(struct nfs_context *nfs, const char *path, struct nfsdir **nfsdir) { return -1; }
+  virtual int nfs_statvfs(struct nfs_context *nfs, const char *path, struct statvfs *svfs) { return -1; }
+  virtual int nfs_chmod(struct nfs_context *nfs, const char *path, int mode) { return -1; }
+  virtual int nfs_fchmod(struct nfs_context *nfs, struct nfsfh *nfsfh, int mode) { return -1; }
+  virtual int nfs_access(struct nfs_context *nfs, const char *path, int mode) { return -1; }
+  virtual int nfs_utimes(struct nfs_context *nfs, const char *path, struct timeval *times) { return -1; }
+  virtual int nfs_utime(struct nfs_context *nfs, const char *path, struct utimbuf *times) { return -1; }
+  virtual int nfs_symlink(struct nfs_context *nfs, const char *oldpath, const char *newpath) { return -1; }
+  virtual int nfs_rename(struct nfs_context *nfs, const char *oldpath, const char *newpath) { return -1; }
+  virtual int nfs_link(struct nfs_context *nfs, const char *oldpath, const char *newpath) { return -1; }
+  virtual int nfs_readlink(struct nfs_context *nfs, const char *path, char *buf, int bufsize) { return -1; }
+  virtual int nfs_chown(struct nfs_context *nfs, const char *path, int uid, int gid) { return -1; }
+  virtual int nfs_fchown(struct nfs_context *nfs, struct nfsfh *nfsfh, int uid, int gid) { return -1; }
+  virtual int nfs_open(struct nfs_context *nfs, const char *path, int mode, struct nfsfh **nfsfh) { return -1; }
+  virtual int nfs_read(struct nfs_context *nfs, struct nfsfh *nfsfh, uint64_t count, char *buf) { return -1; }
+  virtual int nfs_write(struct nfs_context *nfs, struct nfsfh *nfsfh, uint64_t count, char *buf) { return -1; }
+  virtual int nfs_creat(struct nfs_context *nfs, const char *path, int mode, struct nfsfh **nfsfh) { return -1; }
+  virtual int nfs_pread(struct nfs_context *nfs, struct nfsfh *nfsfh, uint64_t offset, uint64_t count, char *buf) { return -1; }
+  virtual int nfs_pwrite(struct nfs_context *nfs, struct nfsfh *nfsfh, uint64_t offset, uint64_t count, char *buf) { return -1; }
+
+private:
+  typedef struct
+  {
+    uint64_t offset;
+    uint64_t count;
+    nfs_cb   cb;
+    void    *private_data;
+  } Pending;
+
+  std::vector<Pending> m_pending;
+  uint64_t             m_pos;
+  int                  m_pipe[2];
+  bool                 m_ready;
+};
+
+/* an open file on the fake lib */
+class CTestNFSFile : public XFILE::CNFSFile
+{
+public:
+  CTestNFSFile(CFakeNfsLib *lib)
+  {
+    m_pLib        = lib;
+    m_pFileHandle = (struct nfsfh *)this;
+    m_pNfsContext = GetContext(lib);
+    m_fileSize    = TEST_FILE_SIZE;
+  }
+
+  static struct nfs_context *GetContext(CFakeNfsLib *lib) { return (struct nfs_context *)lib; }
+  static size_t ReadsOnWire()
+  {
+    CSingleLock lock(m_readsOnWireLock);
+    return m_readsOnWire.size();
+  }
+};
+
+/* reads size bytes at pos and checks them */
+static bool ReadAt(CTestNFSFile& file, int64_t pos, unsigned int size)
+{
+  if (file.Seek(pos, SEEK_SET) != pos)
+    return false;
+
+  std::string data(size, 0);
+  unsigned int done = 0;
+  while (done < size)
+  {
+    unsigned int read = file.Read(&data[done], size - done);
+    if (read == 0)
+      return false;
+    done += read;
+  }
+  for (unsigned int i = 0; i < size; i++)
+  {
+    if (data[i] != FileByte(pos + i))
+      return false;
+  }
+  return true;
+}
+
+class TestNFSFile : public testing::Test
+{
+protected:
+  TestNFSFile()
+  {
+    m_readAhead = g_advancedSettings.m_nfsReadAhead;
+    g_advancedSettings.m_nfsReadAhead = 4;
+  }
+  ~TestNFSFile()
+  {
+    g_advancedSettings.m_nfsReadAhead = m_readAhead;
+  }
+
+  int m_readAhead;
+};
+
+TEST_F(TestNFSFile, InOrder)
+{
+  CFakeNfsLib lib;
+  ASSERT_TRUE(lib.IsReady());
+  CTestNFSFile file(&lib);
+
+  /* replies come newest first, the data is handed out in order */
+  EXPECT_TRUE(ReadAt(file, 0, TEST_FILE_SIZE));
+  char buf[16];
+  EXPECT_EQ(0U, file.Read(buf, sizeof(buf)));
+
+  file.Close();
+  EXPECT_EQ(0U, lib.Pendings());
+  EXPECT_EQ(0U, CTestNFSFile::ReadsOnWire());
+}
+
+TEST_F(TestNFSFile, Seek)
+{
+  CFakeNfsLib lib;
+  ASSERT_TRUE(lib.IsReady());
+  CTestNFSFile file(&lib);
+
+  /* the whole first request, the next one is sent */
+  EXPECT_TRUE(ReadAt(file, 0, CHUNK_SIZE));
+  EXPECT_EQ(1U, lib.Pendings());
+
+  /* forward past all of them, the one still on the wire is of no use */
+  EXPECT_TRUE(ReadAt(file, 5 * CHUNK_SIZE + 10, 1000));
+  EXPECT_TRUE(ReadAt(file, 5 * CHUNK_SIZE + 1010, CHUNK_SIZE));
+
+  /* and back before them */
+  EXPECT_TRUE(ReadAt(file, 100, 1000));
+
+  /* the replies to the dropped requests come in late */
+  lib.CompleteAll();
+  EXPECT_TRUE(ReadAt(file, 1100, 2 * CHUNK_SIZE));
+
+  file.Close();
+  lib.CompleteAll();
+  EXPECT_EQ(0U, CTestNFSFile::ReadsOnWire());
+}
+
+TEST_F(TestNFSFile, LateReplyAfterClose)
+{
+  CFakeNfsLib lib;
+  ASSERT_TRUE(lib.IsReady());
+  CTestNFSFile file(&lib);
+
+  EXPECT_TRUE(ReadAt(file, 0, CHUNK_SIZE));
+  file.Close();
+  EXPECT_EQ(1U, CTestNFSFile::ReadsOnWire());
+
+  /* while another file on the context is serviced */
+  lib.CompleteAll();
+  EXPECT_EQ(0U, CTestNFSFile::ReadsOnWire());
+}
+
+TEST_F(TestNFSFile, ContextDestroyed)
+{
+  CFakeNfsLib lib;
+  ASSERT_TRUE(lib.IsReady());
+  {
+    CTestNFSFile file(&lib);
+    EXPECT_TRUE(ReadAt(file, 0, CHUNK_SIZE));
+    file.Close();
+  }
+  CTestNFSFile file(&lib);
+  EXPECT_TRUE(ReadAt(file, 0, CHUNK_SIZE));
+  EXPECT_EQ(2U, CTestNFSFile::ReadsOnWire());
+
+  /* as CNfsConnection does when it drops the context */
+  lib.nfs_destroy_context(CTestNFSFile::GetContext(&lib));
+  XFILE::CNFSFile::CancelReadAhead(CTestNFSFile::GetContext(&lib));
+  EXPECT_EQ(0U, CTestNFSFile::ReadsOnWire());
+
+  /* what was read ahead is still there, the cancelled read fails */
+  EXPECT_TRUE(ReadAt(file, CHUNK_SIZE, 3 * CHUNK_SIZE));
+  char buf[16];
+  EXPECT_EQ(0U, file.Read(buf, sizeof(buf)));
+  file.Close();
+
+  /* the reads sent after it on the destroyed context */
+  lib.CompleteAll();
+  EXPECT_EQ(0U, CTestNFSFile::ReadsOnWire());
+}
+#endif
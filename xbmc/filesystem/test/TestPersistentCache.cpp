@@ -0,0 +1,149 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/PersistentCache.h"
+#include "filesystem/CircularCache.h"
+#include "filesystem/Directory.h"
+#include "filesystem/FileCache.h"
+#include "settings/AdvancedSettings.h"
+#include "test/TestUtils.h"
+#include "URL.h"
+
+#include "gtest/gtest.h"
+
+TEST(TestPersistentCache, StoreEvict)
+{
+  const CStdString path = "special://temp/testpersistentcache/";
+  std::string block(PERSISTENT_CACHE_BLOCK_SIZE, 'x');
+  std::string data;
+
+  {
+    /* room for two blocks */
+    XFILE::CPersistentCacheStore store(path, 2 * PERSISTENT_CACHE_BLOCK_SIZE);
+    store.Write("file", 0, block);
+    store.Write("file", 1, block);
+    EXPECT_TRUE(store.Has("file", 0));
+    ASSERT_TRUE(store.Read("file", 0, data));
+    EXPECT_EQ(block, data);
+
+    /* block 1 was used least recently */
+    store.Write("file", 2, block);
+    EXPECT_TRUE(store.Has("file", 0));
+    EXPECT_FALSE(store.Has("file", 1));
+    EXPECT_TRUE(store.Has("file", 2));
+  }
+
+  /* a new store finds the blocks on disk */
+  XFILE::CPersistentCacheStore store(path, 2 * PERSISTENT_CACHE_BLOCK_SIZE);
+  EXPECT_TRUE(store.Has("file", 0));
+  EXPECT_TRUE(store.Has("file", 2));
+  EXPECT_FALSE(store.Read("other", 0, data));
+
+  store.Clear();
+  EXPECT_FALSE(store.Has("file", 0));
+  EXPECT_TRUE(XFILE::CDirectory::Remove(path));
+}
+
+TEST(TestPersistentCache, ReadFromStore)
+{
+  /* it is off by default */
+  XFILE::CPersistentCacheStore::GetInstance().SetMaxSize(16 * 1024 * 1024);
+  const int64_t length = PERSISTENT_CACHE_BLOCK_SIZE + 1000;
+  std::string file(length, 0);
+  for (int64_t i = 0; i < length; i++)
+    file[i] = (char)(i % 251);
+
+  {
+    XFILE::CPersistentCache cache(new XFILE::CCircularCache(1024 * 1024, 1024 * 1024));
+    ASSERT_EQ(CACHE_RC_OK, cache.Open());
+    cache.SetSource("nfs://server/testpersistentcache.ts", length, 1234);
+    EXPECT_FALSE(cache.IsStored(0));
+    EXPECT_EQ(length, cache.WriteToCache(file.data(), length));
+    cache.EndOfInput();
+    cache.Close();
+  }
+
+  XFILE::CPersistentCache cache(new XFILE::CCircularCache(1024 * 1024, 1024 * 1024));
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+  cache.SetSource("nfs://server/testpersistentcache.ts", length, 1234);
+  EXPECT_EQ(0, cache.GetSourcePosition(1000));
+
+  /* the full block and the short last one */
+  char buf[2000];
+  ASSERT_TRUE(cache.IsStored(1000));
+  EXPECT_EQ(2000, cache.ReadFromStore(1000, buf, sizeof(buf)));
+  EXPECT_EQ(0, memcmp(file.data() + 1000, buf, sizeof(buf)));
+  ASSERT_TRUE(cache.IsStored(PERSISTENT_CACHE_BLOCK_SIZE + 500));
+  EXPECT_EQ(500, cache.ReadFromStore(PERSISTENT_CACHE_BLOCK_SIZE + 500, buf, sizeof(buf)));
+  EXPECT_EQ(0, memcmp(file.data() + PERSISTENT_CACHE_BLOCK_SIZE + 500, buf, 500));
+
+  /* the file changed */
+  cache.Close();
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+  cache.SetSource("nfs://server/testpersistentcache.ts", length, 5678);
+  EXPECT_FALSE(cache.IsStored(0));
+  cache.Close();
+
+  XFILE::CPersistentCacheStore::GetInstance().Clear();
+  XFILE::CPersistentCacheStore::GetInstance().SetMaxSize(g_advancedSettings.m_cacheDiskSize);
+}
+
+static std::string ReadAll(XFILE::CFileCache& file)
+{
+  std::string data;
+  char buf[16384];
+  unsigned int read;
+  while ((read = file.Read(buf, sizeof(buf))) > 0)
+    data.append(buf, read);
+  return data;
+}
+
+TEST(TestPersistentCache, FileCacheOpen)
+{
+  XFILE::CPersistentCacheStore::GetInstance().SetMaxSize(16 * 1024 * 1024);
+  XFILE::CFile *file = XBMC_CREATETEMPFILE(".ts");
+  ASSERT_TRUE(file);
+  std::string data(PERSISTENT_CACHE_BLOCK_SIZE + 1000, 0);
+  for (size_t i = 0; i < data.size(); i++)
+    data[i] = (char)(i % 251);
+  ASSERT_EQ((int)data.size(), file->Write(data.data(), data.size()));
+  file->Close();
+  CURL url(XBMC_TEMPFILEPATH(file));
+
+  XFILE::CPersistentCache *cache = new XFILE::CPersistentCache(new XFILE::CCircularCache(1024 * 1024, 1024 * 1024));
+  {
+    XFILE::CFileCache reader(cache, false);
+    ASSERT_TRUE(reader.Open(url));
+    EXPECT_EQ(data, ReadAll(reader));
+    reader.Close();
+
+    /* the second open finds what the first one read */
+    ASSERT_TRUE(reader.Open(url));
+    EXPECT_TRUE(cache->IsStored(0));
+    EXPECT_TRUE(cache->IsStored(PERSISTENT_CACHE_BLOCK_SIZE));
+    EXPECT_EQ(data, ReadAll(reader));
+    reader.Close();
+  }
+  delete cache;
+
+  XFILE::CPersistentCacheStore::GetInstance().Clear();
+  XFILE::CPersistentCacheStore::GetInstance().SetMaxSize(g_advancedSettings.m_cacheDiskSize);
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(file));
+}
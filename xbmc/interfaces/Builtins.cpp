@@ -59,6 +59,7 @@
 #include "Util.h"
 #include "URL.h"
 #include "music/MusicDatabase.h"
+#include "music/infoscanner/MusicLoudnessAnalyzer.h"
 #include "cores/IPlayer.h"
 #include "games/tags/GameInfoTag.h"
 
@@ -177,6 +178,7 @@ const BUILT_IN commands[] = {
   { "SetFocus",                   true,   "Change current focus to a different control id" },
   { "UpdateLibrary",              true,   "Update the selected library (music or video)" },
   { "CleanLibrary",               true,   "Clean the video/music library" },
+  { "AnalyzeLoudness",            false,  "Measure the loudness of the unmeasured songs in the music library" },
   { "ExportLibrary",              true,   "Export the video/music library" },
   { "PageDown",                   true,   "Send a page down event to the pagecontrol with given id" },
   { "PageUp",                     true,   "Send a page up event to the pagecontrol with given id" },
@@ -1354,6 +1356,14 @@ int CBuiltins::Execute(const CStdString& execString)
         CLog::Log(LOGERROR, "XBMC.CleanLibrary is not possible while scanning for media info");
     }
   }
+  else if (execute.Equals("analyzeloudness"))
+  {
+    MUSIC_INFO::CMusicLoudnessAnalyzer &analyzer = MUSIC_INFO::CMusicLoudnessAnalyzer::GetInstance();
+    if (analyzer.IsAnalyzing())
+      analyzer.Stop();
+    else
+      analyzer.Start(true);
+  }
   else if (execute.Equals("exportlibrary"))
   {
     int iHeading = 647;
@@ -218,6 +218,43 @@ JSONRPC_STATUS CPlayerOperations::GetItem(const CStdString &method, ITransportLa
   return OK;
 }
 
+JSONRPC_STATUS CPlayerOperations::GetPerformance(const CStdString &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+{
+  switch (GetPlayer(parameterObject["playerid"]))
+  {
+    case Video:
+    case Audio:
+    {
+      SPlayerPerformanceInfo info;
+      if (!g_application.m_pPlayer || !g_application.m_pPlayer->GetPerformanceInfo(info))
+        return FailedToExecute;
+
+      result["stages"] = CVariant(CVariant::VariantTypeArray);
+      for (std::vector<SPlayerStagePerformance>::const_iterator it = info.stages.begin(); it != info.stages.end(); ++it)
+      {
+        CVariant stage(CVariant::VariantTypeObject);
+        stage["name"] = it->name;
+        stage["busy"] = it->busy;
+        stage["queuelevel"] = it->queueLevel;
+        stage["decodetime"]["p50"] = it->decodeP50;
+        stage["decodetime"]["p90"] = it->decodeP90;
+        stage["decodetime"]["p99"] = it->decodeP99;
+        stage["decodetime"]["max"] = it->decodeMax;
+        stage["frames"] = it->frames;
+        stage["dropped"] = it->dropped;
+        stage["late"] = it->late;
+        result["stages"].push_back(stage);
+      }
+      return OK;
+    }
+
+    case Picture:
+    case None:
+    default:
+      return FailedToExecute;
+  }
+}
+
 JSONRPC_STATUS CPlayerOperations::PlayPause(const CStdString &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CGUIWindowSlideShow *slideshow = NULL;
@@ -22,7 +22,7 @@
 namespace JSONRPC
 {
   const char* const JSONRPC_SERVICE_ID          = "http://www.xbmc.org/jsonrpc/ServiceDescription.json";
-  const char* const JSONRPC_SERVICE_VERSION     = "6.3.0";
+  const char* const JSONRPC_SERVICE_VERSION     = "6.4.0";
   const char* const JSONRPC_SERVICE_DESCRIPTION = "JSON-RPC API of XBMC";
 
   const char* const JSONRPC_SERVICE_TYPES[] = {  
@@ -1452,6 +1452,39 @@ namespace JSONRPC
         "}"
       "}"
     "}",
+    "\"Player.GetPerformance\": {"
+      "\"type\": \"method\","
+      "\"description\": \"Retrieves the decode times, thread load and frame counts of each stage of playback\","
+      "\"transport\": \"Response\","
+      "\"permission\": \"ReadData\","
+      "\"params\": ["
+        "{ \"name\": \"playerid\", \"$ref\": \"Player.Id\", \"required\": true }"
+      "],"
+      "\"returns\": { \"type\": \"object\","
+        "\"properties\": {"
+          "\"stages\": { \"type\": \"array\", \"required\": true,"
+            "\"items\": { \"type\": \"object\","
+              "\"properties\": {"
+                "\"name\": { \"type\": \"string\", \"required\": true },"
+                "\"busy\": { \"type\": \"number\", \"required\": true },"
+                "\"queuelevel\": { \"type\": \"integer\", \"required\": true },"
+                "\"decodetime\": { \"type\": \"object\", \"required\": true,"
+                  "\"properties\": {"
+                    "\"p50\": { \"type\": \"number\", \"required\": true },"
+                    "\"p90\": { \"type\": \"number\", \"required\": true },"
+                    "\"p99\": { \"type\": \"number\", \"required\": true },"
+                    "\"max\": { \"type\": \"number\", \"required\": true }"
+                  "}"
+                "},"
+                "\"frames\": { \"type\": \"integer\", \"required\": true },"
+                "\"dropped\": { \"type\": \"integer\", \"required\": true },"
+                "\"late\": { \"type\": \"integer\", \"required\": true }"
+              "}"
+            "}"
+          "}"
+        "}"
+      "}"
+    "}",
     "\"Player.PlayPause\": {"
       "\"type\": \"method\","
       "\"description\": \"Pauses or unpause playback and returns the new state\","
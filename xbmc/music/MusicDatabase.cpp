@@ -115,7 +115,7 @@ bool CMusicDatabase::CreateTables()
     CLog::Log(LOGINFO, "create path table");
     m_pDS->exec("CREATE TABLE path ( idPath integer primary key, strPath varchar(512), strHash text)\n");
     CLog::Log(LOGINFO, "create song table");
-    m_pDS->exec("CREATE TABLE song ( idSong integer primary key, idAlbum integer, idPath integer, strArtists text, strGenres text, strTitle varchar(512), iTrack integer, iDuration integer, iYear integer, dwFileNameCRC text, strFileName text, strMusicBrainzTrackID text, strMusicBrainzArtistID text, strMusicBrainzAlbumID text, strMusicBrainzAlbumArtistID text, strMusicBrainzTRMID text, iTimesPlayed integer, iStartOffset integer, iEndOffset integer, idThumb integer, lastplayed varchar(20) default NULL, rating char default '0', comment text)\n");
+    m_pDS->exec("CREATE TABLE song ( idSong integer primary key, idAlbum integer, idPath integer, strArtists text, strGenres text, strTitle varchar(512), iTrack integer, iDuration integer, iYear integer, dwFileNameCRC text, strFileName text, strMusicBrainzTrackID text, strMusicBrainzArtistID text, strMusicBrainzAlbumID text, strMusicBrainzAlbumArtistID text, strMusicBrainzTRMID text, iTimesPlayed integer, iStartOffset integer, iEndOffset integer, idThumb integer, lastplayed varchar(20) default NULL, rating char default '0', comment text, fLoudness float default NULL, fTruePeak float default NULL)\n");
     CLog::Log(LOGINFO, "create song_artist table");
     m_pDS->exec("CREATE TABLE song_artist ( idArtist integer, idSong integer, boolFeatured integer, iOrder integer )\n");
     CLog::Log(LOGINFO, "create song_genre table");
@@ -229,7 +229,8 @@ void CMusicDatabase::CreateViews()
               "  rating, comment, song.idAlbum AS idAlbum, strAlbum, strPath,"
               "  iKaraNumber, iKaraDelay, strKaraEncoding,"
               "  album.bCompilation AS bCompilation,"
-              "  album.strArtists AS strAlbumArtists "
+              "  album.strArtists AS strAlbumArtists,"
+              "  fLoudness, fTruePeak "
               "FROM song"
               "  JOIN album ON"
               "    song.idAlbum=album.idAlbum"
@@ -917,6 +918,9 @@ CSong CMusicDatabase::GetSongFromDataset(bool bWithMusicDbPath/*=false*/)
   song.iKaraokeDelay = m_pDS->fv(song_iKarDelay).get_asInt();
   song.bCompilation = m_pDS->fv(song_bCompilation).get_asInt() == 1;
   song.albumArtist = StringUtils::Split(m_pDS->fv(song_strAlbumArtists).get_asString(), g_advancedSettings.m_musicItemSeparator);
+  song.bHasLoudness = !m_pDS->fv(song_fLoudness).get_isNull();
+  song.fLoudness = m_pDS->fv(song_fLoudness).get_asFloat();
+  song.fTruePeak = m_pDS->fv(song_fTruePeak).get_isNull() ? -1.0f : m_pDS->fv(song_fTruePeak).get_asFloat();
 
   // Get filename with full path
   if (!bWithMusicDbPath)
@@ -970,6 +974,8 @@ void CMusicDatabase::GetFileItemFromDataset(const dbiplus::sql_record* const rec
   item->GetMusicInfoTag()->SetURL(strRealPath);
   item->GetMusicInfoTag()->SetCompilation(record->at(song_bCompilation).get_asInt() == 1);
   item->GetMusicInfoTag()->SetAlbumArtist(record->at(song_strAlbumArtists).get_asString());
+  if (!record->at(song_fLoudness).get_isNull())
+    item->GetMusicInfoTag()->SetReplayGainFromLoudness(record->at(song_fLoudness).get_asFloat(), record->at(song_fTruePeak).get_asFloat());
   item->GetMusicInfoTag()->SetLoaded(true);
   // Get filename with full path
   if (strMusicDBbasePath.IsEmpty())
@@ -3722,6 +3728,11 @@ bool CMusicDatabase::UpdateOldVersion(int version)
     m_pDS->exec("DROP INDEX idxSong6 ON song");
     m_pDS->exec("CREATE UNIQUE INDEX idxSong6 on song( idPath, strFileName(255) )");
   }
+  if (version < 34)
+  {
+    m_pDS->exec("ALTER TABLE song ADD fLoudness float default NULL");
+    m_pDS->exec("ALTER TABLE song ADD fTruePeak float default NULL");
+  }
   // always recreate the views after any table change
   CreateViews();
 
@@ -3730,7 +3741,7 @@ bool CMusicDatabase::UpdateOldVersion(int version)
 
 int CMusicDatabase::GetMinVersion() const
 {
-  return 33;
+  return 34;
 }
 
 unsigned int CMusicDatabase::GetSongIDs(const Filter &filter, vector<pair<int,int> > &songIDs)
@@ -3767,6 +3778,60 @@ unsigned int CMusicDatabase::GetSongIDs(const Filter &filter, vector<pair<int,in
   return 0;
 }
 
+bool CMusicDatabase::GetSongsWithoutLoudness(int idSongAfter, unsigned int limit, VECSONGS &songs)
+{
+  try
+  {
+    songs.clear();
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    // songs are paged by id so those still being measured are not returned again
+    CStdString strSQL = PrepareSQL("select * from songview where fTruePeak is null and idSong > %i order by idSong limit %u", idSongAfter, limit);
+    if (!m_pDS->query(strSQL.c_str())) return false;
+    songs.reserve(m_pDS->num_rows());
+    while (!m_pDS->eof())
+    {
+      songs.push_back(GetSongFromDataset());
+      m_pDS->next();
+    }
+    m_pDS->close();
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s(%i) failed", __FUNCTION__, idSongAfter);
+  }
+  return false;
+}
+
+bool CMusicDatabase::SetSongsLoudness(const VECSONGS &songs)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    BeginTransaction();
+    for (VECSONGS::const_iterator it = songs.begin(); it != songs.end(); ++it)
+    {
+      CStdString strSQL;
+      if (it->bHasLoudness)
+        strSQL = PrepareSQL("UPDATE song SET fLoudness=%f, fTruePeak=%f WHERE idSong=%i", it->fLoudness, it->fTruePeak, it->idSong);
+      else
+        strSQL = PrepareSQL("UPDATE song SET fLoudness=NULL, fTruePeak=%f WHERE idSong=%i", it->fTruePeak > 0.0f ? it->fTruePeak : 0.0f, it->idSong);
+      m_pDS->exec(strSQL.c_str());
+    }
+    return CommitTransaction();
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s (%u songs) failed", __FUNCTION__, (unsigned int)songs.size());
+    RollbackTransaction();
+  }
+  return false;
+}
+
 int CMusicDatabase::GetSongsCount(const Filter &filter)
 {
   try
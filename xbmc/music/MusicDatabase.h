@@ -264,6 +264,23 @@ public:
   bool GetRandomSong(CFileItem* item, int& idSong, const Filter &filter);
   int GetSongsCount(const Filter &filter = Filter());
   unsigned int GetSongIDs(const Filter &filter, std::vector<std::pair<int,int> > &songIDs);
+
+  /*! \brief Get songs whose loudness has not been measured yet
+   \param idSongAfter only songs with a larger id are returned, so the list can be paged through.
+   \param limit the maximum number of songs to return.
+   \param songs [out] the songs, ordered by id.
+   \return true if the query succeeded.
+   \sa SetSongsLoudness
+   */
+  bool GetSongsWithoutLoudness(int idSongAfter, unsigned int limit, VECSONGS &songs);
+
+  /*! \brief Store the measured loudness of songs in a single transaction
+   Songs without a loudness (silence, or too short to measure) are stored with only
+   their peak so they are not measured again.
+   \param songs the songs with idSong, bHasLoudness, fLoudness and fTruePeak set.
+   \return true if the songs were updated.
+   */
+  bool SetSongsLoudness(const VECSONGS &songs);
   virtual bool GetFilter(CDbUrl &musicUrl, Filter &filter, SortDescription &sorting);
 
   /////////////////////////////////////////////////
@@ -439,7 +456,9 @@ private:
     song_iKarDelay,
     song_strKarEncoding,
     song_bCompilation,
-    song_strAlbumArtists
+    song_strAlbumArtists,
+    song_fLoudness,
+    song_fTruePeak
   } SongFields;
 
   // Fields should be ordered as they
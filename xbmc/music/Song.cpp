@@ -55,6 +55,9 @@ CSong::CSong(CMusicInfoTag& tag)
   iKaraokeNumber = 0;
   iKaraokeDelay = 0;         //! Karaoke song lyrics-music delay in 1/10 seconds.
   idAlbum = -1;
+  bHasLoudness = false;
+  fLoudness = 0.0f;
+  fTruePeak = -1.0f;
 }
 
 CSong::CSong()
@@ -116,6 +119,9 @@ void CSong::Clear()
   idAlbum = -1;
   bCompilation = false;
   embeddedArt.clear();
+  bHasLoudness = false;
+  fLoudness = 0.0f;
+  fTruePeak = -1.0f;
 }
 
 bool CSong::HasArt() const
@@ -103,6 +103,11 @@ public:
   int iEndOffset;
   bool bCompilation;
 
+  // Loudness measured by CMusicLoudnessAnalyzer
+  bool  bHasLoudness; //! Whether fLoudness is valid. False if the song is unmeasured or had nothing above the gate.
+  float fLoudness;    //! Integrated EBU R128 loudness in LUFS.
+  float fTruePeak;    //! True peak as a linear amplitude, negative if the song is unmeasured.
+
   // Karaoke-specific information
   long       iKaraokeNumber;        //! Karaoke song number to "select by number". 0 for non-karaoke
   CStdString strKaraokeLyrEncoding; //! Karaoke song lyrics encoding if known. Empty if unknown.
@@ -0,0 +1,407 @@
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "MusicLoudnessAnalyzer.h"
+#include "music/MusicDatabase.h"
+#include "cores/paplayer/CodecFactory.h"
+#include "cores/AudioEngine/Utils/AEConvert.h"
+#include "cores/AudioEngine/Utils/AELoudness.h"
+#include "cores/AudioEngine/Utils/AEUtil.h"
+#include "dialogs/GUIDialogExtendedProgressBar.h"
+#include "guilib/GUIWindowManager.h"
+#include "guilib/LocalizeStrings.h"
+#include "settings/GUISettings.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/CPUInfo.h"
+#include "utils/log.h"
+#include "FileItem.h"
+
+#include <algorithm>
+#include <string.h>
+
+using namespace std;
+using namespace MUSIC_INFO;
+
+/* frames decoded per read */
+#define LOUDNESS_READ_FRAMES  4096
+/* songs fetched from the database at a time */
+#define LOUDNESS_PAGE_SIZE    256
+/* measured songs written to the database in one transaction */
+#define LOUDNESS_BATCH_SIZE   100
+
+CMusicLoudnessJob::CMusicLoudnessJob(const CSong &song, const volatile bool *stop) :
+  m_song(song),
+  m_stop(stop)
+{
+}
+
+CMusicLoudnessJob::~CMusicLoudnessJob()
+{
+}
+
+bool CMusicLoudnessJob::DoWork()
+{
+  const CStdString &path = m_song.strFileName;
+
+  // get correct cache size, the same as CAudioDecoder
+  CFileItem item(path, false);
+  unsigned int filecache = g_guiSettings.GetInt("cacheaudio.internet");
+  if (item.IsHD())
+    filecache = g_guiSettings.GetInt("cache.harddisk");
+  else if (item.IsOnDVD())
+    filecache = g_guiSettings.GetInt("cacheaudio.dvdrom");
+  else if (item.IsOnLAN())
+    filecache = g_guiSettings.GetInt("cacheaudio.lan");
+
+  ICodec *codec = CodecFactory::CreateCodecDemux(path, "", filecache * 1024);
+  if (!codec || !codec->Init(path, filecache * 1024))
+  {
+    CLog::Log(LOGERROR, "CMusicLoudnessJob: Unable to init codec for %s", path.c_str());
+    delete codec;
+    return false;
+  }
+
+  const CAEChannelInfo layout   = codec->GetChannelInfo();
+  const unsigned int   channels = layout.Count();
+  const unsigned int   rate     = codec->m_SampleRate;
+  const unsigned int   bytes    = CAEUtil::DataFormatToBits(codec->m_DataFormat) >> 3;
+
+  CAEConvert::AEConvertToFn convert = NULL;
+  if (codec->m_DataFormat != AE_FMT_FLOAT && !AE_IS_RAW(codec->m_DataFormat))
+    convert = CAEConvert::ToFloat(codec->m_DataFormat);
+
+  CAELoudness meter;
+  if (!bytes || (codec->m_DataFormat != AE_FMT_FLOAT && !convert) || !meter.Initialize(layout, rate))
+  {
+    CLog::Log(LOGERROR, "CMusicLoudnessJob: Unsupported format %s, %u channels at %uHz in %s",
+              CAEUtil::DataFormatToStr(codec->m_DataFormat), channels, rate, path.c_str());
+    codec->DeInit();
+    delete codec;
+    return false;
+  }
+
+  // songs from a cue sheet are a part of the file, their offsets are in 1/75 seconds
+  int64_t framesLeft = -1;
+  if (m_song.iStartOffset > 0)
+    codec->Seek((int64_t)m_song.iStartOffset * 1000 / 75);
+  if (m_song.iEndOffset > m_song.iStartOffset)
+    framesLeft = (int64_t)(m_song.iEndOffset - m_song.iStartOffset) * rate / 75;
+
+  const unsigned int frameSize = bytes * channels;
+  std::vector<BYTE>  pcm(LOUDNESS_READ_FRAMES * frameSize);
+  std::vector<float> samples(LOUDNESS_READ_FRAMES * channels);
+
+  bool         ok         = true;
+  unsigned int frames     = 0;
+  unsigned int nextCheck  = 0;
+  unsigned int emptyReads = 0;
+  while (framesLeft != 0)
+  {
+    // check for cancellation about every 10 seconds of audio
+    if (frames >= nextCheck)
+    {
+      if (m_stop && *m_stop)
+      {
+        ok = false;
+        break;
+      }
+      nextCheck = frames + rate * 10;
+    }
+
+    int read = 0;
+    int result = codec->ReadPCM(&pcm[0], pcm.size(), &read);
+    if (result == READ_ERROR)
+    {
+      CLog::Log(LOGERROR, "CMusicLoudnessJob: Error decoding %s", path.c_str());
+      ok = false;
+      break;
+    }
+
+    unsigned int count = read / frameSize;
+    if (framesLeft > 0 && count > framesLeft)
+      count = (unsigned int)framesLeft;
+
+    if (count)
+    {
+      if (convert)
+        convert(&pcm[0], count * channels, &samples[0]);
+      else
+        memcpy(&samples[0], &pcm[0], count * frameSize);
+      meter.Process(&samples[0], count);
+
+      frames += count;
+      if (framesLeft > 0)
+        framesLeft -= count;
+      emptyReads = 0;
+    }
+    else if (++emptyReads > 1000)
+    {
+      CLog::Log(LOGERROR, "CMusicLoudnessJob: Decoder stalled on %s", path.c_str());
+      ok = false;
+      break;
+    }
+
+    if (result == READ_EOF)
+      break;
+  }
+
+  codec->DeInit();
+  delete codec;
+
+  if (!ok)
+    return false;
+
+  double loudness = 0.0;
+  m_song.bHasLoudness = meter.GetIntegratedLoudness(loudness);
+  m_song.fLoudness    = (float)loudness;
+  m_song.fTruePeak    = (float)meter.GetTruePeak();
+  return true;
+}
+
+CMusicLoudnessWorker::CMusicLoudnessWorker(CMusicLoudnessAnalyzer &analyzer) :
+  CThread("MusicLoudnessWorker"),
+  m_analyzer(analyzer)
+{
+}
+
+void CMusicLoudnessWorker::Process()
+{
+  CSong song;
+  while (m_analyzer.GetNextSong(song, m_bStop))
+  {
+    CMusicLoudnessJob job(song, &m_bStop);
+    bool success = job.DoWork();
+
+    // a stopped measurement is dropped, the song is measured next time
+    if (m_bStop)
+      break;
+    m_analyzer.OnSongDone(job, success);
+  }
+}
+
+CMusicLoudnessAnalyzer::CMusicLoudnessAnalyzer() : CThread("MusicLoudnessAnalyzer")
+{
+  m_showDialog = false;
+  m_queueDone = false;
+  m_bRunning = false;
+  m_completed = 0;
+  m_failed = 0;
+}
+
+CMusicLoudnessAnalyzer::~CMusicLoudnessAnalyzer()
+{
+}
+
+CMusicLoudnessAnalyzer &CMusicLoudnessAnalyzer::GetInstance()
+{
+  static CMusicLoudnessAnalyzer sAnalyzer;
+  return sAnalyzer;
+}
+
+void CMusicLoudnessAnalyzer::Start(bool showDialog)
+{
+  StopThread();
+  m_showDialog = showDialog;
+  /* set before the thread starts, Process clears it when it is done */
+  m_bRunning = true;
+  Create();
+}
+
+void CMusicLoudnessAnalyzer::Stop()
+{
+  StopThread(false);
+  m_jobDone.Set();
+}
+
+bool CMusicLoudnessAnalyzer::IsAnalyzing()
+{
+  return m_bRunning;
+}
+
+bool CMusicLoudnessAnalyzer::GetNextSong(CSong &song, const volatile bool &stop)
+{
+  while (!stop)
+  {
+    {
+      CSingleLock lock(m_section);
+      if (!m_pending.empty())
+      {
+        song = m_pending.front();
+        m_pending.pop_front();
+        m_current = song.strTitle;
+        m_jobDone.Set(); // wake the analyzer to queue more
+        return true;
+      }
+      if (m_queueDone)
+        return false;
+    }
+    m_songQueued.WaitMSec(100);
+  }
+  return false;
+}
+
+void CMusicLoudnessAnalyzer::OnSongDone(const CMusicLoudnessJob &job, bool success)
+{
+  CSingleLock lock(m_section);
+  m_completed++;
+  if (success)
+    m_measured.push_back(job.GetSong());
+  else
+    m_failed++;
+  m_jobDone.Set();
+}
+
+void CMusicLoudnessAnalyzer::StopWorkers()
+{
+  for (vector<CMusicLoudnessWorker*>::iterator it = m_workers.begin(); it != m_workers.end(); ++it)
+    (*it)->StopThread(false);
+  for (vector<CMusicLoudnessWorker*>::iterator it = m_workers.begin(); it != m_workers.end(); ++it)
+  {
+    (*it)->StopThread(true);
+    delete *it;
+  }
+  m_workers.clear();
+}
+
+unsigned int CMusicLoudnessAnalyzer::Flush(CMusicDatabase &database)
+{
+  VECSONGS songs;
+  {
+    CSingleLock lock(m_section);
+    songs.swap(m_measured);
+  }
+
+  if (songs.empty() || !database.SetSongsLoudness(songs))
+    return 0;
+  return songs.size();
+}
+
+void CMusicLoudnessAnalyzer::Process()
+{
+  CMusicDatabase database;
+  if (!database.Open())
+  {
+    m_bRunning = false;
+    return;
+  }
+
+  unsigned int tick = XbmcThreads::SystemClockMillis();
+  const int total = database.GetSongsCount(CMusicDatabase::Filter("fTruePeak is null"));
+  CLog::Log(LOGNOTICE, "%s - Measuring the loudness of %i songs", __FUNCTION__, total);
+
+  CGUIDialogProgressBarHandle *handle = NULL;
+  if (m_showDialog && total > 0)
+  {
+    CGUIDialogExtendedProgressBar* dialog =
+      (CGUIDialogExtendedProgressBar*)g_windowManager.GetWindow(WINDOW_DIALOG_EXT_PROGRESS);
+    handle = dialog->GetHandle(g_localizeStrings.Get(20322));
+  }
+
+  {
+    CSingleLock lock(m_section);
+    m_pending.clear();
+    m_queueDone = false;
+    m_completed = 0;
+    m_failed = 0;
+  }
+
+  // a worker per core, the job manager keeps its low priority workers for the rest of the gui
+  const unsigned int maxJobs = std::max(1, g_cpuInfo.getCPUCount());
+  if (total > 0)
+  {
+    for (unsigned int i = 0; i < maxJobs; i++)
+    {
+      CMusicLoudnessWorker *worker = new CMusicLoudnessWorker(*this);
+      worker->Create();
+      m_workers.push_back(worker);
+    }
+  }
+
+  VECSONGS     queue;
+  int          lastId  = -1;
+  bool         more    = total > 0;
+  unsigned int queued  = 0;
+  unsigned int written = 0;
+
+  while (!m_bStop)
+  {
+    // page through the unmeasured songs, the ones in flight are past lastId
+    bool waiting;
+    {
+      CSingleLock lock(m_section);
+      waiting = m_pending.size() < maxJobs;
+    }
+    if (waiting && more)
+    {
+      if (!database.GetSongsWithoutLoudness(lastId, LOUDNESS_PAGE_SIZE, queue))
+        break;
+      more = queue.size() == LOUDNESS_PAGE_SIZE;
+      if (!queue.empty())
+        lastId = queue.back().idSong;
+
+      CSingleLock lock(m_section);
+      m_pending.insert(m_pending.end(), queue.begin(), queue.end());
+      m_queueDone = !more;
+      queued += queue.size();
+      m_songQueued.Set();
+    }
+
+    unsigned int completed, pending;
+    CStdString current;
+    {
+      CSingleLock lock(m_section);
+      if (!more && m_completed == queued)
+        break;
+
+      completed = m_completed;
+      pending = m_measured.size();
+      current = m_current;
+    }
+
+    if (handle && total > 0)
+    {
+      handle->SetText(current);
+      handle->SetPercentage(completed * 100.0f / total);
+    }
+
+    if (pending >= LOUDNESS_BATCH_SIZE)
+      written += Flush(database);
+
+    m_jobDone.WaitMSec(1000);
+  }
+
+  // songs still being measured are dropped, they are measured next time
+  {
+    CSingleLock lock(m_section);
+    m_pending.clear();
+    m_queueDone = true;
+  }
+  StopWorkers();
+  written += Flush(database);
+  database.Close();
+
+  CLog::Log(LOGNOTICE, "%s - Measured %u songs, %u failed, in %u seconds%s", __FUNCTION__,
+            written, m_failed, (XbmcThreads::SystemClockMillis() - tick) / 1000, m_bStop ? " (stopped)" : "");
+
+  if (handle)
+    handle->MarkFinished();
+  m_bRunning = false;
+}
@@ -0,0 +1,144 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "threads/Thread.h"
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
+#include "music/Song.h"
+
+#include <deque>
+#include <vector>
+
+class CMusicDatabase;
+
+namespace MUSIC_INFO
+{
+
+/*! \brief Decode a single song and measure its EBU R128 loudness and true peak
+ Run by the analyzer's workers on their own threads.
+ */
+class CMusicLoudnessJob
+{
+public:
+  /*!
+   \brief Create a job for a song
+   \param song the song to measure.
+   \param stop when set, polled while decoding so a stopped analysis gives up on the song.
+   */
+  CMusicLoudnessJob(const CSong &song, const volatile bool *stop = NULL);
+  ~CMusicLoudnessJob();
+
+  bool DoWork();
+
+  /*! \brief The song with bHasLoudness, fLoudness and fTruePeak filled in
+   Only valid if DoWork succeeded, a song that could not be decoded is left unmeasured
+   so it is tried again next time.
+   */
+  const CSong &GetSong() const { return m_song; }
+
+private:
+  CSong                m_song;
+  const volatile bool *m_stop;
+};
+
+class CMusicLoudnessAnalyzer;
+
+/*! \brief A thread of the analyzer, measures songs until the analyzer has none left
+ */
+class CMusicLoudnessWorker : public CThread
+{
+public:
+  CMusicLoudnessWorker(CMusicLoudnessAnalyzer &analyzer);
+
+protected:
+  virtual void Process();
+
+private:
+  CMusicLoudnessAnalyzer &m_analyzer;
+};
+
+/*! \brief Measure the loudness of every song in the music library
+
+ Songs are measured in parallel on a worker thread per core owned by the analyzer,
+ so the analysis neither waits on nor holds up the job manager's low priority
+ workers, and the results are written to the database in batches. Only songs
+ that have not been measured are queued, so a stopped analysis resumes where it
+ left off the next time it is started.
+
+ PAPlayer uses the measured loudness as the track gain of songs that have no
+ ReplayGain tags.
+ */
+class CMusicLoudnessAnalyzer : CThread
+{
+public:
+  /*!
+   \brief The only way through which the global instance of the analyzer should be accessed.
+   \return the global instance.
+   */
+  static CMusicLoudnessAnalyzer &GetInstance();
+
+  /*! \brief Start measuring the songs that have not been measured yet
+   \param showDialog whether to show progress in the extended progress dialog.
+   */
+  void Start(bool showDialog);
+  void Stop();
+  bool IsAnalyzing();
+
+protected:
+  virtual void Process();
+
+private:
+  CMusicLoudnessAnalyzer();
+  CMusicLoudnessAnalyzer(const CMusicLoudnessAnalyzer&);
+  virtual ~CMusicLoudnessAnalyzer();
+  CMusicLoudnessAnalyzer const& operator=(CMusicLoudnessAnalyzer const&);
+
+  /*! \brief Write the measured songs to the database
+   \return the number of songs written.
+   */
+  unsigned int Flush(CMusicDatabase &database);
+
+  /*! \brief Called by the workers to take the next song to measure
+   \return false once there are no more songs, or the worker should stop.
+   */
+  bool GetNextSong(CSong &song, const volatile bool &stop);
+  void OnSongDone(const CMusicLoudnessJob &job, bool success);
+
+  void StopWorkers();
+
+  bool                   m_showDialog;
+  bool                   m_bRunning;
+
+  CCriticalSection       m_section;
+  CEvent                 m_jobDone;
+  CEvent                 m_songQueued;
+  std::deque<CSong>      m_pending;   /* the songs waiting for a worker */
+  bool                   m_queueDone; /* no more songs are going to be queued */
+  std::vector<CMusicLoudnessWorker*> m_workers;
+  CStdString             m_current;   /* the title of the song a worker last took */
+  VECSONGS               m_measured;  /* the songs measured since the last flush */
+  unsigned int           m_completed; /* the songs that have finished, measured or not */
+  unsigned int           m_failed;    /* the songs that could not be decoded */
+
+  friend class CMusicLoudnessWorker;
+};
+
+}
@@ -25,6 +25,8 @@
 #include "settings/AdvancedSettings.h"
 #include "utils/Variant.h"
 
+#include <math.h>
+
 using namespace MUSIC_INFO;
 
 EmbeddedArtInfo::EmbeddedArtInfo(size_t siz, const std::string &mim)
@@ -505,6 +507,16 @@ void CMusicInfoTag::SetReplayGainAlbumPeak(float albumPeak)
   m_iHasGainInfo |= REPLAY_GAIN_HAS_ALBUM_PEAK;
 }
 
+void CMusicInfoTag::SetReplayGainFromLoudness(float loudness, float truePeak)
+{
+  if (m_iHasGainInfo & REPLAY_GAIN_HAS_TRACK_INFO)
+    return;
+
+  // gains are stored in hundredths of a dB
+  SetReplayGainTrackGain((int)floor((REPLAY_GAIN_REFERENCE_LOUDNESS - loudness) * 100.0f + 0.5f));
+  SetReplayGainTrackPeak(truePeak);
+}
+
 void CMusicInfoTag::SetArtist(const CArtist& artist)
 {
   SetArtist(artist.strArtist);
@@ -561,6 +573,8 @@ void CMusicInfoTag::SetSong(const CSong& song)
   m_bLoaded = true;
   m_iTimesPlayed = song.iTimesPlayed;
   m_iAlbumId = song.idAlbum;
+  if (song.bHasLoudness)
+    SetReplayGainFromLoudness(song.fLoudness, song.fTruePeak);
 }
 
 void CMusicInfoTag::Serialize(CVariant& value) const
@@ -38,6 +38,9 @@ class CArtist;
 #define REPLAY_GAIN_HAS_TRACK_PEAK 4
 #define REPLAY_GAIN_HAS_ALBUM_PEAK 8
 
+// the loudness in LUFS that ReplayGain 2.0 gains bring a track to
+#define REPLAY_GAIN_REFERENCE_LOUDNESS -18.0f
+
 namespace MUSIC_INFO
 {
   class EmbeddedArtInfo
@@ -147,6 +150,13 @@ public:
   void SetReplayGainTrackPeak(float trackPeak);
   void SetReplayGainAlbumPeak(float albumPeak);
 
+  /*! \brief Set the track gain from a measured loudness
+   Only used when the file has no ReplayGain tags of its own.
+   \param loudness the integrated loudness in LUFS.
+   \param truePeak the true peak as a linear amplitude.
+   */
+  void SetReplayGainFromLoudness(float loudness, float truePeak);
+
   /*! \brief Append a unique artist to the artist list
    Checks if we have this artist already added, and if not adds it to the songs artist list.
    \param value artist to add.
@@ -80,6 +80,7 @@ void CAdvancedSettings::Initialize()
   m_allChannelStereo = false;
   m_streamSilence = false;
   m_audioSinkBufferDurationMsec = 50;
+  m_audioDecodeAheadSeconds = 10;
 
   //default hold time of 25 ms, this allows a 20 hertz sine to pass undistorted
   m_limiterHold = 0.025f;
@@ -137,6 +138,8 @@ void CAdvancedSettings::Initialize()
   m_videoFpsDetect = 1;
   m_videoDefaultLatency = 0.0;
   m_videoDisableHi10pMultithreading = false;
+  m_videoDemuxBufferSize = 0;
+  m_videoKeyframeIndex = true;
 
   m_musicUseTimeSeeking = true;
   m_musicTimeSeekForward = 10;
@@ -272,6 +275,8 @@ void CAdvancedSettings::Initialize()
   m_curlconnecttimeout = 10;
   m_curllowspeedtime = 20;
   m_curlretries = 2;
+  m_curlConnections = 1;          //Connections a seekable http file is read over, each fetching a range
+  m_nfsReadAhead = 4;            //Reads kept in flight ahead of the position of an nfs file, 0 reads one at a time
   m_curlDisableIPV6 = false;      //Certain hardware/OS combinations have trouble
                                   //with ipv6.
 
@@ -322,6 +327,9 @@ void CAdvancedSettings::Initialize()
   m_measureRefreshrate = false;
 
   m_cacheMemBufferSize = 1024 * 1024 * 20;
+  m_cacheDiskSize = 0;
+  m_dirCacheSize = 1024 * 1024 * 16;
+  m_dirCachePersistent = false;
   m_addonPackageFolderSize = 200;
 
   m_jsonOutputCompact = true;
@@ -441,6 +449,7 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetBoolean(pElement, "streamsilence", m_streamSilence);
     XMLUtils::GetString(pElement, "transcodeto", m_audioTranscodeTo);
     XMLUtils::GetInt(pElement, "audiosinkbufferdurationmsec", m_audioSinkBufferDurationMsec);
+    XMLUtils::GetInt(pElement, "decodeahead", m_audioDecodeAheadSeconds, 0, 60);
 
     TiXmlElement* pAudioExcludes = pElement->FirstChildElement("excludefromlisting");
     if (pAudioExcludes)
@@ -634,6 +643,8 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetBoolean(pElement,"dxvanodeintforprogressive", m_DXVANoDeintProcForProgressive);
     //0 = disable fps detect, 1 = only detect on timestamps with uniform spacing, 2 detect on all timestamps
     XMLUtils::GetInt(pElement, "fpsdetect", m_videoFpsDetect, 0, 2);
+    XMLUtils::GetInt(pElement, "demuxbuffersize", m_videoDemuxBufferSize, 0, 16 * 1024 * 1024);
+    XMLUtils::GetBoolean(pElement, "keyframeindex", m_videoKeyframeIndex);
 
     // Store global display latency settings
     TiXmlElement* pVideoLatency = pElement->FirstChildElement("latency");
@@ -671,6 +682,43 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
       // Get default global display latency
       XMLUtils::GetFloat(pVideoLatency, "delay", m_videoDefaultLatency, -600.0f, 600.0f);
     }
+
+    // Store per codec threading policies
+    TiXmlElement* pThreading = pElement->FirstChildElement("threading");
+    if (pThreading)
+    {
+      TiXmlElement* pCodec = pThreading->FirstChildElement("codec");
+      while (pCodec)
+      {
+        VideoCodecThreading threading;
+        threading.type    = 0;
+        threading.threads = 0;
+        threading.latency = 0.0f;
+
+        CStdString type;
+        XMLUtils::GetString(pCodec, "name", threading.codec);
+        XMLUtils::GetString(pCodec, "type", type);
+        XMLUtils::GetInt(pCodec, "threads", threading.threads, 0, 64);
+        XMLUtils::GetFloat(pCodec, "maxlatency", threading.latency, 0.0f, 5000.0f);
+
+        bool valid = !threading.codec.IsEmpty();
+        if (type.Equals("frame"))
+          threading.type = 1;
+        else if (type.Equals("slice"))
+          threading.type = 2;
+        else if (type.Equals("frame+slice"))
+          threading.type = 3;
+        else if (!type.IsEmpty())
+          valid = false;
+
+        if (valid)
+          m_videoCodecThreading.push_back(threading);
+        else
+          CLog::Log(LOGWARNING, "Ignoring malformed video threading <codec> entry, name:%s type:%s", threading.codec.c_str(), type.c_str());
+
+        pCodec = pCodec->NextSiblingElement("codec");
+      }
+    }
   }
 
   pElement = pRootElement->FirstChildElement("musiclibrary");
@@ -727,8 +775,11 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetInt(pElement, "curlclienttimeout", m_curlconnecttimeout, 1, 1000);
     XMLUtils::GetInt(pElement, "curllowspeedtime", m_curllowspeedtime, 1, 1000);
     XMLUtils::GetInt(pElement, "curlretries", m_curlretries, 0, 10);
+    XMLUtils::GetInt(pElement, "curlconnections", m_curlConnections, 1, 8);
+    XMLUtils::GetInt(pElement, "nfsreadahead", m_nfsReadAhead, 0, 32);
     XMLUtils::GetBoolean(pElement,"disableipv6", m_curlDisableIPV6);
     XMLUtils::GetUInt(pElement, "cachemembuffersize", m_cacheMemBufferSize);
+    XMLUtils::GetUInt(pElement, "cachedisksize", m_cacheDiskSize);
   }
 
   pElement = pRootElement->FirstChildElement("jsonrpc");
@@ -803,6 +854,8 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
   XMLUtils::GetFloat(pRootElement,"sleepbeforeflip", m_sleepBeforeFlip, 0.0f, 1.0f);
   XMLUtils::GetBoolean(pRootElement,"virtualshares", m_bVirtualShares);
   XMLUtils::GetUInt(pRootElement, "packagefoldersize", m_addonPackageFolderSize);
+  XMLUtils::GetUInt(pRootElement, "dircachesize", m_dirCacheSize);
+  XMLUtils::GetBoolean(pRootElement, "dircachepersistent", m_dirCachePersistent);
 
   //Tuxbox
   pElement = pRootElement->FirstChildElement("tuxbox");
@@ -1273,6 +1326,21 @@ float CAdvancedSettings::GetDisplayLatency(float refreshrate)
   return delay; // in seconds
 }
 
+const VideoCodecThreading* CAdvancedSettings::GetVideoCodecThreading(const CStdString &codec) const
+{
+  const VideoCodecThreading* policy = NULL;
+  for (unsigned int i = 0; i < m_videoCodecThreading.size(); i++)
+  {
+    const VideoCodecThreading& threading = m_videoCodecThreading[i];
+    if (threading.codec.Equals(codec))
+      return &threading;
+    if (threading.codec == "*")
+      policy = &threading;
+  }
+
+  return policy;
+}
+
 void CAdvancedSettings::SetDebugMode(bool debug)
 {
   if (debug)
@@ -80,6 +80,14 @@ struct RefreshVideoLatency
   float delay;
 };
 
+struct VideoCodecThreading
+{
+  CStdString codec;   // ffmpeg decoder name, "*" for any codec without a policy of its own
+  int        type;    // as FF_THREAD_FRAME (1) and FF_THREAD_SLICE (2), 0 keeps the default
+  int        threads; // 0 for one per cpu
+  float      latency; // ms frame threading may delay the pictures by, 0 for no limit
+};
+
 typedef std::vector<TVShowRegexp> SETTINGS_TVSHOWLIST;
 
 class CAdvancedSettings : public ISettingsHandler
@@ -114,6 +122,7 @@ class CAdvancedSettings : public ISettingsHandler
     bool m_allChannelStereo;
     bool m_streamSilence;
     int m_audioSinkBufferDurationMsec;
+    int m_audioDecodeAheadSeconds;
     CStdString m_audioTranscodeTo;
     float m_limiterHold;
     float m_limiterRelease;
@@ -169,6 +178,9 @@ class CAdvancedSettings : public ISettingsHandler
     bool m_DXVANoDeintProcForProgressive;
     int  m_videoFpsDetect;
     bool m_videoDisableHi10pMultithreading;
+    std::vector<VideoCodecThreading> m_videoCodecThreading;
+    int  m_videoDemuxBufferSize;
+    bool m_videoKeyframeIndex;
 
     CStdString m_videoDefaultPlayer;
     CStdString m_videoDefaultDVDPlayer;
@@ -293,6 +305,8 @@ class CAdvancedSettings : public ISettingsHandler
     int m_curlconnecttimeout;
     int m_curllowspeedtime;
     int m_curlretries;
+    int m_curlConnections;
+    int m_nfsReadAhead;
     bool m_curlDisableIPV6;
 
     bool m_fullScreen;
@@ -359,6 +373,9 @@ class CAdvancedSettings : public ISettingsHandler
     unsigned int m_addonPackageFolderSize;
 
     unsigned int m_cacheMemBufferSize;
+    unsigned int m_cacheDiskSize;
+    unsigned int m_dirCacheSize;
+    bool m_dirCachePersistent;
 
     bool m_jsonOutputCompact;
     unsigned int m_jsonTcpPort;
@@ -368,6 +385,7 @@ class CAdvancedSettings : public ISettingsHandler
     void ParseSettingsFile(const CStdString &file);
 
     float GetDisplayLatency(float refreshrate);
+    const VideoCodecThreading* GetVideoCodecThreading(const CStdString &codec) const;
     bool m_initialized;
 
     void SetDebugMode(bool debug);
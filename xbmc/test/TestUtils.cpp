@@ -216,6 +216,11 @@ std::vector<CStdString> &CXBMCTestUtils::getAdvancedSettingsFiles()
   return AdvancedSettingsFiles;
 }
 
+std::vector<CStdString> &CXBMCTestUtils::getDVDBenchmarkFiles()
+{
+  return DVDBenchmarkFiles;
+}
+
 std::vector<CStdString> &CXBMCTestUtils::getGUISettingsFiles()
 {
   return GUISettingsFiles;
@@ -251,6 +256,13 @@ static const char usage[] =
 "  --set-testfilefactory-writeinputfile [FILE]\n"
 "    Set the path to the input file used in the TestFileFactory write tests.\n"
 "\n"
+"  --add-dvdbenchmark-file [FILE]\n"
+"    Add a media file to be demuxed and decoded in the TestDVDBenchmark tests.\n"
+"\n"
+"  --add-dvdbenchmark-files [FILES]\n"
+"    Add multiple media files from a ',' delimited string of files to be\n"
+"    demuxed and decoded in the TestDVDBenchmark tests.\n"
+"\n"
 "  --add-advancedsettings-file [FILE]\n"
 "    Add an advanced settings file to be loaded in test cases that use them.\n"
 "\n"
@@ -319,6 +331,18 @@ void CXBMCTestUtils::ParseArgs(int argc, char **argv)
     {
       TestFileFactoryWriteInputFile = argv[++i];
     }
+    else if (arg == "--add-dvdbenchmark-file")
+    {
+      DVDBenchmarkFiles.push_back(argv[++i]);
+    }
+    else if (arg == "--add-dvdbenchmark-files")
+    {
+      arg = argv[++i];
+      std::vector<std::string> files = StringUtils::Split(arg, ",");
+      std::vector<std::string>::iterator it;
+      for (it = files.begin(); it < files.end(); it++)
+        DVDBenchmarkFiles.push_back(*it);
+    }
     else if (arg == "--add-advancedsettings-file")
     {
       AdvancedSettingsFiles.push_back(argv[++i]);
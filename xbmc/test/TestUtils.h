@@ -69,6 +69,9 @@ public:
   /* Function to set the input file used in the TestFileFactory.Write tests */
   void setTestFileFactoryWriteInputFile(CStdString const& file);
 
+  /* Function to get the media files used in the TestDVDBenchmark tests. */
+  std::vector<CStdString> &getDVDBenchmarkFiles();
+
   /* Function to get advanced settings files. */
   std::vector<CStdString> &getAdvancedSettingsFiles();
 
@@ -98,6 +101,7 @@ private:
   std::vector<CStdString> TestFileFactoryReadUrls;
   std::vector<CStdString> TestFileFactoryWriteUrls;
   CStdString TestFileFactoryWriteInputFile;
+  std::vector<CStdString> DVDBenchmarkFiles;
 
   std::vector<CStdString> AdvancedSettingsFiles;
   std::vector<CStdString> GUISettingsFiles;
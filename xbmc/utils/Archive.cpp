@@ -367,6 +367,12 @@ CArchive& CArchive::operator>>(std::string& str)
   int iLength = 0;
   *this >> iLength;
 
+  if (!IsValidLength(iLength, 1))
+  {
+    str.clear();
+    return *this;
+  }
+
   char *s = new char[iLength];
   m_pFile->Read(s, iLength);
   str.assign(s, iLength);
@@ -380,6 +386,12 @@ CArchive& CArchive::operator>>(CStdString& str)
   int iLength = 0;
   *this >> iLength;
 
+  if (!IsValidLength(iLength, 1))
+  {
+    str.clear();
+    return *this;
+  }
+
   m_pFile->Read((void*)str.GetBufferSetLength(iLength), iLength);
   str.ReleaseBuffer();
 
@@ -392,6 +404,12 @@ CArchive& CArchive::operator>>(CStdStringW& str)
   int iLength = 0;
   *this >> iLength;
 
+  if (!IsValidLength(iLength, sizeof(wchar_t)))
+  {
+    str.clear();
+    return *this;
+  }
+
   m_pFile->Read((void*)str.GetBufferSetLength(iLength), iLength * sizeof(wchar_t));
   str.ReleaseBuffer();
 
@@ -521,6 +539,15 @@ CArchive& CArchive::operator>>(std::vector<int>& iArray)
   return *this;
 }
 
+bool CArchive::IsValidLength(int length, unsigned int size)
+{
+  // a damaged file must not make us allocate more than it holds
+  if (length < 0)
+    return false;
+  int64_t fileLength = m_pFile->GetLength();
+  return fileLength <= 0 || (int64_t)length * size <= fileLength - m_pFile->GetPosition();
+}
+
 void CArchive::FlushBuffer()
 {
   if (m_BufferPos > 0)
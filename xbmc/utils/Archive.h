@@ -88,6 +88,7 @@ public:
 
 protected:
   void FlushBuffer();
+  bool IsValidLength(int length, unsigned int size);
   XFILE::CFile* m_pFile;
   int m_iMode;
   uint8_t *m_pBuffer;